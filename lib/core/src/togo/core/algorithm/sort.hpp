@@ -14,6 +14,8 @@
 #include <togo/core/error/assert.hpp>
 #include <togo/core/utility/constraints.hpp>
 #include <togo/core/utility/utility.hpp>
+#include <togo/core/threading/types.hpp>
+#include <togo/core/threading/task_manager.hpp>
 
 #include <cstring>
 
@@ -25,6 +27,96 @@
 
 namespace togo {
 
+/** @cond INTERNAL */
+namespace internal {
+
+template<class T, class K, class B, class KFunc>
+struct SortRadixChunk {
+	enum : unsigned {
+		SLICE_BITS = 8,
+		NUM_BINS = 1 << SLICE_BITS,
+		SLICE_MASK = NUM_BINS - 1,
+	};
+
+	enum class Stage : unsigned {
+		scan,
+		count,
+		scatter,
+	};
+
+	KFunc const* key_func;
+	T const* values;
+	T* values_swap;
+	unsigned begin;
+	unsigned end;
+	Stage stage;
+	unsigned slice_shift;
+	K first_key;
+	K diff;
+	bool sorted;
+	B bins[NUM_BINS];
+
+	void execute() noexcept {
+		auto const& kf = *key_func;
+		unsigned i;
+		switch (stage) {
+		case Stage::scan: {
+			K key;
+			K pkey = begin > 0 ? kf(values[begin - 1]) : 0;
+			unsigned s = 1;
+			diff = 0;
+			for (i = begin; i < end; ++i) {
+				key = kf(values[i]);
+				diff |= key ^ first_key;
+				s &= pkey <= key;
+				pkey = key;
+			}
+			sorted = s;
+		}	break;
+
+		case Stage::count:
+			std::memset(bins, 0, sizeof(bins));
+			for (i = begin; i < end; ++i) {
+				++bins[(kf(values[i]) >> slice_shift) & SLICE_MASK];
+			}
+			break;
+
+		case Stage::scatter:
+			for (i = begin; i < end; ++i) {
+				T const& value = values[i];
+				values_swap[bins[(kf(value) >> slice_shift) & SLICE_MASK]++] = value;
+			}
+			break;
+		}
+	}
+
+	static void task_func(TaskID const, void* const data) {
+		static_cast<SortRadixChunk*>(data)->execute();
+	}
+};
+
+// Execute the first chunk on this thread and the rest as tasks
+template<class C>
+void sort_radix_execute_chunks(
+	TaskManager& task_manager,
+	C* const chunks,
+	unsigned const num_chunks
+) {
+	TaskID const root_id = task_manager::add_hold_empty(task_manager);
+	for (unsigned c = 1; c < num_chunks; ++c) {
+		TaskID const task_id = task_manager::add(
+			task_manager, TaskWork{&chunks[c], C::task_func}
+		);
+		task_manager::set_parent(task_manager, task_id, root_id);
+	}
+	task_manager::end_hold(task_manager, root_id);
+	chunks[0].execute();
+	task_manager::wait(task_manager, root_id);
+}
+
+} // namespace internal
+/** @endcond */ // INTERNAL
+
 /**
 	@addtogroup lib_core_algorithm
 	@{
@@ -50,6 +142,9 @@ namespace togo {
 /// - a 32-bit key makes 3 passes
 /// - a 64-bit key makes 6 passes
 ///
+/// Slices that are the same for every key are skipped, so keys with
+/// few varying bits (such as a constant prefix) take fewer passes.
+///
 /// values and values_swap are swapped for each pass. The return
 /// value is true if they have been swapped at exit (i.e., values_swap
 /// would contain the sorted result).
@@ -100,55 +195,74 @@ bool sort_radix_generic(
 		"size exceeds limit for bin value type"
 	);
 
+	if (size == 0) {
+		return false;
+	}
+
 	B bins[NUM_BINS]{0};
+	K const first_key = key_func(values[0]);
 	K key;
-	K pkey;
+	K pkey = 0;
+	K diff = 0;
 	B num_slices;
 	B offset;
 	unsigned pass = 0;
 	unsigned i;
 	unsigned slice_shift = 0;
-	unsigned sorted;
-	while (pass < NUM_PASSES) {
-		// Count values for this slice
-		sorted = 1;
-		pkey = 0;
-		for (i = 0; i < size; ++i) {
-			key = key_func(values[i]);
-			++bins[(key >> slice_shift) & SLICE_MASK];
-			sorted &= pkey <= key;
-			pkey = key;
-		}
+	unsigned sorted = 1;
+	bool swapped = false;
 
-		// Quick exit if the collection is already sorted
-		if (sorted) {
-			break;
-		}
+	{// Count values for the first slice and find the bits that vary
+	for (i = 0; i < size; ++i) {
+		key = key_func(values[i]);
+		++bins[key & SLICE_MASK];
+		diff |= key ^ first_key;
+		sorted &= pkey <= key;
+		pkey = key;
+	}}
 
-		// Make each bin value an offset to the first item position
-		// of each slice
-		offset = 0;
-		for (i = 0; i < NUM_BINS; ++i) {
-			num_slices = bins[i];
-			bins[i] = offset;
-			offset += num_slices;
+	// Quick exit if the collection is already sorted
+	if (sorted) {
+		return false;
+	}
+
+	while (true) {
+		if ((diff >> slice_shift) & SLICE_MASK) {
+			// Make each bin value an offset to the first item position
+			// of each slice
+			offset = 0;
+			for (i = 0; i < NUM_BINS; ++i) {
+				num_slices = bins[i];
+				bins[i] = offset;
+				offset += num_slices;
+			}
+
+			// Assign items according to offsets
+			for (i = 0; i < size; ++i) {
+				T const& value = values[i];
+				offset = bins[(key_func(value) >> slice_shift) & SLICE_MASK]++;
+				values_swap[offset] = value;
+			}
+
+			swap(values, values_swap);
+			swapped = !swapped;
 		}
 
-		// Assign items according to offsets
-		for (i = 0; i < size; ++i) {
-			T const& value = values[i];
-			offset = bins[(key_func(value) >> slice_shift) & SLICE_MASK]++;
-			values_swap[offset] = value;
+		// Move to the next slice with varying bits
+		do {
+			slice_shift += SLICE_BITS;
+		} while (++pass < NUM_PASSES && !((diff >> slice_shift) & SLICE_MASK));
+		if (pass >= NUM_PASSES) {
+			break;
 		}
 
-		slice_shift += SLICE_BITS;
-		swap(values, values_swap);
-		if (++pass < NUM_PASSES) {
-			std::memset(bins, 0, sizeof(bins));
+		// Count values for this slice
+		std::memset(bins, 0, sizeof(bins));
+		for (i = 0; i < size; ++i) {
+			++bins[(key_func(values[i]) >> slice_shift) & SLICE_MASK];
 		}
 	}
-	// Either quick exit hit or NUM_PASSES is an odd number
-	return (pass & 1);
+	return swapped;
 }
 
 /// 2048-radix sort a 32-bit keyed collection with 32-bit bin values.
@@ -185,6 +299,123 @@ void sort_radix_k64(
 	}
 }
 
+/// 256-radix sort a T-value K-keyed collection with B-value bins
+/// over num_tasks tasks.
+///
+/// The requirements and the return value are the same as
+/// sort_radix_generic().
+///
+/// The collection is split into num_tasks ranges (at most 8). Each pass counts the 8-bit slice of
+/// every range in parallel, makes per-range offsets from the counts,
+/// and then scatters each range in parallel. The first range is
+/// handled by the calling thread and the rest by task_manager.
+/// Slices that are the same for every key are skipped.
+///
+/// Ranges are at least 1024 values. If the collection is too small for
+/// two ranges or num_tasks is below 2, this falls back to
+/// sort_radix_generic().
+template<class T, class K, class B, class KFunc>
+bool sort_radix_parallel(
+	TaskManager& task_manager,
+	T*& values,
+	T*& values_swap,
+	unsigned const size,
+	KFunc key_func,
+	unsigned num_tasks
+) noexcept {
+	TOGO_CONSTRAIN_POD(T);
+	TOGO_CONSTRAIN_UNSIGNED(K);
+	TOGO_CONSTRAIN_UNSIGNED(B);
+
+	using Chunk = internal::SortRadixChunk<T, K, B, KFunc>;
+	enum : unsigned {
+		MAX_TASKS = 8,
+		MIN_TASK_SIZE = 1024,
+		NUM_BINS = Chunk::NUM_BINS,
+		SLICE_MASK = Chunk::SLICE_MASK,
+		NUM_PASSES = sizeof(K),
+	};
+
+	TOGO_ASSERT(
+		size <= static_cast<B>(-1),
+		"size exceeds limit for bin value type"
+	);
+
+	num_tasks = min(
+		min(num_tasks, static_cast<unsigned>(MAX_TASKS)),
+		size / MIN_TASK_SIZE
+	);
+	if (num_tasks < 2) {
+		return sort_radix_generic<T, K, B>(values, values_swap, size, key_func);
+	}
+
+	Chunk chunks[MAX_TASKS];
+	K const first_key = key_func(values[0]);
+	unsigned const chunk_size = size / num_tasks;
+	for (unsigned c = 0; c < num_tasks; ++c) {
+		auto& chunk = chunks[c];
+		chunk.key_func = &key_func;
+		chunk.begin = c * chunk_size;
+		chunk.end = (c + 1 == num_tasks) ? size : chunk.begin + chunk_size;
+		chunk.first_key = first_key;
+	}
+
+	auto const set_stage = [&chunks, num_tasks, &values, &values_swap](
+		typename Chunk::Stage const stage,
+		unsigned const slice_shift
+	) {
+		for (auto& chunk : array_ref(chunks, num_tasks)) {
+			chunk.stage = stage;
+			chunk.slice_shift = slice_shift;
+			chunk.values = values;
+			chunk.values_swap = values_swap;
+		}
+	};
+
+	K diff = 0;
+	{// Find the bits that vary and quick exit if already sorted
+	set_stage(Chunk::Stage::scan, 0);
+	internal::sort_radix_execute_chunks(task_manager, chunks, num_tasks);
+	bool sorted = true;
+	for (auto const& chunk : array_cref(chunks, num_tasks)) {
+		diff |= chunk.diff;
+		sorted &= chunk.sorted;
+	}
+	if (sorted) {
+		return false;
+	}}
+
+	bool swapped = false;
+	B offset;
+	B count;
+	unsigned slice_shift = 0;
+	for (unsigned pass = 0; pass < NUM_PASSES; ++pass, slice_shift += Chunk::SLICE_BITS) {
+		if (!((diff >> slice_shift) & SLICE_MASK)) {
+			continue;
+		}
+		set_stage(Chunk::Stage::count, slice_shift);
+		internal::sort_radix_execute_chunks(task_manager, chunks, num_tasks);
+
+		// Make each bin value in each chunk an offset to the first
+		// position of its values. Ranges are in order within each
+		// slice value, which keeps the sort stable.
+		offset = 0;
+		for (unsigned i = 0; i < NUM_BINS; ++i) {
+			for (auto& chunk : array_ref(chunks, num_tasks)) {
+				count = chunk.bins[i];
+				chunk.bins[i] = offset;
+				offset += count;
+			}
+		}
+
+		set_stage(Chunk::Stage::scatter, slice_shift);
+		internal::sort_radix_execute_chunks(task_manager, chunks, num_tasks);
+		swap(values, values_swap);
+		swapped = !swapped;
+	}
+	return swapped;
+}
+
 /// Insertion sort a collection.
 ///
 /// T must be POD.
@@ -211,8 +211,8 @@ void resize(HashMap<K, T>& hm, u32_fast const new_size) {
 	}
 	u32 index;
 	for (auto const& node : hm._data) {
-		index = make(hm, node.key, false);
-		hm._data[index].value = node.value;
+		index = make(new_hm, node.key, false);
+		new_hm._data[index].value = node.value;
 	}
 	hm = rvalue_ref(new_hm);
 }
@@ -40,6 +40,11 @@ namespace togo {
 	/// This is enabled if it is defined.
 	#define TOGO_USE_CONSTRAINTS
 
+	/// Whether to compile out the TOGO_TRACE_* macros.
+	///
+	/// This is enabled if it is defined.
+	#define TOGO_DISABLE_TRACE
+
 	/// Validate printf-style format when calling the following function.
 	#define TOGO_VALIDATE_FORMAT_PARAM(fmt_index, args_index)
 
@@ -5,6 +5,7 @@
 
 #include <togo/core/config.hpp>
 #include <togo/core/error/assert.hpp>
+#include <togo/core/log/log.hpp>
 
 #include <cstdarg>
 #include <cstdlib>
@@ -13,6 +14,8 @@
 namespace togo {
 
 void error_abort(unsigned line, char const* file, char const* msg, ...) {
+	// Pending messages precede the error
+	log::flush();
 	std::fprintf(stderr, "%s @ %4d: fatal error: ", file, line);
 	va_list va;
 	va_start(va, msg);
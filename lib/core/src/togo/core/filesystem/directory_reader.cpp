@@ -4,6 +4,7 @@
 */
 
 #include <togo/core/config.hpp>
+#include <togo/core/collection/array.hpp>
 #include <togo/core/filesystem/types.hpp>
 #include <togo/core/filesystem/directory_reader.hpp>
 
@@ -26,4 +27,9 @@ DirectoryReader::~DirectoryReader() {
 	directory_reader::close(*this);
 }
 
+DirectoryListing::DirectoryListing(Allocator& allocator)
+	: entries(allocator)
+	, paths(allocator)
+{}
+
 } // namespace togo
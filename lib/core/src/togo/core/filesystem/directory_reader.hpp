@@ -16,7 +16,10 @@
 
 #include <togo/core/config.hpp>
 #include <togo/core/error/assert.hpp>
+#include <togo/core/collection/array.hpp>
 #include <togo/core/string/types.hpp>
+#include <togo/core/string/string.hpp>
+#include <togo/core/threading/types.hpp>
 #include <togo/core/filesystem/types.hpp>
 
 namespace togo {
@@ -55,6 +58,36 @@ bool read(
 	DirectoryEntry::Type type_mask
 );
 
+/// Scan directory into a listing.
+///
+/// Entries matching type_mask are appended to listing in the same
+/// order and form that read() would produce them. Entries are
+/// classified from the directory stream where the filesystem supports
+/// it, so regular files are never stat'd.
+///
+/// If task_manager is non-null, subdirectories are scanned in
+/// parallel. The resulting order does not depend on this.
+///
+/// Returns false if the directory could not be opened.
+/// Subdirectories that cannot be opened are skipped.
+bool scan(
+	DirectoryListing& listing,
+	StringRef const& path,
+	bool prepend_path,
+	bool recursive,
+	bool ignore_dotfiles,
+	DirectoryEntry::Type type_mask,
+	TaskManager* task_manager = nullptr
+);
+
+/// Listing entry.
+///
+/// The entry path is valid until the listing is modified.
+inline DirectoryEntry entry(DirectoryListing const& listing, unsigned const i) {
+	auto const& e = listing.entries[i];
+	return {e.type, StringRef{array::begin(listing.paths) + e.offset, e.size}};
+}
+
 /** @} */ // end of doc-group lib_core_filesystem_directory_reader
 
 } // namespace directory_reader
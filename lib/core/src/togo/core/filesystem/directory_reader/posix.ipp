@@ -7,8 +7,14 @@
 #include <togo/core/error/assert.hpp>
 #include <togo/core/utility/utility.hpp>
 #include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
 #include <togo/core/collection/fixed_array.hpp>
+#include <togo/core/collection/array.hpp>
 #include <togo/core/string/string.hpp>
+#include <togo/core/threading/mutex.hpp>
+#include <togo/core/threading/condvar.hpp>
+#include <togo/core/threading/task_manager.hpp>
+#include <togo/core/system/system.hpp>
 #include <togo/core/filesystem/filesystem.hpp>
 #include <togo/core/filesystem/directory_reader/private.hpp>
 
@@ -16,9 +22,15 @@
 #include <cstring>
 
 #include <sys/types.h>
+#include <sys/stat.h>
 #include <fcntl.h>
+#include <unistd.h>
 #include <dirent.h>
 
+#if defined(TOGO_PLATFORM_LINUX)
+	#include <sys/syscall.h>
+#endif
+
 namespace togo {
 
 PosixDirectoryReaderImpl::PosixDirectoryReaderImpl()
@@ -190,4 +202,340 @@ l_return_entry:
 	return true;
 }
 
+namespace {
+
+enum : unsigned {
+	SCAN_BUFFER_SIZE = 16 * 1024,
+	SCAN_MAX_TASKS = 32,
+	SCAN_NONE = ~0u,
+};
+
+struct ScanItem {
+	DirectoryEntry::Type type;
+	u32 name_offset;
+	u32 name_size;
+	u32 child;
+};
+
+// A directory. Its prefix (relative to the scan base) lives in
+// ScanState::prefixes and its items in the storage of the worker that
+// read it.
+struct ScanNode {
+	u32 prefix_offset;
+	u32 prefix_size;
+	u32 storage;
+	u32 items_offset;
+	u32 num_items;
+};
+
+// Only appended to by one worker, so reads need no locking
+struct ScanStorage {
+	Array<char> names;
+	Array<ScanItem> items;
+
+	ScanStorage()
+		: names(memory::default_allocator())
+		, items(memory::default_allocator())
+	{}
+};
+
+struct ScanState {
+	u32 options;
+	bool opened;
+	StringRef base;
+	unsigned num_active;
+	unsigned num_storage;
+	Mutex mutex;
+	CondVar signal;
+	Array<ScanNode> nodes;
+	Array<char> prefixes;
+	Array<u32> queue;
+	ScanStorage storage[SCAN_MAX_TASKS];
+
+	ScanState(Allocator& allocator)
+		: options(0)
+		, opened(false)
+		, base()
+		, num_active(0)
+		, num_storage(0)
+		, mutex()
+		, signal()
+		, nodes(allocator)
+		, prefixes(allocator)
+		, queue(allocator)
+		, storage()
+	{}
+};
+
+#if defined(TOGO_PLATFORM_LINUX)
+struct LinuxDirent64 {
+	u64 d_ino;
+	s64 d_off;
+	unsigned short d_reclen;
+	unsigned char d_type;
+	char d_name[1];
+};
+#endif
+
+// Call f(dir_fd, name, d_type) for each entry and close fd
+template<class F>
+inline void for_each_dirent(signed const fd, F&& f) {
+#if defined(TOGO_PLATFORM_LINUX)
+	// getdents64 fills the buffer with as many entries as fit per call
+	alignas(8) u8 buffer[SCAN_BUFFER_SIZE];
+	long n;
+	while ((n = ::syscall(SYS_getdents64, fd, buffer, sizeof(buffer))) > 0) {
+		for (long position = 0; position < n;) {
+			auto const* const ent = reinterpret_cast<LinuxDirent64 const*>(buffer + position);
+			f(fd, ent->d_name, ent->d_type);
+			position += ent->d_reclen;
+		}
+	}
+	(void)(::close(fd));
+#else
+	DIR* const handle = ::fdopendir(fd);
+	if (!handle) {
+		(void)(::close(fd));
+		return;
+	}
+	struct ::dirent const* ent;
+	while ((ent = ::readdir(handle))) {
+		f(fd, ent->d_name, ent->d_type);
+	}
+	(void)(::closedir(handle));
+#endif
+}
+
+// Read the entries of the directory at path into storage
+static bool scan_directory(
+	char const* const path,
+	ScanStorage& storage,
+	bool const ignore_dotfiles
+) {
+	signed const fd = ::open(path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+	if (fd == -1) {
+		TOGO_LOG_DEBUGF(
+			"directory_reader::scan: open() failed; ignoring entry;"
+			" errno = %d, %s\n",
+			errno, std::strerror(errno)
+		);
+		return false;
+	}
+	for_each_dirent(fd, [&storage, ignore_dotfiles](
+		signed const dir_fd, char const* const name, unsigned char d_type
+	) {
+		if (name[0] == '.' && (
+			ignore_dotfiles ||
+			name[1] == '\0' ||
+			(name[1] == '.' && name[2] == '\0')
+		)) {
+			return;
+		}
+		if (d_type == DT_UNKNOWN) {
+			// Not all filesystems fill in the type
+			struct ::stat stat_buf;
+			if (::fstatat(dir_fd, name, &stat_buf, AT_SYMLINK_NOFOLLOW) != 0) {
+				return;
+			} else if (S_ISDIR(stat_buf.st_mode)) {
+				d_type = DT_DIR;
+			} else if (S_ISREG(stat_buf.st_mode)) {
+				d_type = DT_REG;
+			}
+		}
+
+		DirectoryEntry::Type type;
+		switch (d_type) {
+		case DT_DIR: type = DirectoryEntry::Type::dir; break;
+		case DT_REG: type = DirectoryEntry::Type::file; break;
+		default: return;
+		}
+		unsigned const offset = array::size(storage.names);
+		unsigned const size = static_cast<unsigned>(std::strlen(name));
+		array::increase_size(storage.names, size + 1);
+		std::memcpy(array::begin(storage.names) + offset, name, size + 1);
+		array::push_back(storage.items, ScanItem{type, offset, size, SCAN_NONE});
+	});
+	return true;
+}
+
+// Record the items of a scanned node and queue its subdirectories.
+// state.mutex must be held.
+static void finish_node(
+	ScanState& state,
+	unsigned const index,
+	unsigned const storage_index,
+	unsigned const items_offset,
+	bool const opened
+) {
+	ScanStorage& storage = state.storage[storage_index];
+	unsigned const num_items = array::size(storage.items) - items_offset;
+	{
+	ScanNode& node = state.nodes[index];
+	node.storage = storage_index;
+	node.items_offset = items_offset;
+	node.num_items = num_items;
+	}
+	if (index == 0) {
+		state.opened = opened;
+	}
+	if (!(state.options & directory_reader::OPT_RECURSIVE)) {
+		return;
+	}
+
+	unsigned const prefix_offset = state.nodes[index].prefix_offset;
+	unsigned const prefix_size = state.nodes[index].prefix_size;
+	for (auto& item : array_ref(array::begin(storage.items) + items_offset, num_items)) {
+		if (item.type != DirectoryEntry::Type::dir) {
+			continue;
+		}
+		unsigned const offset = array::size(state.prefixes);
+		unsigned const size = prefix_size + item.name_size + 1;
+		array::increase_size(state.prefixes, size);
+		char* const p = array::begin(state.prefixes);
+		std::memcpy(p + offset, p + prefix_offset, prefix_size);
+		std::memcpy(
+			p + offset + prefix_size,
+			array::begin(storage.names) + item.name_offset,
+			item.name_size
+		);
+		p[offset + size - 1] = '/';
+		item.child = array::size(state.nodes);
+		array::push_back(state.nodes, ScanNode{offset, size, 0, 0, 0});
+		array::push_back(state.queue, item.child);
+	}
+}
+
+// Scan queued nodes until none are queued or being scanned
+static void scan_work(ScanState& state) {
+	Array<char> path{memory::default_allocator()};
+	bool const ignore_dotfiles = state.options & directory_reader::OPT_IGNORE_DOTFILES;
+	unsigned storage_index;
+	{
+	MutexLock lock{state.mutex};
+	storage_index = state.num_storage++;
+	}
+	ScanStorage& storage = state.storage[storage_index];
+	unsigned index = SCAN_NONE;
+	unsigned items_offset = 0;
+	bool opened = false;
+	while (true) {
+		{
+		MutexLock lock{state.mutex};
+		if (index != SCAN_NONE) {
+			finish_node(state, index, storage_index, items_offset, opened);
+			--state.num_active;
+			condvar::signal_all(state.signal, lock);
+		}
+		while (array::empty(state.queue) && state.num_active > 0) {
+			condvar::wait(state.signal, lock);
+		}
+		if (array::empty(state.queue)) {
+			return;
+		}
+		index = array::back(state.queue);
+		array::pop_back(state.queue);
+		++state.num_active;
+
+		ScanNode const& node = state.nodes[index];
+		string::copy(path, state.base);
+		string::append(path, StringRef{
+			array::begin(state.prefixes) + node.prefix_offset, node.prefix_size
+		});
+		}
+		items_offset = array::size(storage.items);
+		opened = scan_directory(array::begin(path), storage, ignore_dotfiles);
+	}
+}
+
+static void scan_task_func(TaskID, void* data) {
+	scan_work(*static_cast<ScanState*>(data));
+}
+
+} // anonymous namespace
+
+bool directory_reader::scan(
+	DirectoryListing& listing,
+	StringRef const& path,
+	bool const prepend_path,
+	bool const recursive,
+	bool const ignore_dotfiles,
+	DirectoryEntry::Type const type_mask,
+	TaskManager* const task_manager
+) {
+	TOGO_DEBUG_ASSERTE(type_mask != static_cast<DirectoryEntry::Type>(0));
+
+	auto& allocator = memory::default_allocator();
+	Array<char> base{allocator};
+	string::copy(base, path);
+	array::resize(base, string::trim_trailing_slashes(array::begin(base), string::size(base)));
+	array::push_back(base, '/');
+	array::push_back(base, '\0');
+
+	ScanState state{allocator};
+	state.options = directory_reader::make_options(prepend_path, recursive, ignore_dotfiles);
+	state.base = base;
+	array::push_back(state.nodes, ScanNode{0, 0, 0, 0, 0});
+	array::push_back(state.queue, 0u);
+	if (!task_manager || !recursive) {
+		scan_work(state);
+	} else {
+		// Workers wait for subdirectories of the root to be queued
+		unsigned const num_tasks = min(system::num_cores(), unsigned{SCAN_MAX_TASKS});
+		TaskID const root_id = task_manager::add_hold_empty(*task_manager);
+		for (unsigned t = 1; t < num_tasks; ++t) {
+			TaskID const task_id = task_manager::add(
+				*task_manager, TaskWork{&state, scan_task_func}
+			);
+			task_manager::set_parent(*task_manager, task_id, root_id);
+		}
+		task_manager::end_hold(*task_manager, root_id);
+		scan_work(state);
+		task_manager::wait(*task_manager, root_id);
+	}
+
+	{// Flatten depth-first so subdirectory entries follow their parent
+	struct Cursor {
+		u32 node;
+		u32 item;
+	};
+	Array<Cursor> stack{allocator};
+	array::push_back(stack, Cursor{0, 0});
+	StringRef const path_base = prepend_path ? StringRef{base} : StringRef{};
+	while (array::any(stack)) {
+		Cursor& cursor = array::back(stack);
+		ScanNode const& node = state.nodes[cursor.node];
+		if (cursor.item == node.num_items) {
+			array::pop_back(stack);
+			continue;
+		}
+		ScanStorage const& storage = state.storage[node.storage];
+		ScanItem const& item = storage.items[node.items_offset + cursor.item++];
+		if (enum_bool(type_mask & item.type)) {
+			bool const is_dir = item.type == DirectoryEntry::Type::dir;
+			unsigned const offset = array::size(listing.paths);
+			unsigned const size = path_base.size + node.prefix_size + item.name_size + is_dir;
+			array::increase_size(listing.paths, size + 1);
+			char* p = array::begin(listing.paths) + offset;
+			auto const append = [&p](char const* const data, unsigned const size) {
+				if (size > 0) {
+					std::memcpy(p, data, size);
+					p += size;
+				}
+			};
+			append(path_base.data, path_base.size);
+			append(array::begin(state.prefixes) + node.prefix_offset, node.prefix_size);
+			append(array::begin(storage.names) + item.name_offset, item.name_size);
+			if (is_dir) {
+				*p++ = '/';
+			}
+			*p = '\0';
+			array::push_back(listing.entries, DirectoryListing::Entry{item.type, offset, size});
+		}
+		if (item.child != SCAN_NONE) {
+			array::push_back(stack, Cursor{item.child, 0});
+		}
+	}}
+	return state.opened;
+}
+
 } // namespace togo
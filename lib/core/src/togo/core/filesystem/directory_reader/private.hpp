@@ -21,19 +21,27 @@ namespace {
 	};
 } // anonymous namespace
 
-inline void set_options(
-	DirectoryReader& reader,
+inline u32 make_options(
 	bool const prepend_path,
 	bool const recursive,
 	bool const ignore_dotfiles
 ) {
-	reader._options
-		= (prepend_path    ? OPT_PREPEND_PATH : OPT_NONE)
+	return
+		  (prepend_path    ? OPT_PREPEND_PATH : OPT_NONE)
 		| (recursive       ? OPT_RECURSIVE : OPT_NONE)
 		| (ignore_dotfiles ? OPT_IGNORE_DOTFILES : OPT_NONE)
 	;
 }
 
+inline void set_options(
+	DirectoryReader& reader,
+	bool const prepend_path,
+	bool const recursive,
+	bool const ignore_dotfiles
+) {
+	reader._options = make_options(prepend_path, recursive, ignore_dotfiles);
+}
+
 inline bool option_prepend_path(DirectoryReader const& reader) {
 	return reader._options & OPT_PREPEND_PATH;
 }
@@ -0,0 +1,14 @@
+#line 2 "togo/core/filesystem/file_watcher.cpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#include <togo/core/config.hpp>
+#include <togo/core/filesystem/types.hpp>
+#include <togo/core/filesystem/file_watcher.hpp>
+
+#if defined(TOGO_PLATFORM_IS_POSIX)
+	#include <togo/core/filesystem/file_watcher/posix.ipp>
+#else
+	#error "missing FileWatcher implementation for target platform"
+#endif
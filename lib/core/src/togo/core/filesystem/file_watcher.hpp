@@ -0,0 +1,82 @@
+#line 2 "togo/core/filesystem/file_watcher.hpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+
+@file
+@brief FileWatcher interface.
+@ingroup lib_core_filesystem
+@ingroup lib_core_filesystem_file_watcher
+
+@defgroup lib_core_filesystem_file_watcher FileWatcher
+@ingroup lib_core_filesystem
+@details
+
+On Linux, changes are received through inotify. Elsewhere, or if
+requested, trees are rescanned and compared on each poll, which is
+proportional to the size of the trees and cannot detect moves (they
+are reported as a removal and a creation).
+*/
+
+#pragma once
+
+#include <togo/core/config.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/types.hpp>
+#include <togo/core/string/types.hpp>
+#include <togo/core/filesystem/types.hpp>
+
+namespace togo {
+namespace file_watcher {
+
+/**
+	@addtogroup lib_core_filesystem_file_watcher
+	@{
+*/
+
+enum : unsigned {
+	/// Time to wait for further events after the first of a batch.
+	SETTLE_MS = 10,
+	/// Interval between rescans when polling.
+	POLL_INTERVAL_MS = 100,
+};
+
+/// Whether the watcher polls the filesystem for changes.
+inline bool is_polling(FileWatcher const& watcher) {
+	return watcher._polling;
+}
+
+/// Number of roots.
+unsigned num_roots(FileWatcher const& watcher);
+
+/// Watch a directory tree.
+///
+/// Events for the tree refer to it by its index in the order roots
+/// were added, even if this fails.
+/// ignore_dotfiles will ignore directories and files that start
+/// with ".".
+///
+/// Returns false if the directory could not be watched.
+bool add_root(
+	FileWatcher& watcher,
+	StringRef const& path,
+	bool ignore_dotfiles
+);
+
+/// Remove all roots.
+void clear(FileWatcher& watcher);
+
+/// Wait for a batch of events.
+///
+/// Waits up to timeout_ms for changes. Once there are changes, events
+/// are collected until none arrive for SETTLE_MS. Redundant events
+/// within a batch are coalesced: e.g., a file that is created and then
+/// modified only has a create event, and one that is created and then
+/// removed has no events.
+///
+/// Events are valid until the next call.
+ArrayRef<FileWatchEvent const> poll(FileWatcher& watcher, unsigned timeout_ms);
+
+/** @} */ // end of doc-group lib_core_filesystem_file_watcher
+
+} // namespace file_watcher
+} // namespace togo
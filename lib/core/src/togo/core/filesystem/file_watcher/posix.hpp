@@ -0,0 +1,50 @@
+#line 2 "togo/core/filesystem/file_watcher/posix.hpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#pragma once
+
+#include <togo/core/config.hpp>
+#include <togo/core/types.hpp>
+#include <togo/core/collection/types.hpp>
+
+namespace togo {
+
+struct PosixFileWatcherRoot;
+struct PosixFileWatcherDir;
+
+struct PosixFileWatcherImpl {
+	// Event with paths as offsets into FileWatcher::_paths
+	struct Record {
+		u32 type;
+		u32 entry_type;
+		u32 root;
+		u32 path_offset;
+		u32 path_size;
+		u32 from_offset;
+		u32 from_size;
+		bool dropped;
+	};
+
+	// Unpaired IN_MOVED_FROM
+	struct MoveFrom {
+		u32 cookie;
+		Record record;
+	};
+
+	signed fd;
+	// Events were lost since the last poll
+	bool overflowed;
+	Array<PosixFileWatcherRoot*> roots;
+	HashMap<hash32, PosixFileWatcherDir*> dirs;
+	Array<Record> records;
+	HashMap<hash64, u32> record_lookup;
+	Array<MoveFrom> move_froms;
+
+	PosixFileWatcherImpl(Allocator& allocator);
+};
+
+using FileWatcherImpl = PosixFileWatcherImpl;
+
+} // namespace togo
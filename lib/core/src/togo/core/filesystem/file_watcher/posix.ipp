@@ -0,0 +1,691 @@
+#line 2 "togo/core/filesystem/file_watcher/posix.ipp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#include <togo/core/config.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/collection/hash_map.hpp>
+#include <togo/core/string/string.hpp>
+#include <togo/core/hash/hash.hpp>
+#include <togo/core/system/system.hpp>
+#include <togo/core/filesystem/directory_reader.hpp>
+#include <togo/core/filesystem/file_watcher.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <poll.h>
+
+#if defined(TOGO_PLATFORM_LINUX)
+	#include <sys/inotify.h>
+#endif
+
+namespace togo {
+
+struct PosixFileWatcherRoot {
+	struct PollStamp {
+		u64 time;
+		u64 size;
+	};
+
+	bool ignore_dotfiles;
+	// With a trailing slash
+	Array<char> path;
+
+	// Last scan when polling
+	DirectoryListing listing;
+	Array<PollStamp> stamps;
+	HashMap<hash64, u32> lookup;
+
+	PosixFileWatcherRoot(Allocator& allocator)
+		: ignore_dotfiles(false)
+		, path(allocator)
+		, listing(allocator)
+		, stamps(allocator)
+		, lookup(allocator)
+	{}
+};
+
+struct PosixFileWatcherDir {
+	u32 root;
+	signed wd;
+	// Relative to the root, with a trailing slash unless it is the root
+	Array<char> path;
+
+	PosixFileWatcherDir(Allocator& allocator)
+		: root(0)
+		, wd(-1)
+		, path(allocator)
+	{}
+};
+
+PosixFileWatcherImpl::PosixFileWatcherImpl(Allocator& allocator)
+	: fd(-1)
+	, overflowed(false)
+	, roots(allocator)
+	, dirs(allocator)
+	, records(allocator)
+	, record_lookup(allocator)
+	, move_froms(allocator)
+{}
+
+namespace {
+
+using Root = PosixFileWatcherRoot;
+using Dir = PosixFileWatcherDir;
+using Record = PosixFileWatcherImpl::Record;
+using EventType = FileWatchEvent::Type;
+
+enum : unsigned {
+	// Limits how long a constant stream of changes can extend a batch
+	SETTLE_MAX_ROUNDS = 100,
+};
+
+inline Allocator& watcher_allocator(FileWatcher& watcher) {
+	return *watcher._events._allocator;
+}
+
+inline hash64 path_key(u32 const root, StringRef const& path) {
+	hash::Default64 hasher{};
+	hash::add(hasher, reinterpret_cast<u8 const*>(&root), sizeof(root));
+	hash::add(hasher, path);
+	return hash::value(hasher);
+}
+
+inline StringRef record_path(FileWatcher const& watcher, u32 const offset, u32 const size) {
+	return {array::begin(watcher._paths) + offset, size};
+}
+
+inline StringRef entry_name(DirectoryEntry const& entry) {
+	// Directory entries have a trailing slash
+	return {
+		entry.path.data,
+		entry.path.size - (entry.type == DirectoryEntry::Type::dir)
+	};
+}
+
+// dst = a + b, NUL-terminated
+static void join_path(Array<char>& dst, StringRef const& a, StringRef const& b) {
+	string::copy(dst, a);
+	string::append(dst, b);
+}
+
+// Append prefix + name (+ a slash for directories) to the path buffer.
+// Neither may refer to the path buffer. The root itself has an empty
+// path.
+static Record make_record(
+	FileWatcher& watcher,
+	EventType const type,
+	DirectoryEntry::Type const entry_type,
+	u32 const root,
+	StringRef const& prefix,
+	StringRef const& name
+) {
+	bool const is_dir =
+		entry_type == DirectoryEntry::Type::dir &&
+		prefix.size + name.size > 0
+	;
+	Record record{};
+	record.type = static_cast<u32>(type);
+	record.entry_type = static_cast<u32>(entry_type);
+	record.root = root;
+	record.path_offset = array::size(watcher._paths);
+	record.path_size = prefix.size + name.size + is_dir;
+	array::increase_size(watcher._paths, record.path_size + 1);
+	char* p = array::begin(watcher._paths) + record.path_offset;
+	if (prefix.size > 0) {
+		std::memcpy(p, prefix.data, prefix.size);
+		p += prefix.size;
+	}
+	if (name.size > 0) {
+		std::memcpy(p, name.data, name.size);
+		p += name.size;
+	}
+	if (is_dir) {
+		*p++ = '/';
+	}
+	*p = '\0';
+	return record;
+}
+
+// Add a record, coalescing it with an earlier record for the same path
+static void add_record(FileWatcher& watcher, Record record) {
+	auto& impl = watcher._impl;
+	auto const type = static_cast<EventType>(record.type);
+	hash64 const key = path_key(
+		record.root,
+		record_path(watcher, record.path_offset, record.path_size)
+	);
+	u32 const* const existing_index = hash_map::find(impl.record_lookup, key);
+	if (existing_index) {
+		Record& existing = impl.records[*existing_index];
+		auto const existing_type = static_cast<EventType>(existing.type);
+		bool const is_file = record.entry_type == static_cast<u32>(DirectoryEntry::Type::file);
+		if (existing.entry_type != record.entry_type) {
+			// Replaced by a different kind of entry
+		} else if (type == EventType::modify || type == EventType::overflow) {
+			if (existing_type != EventType::remove) {
+				return;
+			}
+		} else if (type == EventType::create) {
+			if (existing_type == EventType::create) {
+				return;
+			} else if (existing_type == EventType::remove && is_file) {
+				existing.type = static_cast<u32>(EventType::modify);
+				return;
+			}
+		} else if (type == EventType::remove) {
+			if (existing_type == EventType::create) {
+				existing.dropped = true;
+				hash_map::remove(impl.record_lookup, key);
+				return;
+			} else if (existing_type == EventType::modify) {
+				existing.type = static_cast<u32>(EventType::remove);
+				return;
+			}
+		}
+	}
+	if (type == EventType::move) {
+		// A temporary file that is moved into place is just a creation
+		hash64 const from_key = path_key(
+			record.root,
+			record_path(watcher, record.from_offset, record.from_size)
+		);
+		u32 const* const from_index = hash_map::find(impl.record_lookup, from_key);
+		if (
+			from_index &&
+			impl.records[*from_index].type == static_cast<u32>(EventType::create)
+		) {
+			impl.records[*from_index].dropped = true;
+			hash_map::remove(impl.record_lookup, from_key);
+			record.type = static_cast<u32>(EventType::create);
+			record.from_offset = 0;
+			record.from_size = 0;
+		}
+	}
+	hash_map::set(impl.record_lookup, key, static_cast<u32>(array::size(impl.records)));
+	array::push_back(impl.records, record);
+}
+
+inline void add_event(
+	FileWatcher& watcher,
+	EventType const type,
+	DirectoryEntry::Type const entry_type,
+	u32 const root,
+	StringRef const& prefix,
+	StringRef const& name
+) {
+	add_record(watcher, make_record(watcher, type, entry_type, root, prefix, name));
+}
+
+// Normalize a root path to have a single trailing slash
+static void set_root_path(Root& root, StringRef const& path) {
+	string::copy(root.path, path);
+	array::resize(
+		root.path,
+		string::trim_trailing_slashes(array::begin(root.path), string::size(root.path))
+	);
+	array::push_back(root.path, '/');
+	array::push_back(root.path, '\0');
+}
+
+// Scan a root and compare it to the last scan
+static bool poll_root(FileWatcher& watcher, u32 const root_index, bool const add_events) {
+	auto& allocator = watcher_allocator(watcher);
+	Root& root = *watcher._impl.roots[root_index];
+	DirectoryListing listing{allocator};
+	Array<Root::PollStamp> stamps{allocator};
+	HashMap<hash64, u32> lookup{allocator};
+	bool const opened = directory_reader::scan(
+		listing, root.path, false, true, root.ignore_dotfiles, DirectoryEntry::Type::all
+	);
+
+	unsigned const num_entries = array::size(listing.entries);
+	array::resize(stamps, num_entries);
+	hash_map::reserve(lookup, num_entries);
+	Array<char> path{allocator};
+	struct ::stat stat_buf;
+	for (unsigned i = 0; i < num_entries; ++i) {
+		auto const entry = directory_reader::entry(listing, i);
+		stamps[i] = {0, 0};
+		if (entry.type == DirectoryEntry::Type::file) {
+			join_path(path, root.path, entry.path);
+			if (::stat(array::begin(path), &stat_buf) == 0) {
+			#if defined(TOGO_PLATFORM_LINUX)
+				stamps[i].time
+					= static_cast<u64>(stat_buf.st_mtim.tv_sec) * 1000000000u
+					+ static_cast<u64>(stat_buf.st_mtim.tv_nsec)
+				;
+			#else
+				stamps[i].time = static_cast<u64>(stat_buf.st_mtime);
+			#endif
+				stamps[i].size = static_cast<u64>(stat_buf.st_size);
+			}
+		}
+		hash_map::set(lookup, path_key(root_index, entry.path), i);
+	}
+
+	if (add_events) {
+		unsigned const num_prev = array::size(root.listing.entries);
+		for (unsigned i = 0; i < num_prev; ++i) {
+			auto const entry = directory_reader::entry(root.listing, i);
+			u32 const* const index = hash_map::find(lookup, path_key(root_index, entry.path));
+			if (!index || listing.entries[*index].type != entry.type) {
+				add_event(watcher, EventType::remove, entry.type, root_index, "", entry_name(entry));
+			}
+		}
+		for (unsigned i = 0; i < num_entries; ++i) {
+			auto const entry = directory_reader::entry(listing, i);
+			u32 const* const index = hash_map::find(root.lookup, path_key(root_index, entry.path));
+			if (!index || root.listing.entries[*index].type != entry.type) {
+				add_event(watcher, EventType::create, entry.type, root_index, "", entry_name(entry));
+			} else if (
+				entry.type == DirectoryEntry::Type::file && (
+					root.stamps[*index].time != stamps[i].time ||
+					root.stamps[*index].size != stamps[i].size
+				)
+			) {
+				add_event(watcher, EventType::modify, entry.type, root_index, "", entry_name(entry));
+			}
+		}
+	}
+	root.listing = rvalue_ref(listing);
+	root.stamps = rvalue_ref(stamps);
+	root.lookup = rvalue_ref(lookup);
+	return opened;
+}
+
+#if defined(TOGO_PLATFORM_LINUX)
+
+enum : u32 {
+	INOTIFY_MASK
+		= IN_CREATE | IN_DELETE | IN_MODIFY | IN_CLOSE_WRITE
+		| IN_MOVED_FROM | IN_MOVED_TO
+		| IN_ONLYDIR | IN_DONT_FOLLOW | IN_EXCL_UNLINK
+	,
+	INOTIFY_BUFFER_SIZE = 16 * 1024,
+};
+
+// Watch a directory. path is relative to the root.
+static bool watch_dir(FileWatcher& watcher, u32 const root_index, StringRef const& path) {
+	auto& impl = watcher._impl;
+	auto& allocator = watcher_allocator(watcher);
+	Array<char> full_path{allocator};
+	join_path(full_path, impl.roots[root_index]->path, path);
+	signed const wd = ::inotify_add_watch(impl.fd, array::begin(full_path), INOTIFY_MASK);
+	if (wd == -1) {
+		TOGO_LOG_DEBUGF(
+			"file_watcher: inotify_add_watch() failed; ignoring directory;"
+			" errno = %d, %s\n",
+			errno, std::strerror(errno)
+		);
+		return false;
+	}
+	Dir** const existing = hash_map::find(impl.dirs, static_cast<hash32>(wd));
+	Dir* dir = existing ? *existing : nullptr;
+	if (!dir) {
+		dir = TOGO_CONSTRUCT(allocator, Dir, allocator);
+		dir->wd = wd;
+		hash_map::push(impl.dirs, static_cast<hash32>(wd), dir);
+	}
+	dir->root = root_index;
+	string::copy(dir->path, path);
+	return true;
+}
+
+// Watch a directory and its subdirectories, optionally adding create
+// events for everything within it
+static bool watch_tree(
+	FileWatcher& watcher,
+	u32 const root_index,
+	StringRef const& path,
+	bool const add_events
+) {
+	if (!watch_dir(watcher, root_index, path)) {
+		return false;
+	}
+	auto& allocator = watcher_allocator(watcher);
+	Root const& root = *watcher._impl.roots[root_index];
+	Array<char> scan_path{allocator};
+	join_path(scan_path, root.path, path);
+	DirectoryListing listing{allocator};
+	directory_reader::scan(
+		listing, scan_path, false, true, root.ignore_dotfiles, DirectoryEntry::Type::all
+	);
+	Array<char> sub_path{allocator};
+	for (unsigned i = 0; i < array::size(listing.entries); ++i) {
+		auto const entry = directory_reader::entry(listing, i);
+		if (entry.type == DirectoryEntry::Type::dir) {
+			join_path(sub_path, path, entry.path);
+			watch_dir(watcher, root_index, sub_path);
+		}
+		if (add_events) {
+			add_event(watcher, EventType::create, entry.type, root_index, path, entry_name(entry));
+		}
+	}
+	return true;
+}
+
+inline bool has_prefix(Dir const& dir, u32 const root, StringRef const& prefix) {
+	return
+		dir.root == root &&
+		string::size(dir.path) >= prefix.size &&
+		std::memcmp(array::begin(dir.path), prefix.data, prefix.size) == 0
+	;
+}
+
+// Stop watching a directory and its subdirectories
+static void unwatch_tree(FileWatcher& watcher, u32 const root, StringRef const& path) {
+	auto& impl = watcher._impl;
+	auto& allocator = watcher_allocator(watcher);
+	Array<hash32> wds{allocator};
+	for (auto const& node : impl.dirs) {
+		if (has_prefix(*node.value, root, path)) {
+			array::push_back(wds, node.key);
+		}
+	}
+	for (hash32 const wd : wds) {
+		Dir* const dir = *hash_map::find(impl.dirs, wd);
+		(void)(::inotify_rm_watch(impl.fd, static_cast<signed>(wd)));
+		TOGO_DESTROY(allocator, dir);
+		hash_map::remove(impl.dirs, wd);
+	}
+}
+
+// Update the paths of a moved directory and its subdirectories
+static void move_tree(
+	FileWatcher& watcher,
+	u32 const root,
+	StringRef const& from_path,
+	StringRef const& to_path
+) {
+	Array<char> path{watcher_allocator(watcher)};
+	for (auto& node : watcher._impl.dirs) {
+		Dir& dir = *node.value;
+		if (has_prefix(dir, root, from_path)) {
+			StringRef const rest{
+				array::begin(dir.path) + from_path.size,
+				string::size(dir.path) - from_path.size
+			};
+			join_path(path, to_path, rest);
+			string::copy(dir.path, path);
+		}
+	}
+}
+
+static void finish_move_from(FileWatcher& watcher, Record const& record) {
+	if (record.entry_type == static_cast<u32>(DirectoryEntry::Type::dir)) {
+		unwatch_tree(
+			watcher, record.root,
+			record_path(watcher, record.path_offset, record.path_size)
+		);
+	}
+	add_record(watcher, record);
+}
+
+static void handle_notification(FileWatcher& watcher, struct ::inotify_event const& ev) {
+	auto& impl = watcher._impl;
+	if (ev.mask & IN_Q_OVERFLOW) {
+		impl.overflowed = true;
+		for (unsigned i = 0; i < array::size(impl.roots); ++i) {
+			add_event(watcher, EventType::overflow, DirectoryEntry::Type::dir, i, "", "");
+		}
+		return;
+	}
+
+	Dir** const dir_ptr = hash_map::find(impl.dirs, static_cast<hash32>(ev.wd));
+	if (!dir_ptr) {
+		return;
+	}
+	Dir& dir = **dir_ptr;
+	if (ev.mask & IN_IGNORED) {
+		// Watch was removed by the kernel
+		Dir* const dir_removed = &dir;
+		hash_map::remove(impl.dirs, static_cast<hash32>(ev.wd));
+		TOGO_DESTROY(watcher_allocator(watcher), dir_removed);
+		return;
+	} else if (ev.len == 0) {
+		return;
+	}
+
+	u32 const root_index = dir.root;
+	Root const& root = *impl.roots[root_index];
+	StringRef const name{ev.name, cstr_tag{}};
+	if (root.ignore_dotfiles && name[0] == '.') {
+		return;
+	}
+	bool const is_dir = ev.mask & IN_ISDIR;
+	auto const entry_type = is_dir ? DirectoryEntry::Type::dir : DirectoryEntry::Type::file;
+	Array<char> prefix{watcher_allocator(watcher)};
+	string::copy(prefix, dir.path);
+
+	if (ev.mask & IN_CREATE) {
+		Record const record = make_record(watcher, EventType::create, entry_type, root_index, prefix, name);
+		add_record(watcher, record);
+		if (is_dir) {
+			Array<char> path{watcher_allocator(watcher)};
+			string::copy(path, record_path(watcher, record.path_offset, record.path_size));
+			watch_tree(watcher, root_index, path, true);
+		}
+	} else if (ev.mask & (IN_MODIFY | IN_CLOSE_WRITE)) {
+		if (!is_dir) {
+			add_event(watcher, EventType::modify, entry_type, root_index, prefix, name);
+		}
+	} else if (ev.mask & IN_DELETE) {
+		// Watches on directories are removed by the kernel
+		add_event(watcher, EventType::remove, entry_type, root_index, prefix, name);
+	} else if (ev.mask & IN_MOVED_FROM) {
+		array::push_back(impl.move_froms, PosixFileWatcherImpl::MoveFrom{
+			ev.cookie,
+			make_record(watcher, EventType::remove, entry_type, root_index, prefix, name)
+		});
+	} else if (ev.mask & IN_MOVED_TO) {
+		Record record = make_record(watcher, EventType::create, entry_type, root_index, prefix, name);
+		unsigned i = 0;
+		for (; i < array::size(impl.move_froms); ++i) {
+			if (impl.move_froms[i].cookie == ev.cookie) {
+				break;
+			}
+		}
+		if (i < array::size(impl.move_froms)) {
+			Record const from = impl.move_froms[i].record;
+			array::remove_over(impl.move_froms, i);
+			if (from.root == root_index && from.entry_type == record.entry_type) {
+				record.type = static_cast<u32>(EventType::move);
+				record.from_offset = from.path_offset;
+				record.from_size = from.path_size;
+				if (is_dir) {
+					Array<char> from_path{watcher_allocator(watcher)};
+					Array<char> to_path{watcher_allocator(watcher)};
+					string::copy(from_path, record_path(watcher, from.path_offset, from.path_size));
+					string::copy(to_path, record_path(watcher, record.path_offset, record.path_size));
+					move_tree(watcher, root_index, from_path, to_path);
+				}
+				add_record(watcher, record);
+				return;
+			}
+			// Moved between roots
+			finish_move_from(watcher, from);
+		}
+		add_record(watcher, record);
+		if (is_dir) {
+			Array<char> path{watcher_allocator(watcher)};
+			string::copy(path, record_path(watcher, record.path_offset, record.path_size));
+			watch_tree(watcher, root_index, path, true);
+		}
+	}
+}
+
+static void read_notifications(FileWatcher& watcher) {
+	alignas(struct ::inotify_event) char buffer[INOTIFY_BUFFER_SIZE];
+	ssize_t size;
+	while ((size = ::read(watcher._impl.fd, buffer, sizeof(buffer))) > 0) {
+		for (char const* p = buffer; p < buffer + size;) {
+			auto const& ev = *reinterpret_cast<struct ::inotify_event const*>(p);
+			p += sizeof(struct ::inotify_event) + ev.len;
+			handle_notification(watcher, ev);
+		}
+	}
+}
+
+#endif // defined(TOGO_PLATFORM_LINUX)
+
+} // anonymous namespace
+
+FileWatcher::~FileWatcher() {
+	file_watcher::clear(*this);
+	if (_impl.fd != -1) {
+		(void)(::close(_impl.fd));
+	}
+}
+
+FileWatcher::FileWatcher(Allocator& allocator, bool const polling)
+	: _polling(polling)
+	, _events(allocator)
+	, _paths(allocator)
+	, _impl(allocator)
+{
+#if defined(TOGO_PLATFORM_LINUX)
+	if (!_polling) {
+		_impl.fd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+		if (_impl.fd == -1) {
+			TOGO_LOG_DEBUGF(
+				"file_watcher: inotify_init1() failed; polling instead;"
+				" errno = %d, %s\n",
+				errno, std::strerror(errno)
+			);
+			_polling = true;
+		}
+	}
+#else
+	_polling = true;
+#endif
+}
+
+unsigned file_watcher::num_roots(FileWatcher const& watcher) {
+	return array::size(watcher._impl.roots);
+}
+
+bool file_watcher::add_root(
+	FileWatcher& watcher,
+	StringRef const& path,
+	bool const ignore_dotfiles
+) {
+	auto& impl = watcher._impl;
+	auto& allocator = watcher_allocator(watcher);
+	u32 const root_index = array::size(impl.roots);
+	Root* const root = TOGO_CONSTRUCT(allocator, Root, allocator);
+	root->ignore_dotfiles = ignore_dotfiles;
+	set_root_path(*root, path);
+	array::push_back(impl.roots, root);
+	if (watcher._polling) {
+		return poll_root(watcher, root_index, false);
+	}
+#if defined(TOGO_PLATFORM_LINUX)
+	return watch_tree(watcher, root_index, "", false);
+#else
+	return false;
+#endif
+}
+
+void file_watcher::clear(FileWatcher& watcher) {
+	auto& impl = watcher._impl;
+	auto& allocator = watcher_allocator(watcher);
+	for (auto const& node : impl.dirs) {
+		Dir* const dir = node.value;
+	#if defined(TOGO_PLATFORM_LINUX)
+		(void)(::inotify_rm_watch(impl.fd, dir->wd));
+	#endif
+		TOGO_DESTROY(allocator, dir);
+	}
+	for (Root* const root : impl.roots) {
+		TOGO_DESTROY(allocator, root);
+	}
+	hash_map::clear(impl.dirs);
+	array::clear(impl.roots);
+	array::clear(impl.records);
+	hash_map::clear(impl.record_lookup);
+	array::clear(impl.move_froms);
+	impl.overflowed = false;
+	array::clear(watcher._events);
+	array::clear(watcher._paths);
+}
+
+ArrayRef<FileWatchEvent const> file_watcher::poll(
+	FileWatcher& watcher,
+	unsigned const timeout_ms
+) {
+	auto& impl = watcher._impl;
+	array::clear(watcher._events);
+	array::clear(watcher._paths);
+	array::clear(impl.records);
+	hash_map::clear(impl.record_lookup);
+
+	if (watcher._polling) {
+		f64 const end = system::time_monotonic() + static_cast<f64>(timeout_ms) / 1000.0;
+		while (true) {
+			for (unsigned i = 0; i < array::size(impl.roots); ++i) {
+				poll_root(watcher, i, true);
+			}
+			f64 const remaining = end - system::time_monotonic();
+			if (array::any(impl.records) || remaining <= 0.0) {
+				break;
+			}
+			system::sleep_ms(min(
+				unsigned{file_watcher::POLL_INTERVAL_MS},
+				static_cast<unsigned>(remaining * 1000.0) + 1
+			));
+		}
+	} else {
+	#if defined(TOGO_PLATFORM_LINUX)
+		struct ::pollfd pfd{impl.fd, POLLIN, 0};
+		if (::poll(&pfd, 1, static_cast<signed>(timeout_ms)) > 0) {
+			unsigned round = 0;
+			do {
+				read_notifications(watcher);
+			} while (
+				++round < SETTLE_MAX_ROUNDS &&
+				::poll(&pfd, 1, signed{file_watcher::SETTLE_MS}) > 0
+			);
+			for (auto const& move_from : impl.move_froms) {
+				finish_move_from(watcher, move_from.record);
+			}
+			array::clear(impl.move_froms);
+			if (impl.overflowed) {
+				// Directories created while events were lost are not
+				// watched yet
+				impl.overflowed = false;
+				for (unsigned i = 0; i < array::size(impl.roots); ++i) {
+					watch_tree(watcher, i, "", false);
+				}
+			}
+		}
+	#endif
+	}
+
+	for (auto const& record : impl.records) {
+		if (record.dropped) {
+			continue;
+		}
+		array::push_back(watcher._events, FileWatchEvent{
+			static_cast<EventType>(record.type),
+			static_cast<DirectoryEntry::Type>(record.entry_type),
+			record.root,
+			record_path(watcher, record.path_offset, record.path_size),
+			record.from_size > 0
+				? record_path(watcher, record.from_offset, record.from_size)
+				: StringRef{}
+		});
+	}
+	return watcher._events;
+}
+
+} // namespace togo
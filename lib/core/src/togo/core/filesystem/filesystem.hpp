@@ -98,8 +98,19 @@ bool move_file(StringRef src, StringRef dest);
 /// Copy a file.
 ///
 /// Unless overwrite == true, this will fail if the destination already exists.
+/// Data is copied within the kernel where possible, and shared with the
+/// source on filesystems that support it (e.g., btrfs and XFS).
 bool copy_file(StringRef src, StringRef dest, bool overwrite = false);
 
+/// Map a file into memory for reading.
+///
+/// Any previous mapping in file is unmapped. An empty file maps to
+/// no data.
+bool map_file(MappedFile& file, StringRef path);
+
+/// Unmap a file.
+void unmap_file(MappedFile& file);
+
 /// Create a directory.
 ///
 /// Unless accept_exists == true, this will fail if the directory already
@@ -117,6 +128,17 @@ bool remove_directory(StringRef path, bool accept_nonexistent = false);
 
 } // namespace filesystem
 
+/// Unmaps the file.
+inline MappedFile::~MappedFile() {
+	filesystem::unmap_file(*this);
+}
+
+/// Construct unmapped.
+inline MappedFile::MappedFile()
+	: data(nullptr)
+	, size(0)
+{}
+
 /// Resets the working directory to its pre-initialization path.
 inline WorkingDirScope::~WorkingDirScope() {
 	TOGO_ASSERTE(filesystem::set_working_dir(_prev_path));
@@ -22,7 +22,11 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/sendfile.h>
+#include <sys/mman.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
 #include <fcntl.h>
+#include <linux/fs.h>
 
 namespace togo {
 
@@ -265,13 +269,78 @@ bool filesystem::move_file(StringRef src, StringRef dest) {
 	return true;
 }
 
+// Share the source's extents with the destination (reflink).
+// Only supported by some filesystems (e.g., btrfs and XFS).
+inline static bool clone_file_data(signed fd_dest, signed fd_src) {
+#if defined(FICLONE)
+	return ::ioctl(fd_dest, FICLONE, fd_src) == 0;
+#else
+	(void)fd_dest;
+	(void)fd_src;
+	return false;
+#endif
+}
+
+// Copy within the kernel with copy_file_range(), falling back to
+// sendfile() where it is unsupported (e.g., across filesystems before
+// Linux 5.3).
+static bool copy_file_data(signed fd_dest, signed fd_src, off_t const size) {
+	off_t offset = 0;
+#if defined(SYS_copy_file_range)
+	while (offset < size) {
+		auto const copied = ::syscall(
+			SYS_copy_file_range,
+			fd_src, nullptr, fd_dest, nullptr,
+			static_cast<size_t>(size - offset), 0u
+		);
+		if (copied > 0) {
+			offset += copied;
+			continue;
+		} else if (copied == 0) {
+			// Source shrank or its filesystem doesn't report data
+			break;
+		} else if (errno == EINTR) {
+			continue;
+		} else if (
+			errno == ENOSYS || errno == EXDEV ||
+			errno == EINVAL || errno == EOPNOTSUPP
+		) {
+			break;
+		}
+		TOGO_LOG_DEBUGF(
+			"copy_file: copy_file_range(src, dest): errno = %d, %s\n",
+			errno, std::strerror(errno)
+		);
+		return false;
+	}
+#endif
+
+	// Both file positions are at offset
+	while (offset < size) {
+		auto const written = ::sendfile(fd_dest, fd_src, &offset, size - offset);
+		if (written == 0) {
+			// Source shrank
+			break;
+		} else if (written == -1) {
+			if (errno == EAGAIN || errno == EINTR) {
+				continue;
+			}
+			TOGO_LOG_DEBUGF(
+				"copy_file: sendfile(dest, src): errno = %d, %s\n",
+				errno, std::strerror(errno)
+			);
+			return false;
+		}
+	}
+	return true;
+}
+
 bool filesystem::copy_file(StringRef src, StringRef dest, bool overwrite) {
 	bool success = false;
 	signed fd_src, fd_dest;
 	struct ::stat stat_buf{};
 	mode_t mode = 0;
 	off_t size = 0;
-	off_t offset = 0;
 
 	fd_src = ::open(filesystem::to_cstring(src).data, O_RDONLY);
 	if (fd_src == -1) {
@@ -313,21 +382,11 @@ bool filesystem::copy_file(StringRef src, StringRef dest, bool overwrite) {
 		}
 	}
 
-	while (offset != size) {
-		auto written = ::sendfile(fd_dest, fd_src, &offset, size - offset);
-		if (written == -1) {
-			if (errno == EAGAIN) {
-				continue;
-			}
-			TOGO_LOG_DEBUGF(
-				"copy_file: sendfile(dest, src): errno = %d, %s\n",
-				errno, std::strerror(errno)
-			);
-			goto l_close;
-		}
-	}
-
-	success = true;
+	success =
+		size == 0 ||
+		clone_file_data(fd_dest, fd_src) ||
+		copy_file_data(fd_dest, fd_src, size)
+	;
 
 l_close:
 	if (::close(fd_dest) != 0) {
@@ -349,6 +408,64 @@ l_exit:
 	return success;
 }
 
+bool filesystem::map_file(MappedFile& file, StringRef path) {
+	filesystem::unmap_file(file);
+	bool success = false;
+	struct ::stat stat_buf{};
+	void* data;
+	signed const fd = ::open(filesystem::to_cstring(path).data, O_RDONLY);
+	if (fd == -1) {
+		TOGO_LOG_DEBUGF(
+			"map_file: open: errno = %d, %s\n",
+			errno, std::strerror(errno)
+		);
+		goto l_exit;
+	}
+	if (!fstat_wrapper(fd, stat_buf)) {
+		goto l_close;
+	}
+	if (stat_buf.st_size == 0) {
+		success = true;
+		goto l_close;
+	}
+
+	data = ::mmap(nullptr, stat_buf.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	if (data == MAP_FAILED) {
+		TOGO_LOG_DEBUGF(
+			"map_file: mmap: errno = %d, %s\n",
+			errno, std::strerror(errno)
+		);
+		goto l_close;
+	}
+	file.data = static_cast<u8 const*>(data);
+	file.size = static_cast<u64>(stat_buf.st_size);
+	success = true;
+
+l_close:
+	if (::close(fd) != 0) {
+		TOGO_LOG_DEBUGF(
+			"map_file: close: errno = %d, %s\n",
+			errno, std::strerror(errno)
+		);
+	}
+
+l_exit:
+	return success;
+}
+
+void filesystem::unmap_file(MappedFile& file) {
+	if (file.data) {
+		if (::munmap(const_cast<u8*>(file.data), file.size) != 0) {
+			TOGO_LOG_DEBUGF(
+				"unmap_file: munmap: errno = %d, %s\n",
+				errno, std::strerror(errno)
+			);
+		}
+		file.data = nullptr;
+		file.size = 0;
+	}
+}
+
 bool filesystem::create_directory(StringRef path, bool accept_exists) {
 	path = filesystem::to_cstring(path);
 	if (accept_exists && filesystem::is_directory(path)) {
@@ -24,6 +24,12 @@
 	#error "missing DirectoryReader implementation for target platform"
 #endif
 
+#if defined(TOGO_PLATFORM_IS_POSIX)
+	#include <togo/core/filesystem/file_watcher/posix.hpp>
+#else
+	#error "missing FileWatcher implementation for target platform"
+#endif
+
 namespace togo {
 
 /**
@@ -77,6 +83,99 @@ struct DirectoryReader {
 	~DirectoryReader();
 };
 
+/// Bulk directory listing.
+///
+/// Entry paths are NUL-terminated and packed into paths.
+struct DirectoryListing {
+	struct Entry {
+		DirectoryEntry::Type type;
+		u32 offset;
+		u32 size;
+	};
+
+	Array<Entry> entries;
+	Array<char> paths;
+
+	DirectoryListing() = delete;
+	DirectoryListing(DirectoryListing const&) = delete;
+	DirectoryListing& operator=(DirectoryListing const&) = delete;
+
+	DirectoryListing(DirectoryListing&&) = default;
+	DirectoryListing& operator=(DirectoryListing&&) = default;
+
+	~DirectoryListing() = default;
+	DirectoryListing(Allocator& allocator);
+};
+
+/// File watch event.
+struct FileWatchEvent {
+	enum class Type : unsigned {
+		/// Entry was created or moved into the tree.
+		create,
+		/// File contents were modified.
+		modify,
+		/// Entry was moved within the tree.
+		move,
+		/// Entry was removed or moved out of the tree.
+		remove,
+		/// Events were lost; the root should be rescanned.
+		overflow,
+	};
+
+	Type type;
+	DirectoryEntry::Type entry_type;
+	u32 root;
+
+	/// Path relative to the root.
+	///
+	/// Directory paths end with a slash. This is empty for overflow
+	/// events.
+	StringRef path;
+
+	/// Previous path of a moved entry.
+	StringRef from_path;
+};
+
+/// File watcher.
+///
+/// Watches directory trees for changes.
+struct FileWatcher {
+	bool _polling;
+	Array<FileWatchEvent> _events;
+	Array<char> _paths;
+	FileWatcherImpl _impl;
+
+	FileWatcher() = delete;
+	FileWatcher(FileWatcher&&) = delete;
+	FileWatcher(FileWatcher const&) = delete;
+	FileWatcher& operator=(FileWatcher&&) = delete;
+	FileWatcher& operator=(FileWatcher const&) = delete;
+
+	~FileWatcher();
+
+	/// Construct with an allocator.
+	///
+	/// If polling is true or change notifications are not supported,
+	/// the watcher will poll the filesystem for changes.
+	FileWatcher(Allocator& allocator, bool polling = false);
+};
+
+/// Read-only memory-mapped file.
+///
+/// The file is unmapped when the object dies.
+struct MappedFile {
+	u8 const* data;
+	u64 size;
+
+	MappedFile(MappedFile&&) = delete;
+	MappedFile(MappedFile const&) = delete;
+	MappedFile& operator=(MappedFile&&) = delete;
+	MappedFile& operator=(MappedFile const&) = delete;
+
+	~MappedFile();
+	MappedFile();
+};
+
 /** @cond INTERNAL */
 template<>
 struct enable_enum_bitwise_ops<DirectoryEntry::Type> : true_type {};
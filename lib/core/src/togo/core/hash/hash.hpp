@@ -11,11 +11,11 @@
 
 #include <togo/core/config.hpp>
 #include <togo/core/types.hpp>
+#include <togo/core/utility/endian.hpp>
 #include <togo/core/string/string.hpp>
 #include <togo/core/hash/types.hpp>
 
-// TODO: Build constexpr version of MurmurHash2 or MurmurHash3
-// (both lengths) and use it instead of FNV-1a
+#include <cstring>
 
 namespace togo {
 
@@ -135,6 +135,224 @@ constexpr typename FNV1a<S>::Value FNV1a<S>::calc_ce(
 	;
 }
 
+namespace {
+
+struct XXH64Internals {
+	static constexpr u64 const prime1 = 0x9E3779B185EBCA87;
+	static constexpr u64 const prime2 = 0xC2B2AE3D27D4EB4F;
+	static constexpr u64 const prime3 = 0x165667B19E3779F9;
+	static constexpr u64 const prime4 = 0x85EBCA77C2B2AE63;
+	static constexpr u64 const prime5 = 0x27D4EB2F165667C5;
+
+	static constexpr u64 rotl(u64 const x, unsigned const r) {
+		return (x << r) | (x >> (64 - r));
+	}
+
+	static constexpr u64 round(u64 const acc, u64 const input) {
+		return rotl(acc + input * prime2, 31) * prime1;
+	}
+
+	static constexpr u64 merge(u64 const acc, u64 const value) {
+		return (acc ^ round(0, value)) * prime1 + prime4;
+	}
+
+	static constexpr u64 converge(u64 const v1, u64 const v2, u64 const v3, u64 const v4) {
+		return merge(merge(merge(merge(
+			rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18),
+			v1), v2), v3), v4
+		);
+	}
+
+	static constexpr u64 mix8(u64 const h, u64 const input) {
+		return rotl(h ^ round(0, input), 27) * prime1 + prime4;
+	}
+
+	static constexpr u64 mix4(u64 const h, u64 const input) {
+		return rotl(h ^ (input * prime1), 23) * prime2 + prime3;
+	}
+
+	static constexpr u64 mix1(u64 const h, u64 const input) {
+		return rotl(h ^ (input * prime5), 11) * prime1;
+	}
+
+	static constexpr u64 avalanche_final(u64 const h) {
+		return h ^ (h >> 32);
+	}
+
+	static constexpr u64 avalanche_mid(u64 const h) {
+		return avalanche_final((h ^ (h >> 29)) * prime3);
+	}
+
+	static constexpr u64 avalanche(u64 const h) {
+		return avalanche_mid((h ^ (h >> 33)) * prime2);
+	}
+
+	// constexpr reads are little-endian by construction
+
+	static constexpr u64 ce_byte(char const* const data, unsigned const i) {
+		return static_cast<u8>(data[i]);
+	}
+
+	static constexpr u64 ce_read32(char const* const data, unsigned const i) {
+		return
+			(ce_byte(data, i + 0) <<  0) |
+			(ce_byte(data, i + 1) <<  8) |
+			(ce_byte(data, i + 2) << 16) |
+			(ce_byte(data, i + 3) << 24)
+		;
+	}
+
+	static constexpr u64 ce_read64(char const* const data, unsigned const i) {
+		return ce_read32(data, i) | (ce_read32(data, i + 4) << 32);
+	}
+
+	static constexpr u64 ce_tail(
+		char const* const data, unsigned const size, unsigned const i, u64 const h
+	) {
+		return
+			(i + 8 <= size) ? ce_tail(data, size, i + 8, mix8(h, ce_read64(data, i)))
+			: (i + 4 <= size) ? ce_tail(data, size, i + 4, mix4(h, ce_read32(data, i)))
+			: (i < size) ? ce_tail(data, size, i + 1, mix1(h, ce_byte(data, i)))
+			: avalanche(h)
+		;
+	}
+
+	static constexpr u64 ce_stripes(
+		char const* const data, unsigned const size, unsigned const i,
+		u64 const v1, u64 const v2, u64 const v3, u64 const v4
+	) {
+		return (i + 32 <= size)
+			? ce_stripes(
+				data, size, i + 32,
+				round(v1, ce_read64(data, i +  0)),
+				round(v2, ce_read64(data, i +  8)),
+				round(v3, ce_read64(data, i + 16)),
+				round(v4, ce_read64(data, i + 24))
+			)
+			: ce_tail(data, size, i, converge(v1, v2, v3, v4) + size)
+		;
+	}
+
+	static u64 read64(u8 const* const data) {
+		u64 value;
+		std::memcpy(&value, data, sizeof(u64));
+		return reverse_bytes_copy_if(value, Endian::little);
+	}
+
+	static u32 read32(u8 const* const data) {
+		u32 value;
+		std::memcpy(&value, data, sizeof(u32));
+		return reverse_bytes_copy_if(value, Endian::little);
+	}
+
+	static void stripe(u64 (&acc)[4], u8 const* const data) {
+		acc[0] = round(acc[0], read64(data +  0));
+		acc[1] = round(acc[1], read64(data +  8));
+		acc[2] = round(acc[2], read64(data + 16));
+		acc[3] = round(acc[3], read64(data + 24));
+	}
+};
+
+} // anonymous namespace
+
+/// Initialize hasher.
+inline void init(XXH64& s) {
+	s.acc[0] = XXH64Internals::prime1 + XXH64Internals::prime2;
+	s.acc[1] = XXH64Internals::prime2;
+	s.acc[2] = 0;
+	s.acc[3] = 0 - XXH64Internals::prime1;
+	s.buffer_size = 0;
+	s.size = 0;
+}
+
+/// Initialize hasher.
+inline XXH64::XXH64() {
+	init(*this);
+}
+
+/// Add bytes to hasher.
+inline void add(
+	XXH64& s,
+	u8 const* data,
+	unsigned size
+) {
+	s.size += size;
+	if (s.buffer_size + size < 32) {
+		if (size > 0) {
+			std::memcpy(s.buffer + s.buffer_size, data, size);
+			s.buffer_size += size;
+		}
+		return;
+	}
+	if (s.buffer_size > 0) {
+		unsigned const fill = 32 - s.buffer_size;
+		std::memcpy(s.buffer + s.buffer_size, data, fill);
+		XXH64Internals::stripe(s.acc, s.buffer);
+		data += fill;
+		size -= fill;
+		s.buffer_size = 0;
+	}
+	for (; size >= 32; data += 32, size -= 32) {
+		XXH64Internals::stripe(s.acc, data);
+	}
+	if (size > 0) {
+		std::memcpy(s.buffer, data, size);
+		s.buffer_size = size;
+	}
+}
+
+/// Value of hasher.
+inline XXH64::Value value(XXH64 const& s) {
+	if (hash::empty(s)) {
+		return XXH64::identity;
+	}
+	u64 h = s.size >= 32
+		? XXH64Internals::converge(s.acc[0], s.acc[1], s.acc[2], s.acc[3])
+		: XXH64Internals::prime5
+	;
+	h += s.size;
+	u8 const* p = s.buffer;
+	u8 const* const e = s.buffer + s.buffer_size;
+	for (; p + 8 <= e; p += 8) {
+		h = XXH64Internals::mix8(h, XXH64Internals::read64(p));
+	}
+	if (p + 4 <= e) {
+		h = XXH64Internals::mix4(h, XXH64Internals::read32(p));
+		p += 4;
+	}
+	for (; p < e; ++p) {
+		h = XXH64Internals::mix1(h, *p);
+	}
+	return XXH64Internals::avalanche(h);
+}
+
+inline XXH64::Value XXH64::calc(
+	u8 const* const data,
+	unsigned const size
+) {
+	XXH64 s;
+	hash::add(s, data, size);
+	return hash::value(s);
+}
+
+constexpr XXH64::Value XXH64::calc_ce(
+	char const* const data,
+	unsigned const size
+) {
+	return size == 0
+		? XXH64::identity
+		: size >= 32
+		? XXH64Internals::ce_stripes(
+			data, size, 0,
+			XXH64Internals::prime1 + XXH64Internals::prime2,
+			XXH64Internals::prime2,
+			0,
+			0 - XXH64Internals::prime1
+		)
+		: XXH64Internals::ce_tail(data, size, 0, XXH64Internals::prime5 + size)
+	;
+}
+
 /// Add string to hasher.
 template<class H>
 inline void add(
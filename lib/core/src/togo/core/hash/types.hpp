@@ -94,6 +94,35 @@ struct FNV1a {
 	);
 };
 
+/// xxHash64 hasher.
+///
+/// This consumes input a word at a time and is much faster than
+/// FNV-1a on longer input. The seed is always 0.
+struct XXH64 {
+	using Value = hash64;
+
+	static constexpr Value const identity = 0;
+
+	u64 acc[4];
+	u8 buffer[32];
+	unsigned buffer_size;
+	unsigned size;
+
+	XXH64();
+
+	static Value
+	calc(
+		u8 const* const data,
+		unsigned const size
+	);
+
+	static constexpr Value
+	calc_ce(
+		char const* const data,
+		unsigned const size
+	);
+};
+
 /// Default hasher.
 template<hash::Size S>
 using Default = hash::FNV1a<S>;
@@ -0,0 +1,252 @@
+#line 2 "togo/core/io/async_io.cpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#include <togo/core/config.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/threading/condvar.hpp>
+#include <togo/core/threading/mutex.hpp>
+#include <togo/core/threading/thread.hpp>
+#include <togo/core/threading/task_manager.hpp>
+#include <togo/core/io/file_stream.hpp>
+#include <togo/core/io/async_io.hpp>
+
+#include <cstdio>
+
+namespace togo {
+
+namespace {
+
+enum : unsigned {
+	FLAG_SHUTDOWN = 1 << 0,
+};
+
+inline void finish(AsyncIORequest& request, bool const error) {
+	bool const short_transfer = request.transferred < request.size;
+	request.status.assign(
+		error || (request.op == AsyncIOOp::write && short_transfer),
+		request.op == AsyncIOOp::read && short_transfer
+	);
+}
+
+inline void notify(AsyncIORequest& request) {
+	if (request.callback) {
+		request.callback(request);
+	}
+	if (request.task_manager) {
+		task_manager::end_hold(*request.task_manager, request.task_id);
+	}
+}
+
+// Called with the mutex held; request must not be touched after this
+inline void release(AsyncIO& io) {
+	TOGO_DEBUG_ASSERTE(io._num_in_flight > 0);
+	--io._num_in_flight;
+	condvar::signal_all(io._signal, io._mutex);
+}
+
+inline void complete(AsyncIO& io, AsyncIORequest& request) {
+	notify(request);
+	MutexLock lock{io._mutex};
+	release(io);
+}
+
+} // anonymous namespace
+
+} // namespace togo
+
+#if defined(TOGO_PLATFORM_LINUX)
+	#include <togo/core/io/async_io/linux.ipp>
+#elif defined(TOGO_PLATFORM_IS_POSIX)
+	#include <togo/core/io/async_io/posix.ipp>
+#else
+	#error "missing AsyncIO implementation for target platform"
+#endif
+
+namespace togo {
+
+namespace {
+
+void* worker_func(void* const io_void) {
+	AsyncIO& io = *static_cast<AsyncIO*>(io_void);
+	MutexLock lock{io._mutex};
+	while (true) {
+		if (io._queue_head) {
+			AsyncIORequest& request = *io._queue_head;
+			io._queue_head = request._next;
+			if (!io._queue_head) {
+				io._queue_tail = nullptr;
+			}
+			mutex::unlock(io._mutex);
+			perform(request);
+			notify(request);
+			mutex::lock(io._mutex);
+			release(io);
+		} else if (io._flags & FLAG_SHUTDOWN) {
+			return nullptr;
+		} else {
+			condvar::wait(io._signal, lock);
+		}
+	}
+}
+
+} // anonymous namespace
+
+// class AsyncIO implementation
+
+AsyncIO::~AsyncIO() {
+	async_io::wait(*this);
+	{
+		MutexLock lock{_mutex};
+		_flags |= FLAG_SHUTDOWN;
+		if (_backend == AsyncIOBackend::kernel) {
+			kernel_push(*this, nullptr);
+			kernel_enter(*this, 1);
+		}
+		condvar::signal_all(_signal, lock);
+	}
+	for (Thread* const thread : _threads) {
+		thread::join(thread);
+	}
+	if (_backend == AsyncIOBackend::kernel) {
+		kernel_destroy(*this);
+	}
+}
+
+AsyncIO::AsyncIO(
+	unsigned const queue_depth,
+	unsigned num_workers,
+	Allocator& allocator,
+	AsyncIOBackend const backend
+)
+	: _impl()
+	, _mutex(MutexType::normal)
+	, _signal()
+	, _threads(allocator)
+	, _queue_head(nullptr)
+	, _queue_tail(nullptr)
+	, _backend(AsyncIOBackend::threads)
+	, _queue_depth(max(queue_depth, 1u))
+	, _num_in_flight(0)
+	, _flags(0)
+{
+	char name[32];
+	if (backend != AsyncIOBackend::threads && kernel_init(*this)) {
+		_backend = AsyncIOBackend::kernel;
+		std::snprintf(name, sizeof(name), "aio-%8p-reaper", static_cast<void*>(this));
+		array::push_back(_threads, thread::create(name, this, kernel_reap_func, allocator));
+		return;
+	}
+	num_workers = max(num_workers, 1u);
+	array::reserve(_threads, num_workers);
+	while (num_workers--) {
+		std::snprintf(name, sizeof(name), "aio-%8p-worker-%u", static_cast<void*>(this), num_workers);
+		array::push_back(_threads, thread::create(name, this, worker_func, allocator));
+	}
+}
+
+// interface async_io implementation
+
+/// Prepare a read request.
+///
+/// Reads size bytes at offset into data. The stream's position and
+/// buffer are not used.
+void async_io::set_read(
+	AsyncIORequest& request,
+	FileReader const& stream,
+	u64 const offset,
+	void* const data,
+	unsigned const size
+) {
+	TOGO_ASSERT(stream.is_open(), "stream must be open");
+	request = {};
+	request.op = AsyncIOOp::read;
+	request.handle = stream_handle(stream._data);
+	request.offset = offset;
+	request.data = data;
+	request.size = size;
+}
+
+/// Prepare a write request.
+///
+/// Writes size bytes from data at offset. The stream's position and
+/// buffer are not used, so any buffered data overlapping the write
+/// should be flushed first.
+void async_io::set_write(
+	AsyncIORequest& request,
+	FileWriter const& stream,
+	u64 const offset,
+	void const* const data,
+	unsigned const size
+) {
+	TOGO_ASSERT(stream.is_open(), "stream must be open");
+	request = {};
+	request.op = AsyncIOOp::write;
+	request.handle = stream_handle(stream._data);
+	request.offset = offset;
+	request.data = const_cast<void*>(data);
+	request.size = size;
+}
+
+/// Submit requests.
+///
+/// Requests are submitted together where the backend allows it.
+/// This blocks while the queue is full.
+void async_io::submit(
+	AsyncIO& io,
+	ArrayRef<AsyncIORequest* const> const& requests
+) {
+	bool const kernel = io._backend == AsyncIOBackend::kernel;
+	unsigned num_pushed = 0;
+	MutexLock lock{io._mutex};
+	for (AsyncIORequest* const request : requests) {
+		TOGO_DEBUG_ASSERTE(request);
+		request->status.clear();
+		request->transferred = 0;
+		request->_next = nullptr;
+		while (io._num_in_flight == io._queue_depth) {
+			// Pushed entries must be in the kernel before waiting on them
+			if (num_pushed) {
+				kernel_enter(io, num_pushed);
+				num_pushed = 0;
+			}
+			condvar::wait(io._signal, lock);
+		}
+		++io._num_in_flight;
+		if (kernel) {
+			kernel_push(io, request);
+			++num_pushed;
+		} else {
+			if (io._queue_tail) {
+				io._queue_tail->_next = request;
+			} else {
+				io._queue_head = request;
+			}
+			io._queue_tail = request;
+			condvar::signal_all(io._signal, lock);
+		}
+	}
+	if (num_pushed) {
+		kernel_enter(io, num_pushed);
+	}
+}
+
+/// Submit a request.
+void async_io::submit(AsyncIO& io, AsyncIORequest& request) {
+	AsyncIORequest* const requests[]{&request};
+	async_io::submit(io, array_cref(requests));
+}
+
+/// Wait for all submitted requests to complete.
+void async_io::wait(AsyncIO& io) {
+	MutexLock lock{io._mutex};
+	while (io._num_in_flight) {
+		condvar::wait(io._signal, lock);
+	}
+}
+
+} // namespace togo
@@ -0,0 +1,71 @@
+#line 2 "togo/core/io/async_io.hpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+
+@file
+@brief Asynchronous IO interface.
+@ingroup lib_core_io
+@ingroup lib_core_io_async
+
+@defgroup lib_core_io_async Asynchronous IO
+@ingroup lib_core_io
+@details
+
+AsyncIO performs positioned reads and writes on file streams without
+blocking the submitting thread. On Linux, requests go through io_uring
+when the kernel supports it. Otherwise a pool of worker threads performs
+them with blocking IO.
+
+On completion, a request's callback is called and then, if it has a task
+manager, the hold on its task is ended. This allows work depending on the
+data to be queued as a held task before the request is submitted.
+*/
+
+#pragma once
+
+#include <togo/core/config.hpp>
+#include <togo/core/types.hpp>
+#include <togo/core/utility/types.hpp>
+#include <togo/core/io/types.hpp>
+#include <togo/core/io/async_io_type.hpp>
+#include <togo/core/io/file_stream.hpp>
+
+#include <togo/core/io/async_io.gen_interface>
+
+namespace togo {
+namespace async_io {
+
+/**
+	@addtogroup lib_core_io_async
+	@{
+*/
+
+/// Backend in use.
+inline AsyncIOBackend backend(AsyncIO const& io) {
+	return io._backend;
+}
+
+/// Set completion callback.
+inline void set_callback(
+	AsyncIORequest& request,
+	AsyncIORequest::callback_type* const callback,
+	void* const userdata
+) {
+	request.callback = callback;
+	request.userdata = userdata;
+}
+
+/// Set task to release on completion.
+inline void set_task(
+	AsyncIORequest& request,
+	TaskManager& tm,
+	TaskID const task_id
+) {
+	request.task_manager = &tm;
+	request.task_id = task_id;
+}
+
+/** @} */ // end of doc-group lib_core_io_async
+
+} // namespace async_io
+} // namespace togo
@@ -0,0 +1,34 @@
+#line 2 "togo/core/io/async_io/linux.hpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#pragma once
+
+#include <togo/core/config.hpp>
+#include <togo/core/types.hpp>
+
+namespace togo {
+
+// io_uring instance
+struct LinuxAsyncIOImpl {
+	signed ring_fd;
+	void* sq_ring;
+	void* cq_ring;
+	void* sqes;
+	unsigned sq_ring_size;
+	unsigned cq_ring_size;
+	unsigned sqes_size;
+
+	u32* sq_tail;
+	u32* sq_array;
+	u32 sq_mask;
+	u32* cq_head;
+	u32* cq_tail;
+	u32 cq_mask;
+	void* cqes;
+};
+
+using AsyncIOImpl = LinuxAsyncIOImpl;
+
+} // namespace togo
@@ -0,0 +1,230 @@
+#line 2 "togo/core/io/async_io/linux.ipp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#include <togo/core/config.hpp>
+#include <togo/core/types.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/threading/mutex.hpp>
+#include <togo/core/io/async_io.hpp>
+#include <togo/core/io/async_io/posix.ipp>
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace togo {
+
+namespace {
+
+inline signed sys_io_uring_setup(unsigned const entries, io_uring_params* const params) {
+	return static_cast<signed>(::syscall(__NR_io_uring_setup, entries, params));
+}
+
+inline signed sys_io_uring_enter(
+	signed const fd,
+	unsigned const to_submit,
+	unsigned const min_complete,
+	unsigned const flags
+) {
+	return static_cast<signed>(::syscall(
+		__NR_io_uring_enter, fd, to_submit, min_complete, flags, nullptr, 0
+	));
+}
+
+inline void* ring_map(signed const fd, unsigned const size, u64 const offset) {
+	void* const p = ::mmap(
+		nullptr, size,
+		PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+		fd, static_cast<off_t>(offset)
+	);
+	return p == MAP_FAILED ? nullptr : p;
+}
+
+template<class T>
+inline T* ring_ptr(void* const ring, u32 const offset) {
+	return reinterpret_cast<T*>(static_cast<u8*>(ring) + offset);
+}
+
+void kernel_destroy(AsyncIO& io) {
+	auto& impl = io._impl;
+	if (impl.sqes) {
+		::munmap(impl.sqes, impl.sqes_size);
+	}
+	if (impl.cq_ring && impl.cq_ring != impl.sq_ring) {
+		::munmap(impl.cq_ring, impl.cq_ring_size);
+	}
+	if (impl.sq_ring) {
+		::munmap(impl.sq_ring, impl.sq_ring_size);
+	}
+	if (impl.ring_fd != -1) {
+		::close(impl.ring_fd);
+	}
+	std::memset(&impl, 0, sizeof(impl));
+	impl.ring_fd = -1;
+}
+
+bool kernel_init(AsyncIO& io) {
+	auto& impl = io._impl;
+	std::memset(&impl, 0, sizeof(impl));
+	io_uring_params params;
+	std::memset(&params, 0, sizeof(params));
+	impl.ring_fd = sys_io_uring_setup(io._queue_depth, &params);
+	if (impl.ring_fd < 0) {
+		TOGO_LOG_DEBUGF(
+			"io_uring unavailable: %d, %s\n",
+			errno, std::strerror(errno)
+		);
+		impl.ring_fd = -1;
+		return false;
+	}
+	// IORING_OP_READ and IORING_OP_WRITE arrived with this feature
+	if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+		TOGO_LOG_DEBUG("io_uring does not support IORING_OP_READ\n");
+		kernel_destroy(io);
+		return false;
+	}
+
+	bool const single_mmap = params.features & IORING_FEAT_SINGLE_MMAP;
+	impl.sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(u32);
+	impl.cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+	if (single_mmap) {
+		impl.sq_ring_size = impl.cq_ring_size = max(impl.sq_ring_size, impl.cq_ring_size);
+	}
+	impl.sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+	impl.sq_ring = ring_map(impl.ring_fd, impl.sq_ring_size, IORING_OFF_SQ_RING);
+	impl.cq_ring
+		= single_mmap
+		? impl.sq_ring
+		: ring_map(impl.ring_fd, impl.cq_ring_size, IORING_OFF_CQ_RING)
+	;
+	impl.sqes = ring_map(impl.ring_fd, impl.sqes_size, IORING_OFF_SQES);
+	if (!impl.sq_ring || !impl.cq_ring || !impl.sqes) {
+		TOGO_LOG_DEBUGF(
+			"failed to map io_uring: %d, %s\n",
+			errno, std::strerror(errno)
+		);
+		kernel_destroy(io);
+		return false;
+	}
+
+	impl.sq_tail = ring_ptr<u32>(impl.sq_ring, params.sq_off.tail);
+	impl.sq_array = ring_ptr<u32>(impl.sq_ring, params.sq_off.array);
+	impl.sq_mask = *ring_ptr<u32>(impl.sq_ring, params.sq_off.ring_mask);
+	impl.cq_head = ring_ptr<u32>(impl.cq_ring, params.cq_off.head);
+	impl.cq_tail = ring_ptr<u32>(impl.cq_ring, params.cq_off.tail);
+	impl.cq_mask = *ring_ptr<u32>(impl.cq_ring, params.cq_off.ring_mask);
+	impl.cqes = ring_ptr<void>(impl.cq_ring, params.cq_off.cqes);
+	return true;
+}
+
+// Queue the remainder of a request (or a shutdown marker if request
+// is null). The mutex must be held.
+void kernel_push(AsyncIO& io, AsyncIORequest* const request) {
+	auto& impl = io._impl;
+	u32 const tail = *impl.sq_tail;
+	u32 const index = tail & impl.sq_mask;
+	auto& sqe = static_cast<io_uring_sqe*>(impl.sqes)[index];
+	std::memset(&sqe, 0, sizeof(sqe));
+	if (request) {
+		sqe.opcode = request->op == AsyncIOOp::read ? IORING_OP_READ : IORING_OP_WRITE;
+		sqe.fd = request->handle;
+		sqe.off = request->offset + request->transferred;
+		sqe.addr = reinterpret_cast<std::uintptr_t>(
+			static_cast<u8*>(request->data) + request->transferred
+		);
+		sqe.len = request->size - request->transferred;
+	} else {
+		sqe.opcode = IORING_OP_NOP;
+	}
+	sqe.user_data = reinterpret_cast<std::uintptr_t>(request);
+	impl.sq_array[index] = index;
+	__atomic_store_n(impl.sq_tail, tail + 1, __ATOMIC_RELEASE);
+}
+
+// Submit pushed entries. The mutex must be held.
+void kernel_enter(AsyncIO& io, unsigned count) {
+	while (count > 0) {
+		signed const result = sys_io_uring_enter(io._impl.ring_fd, count, 0, 0);
+		if (result < 0) {
+			TOGO_ASSERTF(
+				errno == EINTR || errno == EAGAIN || errno == EBUSY,
+				"io_uring_enter failed: %d, %s", errno, std::strerror(errno)
+			);
+			continue;
+		}
+		count -= static_cast<unsigned>(result);
+	}
+}
+
+void kernel_result(AsyncIO& io, AsyncIORequest& request, signed const result) {
+	if (result == -EINTR || result == -EAGAIN || (
+		result > 0 &&
+		request.transferred + static_cast<unsigned>(result) < request.size
+	)) {
+		// Retry or continue a short transfer
+		if (result > 0) {
+			request.transferred += static_cast<unsigned>(result);
+		}
+		MutexLock lock{io._mutex};
+		kernel_push(io, &request);
+		kernel_enter(io, 1);
+		return;
+	} else if (result < 0) {
+		TOGO_LOG_DEBUGF(
+			"async %s failed at %lu: %d, %s\n",
+			request.op == AsyncIOOp::read ? "read" : "write",
+			request.offset + request.transferred, -result, std::strerror(-result)
+		);
+	} else {
+		request.transferred += static_cast<unsigned>(result);
+	}
+	finish(request, result < 0);
+	complete(io, request);
+}
+
+void* kernel_reap_func(void* const io_void) {
+	AsyncIO& io = *static_cast<AsyncIO*>(io_void);
+	auto& impl = io._impl;
+	auto const* const cqes = static_cast<io_uring_cqe const*>(impl.cqes);
+	bool shutdown = false;
+	while (!shutdown) {
+		if (sys_io_uring_enter(impl.ring_fd, 0, 1, IORING_ENTER_GETEVENTS) < 0) {
+			TOGO_ASSERTF(
+				errno == EINTR || errno == EAGAIN || errno == EBUSY,
+				"io_uring_enter failed: %d, %s", errno, std::strerror(errno)
+			);
+		}
+		u32 head = *impl.cq_head;
+		u32 const tail = __atomic_load_n(impl.cq_tail, __ATOMIC_ACQUIRE);
+		if (head != tail) {
+			// Pair with the submitter's unlock so request fields are
+			// visible without relying on the kernel's ordering
+			mutex::lock(io._mutex);
+			mutex::unlock(io._mutex);
+		}
+		for (; head != tail; ++head) {
+			io_uring_cqe const& cqe = cqes[head & impl.cq_mask];
+			auto* const request = reinterpret_cast<AsyncIORequest*>(cqe.user_data);
+			signed const result = cqe.res;
+			__atomic_store_n(impl.cq_head, head + 1, __ATOMIC_RELEASE);
+			if (request) {
+				kernel_result(io, *request, result);
+			} else {
+				shutdown = true;
+			}
+		}
+	}
+	return nullptr;
+}
+
+} // anonymous namespace
+
+} // namespace togo
@@ -0,0 +1,16 @@
+#line 2 "togo/core/io/async_io/posix.hpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#pragma once
+
+#include <togo/core/config.hpp>
+
+namespace togo {
+
+struct PosixAsyncIOImpl {};
+
+using AsyncIOImpl = PosixAsyncIOImpl;
+
+} // namespace togo
@@ -0,0 +1,80 @@
+#line 2 "togo/core/io/async_io/posix.ipp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#include <togo/core/config.hpp>
+#include <togo/core/types.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/io/async_io.hpp>
+
+#include <cerrno>
+#include <cstring>
+
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace togo {
+
+namespace {
+
+inline signed stream_handle(PosixFileStreamData const& data) {
+	return data.fd;
+}
+
+// Blocking transfer for the thread backend
+void perform(AsyncIORequest& request) {
+	u8* const data = static_cast<u8*>(request.data);
+	bool error = false;
+	while (request.transferred < request.size) {
+		unsigned const transferred = request.transferred;
+		ssize_t const result = request.op == AsyncIOOp::read
+			? ::pread(
+				request.handle, data + transferred, request.size - transferred,
+				static_cast<off_t>(request.offset + transferred)
+			)
+			: ::pwrite(
+				request.handle, data + transferred, request.size - transferred,
+				static_cast<off_t>(request.offset + transferred)
+			)
+		;
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			TOGO_LOG_DEBUGF(
+				"async %s failed at %lu: %d, %s\n",
+				request.op == AsyncIOOp::read ? "read" : "write",
+				request.offset + transferred, errno, std::strerror(errno)
+			);
+			error = true;
+			break;
+		} else if (result == 0) {
+			break;
+		}
+		request.transferred += static_cast<unsigned>(result);
+	}
+	finish(request, error);
+}
+
+#if !defined(TOGO_PLATFORM_LINUX)
+
+// No kernel queue
+
+inline bool kernel_init(AsyncIO&) {
+	return false;
+}
+
+inline void kernel_destroy(AsyncIO&) {}
+inline void kernel_push(AsyncIO&, AsyncIORequest*) {}
+inline void kernel_enter(AsyncIO&, unsigned) {}
+
+void* kernel_reap_func(void*) {
+	return nullptr;
+}
+
+#endif
+
+} // anonymous namespace
+
+} // namespace togo
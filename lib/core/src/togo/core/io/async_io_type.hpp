@@ -0,0 +1,137 @@
+#line 2 "togo/core/io/async_io_type.hpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+
+@file
+@brief Asynchronous IO types.
+@ingroup lib_core_types
+@ingroup lib_core_io
+@ingroup lib_core_io_async
+*/
+
+#pragma once
+
+#include <togo/core/config.hpp>
+#include <togo/core/types.hpp>
+#include <togo/core/memory/types.hpp>
+#include <togo/core/collection/types.hpp>
+#include <togo/core/threading/types.hpp>
+#include <togo/core/io/types.hpp>
+
+#if defined(TOGO_PLATFORM_LINUX)
+	#include <togo/core/io/async_io/linux.hpp>
+#elif defined(TOGO_PLATFORM_IS_POSIX)
+	#include <togo/core/io/async_io/posix.hpp>
+#else
+	#error "missing AsyncIO implementation for target platform"
+#endif
+
+namespace togo {
+
+/**
+	@addtogroup lib_core_io_async
+	@{
+*/
+
+/// Asynchronous IO operation.
+enum class AsyncIOOp : unsigned {
+	/// Read into a buffer.
+	read,
+	/// Write from a buffer.
+	write,
+};
+
+/// Asynchronous IO backend.
+enum class AsyncIOBackend : unsigned {
+	/// Use the kernel queue if available, otherwise worker threads.
+	automatic,
+	/// Kernel submission queue (io_uring on Linux).
+	kernel,
+	/// Worker threads performing blocking IO.
+	threads,
+};
+
+/// Asynchronous IO request.
+///
+/// A request must remain alive and unmodified from submission until
+/// it is completed.
+struct AsyncIORequest {
+	using callback_type = void (AsyncIORequest& request);
+
+	/// Operation.
+	AsyncIOOp op;
+	/// File handle.
+	signed handle;
+	/// File offset.
+	u64 offset;
+	/// Buffer.
+	void* data;
+	/// Size of buffer (in bytes).
+	unsigned size;
+
+	/// Completion callback (optional).
+	///
+	/// This is called from an IO thread. It must not submit requests.
+	callback_type* callback;
+	/// Userdata for callback.
+	void* userdata;
+
+	/// Task manager (optional).
+	///
+	/// If non-null, the hold on task_id is ended after callback is
+	/// called (see task_manager::add_hold()).
+	TaskManager* task_manager;
+	/// Task to release on completion.
+	TaskID task_id;
+
+	/// Result status.
+	///
+	/// A read that reaches the end of the file sets the EOF flag.
+	IOStatus status;
+	/// Number of bytes transferred.
+	unsigned transferred;
+
+	AsyncIORequest* _next;
+};
+
+/// Asynchronous IO service.
+struct AsyncIO {
+	AsyncIOImpl _impl;
+	Mutex _mutex;
+	CondVar _signal;
+	Array<Thread*> _threads;
+	AsyncIORequest* _queue_head;
+	AsyncIORequest* _queue_tail;
+	AsyncIOBackend _backend;
+	unsigned _queue_depth;
+	unsigned _num_in_flight;
+	unsigned _flags;
+
+	AsyncIO() = delete;
+	AsyncIO(AsyncIO const&) = delete;
+	AsyncIO(AsyncIO&&) = delete;
+	AsyncIO& operator=(AsyncIO const&) = delete;
+	AsyncIO& operator=(AsyncIO&&) = delete;
+
+	/// Destroy.
+	///
+	/// Waits for all requests to complete.
+	~AsyncIO();
+
+	/// Construct with queue depth, worker threads, and an allocator.
+	///
+	/// At most queue_depth requests are in flight at once.
+	/// num_workers threads are created if the thread backend is used.
+	/// If backend is AsyncIOBackend::kernel and the kernel queue is
+	/// unavailable, the thread backend is used.
+	AsyncIO(
+		unsigned queue_depth,
+		unsigned num_workers,
+		Allocator& allocator,
+		AsyncIOBackend backend = AsyncIOBackend::automatic
+	);
+};
+
+/** @} */ // end of doc-group lib_core_io_async
+
+} // namespace togo
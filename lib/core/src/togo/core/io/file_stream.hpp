@@ -54,11 +54,17 @@ public:
 	/// Whether stream is open.
 	bool is_open() const;
 
+	/// Set user-space buffer size.
+	///
+	/// A size of 0 disables buffering. Reads at least as large as the
+	/// buffer bypass it. This must be called while the stream is closed.
+	void set_buffer_size(unsigned size);
+
 	/// Attempt to open a file.
 	///
 	/// Returns false if the file could not be opened.
 	/// path must be NUL-terminated.
-	bool open(StringRef const& path);
+	bool open(StringRef const& path, FileStreamFlags flags = FileStreamFlags::none);
 
 	/// Close.
 	void close();
@@ -74,6 +80,7 @@ private:
 
 // IReader implementation
 	IOStatus read(void* data, unsigned size, unsigned* read_size) override;
+	IOStatus readv(ArrayRef<IOVec const> const& buffers, unsigned* read_size) override;
 };
 
 /// File writer.
@@ -97,15 +104,30 @@ public:
 	/// Whether stream is open.
 	bool is_open() const;
 
+	/// Set user-space buffer size.
+	///
+	/// A size of 0 disables buffering. Writes at least as large as the
+	/// buffer bypass it. This must be called while the stream is closed.
+	void set_buffer_size(unsigned size);
+
 	/// Attempt to open a file.
 	///
 	/// Returns false if the file could not be opened.
 	/// If append is true, the stream will be seeked to the end of
 	/// the file if it already exists.
 	/// path must be NUL-terminated.
-	bool open(StringRef const& path, bool append);
+	bool open(
+		StringRef const& path,
+		bool append,
+		FileStreamFlags flags = FileStreamFlags::none
+	);
+
+	/// Write buffered data to the file.
+	IOStatus flush();
 
 	/// Close.
+	///
+	/// Buffered data is written before the file is closed.
 	void close();
 
 private:
@@ -119,6 +141,7 @@ private:
 
 // IWriter implementation
 	IOStatus write(void const* data, unsigned size) override;
+	IOStatus writev(ArrayRef<IOVecConst const> const& buffers) override;
 };
 
 /** @} */ // end of doc-group lib_core_io_file
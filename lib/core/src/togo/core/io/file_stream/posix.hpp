@@ -6,14 +6,25 @@
 #pragma once
 
 #include <togo/core/config.hpp>
-
-#include <cstdio>
+#include <togo/core/types.hpp>
+#include <togo/core/io/types.hpp>
 
 namespace togo {
 
 struct PosixFileStreamData {
-	std::FILE* handle{nullptr};
+	signed fd{-1};
 	IOStatus status{IOStatus::flag_none};
+	FileStreamFlags flags{FileStreamFlags::none};
+	unsigned buffer_capacity{FILE_STREAM_BUFFER_SIZE_DEFAULT};
+	u8* buffer{nullptr};
+
+	// File offset of buffer[0]
+	u64 buffer_position{0};
+	// Reader: number of valid bytes in the buffer
+	// Writer: number of unwritten bytes in the buffer
+	unsigned buffer_size{0};
+	// Reader stream position (writer position is the end of the buffer)
+	u64 position{0};
 };
 
 using FileStreamData = PosixFileStreamData;
@@ -6,38 +6,247 @@
 #include <togo/core/config.hpp>
 #include <togo/core/types.hpp>
 #include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
 #include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
 #include <togo/core/string/string.hpp>
 #include <togo/core/io/file_stream.hpp>
 
 #include <cerrno>
-#include <cstdio>
 #include <cstring>
 
+#include <sys/types.h>
+#include <sys/uio.h>
+#include <fcntl.h>
+#include <unistd.h>
+
 namespace togo {
 
+namespace {
+
+enum : unsigned {
+	// Number of iovecs passed to a single preadv() or pwritev()
+	IOV_CHUNK_SIZE = 64,
+	DIRECT_MASK = FILE_STREAM_DIRECT_ALIGNMENT - 1,
+};
+
+inline bool
+file_is_direct(
+	PosixFileStreamData const& data
+) {
+	return enum_bool(data.flags & FileStreamFlags::direct);
+}
+
+// Read until size bytes are read, EOF, or an error
+static unsigned file_pread_full(
+	PosixFileStreamData& data,
+	u8* const buffer,
+	unsigned const size,
+	u64 const offset,
+	bool& error
+) {
+	unsigned total = 0;
+	while (total < size) {
+		ssize_t const result = ::pread(
+			data.fd,
+			buffer + total, size - total,
+			static_cast<off_t>(offset + total)
+		);
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			TOGO_LOG_DEBUGF(
+				"failed to read %ub at %lu: %d, %s\n",
+				size - total, offset + total, errno, std::strerror(errno)
+			);
+			error = true;
+			break;
+		} else if (result == 0) {
+			break;
+		}
+		total += static_cast<unsigned>(result);
+		if (file_is_direct(data)) {
+			// A short direct read is at EOF, and the next offset would
+			// be misaligned anyways
+			break;
+		}
+	}
+	return total;
+}
+
+// Write until size bytes are written or an error
+static unsigned file_pwrite_full(
+	PosixFileStreamData& data,
+	u8 const* const buffer,
+	unsigned const size,
+	u64 const offset,
+	bool& error
+) {
+	unsigned total = 0;
+	while (total < size) {
+		ssize_t const result = ::pwrite(
+			data.fd,
+			buffer + total, size - total,
+			static_cast<off_t>(offset + total)
+		);
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			TOGO_LOG_DEBUGF(
+				"failed to write %ub at %lu: %d, %s\n",
+				size - total, offset + total, errno, std::strerror(errno)
+			);
+			error = true;
+			break;
+		}
+		total += static_cast<unsigned>(result);
+	}
+	return total;
+}
+
+// Drop bytes from the front of an iovec range
+inline void iov_consume(
+	struct iovec*& it,
+	struct iovec* const end,
+	u64 size
+) {
+	for (; it != end && size >= it->iov_len; ++it) {
+		size -= it->iov_len;
+	}
+	if (it != end && size > 0) {
+		it->iov_base = static_cast<u8*>(it->iov_base) + size;
+		it->iov_len -= size;
+	}
+}
+
+// Vectored IO over a chunk of iovecs; returns the number of bytes
+// transferred
+template<bool WRITE>
+static u64 file_iov_full(
+	PosixFileStreamData& data,
+	struct iovec* it,
+	struct iovec* const end,
+	u64 const offset,
+	bool& error,
+	bool& eof
+) {
+	u64 total = 0;
+	while (it != end) {
+		ssize_t const result = WRITE
+			? ::pwritev(data.fd, it, static_cast<signed>(end - it), static_cast<off_t>(offset + total))
+			: ::preadv(data.fd, it, static_cast<signed>(end - it), static_cast<off_t>(offset + total))
+		;
+		if (result < 0) {
+			if (errno == EINTR) {
+				continue;
+			}
+			TOGO_LOG_DEBUGF(
+				"failed to %s vector at %lu: %d, %s\n",
+				WRITE ? "write" : "read", offset + total, errno, std::strerror(errno)
+			);
+			error = true;
+			break;
+		} else if (!WRITE && result == 0) {
+			eof = true;
+			break;
+		}
+		total += static_cast<u64>(result);
+		iov_consume(it, end, static_cast<u64>(result));
+	}
+	return total;
+}
+
+// Fill iovecs from a list of buffers, skipping the first skip bytes;
+// returns the number of iovecs filled
+template<class V>
+inline unsigned iov_fill(
+	struct iovec (&iov)[IOV_CHUNK_SIZE],
+	V const*& it,
+	V const* const end,
+	unsigned& skip
+) {
+	unsigned count = 0;
+	for (; it != end && count < IOV_CHUNK_SIZE; ++it) {
+		if (skip >= it->size) {
+			skip -= it->size;
+			continue;
+		}
+		iov[count].iov_base = const_cast<u8*>(static_cast<u8 const*>(it->data)) + skip;
+		iov[count].iov_len = it->size - skip;
+		skip = 0;
+		++count;
+	}
+	return count;
+}
+
+} // anonymous namespace
+
 inline bool
 file_is_open(
 	PosixFileStreamData const& data
 ) {
-	return data.handle != nullptr;
+	return data.fd != -1;
+}
+
+inline void
+file_set_buffer_size(
+	PosixFileStreamData& data,
+	unsigned const size
+) {
+	TOGO_ASSERT(data.fd == -1, "cannot set buffer size on an open stream");
+	data.buffer_capacity = size;
 }
 
 inline bool
 file_open(
 	PosixFileStreamData& data,
 	StringRef const& path,
-	char const* const mode
+	signed const mode,
+	FileStreamFlags const flags
 ) {
-	TOGO_ASSERT(!data.handle, "cannot open new path on an open stream");
-	data.handle = std::fopen(path.data, mode);
-	if (!data.handle) {
+	TOGO_ASSERT(data.fd == -1, "cannot open new path on an open stream");
+	data.flags = flags;
+#if defined(O_DIRECT)
+	if (file_is_direct(data)) {
+		data.fd = ::open(path.data, mode | O_CLOEXEC | O_DIRECT, 0666);
+		if (data.fd == -1 && errno == EINVAL) {
+			// Filesystem does not support direct IO
+			data.flags &= ~FileStreamFlags::direct;
+		}
+	}
+#else
+	data.flags &= ~FileStreamFlags::direct;
+#endif
+	if (!file_is_direct(data)) {
+		data.fd = ::open(path.data, mode | O_CLOEXEC, 0666);
+	}
+	if (data.fd == -1) {
 		TOGO_LOG_DEBUGF(
-			"failed to open file '%.*s' for reading: %d, %s\n",
+			"failed to open file '%.*s': %d, %s\n",
 			path.size, path.data, errno, std::strerror(errno)
 		);
 		return false;
 	}
+
+	if (file_is_direct(data)) {
+		// Direct IO always goes through the aligned buffer
+		data.buffer_capacity = max(
+			(data.buffer_capacity + DIRECT_MASK) & ~unsigned{DIRECT_MASK},
+			unsigned{FILE_STREAM_DIRECT_ALIGNMENT}
+		);
+	}
+	if (data.buffer_capacity > 0) {
+		data.buffer = static_cast<u8*>(memory::default_allocator().allocate(
+			data.buffer_capacity,
+			file_is_direct(data) ? unsigned{FILE_STREAM_DIRECT_ALIGNMENT} : 0
+		));
+	}
+	data.status.clear();
+	data.buffer_position = 0;
+	data.buffer_size = 0;
+	data.position = 0;
 	return true;
 }
 
@@ -45,75 +254,56 @@ inline void
 file_close(
 	PosixFileStreamData& data
 ) {
-	if (data.handle) {
-		if (std::fclose(data.handle)) {
+	if (data.fd != -1) {
+		if (::close(data.fd)) {
 			TOGO_LOG_DEBUGF(
 				"failed to close file stream: %d, %s\n",
 				errno, std::strerror(errno)
 			);
 		}
-		data.handle = nullptr;
+		data.fd = -1;
 	}
-}
-
-inline void
-file_set_status(
-	PosixFileStreamData& data
-) {
-	TOGO_DEBUG_ASSERT(data.handle, "cannot perform operation on a closed stream");
-	bool const err = !!std::ferror(data.handle);
-	bool const eof = !!std::feof(data.handle);
-	data.status.assign(err, eof);
-}
-
-inline u64
-file_position(
-	PosixFileStreamData& data
-) {
-	TOGO_DEBUG_ASSERT(data.handle, "cannot perform operation on a closed stream");
-	off_t const lpos = ftello(data.handle);
-	if (lpos < 0) {
-		TOGO_LOG_DEBUGF(
-			"failed to obtain stream position: %d, %s\n",
-			errno, std::strerror(errno)
-		);
-		data.status._value |= IOStatus::flag_fail;
-		return 0;
-	} else {
-		return static_cast<u64>(lpos);
+	if (data.buffer) {
+		memory::default_allocator().deallocate(data.buffer);
+		data.buffer = nullptr;
 	}
+	data.buffer_size = 0;
 }
 
 inline u64
-file_seek_to(
+file_seek(
 	PosixFileStreamData& data,
-	u64 const position
+	u64 const from,
+	s64 const offset
 ) {
-	TOGO_DEBUG_ASSERT(data.handle, "cannot perform operation on a closed stream");
-	if (fseeko(data.handle, static_cast<off_t>(position), SEEK_SET)) {
+	TOGO_DEBUG_ASSERT(data.fd != -1, "cannot perform operation on a closed stream");
+	if (offset < 0 && static_cast<u64>(-offset) > from) {
 		TOGO_LOG_DEBUGF(
-			"failed to seek to %lu: %d, %s\n",
-			position, errno, std::strerror(errno)
+			"failed to seek by offset %ld from %lu: position would be negative\n",
+			offset, from
 		);
+		data.status.assign(true, false);
+		return from;
 	}
-	file_set_status(data);
-	return file_position(data);
+	data.status.clear();
+	return from + static_cast<u64>(offset);
 }
 
-inline u64
-file_seek_relative(
-	PosixFileStreamData& data,
-	s64 const offset
+// Disable direct IO when the next transfer would be misaligned
+static void
+file_disable_direct(
+	PosixFileStreamData& data
 ) {
-	TOGO_DEBUG_ASSERT(data.handle, "cannot perform operation on a closed stream");
-	if (fseeko(data.handle, static_cast<off_t>(offset), SEEK_CUR)) {
+#if defined(O_DIRECT)
+	signed const fl = ::fcntl(data.fd, F_GETFL);
+	if (fl == -1 || ::fcntl(data.fd, F_SETFL, fl & ~O_DIRECT) == -1) {
 		TOGO_LOG_DEBUGF(
-			"failed to seek by offset %ld: %d, %s\n",
-			offset, errno, std::strerror(errno)
+			"failed to disable direct IO: %d, %s\n",
+			errno, std::strerror(errno)
 		);
 	}
-	file_set_status(data);
-	return file_position(data);
+#endif
+	data.flags &= ~FileStreamFlags::direct;
 }
 
 // FileReader implementation
@@ -126,8 +316,12 @@ bool FileReader::is_open() const {
 	return file_is_open(_data);
 }
 
-bool FileReader::open(StringRef const& path) {
-	return file_open(_data, path, "rb");
+void FileReader::set_buffer_size(unsigned const size) {
+	file_set_buffer_size(_data, size);
+}
+
+bool FileReader::open(StringRef const& path, FileStreamFlags const flags) {
+	return file_open(_data, path, O_RDONLY, flags);
 }
 
 void FileReader::close() {
@@ -139,15 +333,35 @@ IOStatus FileReader::status() const {
 }
 
 u64 FileReader::position() {
-	return file_position(_data);
+	return _data.position;
 }
 
 u64 FileReader::seek_to(u64 const position) {
-	return file_seek_to(_data, position);
+	return _data.position = file_seek(_data, 0, static_cast<s64>(position));
 }
 
 u64 FileReader::seek_relative(s64 const offset) {
-	return file_seek_relative(_data, offset);
+	return _data.position = file_seek(_data, _data.position, offset);
+}
+
+// Copy from the buffer at the current position
+inline unsigned
+file_read_buffered(
+	PosixFileStreamData& data,
+	u8* const buffer,
+	unsigned const size
+) {
+	if (
+		data.position < data.buffer_position ||
+		data.position >= data.buffer_position + data.buffer_size
+	) {
+		return 0;
+	}
+	unsigned const offset = static_cast<unsigned>(data.position - data.buffer_position);
+	unsigned const copy_size = min(size, data.buffer_size - offset);
+	std::memcpy(buffer, data.buffer + offset, copy_size);
+	data.position += copy_size;
+	return copy_size;
 }
 
 IOStatus FileReader::read(
@@ -155,18 +369,90 @@ IOStatus FileReader::read(
 	unsigned const size,
 	unsigned* const read_size
 ) {
-	TOGO_DEBUG_ASSERT(_data.handle, "cannot perform IO on a closed stream");
-	std::clearerr(_data.handle);
-	std::size_t const op_read_size = std::fread(data, 1, size, _data.handle);
-	file_set_status(_data);
+	TOGO_DEBUG_ASSERT(_data.fd != -1, "cannot perform IO on a closed stream");
+	u8* const out = static_cast<u8*>(data);
+	bool error = false;
+	unsigned total = file_read_buffered(_data, out, size);
+	while (total < size) {
+		unsigned const remaining = size - total;
+		if (!file_is_direct(_data) && remaining >= _data.buffer_capacity) {
+			unsigned const op_read_size = file_pread_full(
+				_data, out + total, remaining, _data.position, error
+			);
+			_data.position += op_read_size;
+			total += op_read_size;
+			break;
+		}
+
+		_data.buffer_position
+			= file_is_direct(_data)
+			? _data.position & ~u64{DIRECT_MASK}
+			: _data.position
+		;
+		_data.buffer_size = file_pread_full(
+			_data, _data.buffer, _data.buffer_capacity, _data.buffer_position, error
+		);
+		unsigned const op_read_size = file_read_buffered(_data, out + total, remaining);
+		total += op_read_size;
+		if (error || op_read_size == 0) {
+			break;
+		}
+	}
+	_data.status.assign(error, total < size);
 	if (_data.status.fail()) {
 		TOGO_LOG_DEBUGF(
-			"failed to read requested size (read %zub, requested %ub)\n",
-			op_read_size, size
+			"failed to read requested size (read %ub, requested %ub)\n",
+			total, size
+		);
+	}
+	if (read_size) {
+		*read_size = total;
+	}
+	return status();
+}
+
+IOStatus FileReader::readv(
+	ArrayRef<IOVec const> const& buffers,
+	unsigned* const read_size
+) {
+	TOGO_DEBUG_ASSERT(_data.fd != -1, "cannot perform IO on a closed stream");
+	u64 size = 0;
+	for (auto const& buffer : buffers) {
+		size += buffer.size;
+	}
+	if (file_is_direct(_data) || size < _data.buffer_capacity) {
+		return IReader::readv(buffers, read_size);
+	}
+
+	// Drain the buffer, then read the rest directly
+	u64 total = 0;
+	unsigned skip = 0;
+	for (auto const& buffer : buffers) {
+		unsigned const op_read_size = file_read_buffered(
+			_data, static_cast<u8*>(buffer.data), buffer.size
+		);
+		skip += op_read_size;
+		if (op_read_size < buffer.size) {
+			break;
+		}
+	}
+	total = skip;
+
+	bool error = false;
+	bool eof = false;
+	struct iovec iov[IOV_CHUNK_SIZE];
+	IOVec const* it = begin(buffers);
+	while (it != end(buffers) && !error && !eof) {
+		unsigned const count = iov_fill(iov, it, end(buffers), skip);
+		u64 const op_read_size = file_iov_full<false>(
+			_data, iov, iov + count, _data.position, error, eof
 		);
+		_data.position += op_read_size;
+		total += op_read_size;
 	}
+	_data.status.assign(error, total < size);
 	if (read_size) {
-		*read_size = static_cast<unsigned>(op_read_size);
+		*read_size = static_cast<unsigned>(total);
 	}
 	return status();
 }
@@ -181,11 +467,65 @@ bool FileWriter::is_open() const {
 	return file_is_open(_data);
 }
 
-bool FileWriter::open(StringRef const& path, bool const append) {
-	return file_open(_data, path, append ? "ab" : "wb");
+void FileWriter::set_buffer_size(unsigned const size) {
+	file_set_buffer_size(_data, size);
+}
+
+bool FileWriter::open(
+	StringRef const& path,
+	bool const append,
+	FileStreamFlags const flags
+) {
+	if (!file_open(
+		_data, path,
+		O_WRONLY | O_CREAT | (append ? 0 : O_TRUNC),
+		flags
+	)) {
+		return false;
+	}
+	if (append) {
+		off_t const size = ::lseek(_data.fd, 0, SEEK_END);
+		if (size < 0) {
+			TOGO_LOG_DEBUGF(
+				"failed to obtain size of '%.*s': %d, %s\n",
+				path.size, path.data, errno, std::strerror(errno)
+			);
+			file_close(_data);
+			return false;
+		}
+		_data.buffer_position = static_cast<u64>(size);
+	}
+	return true;
+}
+
+IOStatus FileWriter::flush() {
+	TOGO_DEBUG_ASSERT(_data.fd != -1, "cannot perform IO on a closed stream");
+	if (_data.buffer_size == 0) {
+		return _data.status.clear();
+	}
+	if (
+		file_is_direct(_data) &&
+		((_data.buffer_position | _data.buffer_size) & DIRECT_MASK)
+	) {
+		file_disable_direct(_data);
+	}
+	bool error = false;
+	unsigned const write_size = file_pwrite_full(
+		_data, _data.buffer, _data.buffer_size, _data.buffer_position, error
+	);
+	_data.buffer_position += write_size;
+	_data.buffer_size -= write_size;
+	if (_data.buffer_size > 0) {
+		std::memmove(_data.buffer, _data.buffer + write_size, _data.buffer_size);
+	}
+	_data.status.assign(error, false);
+	return status();
 }
 
 void FileWriter::close() {
+	if (_data.fd != -1) {
+		flush();
+	}
 	file_close(_data);
 }
 
@@ -194,31 +534,90 @@ IOStatus FileWriter::status() const {
 }
 
 u64 FileWriter::position() {
-	return file_position(_data);
+	return _data.buffer_position + _data.buffer_size;
 }
 
 u64 FileWriter::seek_to(u64 const position) {
-	return file_seek_to(_data, position);
+	if (!flush()) {
+		return this->position();
+	}
+	return _data.buffer_position = file_seek(_data, 0, static_cast<s64>(position));
 }
 
 u64 FileWriter::seek_relative(s64 const offset) {
-	return file_seek_relative(_data, offset);
+	if (!flush()) {
+		return this->position();
+	}
+	return _data.buffer_position = file_seek(_data, _data.buffer_position, offset);
 }
 
 IOStatus FileWriter::write(
 	void const* const data,
 	unsigned const size
 ) {
-	TOGO_DEBUG_ASSERT(_data.handle, "cannot perform IO on a closed stream");
-	std::clearerr(_data.handle);
-	std::size_t const write_size = std::fwrite(data, 1, size, _data.handle);
-	file_set_status(_data);
+	TOGO_DEBUG_ASSERT(_data.fd != -1, "cannot perform IO on a closed stream");
+	u8 const* const in = static_cast<u8 const*>(data);
+	unsigned total = 0;
+	_data.status.clear();
+	while (total < size) {
+		unsigned const remaining = size - total;
+		if (_data.buffer_size == _data.buffer_capacity || (
+			!file_is_direct(_data) &&
+			_data.buffer_size + remaining > _data.buffer_capacity
+		)) {
+			if (!flush()) {
+				break;
+			}
+		}
+		if (!file_is_direct(_data) && remaining >= _data.buffer_capacity) {
+			bool error = false;
+			unsigned const write_size = file_pwrite_full(
+				_data, in + total, remaining, _data.buffer_position, error
+			);
+			_data.buffer_position += write_size;
+			total += write_size;
+			_data.status.assign(error, false);
+			break;
+		}
+		unsigned const copy_size = min(remaining, _data.buffer_capacity - _data.buffer_size);
+		std::memcpy(_data.buffer + _data.buffer_size, in + total, copy_size);
+		_data.buffer_size += copy_size;
+		total += copy_size;
+	}
 	if (_data.status.fail()) {
 		TOGO_LOG_DEBUGF(
-			"failed to write requested size (wrote %zub, requested %ub)\n",
-			write_size, size
+			"failed to write requested size (wrote %ub, requested %ub)\n",
+			total, size
+		);
+	}
+	return status();
+}
+
+IOStatus FileWriter::writev(ArrayRef<IOVecConst const> const& buffers) {
+	TOGO_DEBUG_ASSERT(_data.fd != -1, "cannot perform IO on a closed stream");
+	u64 size = 0;
+	for (auto const& buffer : buffers) {
+		size += buffer.size;
+	}
+	if (file_is_direct(_data) || _data.buffer_size + size <= _data.buffer_capacity) {
+		return IWriter::writev(buffers);
+	}
+	if (!flush()) {
+		return status();
+	}
+
+	bool error = false;
+	bool eof = false;
+	unsigned skip = 0;
+	struct iovec iov[IOV_CHUNK_SIZE];
+	IOVecConst const* it = begin(buffers);
+	while (it != end(buffers) && !error) {
+		unsigned const count = iov_fill(iov, it, end(buffers), skip);
+		_data.buffer_position += file_iov_full<true>(
+			_data, iov, iov + count, _data.buffer_position, error, eof
 		);
 	}
+	_data.status.assign(error, false);
 	return status();
 }
 
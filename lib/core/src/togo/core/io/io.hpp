@@ -74,6 +74,28 @@ inline IOStatus write(
 	return stream.write(buffer, size);
 }
 
+/// Read into multiple buffers.
+///
+/// Buffers are filled in order. If read_size is non-null, its pointee
+/// will be assigned to the total number of bytes that were read.
+inline IOStatus readv(
+	IReader& stream,
+	ArrayRef<IOVec const> const& buffers,
+	unsigned* const read_size = nullptr
+) {
+	return stream.readv(buffers, read_size);
+}
+
+/// Write from multiple buffers.
+///
+/// Buffers are written in order.
+inline IOStatus writev(
+	IWriter& stream,
+	ArrayRef<IOVecConst const> const& buffers
+) {
+	return stream.writev(buffers);
+}
+
 /// Read an arithmetic value.
 template<class T>
 inline IOStatus read_value(IReader& stream, T& value) {
@@ -151,11 +173,16 @@ inline IOStatus write_array_endian(
 	if (endian == Endian::system) {
 		return io::write_array(stream, data);
 	}
-	T value;
+	// Swap through a small block to avoid a write per value
+	enum : unsigned { BLOCK_SIZE = 64 };
+	T block[BLOCK_SIZE];
 	IOStatus status{IOStatus::flag_none};
-	for (auto it = begin(data); it != end(data) && status; ++it) {
-		value = reverse_bytes_copy(*it);
-		status = io::write_value(stream, value);
+	for (auto it = begin(data); it != end(data) && status;) {
+		unsigned count = 0;
+		for (; count < BLOCK_SIZE && it != end(data); ++count, ++it) {
+			block[count] = reverse_bytes_copy(*it);
+		}
+		status = io::write(stream, block, count * sizeof(T));
 	}
 	return status;
 }
@@ -69,9 +69,35 @@ public:
 	virtual ~IReader() = 0;
 
 	virtual IOStatus read(void* data, unsigned size, unsigned* const read_size) = 0;
+	virtual IOStatus readv(ArrayRef<IOVec const> const& buffers, unsigned* const read_size);
 };
 inline IReader::~IReader() = default;
 
+/// Read into each buffer in order.
+///
+/// Implementations that can read multiple buffers with a single
+/// operation should override this.
+inline IOStatus IReader::readv(
+	ArrayRef<IOVec const> const& buffers,
+	unsigned* const read_size
+) {
+	IOStatus status{IOStatus::flag_none};
+	unsigned total_size = 0;
+	unsigned buffer_read_size;
+	for (auto const& buffer : buffers) {
+		buffer_read_size = 0;
+		status = read(buffer.data, buffer.size, &buffer_read_size);
+		total_size += buffer_read_size;
+		if (!status) {
+			break;
+		}
+	}
+	if (read_size) {
+		*read_size = total_size;
+	}
+	return status;
+}
+
 /// Stream writer interface.
 class IWriter
 	: public virtual IStreamBase
@@ -86,9 +112,25 @@ public:
 	virtual ~IWriter() = 0;
 
 	virtual IOStatus write(void const* data, unsigned size) = 0;
+	virtual IOStatus writev(ArrayRef<IOVecConst const> const& buffers);
 };
 inline IWriter::~IWriter() = default;
 
+/// Write each buffer in order.
+///
+/// Implementations that can write multiple buffers with a single
+/// operation should override this.
+inline IOStatus IWriter::writev(ArrayRef<IOVecConst const> const& buffers) {
+	IOStatus status{IOStatus::flag_none};
+	for (auto const& buffer : buffers) {
+		status = write(buffer.data, buffer.size);
+		if (!status) {
+			break;
+		}
+	}
+	return status;
+}
+
 /** @} */ // end of doc-group lib_core_io
 
 } // namespace togo
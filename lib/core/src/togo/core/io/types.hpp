@@ -11,6 +11,8 @@
 #pragma once
 
 #include <togo/core/config.hpp>
+#include <togo/core/types.hpp>
+#include <togo/core/utility/traits.hpp>
 
 namespace togo {
 
@@ -77,6 +79,44 @@ struct IOStatus {
 	}
 };
 
+/// Buffer for a vectored read.
+struct IOVec {
+	void* data;
+	unsigned size;
+};
+
+/// Buffer for a vectored write.
+struct IOVecConst {
+	void const* data;
+	unsigned size;
+};
+
+/// File stream constants.
+enum : unsigned {
+	/// Default user-space buffer size (64K).
+	FILE_STREAM_BUFFER_SIZE_DEFAULT = 64 * 1024,
+	/// Alignment of buffers, offsets, and sizes for direct IO.
+	FILE_STREAM_DIRECT_ALIGNMENT = 4 * 1024,
+};
+
+/// File stream flags.
+enum class FileStreamFlags : unsigned {
+	/// No flags.
+	none = 0,
+
+	/// Bypass the system page cache.
+	///
+	/// This is intended for large sequential transfers. If the platform
+	/// or filesystem does not support direct IO, the stream falls back
+	/// to regular IO.
+	direct = 1 << 0,
+};
+
 /** @} */ // end of doc-group lib_core_io
 
+/** @cond INTERNAL */
+template<>
+struct enable_enum_bitwise_ops<FileStreamFlags> : true_type {};
+/** @endcond */ // INTERNAL
+
 } // namespace togo
@@ -20,10 +20,12 @@
 namespace togo {
 namespace {
 
+template<class Ser>
 static void kvs_read_binary(
 	KVS& k_value,
-	BinaryInputSerializer& ser,
-	Array<char>& scratch
+	Ser& ser,
+	Array<char>& scratch,
+	KVSArena* const arena
 ) {
 	bool named_children = false;
 	switch (kvs::type(k_value)) {
@@ -38,7 +40,8 @@ static void kvs_read_binary(
 			StringRef{
 				array::begin(scratch),
 				static_cast<unsigned>(array::size(scratch))
-			}
+			},
+			arena
 		);
 		break;
 
@@ -54,7 +57,7 @@ static void kvs_read_binary(
 	case KVSType::array: {
 		u32 num_children;
 		ser % num_children;
-		kvs::resize(k_value, num_children);
+		kvs::resize(k_value, num_children, arena);
 		KVSType type;
 		for (auto& k_child : k_value) {
 			ser % type;
@@ -66,18 +69,61 @@ static void kvs_read_binary(
 					StringRef{
 						array::begin(scratch),
 						static_cast<unsigned>(array::size(scratch))
-					}
+					},
+					arena
 				);
 			}
-			kvs_read_binary(k_child, ser, scratch);
+			kvs_read_binary(k_child, ser, scratch, arena);
 		}
 	}	break;
 	}
 }
 
+template<class Ser>
+static void kvs_visit_binary(
+	KVS& k_collection,
+	Ser& ser,
+	Array<char>& scratch,
+	IKVSVisitor* const visitor
+) {
+	bool const named_children = kvs::is_node(k_collection);
+	u32 num_children;
+	ser % num_children;
+	KVS k_child;
+	KVSType type;
+	for (u32 i = 0; i < num_children; ++i) {
+		ser % type;
+		kvs::set_type(k_child, type);
+		if (named_children) {
+			ser % make_ser_collection<u32>(scratch);
+			kvs::set_name(
+				k_child,
+				StringRef{
+					array::begin(scratch),
+					static_cast<unsigned>(array::size(scratch))
+				}
+			);
+		}
+		if (kvs::is_collection(k_child)) {
+			// Skipped collections are still read to reach the next value
+			bool const visit = visitor && visitor->begin_collection(k_child);
+			kvs_visit_binary(k_child, ser, scratch, visit ? visitor : nullptr);
+			if (visit) {
+				visitor->end_collection(k_child);
+			}
+		} else {
+			kvs_read_binary(k_child, ser, scratch, nullptr);
+			if (visitor) {
+				visitor->value(k_child);
+			}
+		}
+	}
+}
+
+template<class Ser>
 static void kvs_write_binary(
 	KVS const& k_value,
-	BinaryOutputSerializer& ser
+	Ser& ser
 ) {
 	StringRef string_ref;
 	bool named_children = false;
@@ -5,6 +5,7 @@
 
 #include <togo/core/config.hpp>
 #include <togo/core/error/assert.hpp>
+#include <togo/core/memory/memory.hpp>
 #include <togo/core/collection/array.hpp>
 #include <togo/core/io/types.hpp>
 #include <togo/core/io/io.hpp>
@@ -14,6 +15,16 @@
 #include <cstdio>
 #include <cstring>
 
+#if defined(TOGO_COMPILER_CLANG) || defined(TOGO_COMPILER_GCC)
+	#if defined(__AVX2__)
+		#define TOGO_KVS_PARSER_SCAN_AVX2
+		#include <immintrin.h>
+	#elif defined(__SSE2__)
+		#define TOGO_KVS_PARSER_SCAN_SSE2
+		#include <emmintrin.h>
+	#endif
+#endif
+
 namespace togo {
 
 namespace {
@@ -22,6 +33,10 @@ enum : signed {
 	PC_EOF = ~0,
 };
 
+enum : unsigned {
+	PARSER_CHUNK_SIZE = 16384,
+};
+
 enum : unsigned {
 	PF_NONE				= 0,
 	PF_ERROR			= 1 << 0,
@@ -51,20 +66,88 @@ enum ParserValueType : unsigned {
 
 struct KVSParser {
 	KVS& root;
-	IReader& stream;
+	IReader* stream;
 	KVSParserInfo& info;
+	KVSArena* arena;
+	IKVSVisitor* visitor;
+	char* chunk;
+	char const* pos;
+	char const* end;
 	Array<KVS*> stack;
 	Array<char> buffer;
+	Array<KVS*> pool;
 	unsigned line;
 	unsigned column;
 	signed c;
 	Vec4 vec;
 	unsigned vec_size;
 	unsigned flags;
+	unsigned skip_depth;
 	ParserStage stage;
 	ParserValueType value_type;
 };
 
+// Characters that end a run. '\xFF' is included where the
+// character-wise parse would read it as PC_EOF.
+static constexpr char const s_scan_whitespace[]{' ', '\t'};
+static constexpr char const s_scan_string[]{
+	'\t', '\n', '\r', ' ', ',', ';', '=', '}', ']', '/',
+	'\\', '{', '[', '\'', '"', '`', '\xFF'
+};
+static constexpr char const s_scan_string_quote[]{'"', '\\', '\n', '\r', '\xFF'};
+static constexpr char const s_scan_string_block[]{'`', '\n', '\r', '\xFF'};
+static constexpr char const s_scan_comment_line[]{'\n', '\r', '\xFF'};
+static constexpr char const s_scan_comment_block[]{'*', '/', '\n', '\r', '\xFF'};
+
+// Number of leading characters in [pos, end) that are in set (if
+// MATCH) or are not in set (if !MATCH)
+template<bool MATCH, unsigned N>
+static unsigned scan_run(
+	char const* const start,
+	char const* const end,
+	char const (&set)[N]
+) {
+	char const* pos = start;
+#if defined(TOGO_KVS_PARSER_SCAN_AVX2)
+	while (end - pos >= 32) {
+		__m256i const chunk = _mm256_loadu_si256(reinterpret_cast<__m256i const*>(pos));
+		__m256i in_set = _mm256_setzero_si256();
+		for (unsigned i = 0; i < N; ++i) {
+			in_set = _mm256_or_si256(in_set, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(set[i])));
+		}
+		u32 const mask = static_cast<u32>(_mm256_movemask_epi8(in_set)) ^ (MATCH ? ~u32{0} : 0);
+		if (mask) {
+			return static_cast<unsigned>(pos - start) + static_cast<unsigned>(__builtin_ctz(mask));
+		}
+		pos += 32;
+	}
+#endif
+#if defined(TOGO_KVS_PARSER_SCAN_AVX2) || defined(TOGO_KVS_PARSER_SCAN_SSE2)
+	while (end - pos >= 16) {
+		__m128i const chunk = _mm_loadu_si128(reinterpret_cast<__m128i const*>(pos));
+		__m128i in_set = _mm_setzero_si128();
+		for (unsigned i = 0; i < N; ++i) {
+			in_set = _mm_or_si128(in_set, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(set[i])));
+		}
+		u32 const mask = static_cast<u32>(_mm_movemask_epi8(in_set)) ^ (MATCH ? 0xFFFFu : 0);
+		if (mask) {
+			return static_cast<unsigned>(pos - start) + static_cast<unsigned>(__builtin_ctz(mask));
+		}
+		pos += 16;
+	}
+#endif
+	for (; pos != end; ++pos) {
+		bool in_set = false;
+		for (unsigned i = 0; i < N; ++i) {
+			in_set |= *pos == set[i];
+		}
+		if (in_set != MATCH) {
+			break;
+		}
+	}
+	return static_cast<unsigned>(pos - start);
+}
+
 static char escape_char(char const c) {
 	switch (c) {
 	case 't': return '\t';
@@ -203,6 +286,33 @@ static StringRef parser_buffer_ref(KVSParser const& p) {
 	};
 }
 
+// Consume the run of buffered input characters that are (or are not)
+// in set as if by parser_next(), optionally adding them to the buffer.
+// set must contain '\n' and '\r' if !MATCH (and must not if MATCH).
+// Returns the number of characters consumed.
+template<bool MATCH, unsigned N>
+static unsigned parser_consume_run(
+	KVSParser& p,
+	char const (&set)[N],
+	bool const add
+) {
+	if (p.flags & (PF_CARRY | PF_ESCAPED)) {
+		return 0;
+	}
+	unsigned const n = scan_run<MATCH>(p.pos, p.end, set);
+	if (n > 0) {
+		if (add) {
+			unsigned const size = array::size(p.buffer);
+			array::resize(p.buffer, size + n);
+			std::memcpy(array::begin(p.buffer) + size, p.pos, n);
+		}
+		p.c = p.pos[n - 1];
+		p.pos += n;
+		p.column += n;
+	}
+	return n;
+}
+
 inline static KVS& parser_top(KVSParser& p) {
 	return *array::back(p.stack);
 }
@@ -223,18 +333,56 @@ inline static void parser_push(KVSParser& p, KVS& kvs) {
 }
 
 inline static void parser_push_new(KVSParser& p, bool const named) {
+	if (p.visitor) {
+		// Values are not kept, so reuse one value per depth
+		unsigned const depth = array::size(p.stack) - 1;
+		if (depth == array::size(p.pool)) {
+			array::push_back(p.pool, TOGO_CONSTRUCT_DEFAULT(memory::default_allocator(), KVS));
+		}
+		KVS& value = *p.pool[depth];
+		if (named && array::any(p.buffer)) {
+			kvs::set_name(value, parser_buffer_ref(p));
+			parser_buffer_clear(p);
+		} else {
+			kvs::clear_name(value);
+		}
+		parser_push(p, value);
+		return;
+	}
 	KVS& top = parser_top(p);
 	if (!kvs::space(top)) {
-		kvs::grow(top);
+		kvs::grow(top, 0, p.arena);
 	}
 	kvs::resize(top, kvs::size(top) + 1);
 	if (named && array::any(p.buffer)) {
-		kvs::set_name(kvs::back(top), parser_buffer_ref(p));
+		kvs::set_name(kvs::back(top), parser_buffer_ref(p), p.arena);
 		parser_buffer_clear(p);
 	}
 	parser_push(p, kvs::back(top));
 }
 
+inline static bool parser_visiting(KVSParser const& p) {
+	return p.visitor && p.skip_depth == 0;
+}
+
+static void parser_begin_collection(KVSParser& p, KVSType const type) {
+	kvs::set_type(parser_top(p), type);
+	if (parser_visiting(p) && !p.visitor->begin_collection(parser_top(p))) {
+		p.skip_depth = array::size(p.stack);
+	}
+}
+
+static void parser_end_collection(KVSParser& p) {
+	if (parser_visiting(p)) {
+		p.visitor->end_collection(parser_top(p));
+	} else if (p.skip_depth == array::size(p.stack)) {
+		p.skip_depth = 0;
+	} else if (!p.visitor) {
+		kvs::build_index(parser_top(p));
+	}
+	parser_pop(p);
+}
+
 inline static bool parser_set_value(KVSParser& p) {
 	TOGO_DEBUG_ASSERTE(p.value_type != PV_NONE);
 	KVS& top = parser_top(p);
@@ -260,7 +408,7 @@ inline static bool parser_set_value(KVSParser& p) {
 		break;
 
 	case PV_STRING:
-		kvs::string(top, parser_buffer_ref(p));
+		kvs::string(top, parser_buffer_ref(p), p.arena);
 		break;
 
 	case PV_VECTOR:
@@ -273,6 +421,9 @@ inline static bool parser_set_value(KVSParser& p) {
 		p.vec_size = 0;
 		break;
 	}
+	if (parser_visiting(p)) {
+		p.visitor->value(top);
+	}
 	parser_buffer_clear(p);
 	p.stage = (p.flags & PF_VALUE_NAMELESS) ? PS_VALUE : PS_NAME;
 	p.value_type = PV_NONE;
@@ -280,20 +431,35 @@ inline static bool parser_set_value(KVSParser& p) {
 	return true;
 }
 
+static bool parser_fill(KVSParser& p) {
+	if (!p.stream) {
+		return false;
+	}
+	unsigned read_size = 0;
+	IOStatus const status = io::read(*p.stream, p.chunk, PARSER_CHUNK_SIZE, &read_size);
+	p.pos = p.chunk;
+	p.end = p.chunk + read_size;
+	if (status.fail()) {
+		return PARSER_ERROR(p, "stream read failure");
+	}
+	return read_size > 0;
+}
+
 static bool parser_next(KVSParser& p) {
 	if (p.flags & PF_CARRY) {
 		p.flags &= ~PF_CARRY;
 		return true;
 	}
-	char c = '\0';
-	do {} while (io::read_value(p.stream, c) && c == '\r');
-	p.c = c;
-	IOStatus const& status = io::status(p.stream);
-	if (status.eof()) {
-		p.c = PC_EOF;
-	} else if (status.fail()) {
-		return PARSER_ERROR(p, "stream read failure");
-	}
+	do {
+		if (p.pos == p.end && !parser_fill(p)) {
+			if (p.flags & PF_ERROR) {
+				return false;
+			}
+			p.c = PC_EOF;
+			break;
+		}
+		p.c = *p.pos++;
+	} while (p.c == '\r');
 	if (p.c == '\n') {
 		++p.line;
 		p.column = 0;
@@ -305,6 +471,7 @@ static bool parser_next(KVSParser& p) {
 
 static bool parser_skip_whitespace(KVSParser& p, bool const newline) {
 	while (p.c == ' ' || p.c == '\t' || (newline && p.c == '\n')) {
+		parser_consume_run<true>(p, s_scan_whitespace, false);
 		if (!parser_next(p)) {
 			return false;
 		}
@@ -321,6 +488,7 @@ static bool parser_skip_comment(KVSParser& p) {
 			if (p.c == '\n' || p.c == PC_EOF) {
 				return true;
 			}
+			parser_consume_run<false>(p, s_scan_comment_line, false);
 		}
 		return false;
 	} else if (p.c == '*') {
@@ -342,6 +510,9 @@ static bool parser_skip_comment(KVSParser& p) {
 
 			default: tail = false; break;
 			}
+			if (parser_consume_run<false>(p, s_scan_comment_block, false)) {
+				tail = false;
+			}
 		}
 		return false;
 	} else if (p.c == PC_EOF) {
@@ -463,6 +634,7 @@ static bool parser_read_string(KVSParser& p) {
 			return PARSER_ERROR_UNEXPECTED(p, "symbol in string");
 		}
 		parser_buffer_add(p);
+		parser_consume_run<false>(p, s_scan_string, true);
 	} while (parser_next(p));
 	return false;
 
@@ -507,6 +679,7 @@ static bool parser_read_string_quote(KVSParser& p) {
 			return PARSER_ERROR(p, "unexpected newline in double-quote bounded string");
 		}
 		parser_buffer_add(p);
+		parser_consume_run<false>(p, s_scan_string_quote, true);
 	}
 	return false;
 }
@@ -519,7 +692,7 @@ static bool parser_read_string_block(KVSParser& p) {
 		}
 		++count;
 	}
-	if (!io::status(p.stream)) {
+	if (p.flags & PF_ERROR) {
 		return false;
 	}
 	count = 0;
@@ -536,6 +709,9 @@ static bool parser_read_string_block(KVSParser& p) {
 			count = 0;
 		}
 		parser_buffer_add(p);
+		if (parser_consume_run<false>(p, s_scan_string_block, true)) {
+			count = 0;
+		}
 	}
 	return false;
 }
@@ -600,7 +776,7 @@ static void parser_stage_name(KVSParser& p) {
 		if (array::size(p.stack) == 1) {
 			PARSER_ERROR(p, "unbalanced '}' at root level");
 		} else if (kvs::is_type(parser_top(p), KVSType::node)) {
-			parser_pop(p);
+			parser_end_collection(p);
 		} else {
 			PARSER_ERROR_EXPECTED(p, "identifier");
 		}
@@ -688,7 +864,7 @@ static void parser_stage_value(KVSParser& p) {
 		if (~p.flags & PF_ASSIGN) {
 			parser_push_new(p, false);
 		}
-		kvs::set_type(parser_top(p), KVSType::node);
+		parser_begin_collection(p, KVSType::node);
 		p.stage = PS_NAME;
 		p.flags &= ~(PF_NAME | PF_ASSIGN | PF_VALUE_NAMELESS);
 		break;
@@ -697,7 +873,7 @@ static void parser_stage_value(KVSParser& p) {
 		if (~p.flags & PF_ASSIGN) {
 			parser_push_new(p, false);
 		}
-		kvs::set_type(parser_top(p), KVSType::array);
+		parser_begin_collection(p, KVSType::array);
 		p.flags |= PF_VALUE_NAMELESS;
 		p.flags &= ~(PF_NAME | PF_ASSIGN);
 		break;
@@ -706,7 +882,7 @@ static void parser_stage_value(KVSParser& p) {
 		if (array::size(p.stack) == 1) {
 			PARSER_ERROR(p, "unbalanced ']' at root level");
 		} else if (kvs::is_type(parser_top(p), KVSType::array)) {
-			parser_pop(p);
+			parser_end_collection(p);
 		} else {
 			PARSER_ERROR_EXPECTED(p, "value");
 		}
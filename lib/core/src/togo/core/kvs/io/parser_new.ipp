@@ -6,7 +6,6 @@
 #include <togo/core/config.hpp>
 #include <togo/core/error/assert.hpp>
 #include <togo/core/memory/memory.hpp>
-#include <togo/core/memory/fixed_allocator.hpp>
 #include <togo/core/collection/array.hpp>
 #include <togo/core/io/io.hpp>
 #include <togo/core/parser/parser.hpp>
@@ -67,13 +66,7 @@ void string_copy_unescape(char* dst, unsigned capacity, unsigned num_escapes, St
 	*dst = '\0';
 }
 
-FixedAllocator<1536> p_storage;
-
-#define TOGO_PARSER_DEF(name_, ...) \
-	Parser const name_{"KVS." #name_, __VA_ARGS__};
-
-TOGO_PARSER_DEF(p_comment_block,
-Func{[](Parser const*, ParseState& s, ParsePosition const&) {
+inline ParseResultCode pf_comment_block(Parser const*, ParseState& s, ParsePosition const&) {
 	if (s.p >= s.e || *s.p++ != '/') {
 		return fail(s);
 	}
@@ -107,10 +100,9 @@ Func{[](Parser const*, ParseState& s, ParsePosition const&) {
 		return fail(s, "unclosed block comment (at depth %u)", depth);
 	}
 	return ok(s);
-}})
+}
 
-TOGO_PARSER_DEF(p_comment_single,
-Func{[](Parser const*, ParseState& s, ParsePosition const&) {
+inline ParseResultCode pf_comment_single(Parser const*, ParseState& s, ParsePosition const&) {
 	if (s.p >= s.e || *s.p++ != '/') {
 		return fail(s);
 	}
@@ -124,18 +116,9 @@ Func{[](Parser const*, ParseState& s, ParsePosition const&) {
 		}
 	}
 	return ok(s);
-}})
-
-TOGO_PARSER_DEF(p_comment,
-PMod::test,
-Any{p_storage,
-	p_comment_block,
-	p_comment_single
-})
-
-TOGO_PARSER_DEF(p_separator,
-PMod::test,
-Func{[](Parser const*, ParseState& s, ParsePosition const& from) {
+}
+
+inline ParseResultCode pf_separator(Parser const*, ParseState& s, ParsePosition const& from) {
 	while (s.p < s.e) {
 		signed c = *s.p;
 		if (!(false
@@ -154,20 +137,8 @@ Func{[](Parser const*, ParseState& s, ParsePosition const& from) {
 	}
 	return fail(s);
 }
-})
-
-TOGO_PARSER_DEF(p_fluff,
-PMod::repeat_or_none,
-Any{p_storage,
-	PDef::whitespace,
-	p_separator,
-	p_comment
-})
-
-TOGO_PARSER_DEF(p_value_f64,
-PMod::flatten,
-Close{p_storage,
-Func{[](Parser const*, ParseState& s, ParsePosition const&) {
+
+inline ParseResultCode pf_value_f64_scan(Parser const*, ParseState& s, ParsePosition const&) {
 	enum : unsigned {
 		PART_DECIMAL  = 1 << 0,
 		PART_EXPONENT = 1 << 1,
@@ -194,15 +165,14 @@ Func{[](Parser const*, ParseState& s, ParsePosition const&) {
 		return fail(s, "floating-point number must have at least a decimal point or an exponent");
 	}
 	return ok(s);
-}},
-[](Parser const*, ParseState& s, ParsePosition const& from) {
+}
+
+inline ParseResultCode pf_value_f64(Parser const*, ParseState& s, ParsePosition const& from) {
 	auto& r = back(s.results);
 	return ok_replace(s, from, {parser::parse_f64({r.s.b, r.s.e})});
 }
-})
 
-TOGO_PARSER_DEF(p_value_string_identifier,
-Func{[](Parser const*, ParseState& s, ParsePosition const& from) {
+inline ParseResultCode pf_value_string_identifier(Parser const*, ParseState& s, ParsePosition const& from) {
 	if (s.p >= s.e) {
 		return fail(s);
 	}
@@ -233,10 +203,9 @@ Func{[](Parser const*, ParseState& s, ParsePosition const& from) {
 		}
 	}
 	return ok(s, {from.p, s.p});
-}})
+}
 
-TOGO_PARSER_DEF(p_value_string_quote,
-Func{[](Parser const*, ParseState& s, ParsePosition const& from) {
+inline ParseResultCode pf_value_string_quote(Parser const*, ParseState& s, ParsePosition const& from) {
 	if (s.p >= s.e || *s.p++ != '\"') {
 		return fail(s);
 	}
@@ -261,10 +230,9 @@ Func{[](Parser const*, ParseState& s, ParsePosition const& from) {
 		}
 	}
 	return fail(s, "expected \" to end quoted string");
-}})
+}
 
-TOGO_PARSER_DEF(p_value_string_block,
-Func{[](Parser const*, ParseState& s, ParsePosition const& from) {
+inline ParseResultCode pf_value_string_block(Parser const*, ParseState& s, ParsePosition const& from) {
 	if (s.p >= s.e || *s.p++ != '`') {
 		return fail(s);
 	}
@@ -288,20 +256,9 @@ Func{[](Parser const*, ParseState& s, ParsePosition const& from) {
 		}
 	}
 	return fail(s, "expected ``` to end block string");
-}})
-
-TOGO_PARSER_DEF(p_value_vector,
-Close{p_storage,
-Bounded{p_storage,
-	'(', ')', Parser{
-	PMod::repeat,
-	Any{p_storage,
-		p_fluff,
-		p_value_f64,
-		PDef::s64_any
-	}}
-},
-[](Parser const*, ParseState& s, ParsePosition const& from) {
+}
+
+inline ParseResultCode pf_value_vector(Parser const*, ParseState& s, ParsePosition const& from) {
 	auto& k = parser_node_current(s);
 	unsigned nr = num_results(s, from);
 	switch (nr) {
@@ -339,26 +296,9 @@ Bounded{p_storage,
 		return fail(s, "vector must have only 1 to 4 dimensions, but input has %u dimensions", nr);
 	}
 	return ok_replace(s, from);
-}})
-
-extern Parser const p_value_array;
-extern Parser const p_value_node;
+}
 
-TOGO_PARSER_DEF(p_instance_value,
-Close{p_storage,
-Any{p_storage,
-	PDef::null,
-	PDef::boolean,
-	p_value_f64,
-	PDef::s64_any,
-	p_value_string_identifier,
-	p_value_string_quote,
-	p_value_string_block,
-	p_value_vector,
-	p_value_array,
-	p_value_node
-},
-[](Parser const*, ParseState& s, ParsePosition const& from) {
+inline ParseResultCode pf_instance_value(Parser const*, ParseState& s, ParsePosition const& from) {
 	unsigned nr = num_results(s, from);
 	if (nr == 0) {
 		return ok(s);
@@ -394,7 +334,7 @@ Any{p_storage,
 		TOGO_ASSERT(false, "unexpected result type");
 	}
 	return ok_replace(s, from);
-}})
+}
 
 inline ParseResultCode pf_instance_open(Parser const*, ParseState& s, ParsePosition const&) {
 	auto& k = parser_node_current(s);
@@ -412,26 +352,7 @@ inline ParseResultCode pf_instance_close(Parser const*, ParseState& s, ParsePosi
 	return s.result_code;
 }
 
-TOGO_PARSER_DEF(p_instance,
-CloseAndFlush{p_storage,
-	pf_instance_close,
-Open{
-	pf_instance_open,
-	p_instance_value,
-}})
-
-TOGO_PARSER_DEF(p_name,
-Close{p_storage,
-All{p_storage,
-	Any{p_storage,
-		p_value_string_identifier,
-		p_value_string_quote,
-		p_value_string_block,
-	},
-	PDef::space_maybe,
-	Parser{PMod::test, Char{'='}}
-},
-[](Parser const*, ParseState& s, ParsePosition const& from) {
+inline ParseResultCode pf_name(Parser const*, ParseState& s, ParsePosition const& from) {
 	auto& r = result(s, from, 0);
 	auto& k = parser_node_current(s);
 	if (r.type == ParseResult::type_slice) {
@@ -459,69 +380,110 @@ All{p_storage,
 		TOGO_DEBUG_ASSERT(false, "expected identifier or quoted string");
 	}
 	return ok_replace(s, from);
-}})
-
-TOGO_PARSER_DEF(p_instance_named,
-CloseAndFlush{p_storage,
-	pf_instance_close,
-Open{p_storage,
-	pf_instance_open,
-All{p_storage,
-	p_name,
-	PDef::space_maybe,
-	p_instance_value
-}}})
-
-TOGO_PARSER_DEF(p_items_array,
-PMod::repeat_or_none,
-All{p_storage,
-	p_fluff,
-	p_instance
-	// Parser{PMod::maybe, Ref{p_instance}}
-})
-
-TOGO_PARSER_DEF(p_value_array,
-Open{p_storage,
-Bounded{p_storage,
-	'[', ']',
-All{p_storage,
-	p_fluff,
-	p_items_array
-}},
-[](Parser const*, ParseState& s, ParsePosition const&) {
+}
+
+inline ParseResultCode pf_value_array_open(Parser const*, ParseState& s, ParsePosition const&) {
 	kvs::set_type(parser_node_current(s), KVSType::array);
 	return ok(s);
-}})
-
-TOGO_PARSER_DEF(p_items_node,
-PMod::repeat_or_none,
-All{p_storage,
-	p_fluff,
-	p_instance_named
-	// Parser{PMod::maybe, Ref{p_instance_named}}
-})
-
-TOGO_PARSER_DEF(p_value_node,
-Open{p_storage,
-Bounded{
-	'{', '}',
-	p_items_node,
-},
-[](Parser const*, ParseState& s, ParsePosition const&) {
+}
+
+inline ParseResultCode pf_value_node_open(Parser const*, ParseState& s, ParsePosition const&) {
 	kvs::set_type(parser_node_current(s), KVSType::node);
 	return ok(s);
-}})
+}
+
+// The grammar is constant-initialized. Series are defined over static
+// pointer arrays and unnamed sub-parsers are separate nodes.
+
+#define TOGO_PARSER_DEF(name_, ...) \
+	Parser const name_{"KVS." #name_, __VA_ARGS__};
+
+#define TOGO_PARSER_NODE(name_, ...) \
+	static Parser const name_{__VA_ARGS__};
+
+#define TOGO_PARSER_SERIES(name_, ...) \
+	static Parser const* name_[]{__VA_ARGS__};
+
+extern Parser const p_value_array;
+extern Parser const p_value_node;
+
+TOGO_PARSER_DEF(p_comment_block, Func{pf_comment_block})
+TOGO_PARSER_DEF(p_comment_single, Func{pf_comment_single})
+
+TOGO_PARSER_SERIES(s_comment, &p_comment_block, &p_comment_single)
+TOGO_PARSER_DEF(p_comment, PMod::test, Any{s_comment})
+
+TOGO_PARSER_DEF(p_separator, PMod::test, Func{pf_separator})
+
+TOGO_PARSER_SERIES(s_fluff, &PDef::whitespace, &p_separator, &p_comment)
+TOGO_PARSER_DEF(p_fluff, PMod::repeat_or_none, Any{s_fluff})
+
+TOGO_PARSER_NODE(n_value_f64_scan, Func{pf_value_f64_scan})
+TOGO_PARSER_DEF(p_value_f64, PMod::flatten, Close{pf_value_f64, n_value_f64_scan})
+
+TOGO_PARSER_DEF(p_value_string_identifier, Func{pf_value_string_identifier})
+TOGO_PARSER_DEF(p_value_string_quote, Func{pf_value_string_quote})
+TOGO_PARSER_DEF(p_value_string_block, Func{pf_value_string_block})
+
+TOGO_PARSER_SERIES(s_vector_item, &p_fluff, &p_value_f64, &PDef::s64_any)
+TOGO_PARSER_NODE(n_vector_items, PMod::repeat, Any{s_vector_item})
+TOGO_PARSER_NODE(n_vector_bounded, Bounded{'(', ')', n_vector_items})
+TOGO_PARSER_DEF(p_value_vector, Close{pf_value_vector, n_vector_bounded})
+
+TOGO_PARSER_SERIES(s_instance_value,
+	&PDef::null,
+	&PDef::boolean,
+	&p_value_f64,
+	&PDef::s64_any,
+	&p_value_string_identifier,
+	&p_value_string_quote,
+	&p_value_string_block,
+	&p_value_vector,
+	&p_value_array,
+	&p_value_node
+)
+TOGO_PARSER_NODE(n_instance_value_any, Any{s_instance_value})
+TOGO_PARSER_DEF(p_instance_value, Close{pf_instance_value, n_instance_value_any})
+
+TOGO_PARSER_NODE(n_instance_open, Open{pf_instance_open, p_instance_value})
+TOGO_PARSER_DEF(p_instance, CloseAndFlush{pf_instance_close, n_instance_open})
+
+TOGO_PARSER_SERIES(s_name_string, &p_value_string_identifier, &p_value_string_quote, &p_value_string_block)
+TOGO_PARSER_NODE(n_name_string, Any{s_name_string})
+TOGO_PARSER_NODE(n_name_assign, PMod::test, Char{'='})
+TOGO_PARSER_SERIES(s_name, &n_name_string, &PDef::space_maybe, &n_name_assign)
+TOGO_PARSER_NODE(n_name, All{s_name})
+TOGO_PARSER_DEF(p_name, Close{pf_name, n_name})
+
+TOGO_PARSER_SERIES(s_instance_named, &p_name, &PDef::space_maybe, &p_instance_value)
+TOGO_PARSER_NODE(n_instance_named, All{s_instance_named})
+TOGO_PARSER_NODE(n_instance_named_open, Open{pf_instance_open, n_instance_named})
+TOGO_PARSER_DEF(p_instance_named, CloseAndFlush{pf_instance_close, n_instance_named_open})
+
+TOGO_PARSER_SERIES(s_items_array, &p_fluff, &p_instance)
+TOGO_PARSER_DEF(p_items_array, PMod::repeat_or_none, All{s_items_array})
+
+TOGO_PARSER_SERIES(s_array, &p_fluff, &p_items_array)
+TOGO_PARSER_NODE(n_array, All{s_array})
+TOGO_PARSER_NODE(n_array_bounded, Bounded{'[', ']', n_array})
+TOGO_PARSER_DEF(p_value_array, Open{pf_value_array_open, n_array_bounded})
+
+TOGO_PARSER_SERIES(s_items_node, &p_fluff, &p_instance_named)
+TOGO_PARSER_DEF(p_items_node, PMod::repeat_or_none, All{s_items_node})
+
+TOGO_PARSER_NODE(n_node_bounded, Bounded{'{', '}', p_items_node})
+TOGO_PARSER_DEF(p_value_node, Open{pf_value_node_open, n_node_bounded})
+
+TOGO_PARSER_NODE(n_root_head, Head{})
+TOGO_PARSER_NODE(n_root_tail, Tail{})
+TOGO_PARSER_SERIES(s_root, &n_root_head, &p_fluff, &p_items_node, &n_root_tail)
 
 } // anonymous namespace
 
-TOGO_PARSER_DEF(p_root,
-All{p_storage,
-	Head{},
-	p_fluff,
-	p_items_node,
-	Tail{}
-})
+TOGO_PARSER_DEF(p_root, All{s_root})
 
+#undef TOGO_PARSER_SERIES
+#undef TOGO_PARSER_NODE
 #undef TOGO_PARSER_DEF
 
 } // namespace togo
@@ -12,6 +12,7 @@
 #include <togo/core/io/types.hpp>
 #include <togo/core/io/io.hpp>
 #include <togo/core/io/file_stream.hpp>
+#include <togo/core/filesystem/filesystem.hpp>
 #include <togo/core/kvs/kvs.hpp>
 #include <togo/core/kvs/io/binary.ipp>
 #include <togo/core/serialization/types.hpp>
@@ -25,22 +26,15 @@ namespace {
 enum : u32 {
 	SER_FORMAT_VERSION_KVS = 1,
 };
-} // anonymous namespace
 
-/// Read binary-format KVS from stream.
-///
-/// An assertion will fail if either the format version does not match the
-/// deserializer or an IO error occurs.
-IOStatus kvs::read_binary(
+template<class Ser>
+static void read_binary_impl(
 	KVS& root,
-	IReader& stream,
-	Endian const endian IGEN_DEFAULT(Endian::little)
+	Ser& ser,
+	IKVSVisitor* const visitor,
+	KVSArena* const arena
 ) {
-	kvs::set_type(root, KVSType::node);
-	kvs::clear(root);
-
 	TempAllocator<2048> allocator{};
-	BinaryInputSerializer ser{stream, endian};
 	u32 format_version;
 	ser % format_version;
 	TOGO_ASSERTF(
@@ -51,16 +45,71 @@ IOStatus kvs::read_binary(
 
 	Array<char> scratch{allocator};
 	array::reserve(scratch, 2048 - sizeof(void*));
-	kvs_read_binary(root, ser, scratch);
+	if (visitor) {
+		kvs_visit_binary(root, ser, scratch, visitor);
+	} else {
+		kvs_read_binary(root, ser, scratch, arena);
+	}
+}
+
+inline ArrayRef<u8 const> mapped_data(MappedFile const& file) {
+	return array_cref(file.data, static_cast<unsigned>(file.size));
+}
+
+} // anonymous namespace
+
+/// Read binary-format KVS from stream.
+///
+/// An assertion will fail if either the format version does not match the
+/// deserializer or an IO error occurs.
+///
+/// If arena is non-null, names, strings and collections are allocated
+/// from it.
+IOStatus kvs::read_binary(
+	KVS& root,
+	IReader& stream,
+	Endian const endian IGEN_DEFAULT(Endian::little),
+	KVSArena* const arena IGEN_DEFAULT(nullptr)
+) {
+	kvs::set_type(root, KVSType::node);
+	kvs::clear(root);
+	BinaryInputSerializer ser{stream, endian};
+	read_binary_impl(root, ser, nullptr, arena);
 	return io::status(stream);
 }
 
+/// Read binary-format KVS from memory.
+///
+/// This is equivalent to read_binary(KVS&, IReader&, Endian, KVSArena*),
+/// but deserializes directly from data.
+/// An assertion will fail if data is too small.
+void kvs::read_binary(
+	KVS& root,
+	ArrayRef<u8 const> const& data,
+	Endian const endian IGEN_DEFAULT(Endian::little),
+	KVSArena* const arena IGEN_DEFAULT(nullptr)
+) {
+	kvs::set_type(root, KVSType::node);
+	kvs::clear(root);
+	BinaryMemoryInputSerializer ser{data, endian};
+	read_binary_impl(root, ser, nullptr, arena);
+}
+
 /// Read binary-format KVS from file.
+///
+/// The file is memory-mapped if possible.
 bool kvs::read_binary_file(
 	KVS& root,
 	StringRef const& path,
-	Endian const endian IGEN_DEFAULT(Endian::little)
+	Endian const endian IGEN_DEFAULT(Endian::little),
+	KVSArena* const arena IGEN_DEFAULT(nullptr)
 ) {
+	MappedFile file{};
+	if (filesystem::map_file(file, path) && file.data) {
+		kvs::read_binary(root, mapped_data(file), endian, arena);
+		return true;
+	}
+
 	FileReader stream{};
 	if (!stream.open(path)) {
 		TOGO_LOG_ERRORF(
@@ -70,7 +119,65 @@ bool kvs::read_binary_file(
 		return false;
 	}
 
-	bool success = kvs::read_binary(root, stream, endian).ok();
+	bool success = kvs::read_binary(root, stream, endian, arena).ok();
+	stream.close();
+	return success;
+}
+
+/// Visit binary-format KVS from stream.
+///
+/// Values are passed to visitor as they are read instead of being
+/// collected into a tree.
+///
+/// An assertion will fail if either the format version does not match the
+/// deserializer or an IO error occurs.
+IOStatus kvs::visit_binary(
+	IKVSVisitor& visitor,
+	IReader& stream,
+	Endian const endian IGEN_DEFAULT(Endian::little)
+) {
+	KVS root{KVSType::node};
+	BinaryInputSerializer ser{stream, endian};
+	read_binary_impl(root, ser, &visitor, nullptr);
+	return io::status(stream);
+}
+
+/// Visit binary-format KVS from memory.
+///
+/// See visit_binary(IKVSVisitor&, IReader&, Endian).
+void kvs::visit_binary(
+	IKVSVisitor& visitor,
+	ArrayRef<u8 const> const& data,
+	Endian const endian IGEN_DEFAULT(Endian::little)
+) {
+	KVS root{KVSType::node};
+	BinaryMemoryInputSerializer ser{data, endian};
+	read_binary_impl(root, ser, &visitor, nullptr);
+}
+
+/// Visit binary-format KVS from file.
+///
+/// The file is memory-mapped if possible.
+bool kvs::visit_binary_file(
+	IKVSVisitor& visitor,
+	StringRef const& path,
+	Endian const endian IGEN_DEFAULT(Endian::little)
+) {
+	MappedFile file{};
+	if (filesystem::map_file(file, path) && file.data) {
+		kvs::visit_binary(visitor, mapped_data(file), endian);
+		return true;
+	}
+
+	FileReader stream{};
+	if (!stream.open(path)) {
+		TOGO_LOG_ERRORF(
+			"failed to read KVS binary from '%.*s': failed to open file\n",
+			path.size, path.data
+		);
+		return false;
+	}
+	bool success = kvs::visit_binary(visitor, stream, endian).ok();
 	stream.close();
 	return success;
 }
@@ -91,6 +198,21 @@ IOStatus kvs::write_binary(
 	return io::status(stream);
 }
 
+/// Write binary-format KVS to memory.
+///
+/// Serial data is appended to buffer.
+/// root must be a node.
+void kvs::write_binary(
+	KVS const& root,
+	Array<u8>& buffer,
+	Endian const endian IGEN_DEFAULT(Endian::little)
+) {
+	TOGO_ASSERT(kvs::type(root) == KVSType::node, "root must be a node");
+	BinaryMemoryOutputSerializer ser{buffer, endian};
+	ser % u32{SER_FORMAT_VERSION_KVS};
+	kvs_write_binary(root, ser);
+}
+
 /// Write binary-format KVS to file.
 bool kvs::write_binary_file(
 	KVS const& root,
@@ -106,7 +228,10 @@ bool kvs::write_binary_file(
 		return false;
 	}
 
-	bool success = kvs::write_binary(root, stream, endian).ok();
+	// Serialize in memory so the file sees a single write
+	Array<u8> buffer{memory::scratch_allocator()};
+	kvs::write_binary(root, buffer, endian);
+	bool success = io::write(stream, array::begin(buffer), array::size(buffer)).ok();
 	stream.close();
 	return success;
 }
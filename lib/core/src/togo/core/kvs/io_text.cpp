@@ -13,6 +13,8 @@
 #include <togo/core/io/types.hpp>
 #include <togo/core/io/io.hpp>
 #include <togo/core/io/file_stream.hpp>
+#include <togo/core/filesystem/types.hpp>
+#include <togo/core/filesystem/filesystem.hpp>
 #include <togo/core/kvs/kvs.hpp>
 #include <togo/core/kvs/io/parser.ipp>
 
@@ -20,24 +22,32 @@
 
 namespace togo {
 
-/// Read text-format KVS from stream.
-///
-/// Returns false if a parser error occurred. pinfo will have the
-/// position and error message of the parser.
-bool kvs::read_text(KVS& root, IReader& stream, KVSParserInfo& pinfo) {
+namespace {
+
+static bool read_text_impl(
+	KVS& root,
+	IReader* const stream,
+	ArrayRef<char const> const& data,
+	KVSParserInfo& pinfo,
+	KVSArena* const arena,
+	IKVSVisitor* const visitor
+) {
 	TempAllocator<4096> allocator{};
+	char chunk[PARSER_CHUNK_SIZE];
 	KVSParser p{
-		root, stream, pinfo,
+		root, stream, pinfo, arena, visitor,
+		chunk, begin(data), end(data),
+		{allocator},
 		{allocator},
 		{allocator},
 		1, 0, PC_EOF,
 		Vec4{no_init_tag{}}, 0,
-		PF_NONE,
+		PF_NONE, 0,
 		PS_NAME,
 		PV_NONE
 	};
 	array::reserve(p.stack, 32);
-	array::reserve(p.buffer, 4096 - (1 + 32) * sizeof(void*));
+	array::reserve(p.buffer, 4096 - (1 + 32 + (visitor ? 32 : 0)) * sizeof(void*));
 	kvs::set_type(p.root, KVSType::node);
 	kvs::clear(p.root);
 	parser_push(p, p.root);
@@ -59,18 +69,55 @@ bool kvs::read_text(KVS& root, IReader& stream, KVSParserInfo& pinfo) {
 	}
 	if (p.flags & PF_ERROR) {
 		// do nothing
-	} else if (io::status(p.stream).fail()) {
+	} else if (p.stream && io::status(*p.stream).fail()) {
 		PARSER_ERROR(p, "stream read failure");
 	} else if (p.c == PC_EOF) {
 		if (p.flags & (PF_NAME | PF_ASSIGN)) {
 			PARSER_ERROR(p, "expected value, got EOF");
 		} else if (array::size(p.stack) > 1) {
 			PARSER_ERRORF(p, "%u unclosed collection(s) at EOF", array::size(p.stack) - 1);
+		} else if (!p.visitor) {
+			kvs::build_index(p.root);
 		}
 	}
+	for (KVS* value : p.pool) {
+		TOGO_DESTROY(memory::default_allocator(), value);
+	}
 	return ~p.flags & PF_ERROR;
 }
 
+} // anonymous namespace
+
+/// Read text-format KVS from stream.
+///
+/// Returns false if a parser error occurred. pinfo will have the
+/// position and error message of the parser.
+///
+/// If arena is non-null, names, strings and collections are allocated
+/// from it.
+bool kvs::read_text(
+	KVS& root,
+	IReader& stream,
+	KVSParserInfo& pinfo,
+	KVSArena* const arena IGEN_DEFAULT(nullptr)
+) {
+	return read_text_impl(root, &stream, null_ref_tag{}, pinfo, arena, nullptr);
+}
+
+/// Read text-format KVS from memory.
+///
+/// This is the fastest way to read text-format KVS: runs of
+/// whitespace, comments and strings are scanned in bulk.
+/// See read_text(KVS&, IReader&, KVSParserInfo&, KVSArena*).
+bool kvs::read_text(
+	KVS& root,
+	ArrayRef<char const> const& data,
+	KVSParserInfo& pinfo,
+	KVSArena* const arena IGEN_DEFAULT(nullptr)
+) {
+	return read_text_impl(root, nullptr, data, pinfo, arena, nullptr);
+}
+
 /// Read text-format KVS from stream (sans parser info).
 bool kvs::read_text(KVS& root, IReader& stream) {
 	KVSParserInfo pinfo;
@@ -85,18 +132,99 @@ bool kvs::read_text(KVS& root, IReader& stream) {
 }
 
 /// Read text-format KVS from file.
-bool kvs::read_text_file(KVS& root, StringRef const& path) {
-	FileReader stream{};
-	if (!stream.open(path)) {
+///
+/// The file is memory-mapped if possible.
+///
+/// If arena is non-null, names, strings and collections are allocated
+/// from it.
+bool kvs::read_text_file(
+	KVS& root,
+	StringRef const& path,
+	KVSArena* const arena IGEN_DEFAULT(nullptr)
+) {
+	KVSParserInfo pinfo;
+	bool success;
+	MappedFile file{};
+	if (filesystem::map_file(file, path) && file.data) {
+		success = kvs::read_text(root, array_cref(
+			reinterpret_cast<char const*>(file.data),
+			static_cast<unsigned>(file.size)
+		), pinfo, arena);
+	} else {
+		FileReader stream{};
+		if (!stream.open(path)) {
+			TOGO_LOG_ERRORF(
+				"failed to read KVS from '%.*s': failed to open file\n",
+				path.size, path.data
+			);
+			return false;
+		}
+		success = kvs::read_text(root, stream, pinfo, arena);
+		stream.close();
+	}
+	if (!success) {
 		TOGO_LOG_ERRORF(
-			"failed to read KVS from '%.*s': failed to open file\n",
-			path.size, path.data
+			"failed to read KVS from '%.*s': [%2u,%2u]: %s\n",
+			path.size, path.data,
+			pinfo.line, pinfo.column, pinfo.message
 		);
-		return false;
 	}
+	return success;
+}
+
+/// Visit text-format KVS from stream.
+///
+/// Values are passed to visitor as they are read instead of being
+/// collected into a tree.
+///
+/// Returns false if a parser error occurred. pinfo will have the
+/// position and error message of the parser. visitor may have been
+/// called for values before the error.
+bool kvs::visit_text(
+	IKVSVisitor& visitor,
+	IReader& stream,
+	KVSParserInfo& pinfo
+) {
+	KVS root;
+	return read_text_impl(root, &stream, null_ref_tag{}, pinfo, nullptr, &visitor);
+}
 
+/// Visit text-format KVS from memory.
+///
+/// See visit_text(IKVSVisitor&, IReader&, KVSParserInfo&).
+bool kvs::visit_text(
+	IKVSVisitor& visitor,
+	ArrayRef<char const> const& data,
+	KVSParserInfo& pinfo
+) {
+	KVS root;
+	return read_text_impl(root, nullptr, data, pinfo, nullptr, &visitor);
+}
+
+/// Visit text-format KVS from file.
+///
+/// The file is memory-mapped if possible.
+bool kvs::visit_text_file(IKVSVisitor& visitor, StringRef const& path) {
 	KVSParserInfo pinfo;
-	bool const success = kvs::read_text(root, stream, pinfo);
+	bool success;
+	MappedFile file{};
+	if (filesystem::map_file(file, path) && file.data) {
+		success = kvs::visit_text(visitor, array_cref(
+			reinterpret_cast<char const*>(file.data),
+			static_cast<unsigned>(file.size)
+		), pinfo);
+	} else {
+		FileReader stream{};
+		if (!stream.open(path)) {
+			TOGO_LOG_ERRORF(
+				"failed to read KVS from '%.*s': failed to open file\n",
+				path.size, path.data
+			);
+			return false;
+		}
+		success = kvs::visit_text(visitor, stream, pinfo);
+		stream.close();
+	}
 	if (!success) {
 		TOGO_LOG_ERRORF(
 			"failed to read KVS from '%.*s': [%2u,%2u]: %s\n",
@@ -104,7 +232,6 @@ bool kvs::read_text_file(KVS& root, StringRef const& path) {
 			pinfo.line, pinfo.column, pinfo.message
 		);
 	}
-	stream.close();
 	return success;
 }
 
@@ -28,17 +28,27 @@ namespace togo {
 /// Returns false if a parse error occurred.
 bool kvs::read_text_new(KVS& root, ArrayRef<char const> data, ParseError* error IGEN_DEFAULT(nullptr)) {
 	TempAllocator<4096> allocator{};
-	KVSParseState ud{0};
-	ParseState state{
-		allocator,
-		&ud
-	};
+	ParseState state{allocator};
 	array::reserve(state.results, (4096 / sizeof(ParseResult)) - sizeof(void*));
+	return kvs::read_text_new(root, data, state, error);
+}
+
+/// Read text-format KVS from stream with a reusable parse state.
+///
+/// The storage of state is kept between calls (see parse_state::reset()),
+/// so reading many small inputs with one state does not allocate once it
+/// has grown to fit the largest.
+///
+/// Returns false if a parse error occurred.
+bool kvs::read_text_new(KVS& root, ArrayRef<char const> data, ParseState& state, ParseError* error IGEN_DEFAULT(nullptr)) {
+	KVSParseState ud{0};
+	parse_state::reset(state, &ud);
 	kvs::set_type(root, KVSType::node);
 	kvs::clear(root);
 	set_data_array(state, data);
 	push(state, {rtype_kvs, &root});
 	bool success = parser::parse(p_root, state, error);
+	state.userdata = nullptr;
 	return success;
 }
 
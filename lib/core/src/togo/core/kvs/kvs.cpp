@@ -16,9 +16,109 @@
 
 namespace togo {
 
+/** @cond INTERNAL */
+
+// Open-addressed table of child indices keyed by name hash. Only the
+// first child with a given name is inserted. Children [0, size) are
+// indexed and the rest are searched linearly.
+//
+// Indexed children point back to the index through _parent_index.
+// Renaming one marks the index stale; a stale index is rebuilt by the
+// next non-const kvs::find() and ignored by const lookups.
+struct KVSIndex {
+	enum : u32 {
+		// Collections smaller than this are not indexed
+		MIN_SIZE = 32,
+		EMPTY = ~u32{0},
+	};
+
+	u32 size;
+	u32 num_slots;
+	bool stale;
+
+	inline u32* slots() {
+		return reinterpret_cast<u32*>(this + 1);
+	}
+
+	inline u32 const* slots() const {
+		return reinterpret_cast<u32 const*>(this + 1);
+	}
+};
+
+/** @endcond */ // INTERNAL
+
+namespace {
+
+enum : u32 {
+	ARENA_BLOCK_SIZE_MIN = 16 * 1024,
+	ARENA_BLOCK_SIZE_MAX = 1024 * 1024,
+};
+
+#define ARENA_BLOCK_PREV(block) \
+	*reinterpret_cast<char**>(block)
+
+static void* arena_allocate(KVSArena& arena, u32 const size, u32 const align) {
+	char* p = pointer_align(arena._put, align);
+	if (!arena._block || signed_cast(size) > arena._end - p) {
+		u32 const block_size = max(
+			arena._block_size,
+			u32{sizeof(char*)} + size + align
+		);
+		char* const block = static_cast<char*>(
+			arena._allocator.allocate(block_size, alignof(char*))
+		);
+		ARENA_BLOCK_PREV(block) = arena._block;
+		arena._block = block;
+		arena._end = block + block_size;
+		arena._block_size = min(arena._block_size * 2, u32{ARENA_BLOCK_SIZE_MAX});
+		p = pointer_align(block + sizeof(char*), align);
+	}
+	arena._put = p + size;
+	return p;
+}
+
+// Allocate from arena if non-null, otherwise from the default allocator
+template<class T>
+inline T* allocate_n(KVSArena* const arena, u32 const n) {
+	return arena
+		? static_cast<T*>(arena_allocate(*arena, sizeof(T) * n, alignof(T)))
+		: TOGO_ALLOCATE_N(memory::default_allocator(), T, n)
+	;
+}
+
+} // anonymous namespace
+
+KVSArena::~KVSArena() {
+	char* block = _block;
+	while (block) {
+		char* const prev = ARENA_BLOCK_PREV(block);
+		_allocator.deallocate(block);
+		block = prev;
+	}
+}
+
+KVSArena::KVSArena()
+	: KVSArena(memory::default_allocator())
+{}
+
+KVSArena::KVSArena(Allocator& allocator)
+	: _allocator(allocator)
+	, _block(nullptr)
+	, _put(nullptr)
+	, _end(nullptr)
+	, _block_size(ARENA_BLOCK_SIZE_MIN)
+{}
+
+#undef ARENA_BLOCK_PREV
+
 namespace kvs {
 	static void init_children(KVS& kvs, unsigned const from, unsigned const to);
 	static void reset_children(KVS& kvs, unsigned const from, unsigned const to);
+	static void free_index(KVS& kvs);
+	static void index_stale(KVS& kvs);
+	static void index_refresh(KVS& kvs);
+	static void index_insert(KVS& kvs, u32 const to);
+	static void index_rebuild(KVS& kvs, u32 const size);
 	static KVS const* find_impl(
 		KVS const& kvs,
 		StringRef const& name,
@@ -34,21 +134,112 @@ inline void kvs::init_children(KVS& kvs, unsigned const from, unsigned const to)
 
 inline void kvs::reset_children(KVS& kvs, unsigned const from, unsigned const to) {
 	for (unsigned i = from; i < to; ++i) {
+		kvs._value.collection.data[i]._parent_index = nullptr;
 		kvs._value.collection.data[i].~KVS();
 	}
 }
 
+inline void kvs::free_index(KVS& kvs) {
+	KVSIndex* const index = kvs._value.collection.index;
+	if (index) {
+		for (u32 i = 0; i < index->size; ++i) {
+			kvs._value.collection.data[i]._parent_index = nullptr;
+		}
+		TOGO_DEALLOCATE(memory::default_allocator(), index);
+		kvs._value.collection.index = nullptr;
+	}
+}
+
+// Mark the index of the collection containing kvs as stale
+inline void kvs::index_stale(KVS& kvs) {
+	if (kvs._parent_index) {
+		kvs._parent_index->stale = true;
+	}
+}
+
+// Rebuild the index if it is stale
+inline void kvs::index_refresh(KVS& kvs) {
+	if (kvs::is_type_any(kvs, type_mask_collection)) {
+		KVSIndex const* const index = kvs._value.collection.index;
+		if (index && index->stale) {
+			kvs::index_rebuild(kvs, index->size);
+		}
+	}
+}
+
+// Insert children [index->size, to) into the index
+void kvs::index_insert(KVS& kvs, u32 const to) {
+	KVSIndex* const index = kvs._value.collection.index;
+	if (to * 2 > index->num_slots) {
+		kvs::index_rebuild(kvs, to);
+		return;
+	}
+	u32 const mask = index->num_slots - 1;
+	u32* const slots = index->slots();
+	KVS* const data = kvs._value.collection.data;
+	for (u32 i = index->size; i < to; ++i) {
+		data[i]._parent_index = index;
+		KVSNameHash const name_hash = data[i]._name_hash;
+		if (name_hash == KVS_NAME_NULL) {
+			continue;
+		}
+		u32 slot = name_hash & mask;
+		while (
+			slots[slot] != KVSIndex::EMPTY &&
+			data[slots[slot]]._name_hash != name_hash
+		) {
+			slot = (slot + 1) & mask;
+		}
+		// Keep the first match
+		if (slots[slot] == KVSIndex::EMPTY) {
+			slots[slot] = i;
+		}
+	}
+	index->size = to;
+}
+
+// Index children [0, size)
+void kvs::index_rebuild(KVS& kvs, u32 const size) {
+	u32 num_slots = 64;
+	while (num_slots < size * 2) {
+		num_slots <<= 1;
+	}
+	KVSIndex* index = kvs._value.collection.index;
+	if (!index || index->num_slots != num_slots) {
+		// Children [0, size) are pointed to the new index by
+		// index_insert()
+		if (index) {
+			TOGO_DEALLOCATE(memory::default_allocator(), index);
+		}
+		index = static_cast<KVSIndex*>(memory::default_allocator().allocate(
+			sizeof(KVSIndex) + num_slots * sizeof(u32), alignof(KVSIndex)
+		));
+		index->num_slots = num_slots;
+		kvs._value.collection.index = index;
+	}
+	std::memset(index->slots(), 0xFF, index->num_slots * sizeof(u32));
+	index->size = 0;
+	index->stale = false;
+	kvs::index_insert(kvs, size);
+}
+
 KVS::KVS(KVS&& other)
 	: _type(other._type)
 	, _name_size(other._name_size)
 	, _name_hash(other._name_hash)
+	, _flags(other._flags)
 	, _name(other._name)
+	, _parent_index(nullptr)
 	, _value(rvalue_ref(other._value))
 {
+	if (other._name_hash != KVS_NAME_NULL) {
+		kvs::index_stale(other);
+	}
 	other._type = KVSType::null;
 	other._name = nullptr;
 	other._name_size = 0;
 	other._name_hash = KVS_NAME_NULL;
+	other._flags = 0;
 }
 
 KVS const* kvs::find_impl(
@@ -59,7 +250,21 @@ KVS const* kvs::find_impl(
 	if (name_hash == KVS_NAME_NULL || kvs::empty(kvs)) {
 		return nullptr;
 	}
-	for (KVS const& item : kvs) {
+	KVS const* const data = kvs._value.collection.data;
+	u32 from = 0;
+	KVSIndex const* const index = kvs._value.collection.index;
+	if (index && !index->stale) {
+		u32 const mask = index->num_slots - 1;
+		u32 const* const slots = index->slots();
+		for (u32 slot = name_hash & mask; slots[slot] != KVSIndex::EMPTY; slot = (slot + 1) & mask) {
+			if (data[slots[slot]]._name_hash == name_hash) {
+				return &data[slots[slot]];
+			}
+		}
+		from = index->size;
+	}
+	for (u32 i = from; i < kvs._value.collection.size; ++i) {
+		KVS const& item = data[i];
 		if (name_hash == kvs::name_hash(item)) {
 			#if defined(TOGO_DEBUG)
 			if (name.valid() && !string::compare_equal(name, kvs::name_ref(item))) {
@@ -78,9 +283,20 @@ KVS const* kvs::find_impl(
 	return nullptr;
 }
 
+// Index children by name hash if the collection is large enough.
+// Used by the readers once a collection is complete.
+IGEN_PRIVATE
+void kvs::build_index(KVS& kvs) {
+	TOGO_ASSERTE(kvs::is_type_any(kvs, type_mask_collection));
+	if (kvs._value.collection.size >= KVSIndex::MIN_SIZE) {
+		kvs::index_rebuild(kvs, kvs._value.collection.size);
+	}
+}
+
 /// Find item in collection by name.
 KVS* kvs::find(KVS& kvs, StringRef const& name) {
 	KVSNameHash const name_hash = kvs::hash_name(name);
+	kvs::index_refresh(kvs);
 	return const_cast<KVS*>(kvs::find_impl(kvs, name, name_hash));
 }
 
@@ -92,6 +308,7 @@ KVS const* kvs::find(KVS const& kvs, StringRef const& name) {
 
 /// Find item in collection by name hash.
 KVS* kvs::find(KVS& kvs, KVSNameHash const name_hash) {
+	kvs::index_refresh(kvs);
 	return const_cast<KVS*>(
 		kvs::find_impl(kvs, StringRef{}, name_hash)
 	);
@@ -121,35 +338,54 @@ bool kvs::set_type(KVS& kvs, KVSType const type) {
 		kvs._value.collection.data = nullptr;
 		kvs._value.collection.size = 0;
 		kvs._value.collection.capacity = 0;
+		kvs._value.collection.index = nullptr;
 	}
 	return true;
 }
 
 /// Set name.
-void kvs::set_name(KVS& kvs, StringRef const& name) {
+///
+/// If the name does not fit in the current name and arena is
+/// non-null, the new name is allocated from arena.
+void kvs::set_name(
+	KVS& kvs,
+	StringRef const& name,
+	KVSArena* const arena IGEN_DEFAULT(nullptr)
+) {
 	if (name.empty()) {
 		kvs::clear_name(kvs);
 	} else if (name.size > kvs._name_size) {
-		TOGO_DEALLOCATE(memory::default_allocator(), kvs._name);
-		kvs._name = TOGO_ALLOCATE_N(
-			memory::default_allocator(),
-			char, name.size + 1
-		);
+		if (~kvs._flags & KVS::FLAG_ARENA_NAME) {
+			TOGO_DEALLOCATE(memory::default_allocator(), kvs._name);
+		}
+		kvs._name = allocate_n<char>(arena, name.size + 1);
+		kvs._flags = arena
+			? kvs._flags | KVS::FLAG_ARENA_NAME
+			: kvs._flags & ~KVS::FLAG_ARENA_NAME
+		;
 	}
 	if (name.any()) {
 		string::copy(kvs._name, name.size + 1, name);
 	}
+	KVSNameHash const name_hash = kvs::hash_name(name);
+	if (kvs._name_hash != name_hash) {
+		kvs::index_stale(kvs);
+	}
 	kvs._name_size = name.size;
-	kvs._name_hash = kvs::hash_name(name);
+	kvs._name_hash = name_hash;
 }
 
 /// Clear name.
 void kvs::clear_name(KVS& kvs) {
 	if (kvs::is_named(kvs)) {
-		TOGO_DEALLOCATE(memory::default_allocator(), kvs._name);
+		if (~kvs._flags & KVS::FLAG_ARENA_NAME) {
+			TOGO_DEALLOCATE(memory::default_allocator(), kvs._name);
+		}
+		kvs._flags &= ~KVS::FLAG_ARENA_NAME;
 		kvs._name = nullptr;
 		kvs._name_size = 0;
 		kvs._name_hash = KVS_NAME_NULL;
+		kvs::index_stale(kvs);
 	}
 }
 
@@ -181,7 +417,10 @@ void kvs::clear(KVS& kvs) {
 /// Free dynamic value.
 void kvs::free_dynamic(KVS& kvs) {
 	if (kvs::is_type(kvs, KVSType::string)) {
-		TOGO_DEALLOCATE(memory::default_allocator(), kvs._value.string.data);
+		if (~kvs._flags & KVS::FLAG_ARENA_VALUE) {
+			TOGO_DEALLOCATE(memory::default_allocator(), kvs._value.string.data);
+		}
+		kvs._flags &= ~KVS::FLAG_ARENA_VALUE;
 		kvs._value.string.data = nullptr;
 		kvs._value.string.size = 0;
 		kvs._value.string.capacity = 0;
@@ -213,6 +452,9 @@ void kvs::copy(KVS& dst, KVS const& src) {
 		for (unsigned i = 0; i < kvs::size(dst); ++i) {
 			kvs::copy(dst[i], src[i]);
 		}
+		if (src._value.collection.index) {
+			kvs::build_index(dst);
+		}
 		break;
 
 	case KVSType::null:
@@ -231,16 +473,29 @@ void kvs::move(KVS& dst, KVS& src) {
 	dst._name = src._name;
 	dst._name_size = src._name_size;
 	dst._name_hash = src._name_hash;
+	dst._flags = src._flags;
 	dst._value = rvalue_ref(src._value);
+	if (src._name_hash != KVS_NAME_NULL) {
+		kvs::index_stale(dst);
+		kvs::index_stale(src);
+	}
 
 	src._type = KVSType::null;
 	src._name = nullptr;
 	src._name_size = 0;
 	src._name_hash = KVS_NAME_NULL;
+	src._flags = 0;
 }
 
 /// Set string value.
-void kvs::string(KVS& kvs, StringRef const& value) {
+///
+/// If the value does not fit in the current string and arena is
+/// non-null, the new string is allocated from arena.
+void kvs::string(
+	KVS& kvs,
+	StringRef const& value,
+	KVSArena* const arena IGEN_DEFAULT(nullptr)
+) {
 	TOGO_ASSERTE(value.size == 0 || value.valid());
 	kvs::set_type(kvs, KVSType::string);
 	if (value.empty()) {
@@ -248,10 +503,10 @@ void kvs::string(KVS& kvs, StringRef const& value) {
 	} else if (value.size >= kvs._value.string.capacity) {
 		kvs::free_dynamic(kvs);
 		kvs._value.string.capacity = value.size + 1;
-		kvs._value.string.data = TOGO_ALLOCATE_N(
-			memory::default_allocator(),
-			char, kvs._value.string.capacity
-		);
+		kvs._value.string.data = allocate_n<char>(arena, kvs._value.string.capacity);
+		if (arena) {
+			kvs._flags |= KVS::FLAG_ARENA_VALUE;
+		}
 	}
 	if (value.any()) {
 		string::copy(kvs._value.string.data, kvs._value.string.capacity, value);
@@ -262,21 +517,34 @@ void kvs::string(KVS& kvs, StringRef const& value) {
 /// Change collection capacity.
 ///
 /// If new_capacity is lower than the size, the collection is resized
-/// to new_capacity.
-void kvs::set_capacity(KVS& kvs, u32 const new_capacity) {
+/// to new_capacity. If arena is non-null, the new collection is
+/// allocated from arena.
+void kvs::set_capacity(
+	KVS& kvs,
+	u32 const new_capacity,
+	KVSArena* const arena IGEN_DEFAULT(nullptr)
+) {
 	TOGO_ASSERTE(kvs::is_type_any(kvs, type_mask_collection));
 	if (new_capacity == kvs._value.collection.capacity) {
 		return;
 	}
-
+	if (new_capacity == 0) {
+		kvs::free_index(kvs);
+	}
 	if (new_capacity < kvs._value.collection.size) {
 		kvs::reset_children(kvs, new_capacity, kvs._value.collection.size);
 		kvs._value.collection.size = new_capacity;
+		if (
+			kvs._value.collection.index &&
+			kvs._value.collection.index->size > new_capacity
+		) {
+			kvs::index_rebuild(kvs, new_capacity);
+		}
 	}
 
 	KVS* new_data = nullptr;
 	if (new_capacity != 0) {
-		new_data = TOGO_ALLOCATE_N(memory::default_allocator(), KVS, new_capacity);
+		new_data = allocate_n<KVS>(arena, new_capacity);
 		if (kvs._value.collection.data) {
 			std::memcpy(
 				new_data,
@@ -285,7 +553,13 @@ void kvs::set_capacity(KVS& kvs, u32 const new_capacity) {
 			);
 		}
 	}
-	TOGO_DEALLOCATE(memory::default_allocator(), kvs._value.collection.data);
+	if (~kvs._flags & KVS::FLAG_ARENA_VALUE) {
+		TOGO_DEALLOCATE(memory::default_allocator(), kvs._value.collection.data);
+	}
+	kvs._flags = (arena && new_data)
+		? kvs._flags | KVS::FLAG_ARENA_VALUE
+		: kvs._flags & ~KVS::FLAG_ARENA_VALUE
+	;
 	kvs._value.collection.data = new_data;
 	kvs._value.collection.capacity = new_capacity;
 	kvs::init_children(kvs, kvs._value.collection.size, new_capacity);
@@ -295,29 +569,48 @@ void kvs::set_capacity(KVS& kvs, u32 const new_capacity) {
 ///
 /// Cost of insertion should be amortized O(1), assuming no aggressive
 /// shrinking. Grows to at least min_capacity if it is non-zero.
-void kvs::grow(KVS& kvs, u32 const min_capacity IGEN_DEFAULT(0))
-{
+/// If arena is non-null, the new collection is allocated from arena.
+void kvs::grow(
+	KVS& kvs,
+	u32 const min_capacity IGEN_DEFAULT(0),
+	KVSArena* const arena IGEN_DEFAULT(nullptr)
+) {
 	TOGO_ASSERTE(kvs::is_type_any(kvs, type_mask_collection));
 	u32 new_capacity = kvs._value.collection.capacity * 2 + 8;
 	if (min_capacity > new_capacity) {
 		new_capacity = min_capacity;
 	}
-	kvs::set_capacity(kvs, new_capacity);
+	kvs::set_capacity(kvs, new_capacity, arena);
 }
 
 /// Change collection size.
 ///
 /// Upsize grows by using new_size as the minimum capacity.
 /// If the collection grows, the new values will be null.
-void kvs::resize(KVS& kvs, u32 const new_size) {
+/// If arena is non-null, a grown collection is allocated from arena.
+void kvs::resize(
+	KVS& kvs,
+	u32 const new_size,
+	KVSArena* const arena IGEN_DEFAULT(nullptr)
+) {
 	TOGO_ASSERTE(kvs::is_type_any(kvs, type_mask_collection));
 	if (new_size > kvs._value.collection.capacity) {
-		kvs::grow(kvs, new_size);
+		kvs::grow(kvs, new_size, arena);
 	} else if (new_size < kvs._value.collection.size) {
 		kvs::reset_children(kvs, new_size, kvs._value.collection.size);
 	} else if (new_size > kvs._value.collection.size) {
 		kvs::reset_children(kvs, kvs._value.collection.size, new_size);
 	}
+	KVSIndex* const index = kvs._value.collection.index;
+	if (index) {
+		if (new_size < index->size) {
+			kvs::index_rebuild(kvs, new_size);
+		} else if (new_size > kvs._value.collection.size) {
+			// Names of new items are not known yet, so only index
+			// the existing ones
+			kvs::index_insert(kvs, kvs._value.collection.size);
+		}
+	}
 	kvs._value.collection.size = new_size;
 }
 
@@ -333,6 +626,12 @@ void kvs::remove(KVS& kvs, unsigned const i) {
 			kvs._value.collection.data + i, kvs._value.collection.data + i + 1,
 			(new_size - i) * sizeof(KVS)
 		);
+		// The last item was moved down
+		new (&kvs._value.collection.data[new_size]) KVS();
+		KVSIndex const* const index = kvs._value.collection.index;
+		if (index && i < index->size) {
+			kvs::index_rebuild(kvs, index->size - 1);
+		}
 	}
 	kvs::resize(kvs, new_size);
 }
@@ -345,7 +644,7 @@ void kvs::remove(KVS& kvs, KVS const* const ptr) {
 	TOGO_ASSERTE(ptr != nullptr);
 	TOGO_ASSERTE(kvs::any(kvs));
 	TOGO_ASSERTE(kvs::begin(kvs) <= ptr && ptr < kvs::end(kvs));
-	kvs::remove(kvs, (ptr - kvs._value.collection.data) / sizeof(KVS));
+	kvs::remove(kvs, ptr - kvs._value.collection.data);
 }
 
 } // namespace togo
@@ -385,7 +385,9 @@ inline KVS::KVS(KVSType const type, no_init_tag const)
 	: _type(type)
 	, _name_size(0)
 	, _name_hash(KVS_NAME_NULL)
+	, _flags(0)
 	, _name(nullptr)
+	, _parent_index(nullptr)
 	, _value(no_init_tag{})
 {}
 
@@ -394,7 +396,9 @@ inline KVS::KVS(KVSType const type)
 	: _type(type)
 	, _name_size(0)
 	, _name_hash(KVS_NAME_NULL)
+	, _flags(0)
 	, _name(nullptr)
+	, _parent_index(nullptr)
 	, _value()
 {}
 
@@ -20,6 +20,7 @@
 #include <togo/core/math/vector/2_type.hpp>
 #include <togo/core/math/vector/3_type.hpp>
 #include <togo/core/math/vector/4_type.hpp>
+#include <togo/core/memory/types.hpp>
 #include <togo/core/string/types.hpp>
 #include <togo/core/hash/hash.hpp>
 
@@ -73,6 +74,10 @@ enum class KVSType : u32 {
 	node		= 1 << 10,
 };
 
+/** @cond INTERNAL */
+struct KVSIndex;
+/** @endcond */ // INTERNAL
+
 /// Key-value store.
 struct KVS {
 	struct StringValue {
@@ -85,10 +90,11 @@ struct KVS {
 		u32 size;
 		u32 capacity;
 		KVS* data;
+		KVSIndex* index;
 	};
 
 	union Value {
-		u8 _init[max(sizeof(Vec4), sizeof(StringValue))];
+		u8 _init[max(sizeof(Vec4), max(sizeof(StringValue), sizeof(CollectionValue)))];
 		s64 integer;
 		f64 decimal;
 		bool boolean;
@@ -112,10 +118,19 @@ struct KVS {
 		inline Value(no_init_tag const) {}
 	};
 
+	enum : u32 {
+		/// Name is owned by an arena.
+		FLAG_ARENA_NAME = 1 << 0,
+		/// String or collection data is owned by an arena.
+		FLAG_ARENA_VALUE = 1 << 1,
+	};
+
 	KVSType _type;
 	u32 _name_size;
 	KVSNameHash _name_hash;
+	u32 _flags;
 	char* _name;
+	KVSIndex* _parent_index;
 	Value _value;
 
 	KVS& operator=(KVS const&) = delete;
@@ -164,6 +179,144 @@ struct KVS {
 	KVS const& operator[](unsigned const i) const;
 };
 
+/// KVS arena.
+///
+/// Names, strings and collections can be allocated from an arena when
+/// reading a KVS (see kvs::read_text() and kvs::read_binary()). Arena
+/// memory is never deallocated by a KVS, so destroying a tree that was
+/// read into an arena makes no deallocations. Values that have to grow
+/// after reading are moved to the default allocator.
+///
+/// The arena must outlive all KVS that use it. It is not thread-safe.
+struct KVSArena {
+	Allocator& _allocator;
+	char* _block;
+	char* _put;
+	char* _end;
+	u32 _block_size;
+
+	KVSArena(KVSArena&&) = delete;
+	KVSArena(KVSArena const&) = delete;
+	KVSArena& operator=(KVSArena&&) = delete;
+	KVSArena& operator=(KVSArena const&) = delete;
+
+	/// Deallocates all blocks.
+	~KVSArena();
+
+	/// Construct with the default allocator.
+	KVSArena();
+
+	/// Construct with allocator.
+	KVSArena(Allocator& allocator);
+};
+
+/** @cond INTERNAL */
+
+/// Packed-format KVS header.
+struct KVSPackedHeader {
+	enum : u32 {
+		MAGIC = 0x504b564b, // "KVKP"
+		VERSION = 1,
+	};
+
+	u32 magic;
+	u32 version;
+	Endian endian;
+	u32 size;
+	u32 num_values;
+	u32 _pad;
+};
+
+/// Packed-format KVS value.
+///
+/// Collection children are stored contiguously. Offsets are from the
+/// start of the packed data. Strings are stored as a u32 size followed
+/// by the NUL-terminated characters, aligned to 4 bytes.
+struct KVSPackedValue {
+	union Value {
+		s64 integer;
+		f64 decimal;
+		u32 boolean;
+		u32 offset;
+		Vec1 vec1;
+		Vec2 vec2;
+		Vec3 vec3;
+		Vec4 vec4;
+	};
+
+	KVSType type;
+	KVSNameHash name_hash;
+	/// Offset of name string, or 0 if unnamed.
+	u32 name;
+	/// String or collection size.
+	u32 size;
+	/// String offset, first child offset, or value.
+	Value value;
+};
+
+/** @endcond */ // INTERNAL
+
+/// Read-only view of packed-format KVS.
+///
+/// A view is only valid while its packed data is alive. A null view
+/// refers to no value.
+///
+/// The view also serves as an iterator over collection children.
+struct KVSView {
+	u8 const* _base;
+	KVSPackedValue const* _value;
+
+	/// Whether the view refers to a value.
+	explicit operator bool() const {
+		return _value != nullptr;
+	}
+
+	/** @cond INTERNAL */
+	KVSView operator*() const {
+		return *this;
+	}
+
+	KVSView& operator++() {
+		++_value;
+		return *this;
+	}
+
+	bool operator!=(KVSView const& other) const {
+		return _value != other._value;
+	}
+	/** @endcond */ // INTERNAL
+};
+
+/// KVS visitor interface.
+///
+/// Used to read KVS without building a tree. The KVS passed to each
+/// callback has the name and type of the value (and the value itself if
+/// it is not a collection). It is only valid for the duration of the
+/// call, and a collection passed to it never has any values.
+class IKVSVisitor {
+public:
+	IKVSVisitor() = default;
+	IKVSVisitor(IKVSVisitor const&) = default;
+	IKVSVisitor(IKVSVisitor&&) = default;
+	IKVSVisitor& operator=(IKVSVisitor const&) = default;
+	IKVSVisitor& operator=(IKVSVisitor&&) = default;
+
+	virtual ~IKVSVisitor() = 0;
+
+	/// Called when a collection begins.
+	///
+	/// If this returns false, the values in the collection are skipped
+	/// and end_collection() is not called for it.
+	virtual bool begin_collection(KVS const& collection) = 0;
+
+	/// Called when a collection ends.
+	virtual void end_collection(KVS const& collection) = 0;
+
+	/// Called for a non-collection value.
+	virtual void value(KVS const& value) = 0;
+};
+inline IKVSVisitor::~IKVSVisitor() = default;
+
 /// KVS parser information.
 struct KVSParserInfo {
 	/// Line in stream.
@@ -0,0 +1,302 @@
+#line 2 "togo/core/kvs/view.cpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#include <togo/core/config.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/string/string.hpp>
+#include <togo/core/io/types.hpp>
+#include <togo/core/io/io.hpp>
+#include <togo/core/io/file_stream.hpp>
+#include <togo/core/kvs/kvs.hpp>
+#include <togo/core/kvs/view.hpp>
+
+#include <cstring>
+
+namespace togo {
+
+namespace {
+
+static_assert(
+	sizeof(KVSPackedValue) == 32 && alignof(KVSPackedValue) <= 8,
+	"KVSPackedValue layout changed"
+);
+
+inline u32 packed_string_bytes(u32 const size) {
+	return (sizeof(u32) + size + 1 + 3) & ~u32{3};
+}
+
+static void packed_count(KVS const& kvs, u32& num_values, u32& string_bytes) {
+	++num_values;
+	if (kvs::is_named(kvs)) {
+		string_bytes += packed_string_bytes(kvs::name_size(kvs));
+	}
+	if (kvs::is_string(kvs)) {
+		string_bytes += packed_string_bytes(kvs::string_size(kvs));
+	} else if (kvs::is_collection(kvs)) {
+		for (KVS const& child : kvs) {
+			packed_count(child, num_values, string_bytes);
+		}
+	}
+}
+
+struct PackedWriter {
+	u8* base;
+	u32 next_value;
+	u32 next_string;
+};
+
+static u32 packed_write_string(PackedWriter& w, StringRef const& str) {
+	u32 const offset = w.next_string;
+	*reinterpret_cast<u32*>(w.base + offset) = str.size;
+	if (str.any()) {
+		std::memcpy(w.base + offset + sizeof(u32), str.data, str.size);
+	}
+	w.next_string += packed_string_bytes(str.size);
+	return offset;
+}
+
+static void packed_write(PackedWriter& w, KVS const& kvs, u32 const offset) {
+	auto& value = *reinterpret_cast<KVSPackedValue*>(w.base + offset);
+	value.type = kvs::type(kvs);
+	value.name_hash = kvs::name_hash(kvs);
+	value.name = kvs::is_named(kvs) ? packed_write_string(w, kvs::name_ref(kvs)) : 0;
+	value.size = 0;
+	switch (kvs::type(kvs)) {
+	case KVSType::null: break;
+	case KVSType::integer: value.value.integer = kvs::integer(kvs); break;
+	case KVSType::decimal: value.value.decimal = kvs::decimal(kvs); break;
+	case KVSType::boolean: value.value.boolean = kvs::boolean(kvs); break;
+	case KVSType::string:
+		value.size = kvs::string_size(kvs);
+		value.value.offset = packed_write_string(w, kvs::string_ref(kvs));
+		break;
+
+	case KVSType::vec1: value.value.vec1 = kvs::vec1(kvs); break;
+	case KVSType::vec2: value.value.vec2 = kvs::vec2(kvs); break;
+	case KVSType::vec3: value.value.vec3 = kvs::vec3(kvs); break;
+	case KVSType::vec4: value.value.vec4 = kvs::vec4(kvs); break;
+
+	case KVSType::array: // fall-through
+	case KVSType::node: {
+		// Reserve the children contiguously before descending
+		u32 const first = w.next_value;
+		value.size = kvs::size(kvs);
+		value.value.offset = first;
+		w.next_value += value.size * sizeof(KVSPackedValue);
+		for (unsigned i = 0; i < value.size; ++i) {
+			packed_write(w, kvs[i], first + i * sizeof(KVSPackedValue));
+		}
+	}	break;
+	}
+}
+
+// Whether the string at offset is within the data and terminated
+static bool packed_string_valid(
+	u8 const* const base,
+	u32 const size,
+	u32 const offset
+) {
+	if (
+		offset % alignof(u32) != 0 ||
+		offset < sizeof(KVSPackedHeader) ||
+		u64{offset} + sizeof(u32) > size
+	) {
+		return false;
+	}
+	u64 const end = u64{offset} + sizeof(u32) + *reinterpret_cast<u32 const*>(base + offset);
+	return end < size && base[end] == '\0';
+}
+
+// Check that all offsets and sizes are within the data. Children must
+// come after their collection, so collections can't contain themselves.
+// The header and root have already been checked by view_packed().
+static bool packed_validate(u8 const* const base, KVSPackedHeader const& header) {
+	u32 const values_offset = sizeof(KVSPackedHeader);
+	u64 const values_end = values_offset + u64{header.num_values} * sizeof(KVSPackedValue);
+	auto const* const values = reinterpret_cast<KVSPackedValue const*>(base + values_offset);
+	for (u32 i = 0; i < header.num_values; ++i) {
+		auto const& value = values[i];
+		if (value.name && !packed_string_valid(base, header.size, value.name)) {
+			return false;
+		}
+		switch (value.type) {
+		case KVSType::null:
+		case KVSType::integer:
+		case KVSType::decimal:
+		case KVSType::boolean:
+		case KVSType::vec1:
+		case KVSType::vec2:
+		case KVSType::vec3:
+		case KVSType::vec4:
+			break;
+
+		case KVSType::string:
+			if (
+				!packed_string_valid(base, header.size, value.value.offset) ||
+				*reinterpret_cast<u32 const*>(base + value.value.offset) != value.size
+			) {
+				return false;
+			}
+			break;
+
+		case KVSType::array: // fall-through
+		case KVSType::node: {
+			u32 const offset = values_offset + i * u32{sizeof(KVSPackedValue)};
+			u32 const first = value.value.offset;
+			if (
+				first <= offset ||
+				(first - values_offset) % sizeof(KVSPackedValue) != 0 ||
+				u64{first} + u64{value.size} * sizeof(KVSPackedValue) > values_end
+			) {
+				return false;
+			}
+		}	break;
+
+		default:
+			return false;
+		}
+	}
+	return true;
+}
+
+} // anonymous namespace
+
+/// Write packed-format KVS to stream.
+///
+/// root must be a node.
+IOStatus kvs::write_packed(KVS const& root, IWriter& stream) {
+	TOGO_ASSERT(kvs::type(root) == KVSType::node, "root must be a node");
+
+	u32 num_values = 0;
+	u32 string_bytes = 0;
+	packed_count(root, num_values, string_bytes);
+
+	u32 const values_offset = sizeof(KVSPackedHeader);
+	u32 const strings_offset = values_offset + num_values * sizeof(KVSPackedValue);
+	u32 const size = strings_offset + string_bytes;
+
+	Array<u8> buffer{memory::default_allocator()};
+	array::resize(buffer, size);
+	std::memset(array::begin(buffer), 0, size);
+	auto& header = *reinterpret_cast<KVSPackedHeader*>(array::begin(buffer));
+	header.magic = KVSPackedHeader::MAGIC;
+	header.version = KVSPackedHeader::VERSION;
+	header.endian = Endian::system;
+	header.size = size;
+	header.num_values = num_values;
+
+	PackedWriter w{
+		array::begin(buffer),
+		values_offset + u32{sizeof(KVSPackedValue)},
+		strings_offset
+	};
+	packed_write(w, root, values_offset);
+	TOGO_DEBUG_ASSERTE(w.next_value == strings_offset && w.next_string == size);
+	return io::write(stream, array::begin(buffer), size);
+}
+
+/// Write packed-format KVS to file.
+bool kvs::write_packed_file(KVS const& root, StringRef const& path) {
+	FileWriter stream{};
+	if (!stream.open(path, false)) {
+		TOGO_LOG_ERRORF(
+			"failed to write KVS packed to '%.*s': failed to open file\n",
+			path.size, path.data
+		);
+		return false;
+	}
+
+	bool success = kvs::write_packed(root, stream).ok();
+	stream.close();
+	return success;
+}
+
+/// View packed-format KVS.
+///
+/// This only checks the header and the root value, so it takes
+/// constant time and makes no allocations. Offsets are bounds-checked
+/// as values are accessed in debug builds. Check data from untrusted
+/// sources with validate_packed() first.
+/// data must remain alive while the view is used.
+/// Returns a null view if the header is not valid.
+KVSView kvs::view_packed(ArrayRef<u8 const> const& data) {
+	auto const* const header = reinterpret_cast<KVSPackedHeader const*>(begin(data));
+	if (
+		data.size() < sizeof(KVSPackedHeader) + sizeof(KVSPackedValue) ||
+		reinterpret_cast<std::uintptr_t>(begin(data)) % alignof(KVSPackedValue) != 0
+	) {
+		TOGO_LOG_ERROR("view_packed: data is too small or misaligned\n");
+		return {nullptr, nullptr};
+	} else if (
+		header->magic != KVSPackedHeader::MAGIC ||
+		header->version != KVSPackedHeader::VERSION
+	) {
+		TOGO_LOG_ERROR("view_packed: magic or version mismatch\n");
+		return {nullptr, nullptr};
+	} else if (header->endian != Endian::system) {
+		TOGO_LOG_ERROR("view_packed: endian mismatch\n");
+		return {nullptr, nullptr};
+	} else if (header->size > data.size()) {
+		TOGO_LOG_ERROR("view_packed: data is truncated\n");
+		return {nullptr, nullptr};
+	}
+	auto const* const root = reinterpret_cast<KVSPackedValue const*>(
+		begin(data) + sizeof(KVSPackedHeader)
+	);
+	if (
+		header->num_values == 0 ||
+		sizeof(KVSPackedHeader) + u64{header->num_values} * sizeof(KVSPackedValue) > header->size ||
+		root->type != KVSType::node
+	) {
+		TOGO_LOG_ERROR("view_packed: data is corrupt\n");
+		return {nullptr, nullptr};
+	}
+	return {begin(data), root};
+}
+
+/// Check packed-format KVS.
+///
+/// This checks the header and that every offset and size in the data
+/// is in bounds, which takes time linear in the size of the data.
+/// Returns true if data can be viewed safely with view_packed().
+bool kvs::validate_packed(ArrayRef<u8 const> const& data) {
+	KVSView const view = kvs::view_packed(data);
+	if (!view) {
+		return false;
+	} else if (!packed_validate(
+		view._base, *reinterpret_cast<KVSPackedHeader const*>(view._base)
+	)) {
+		TOGO_LOG_ERROR("validate_packed: data is corrupt\n");
+		return false;
+	}
+	return true;
+}
+
+/// Find value in collection by name hash.
+///
+/// Returns a null view if there is no such value or view is null.
+KVSView kvs::find(KVSView const& view, KVSNameHash const name_hash) {
+	if (name_hash != KVS_NAME_NULL) {
+		for (KVSView it = kvs::begin(view), end = kvs::end(view); it != end; ++it) {
+			if (it._value->name_hash == name_hash) {
+				return it;
+			}
+		}
+	}
+	return {view._base, nullptr};
+}
+
+/// Find value in collection by name.
+///
+/// Returns a null view if there is no such value.
+KVSView kvs::find(KVSView const& view, StringRef const& name) {
+	return kvs::find(view, kvs::hash_name(name));
+}
+
+} // namespace togo
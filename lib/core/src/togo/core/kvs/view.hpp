@@ -0,0 +1,264 @@
+#line 2 "togo/core/kvs/view.hpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+
+@file
+@brief KVSView interface.
+@ingroup lib_core_kvs
+
+The packed format is a header followed by fixed-size value records and
+a string table. Children of a collection are stored contiguously, so a
+view can be made over packed data (e.g., a memory-mapped file) with no
+allocation or deserialization.
+
+Packed data is written in system endian and must be aligned to 8 bytes
+when viewed.
+*/
+
+#pragma once
+
+#include <togo/core/config.hpp>
+#include <togo/core/types.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/string/types.hpp>
+#include <togo/core/io/types.hpp>
+#include <togo/core/kvs/types.hpp>
+#include <togo/core/kvs/kvs.hpp>
+#include <togo/core/kvs/view.gen_interface>
+
+namespace togo {
+
+namespace kvs {
+
+/**
+	@addtogroup lib_core_kvs
+	@{
+*/
+
+/** @cond INTERNAL */
+inline bool packed_in_bounds(KVSView const& view, u32 const offset, u64 const size) {
+	return offset + size <= reinterpret_cast<KVSPackedHeader const*>(view._base)->size;
+}
+
+inline u32 packed_string_size(KVSView const& view, u32 const offset) {
+	TOGO_DEBUG_ASSERTE(kvs::packed_in_bounds(view, offset, sizeof(u32)));
+	return *reinterpret_cast<u32 const*>(view._base + offset);
+}
+
+inline char const* packed_string(KVSView const& view, u32 const offset) {
+	TOGO_DEBUG_ASSERTE(kvs::packed_in_bounds(
+		view, offset, sizeof(u32) + u64{kvs::packed_string_size(view, offset)} + 1
+	));
+	return reinterpret_cast<char const*>(view._base + offset + sizeof(u32));
+}
+/** @endcond */ // INTERNAL
+
+/// Type.
+inline KVSType type(KVSView const& view) {
+	return view._value->type;
+}
+
+/// Whether value type is type.
+inline bool is_type(KVSView const& view, KVSType const type) {
+	return view._value->type == type;
+}
+
+/// Whether value type is any in type.
+inline bool is_type_any(KVSView const& view, KVSType const type) {
+	return enum_bool(view._value->type & type);
+}
+
+/// Whether type is KVSType::null.
+inline bool is_null(KVSView const& view) { return kvs::is_type(view, KVSType::null); }
+
+/// Whether type is KVSType::integer.
+inline bool is_integer(KVSView const& view) { return kvs::is_type(view, KVSType::integer); }
+
+/// Whether type is KVSType::decimal.
+inline bool is_decimal(KVSView const& view) { return kvs::is_type(view, KVSType::decimal); }
+
+/// Whether type is KVSType::boolean.
+inline bool is_boolean(KVSView const& view) { return kvs::is_type(view, KVSType::boolean); }
+
+/// Whether type is KVSType::string.
+inline bool is_string(KVSView const& view) { return kvs::is_type(view, KVSType::string); }
+
+/// Whether type is KVSType::vec1.
+inline bool is_vec1(KVSView const& view) { return kvs::is_type(view, KVSType::vec1); }
+
+/// Whether type is KVSType::vec2.
+inline bool is_vec2(KVSView const& view) { return kvs::is_type(view, KVSType::vec2); }
+
+/// Whether type is KVSType::vec3.
+inline bool is_vec3(KVSView const& view) { return kvs::is_type(view, KVSType::vec3); }
+
+/// Whether type is KVSType::vec4.
+inline bool is_vec4(KVSView const& view) { return kvs::is_type(view, KVSType::vec4); }
+
+/// Whether type is KVSType::node.
+inline bool is_node(KVSView const& view) { return kvs::is_type(view, KVSType::node); }
+
+/// Whether type is KVSType::array.
+inline bool is_array(KVSView const& view) { return kvs::is_type(view, KVSType::array); }
+
+/// Whether type is a vector type.
+inline bool is_vector(KVSView const& view) { return kvs::is_type_any(view, type_mask_vector); }
+
+/// Whether type is an array or node.
+inline bool is_collection(KVSView const& view) { return kvs::is_type_any(view, type_mask_collection); }
+
+/// Name (NUL-terminated).
+inline char const* name(KVSView const& view) {
+	return view._value->name ? kvs::packed_string(view, view._value->name) : "";
+}
+
+/// Name size (not including NUL terminator).
+inline u32 name_size(KVSView const& view) {
+	return view._value->name ? kvs::packed_string_size(view, view._value->name) : 0;
+}
+
+/// Name reference.
+inline StringRef name_ref(KVSView const& view) {
+	return StringRef{kvs::name(view), kvs::name_size(view)};
+}
+
+/// Name hash.
+inline KVSNameHash name_hash(KVSView const& view) {
+	return view._value->name_hash;
+}
+
+/// Whether name is non-empty.
+inline bool is_named(KVSView const& view) {
+	return view._value->name;
+}
+
+/// Number of values in the collection.
+///
+/// This is 0 for a null view.
+inline u32 size(KVSView const& view) {
+	return view._value && kvs::is_collection(view) ? view._value->size : 0;
+}
+
+/// Whether there are any values in the collection.
+inline bool any(KVSView const& view) {
+	return kvs::size(view) > 0;
+}
+
+/// Whether there are no values in the collection.
+inline bool empty(KVSView const& view) {
+	return kvs::size(view) == 0;
+}
+
+/// Beginning of the collection.
+///
+/// A null view is an empty collection.
+inline KVSView begin(KVSView const& view) {
+	TOGO_DEBUG_ASSERTE(
+		!view._value || !kvs::is_collection(view) || kvs::packed_in_bounds(
+			view, view._value->value.offset,
+			u64{view._value->size} * sizeof(KVSPackedValue)
+		)
+	);
+	return KVSView{
+		view._base,
+		view._value && kvs::is_collection(view)
+		? reinterpret_cast<KVSPackedValue const*>(view._base + view._value->value.offset)
+		: nullptr
+	};
+}
+
+/// End of the collection.
+inline KVSView end(KVSView const& view) {
+	KVSView it = kvs::begin(view);
+	if (it._value) {
+		it._value += view._value->size;
+	}
+	return it;
+}
+
+/// Value at index.
+inline KVSView at(KVSView const& view, unsigned const i) {
+	TOGO_ASSERTE(kvs::is_collection(view));
+	TOGO_DEBUG_ASSERTE(i < view._value->size);
+	KVSView it = kvs::begin(view);
+	it._value += i;
+	return it;
+}
+
+/// Integer value.
+inline s64 integer(KVSView const& view) {
+	TOGO_ASSERTE(kvs::is_type(view, KVSType::integer));
+	return view._value->value.integer;
+}
+
+/// Decimal value.
+inline f64 decimal(KVSView const& view) {
+	TOGO_ASSERTE(kvs::is_type(view, KVSType::decimal));
+	return view._value->value.decimal;
+}
+
+/// Boolean value.
+inline bool boolean(KVSView const& view) {
+	TOGO_ASSERTE(kvs::is_type(view, KVSType::boolean));
+	return view._value->value.boolean;
+}
+
+/// String value (NUL-terminated).
+inline char const* string(KVSView const& view) {
+	TOGO_ASSERTE(kvs::is_type(view, KVSType::string));
+	return kvs::packed_string(view, view._value->value.offset);
+}
+
+/// String value size (not including NUL terminator).
+inline u32 string_size(KVSView const& view) {
+	TOGO_ASSERTE(kvs::is_type(view, KVSType::string));
+	TOGO_DEBUG_ASSERTE(
+		view._value->size == kvs::packed_string_size(view, view._value->value.offset)
+	);
+	return view._value->size;
+}
+
+/// String value reference.
+inline StringRef string_ref(KVSView const& view) {
+	return StringRef{kvs::string(view), kvs::string_size(view)};
+}
+
+/// 1-dimensional vector value.
+inline Vec1 const& vec1(KVSView const& view) {
+	TOGO_ASSERTE(kvs::is_type(view, KVSType::vec1));
+	return view._value->value.vec1;
+}
+
+/// 2-dimensional vector value.
+inline Vec2 const& vec2(KVSView const& view) {
+	TOGO_ASSERTE(kvs::is_type(view, KVSType::vec2));
+	return view._value->value.vec2;
+}
+
+/// 3-dimensional vector value.
+inline Vec3 const& vec3(KVSView const& view) {
+	TOGO_ASSERTE(kvs::is_type(view, KVSType::vec3));
+	return view._value->value.vec3;
+}
+
+/// 4-dimensional vector value.
+inline Vec4 const& vec4(KVSView const& view) {
+	TOGO_ASSERTE(kvs::is_type(view, KVSType::vec4));
+	return view._value->value.vec4;
+}
+
+/** @} */ // end of doc-group lib_core_kvs
+
+} // namespace kvs
+
+/** @cond INTERNAL */
+
+// ADL support
+
+inline KVSView begin(KVSView const& view) { return kvs::begin(view); }
+inline KVSView end(KVSView const& view) { return kvs::end(view); }
+
+/** @endcond */ // INTERNAL
+
+} // namespace togo
@@ -4,27 +4,391 @@
 */
 
 #include <togo/core/config.hpp>
-#include <togo/core/log/log.hpp>
+#include <togo/core/types.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/memory/memory.hpp>
 #include <togo/core/threading/mutex.hpp>
+#include <togo/core/threading/thread.hpp>
+#include <togo/core/system/system.hpp>
+#include <togo/core/io/io.hpp>
+#include <togo/core/log/log.hpp>
 
+#include <atomic>
+#include <new>
 #include <cstdarg>
 #include <cstdlib>
 #include <cstdio>
-
-// TODO: Print into buffer, then flush buffer to streams
+#include <cstring>
 
 namespace togo {
 
 namespace {
-	static Mutex _log_mutex{};
+
+enum : unsigned {
+	// Messages that don't fit are written synchronously
+	MESSAGE_SIZE = 1024,
+	MAX_SINKS = 8,
+	RECORD_ALIGNMENT = 16,
+	RECORD_WRAP = ~0u,
+	BUFFER_SIZE_MIN = 256,
+};
+
+struct LogRecord {
+	u32 size;
+	u32 _padding;
+	f64 time;
+};
+
+static_assert(
+	sizeof(LogRecord) == RECORD_ALIGNMENT,
+	"LogRecord must be one record alignment in size"
+);
+
+// Single-producer ring of records. The owning thread pushes at head,
+// and whoever holds s_mutex drains from tail. Records never straddle
+// the end of the ring; a wrap record skips to the start.
+struct LogBuffer {
+	alignas(64) std::atomic<u32> head;
+	alignas(64) std::atomic<u32> tail;
+	u32 capacity;
+	u8* data;
+};
+
+static Mutex s_mutex{};
+static IWriter* s_sinks[MAX_SINKS]{};
+static unsigned s_num_sinks = 0;
+static bool s_stdout = true;
+static bool s_timestamps = false;
+
+static std::atomic<bool> s_async{false};
+static std::atomic<bool> s_shutdown{false};
+static std::atomic<u32> s_generation{0};
+static std::atomic<unsigned> s_num_buffers{0};
+static std::atomic<LogBuffer*> s_buffers[log::ASYNC_MAX_THREADS]{};
+static unsigned s_buffer_capacity = 0;
+static unsigned s_flush_interval_ms = 0;
+static Thread* s_flusher = nullptr;
+
+static thread_local LogBuffer* t_buffer = nullptr;
+static thread_local u32 t_generation = 0;
+static thread_local bool t_locked = false;
+
+struct LogLock {
+	MutexLock _lock;
+
+	~LogLock() {
+		t_locked = false;
+	}
+
+	LogLock()
+		: _lock(s_mutex)
+	{
+		t_locked = true;
+	}
+};
+
+inline u32 record_span(u32 const size) {
+	return (sizeof(LogRecord) + size + RECORD_ALIGNMENT - 1) & ~u32{RECORD_ALIGNMENT - 1};
+}
+
+static void write_sinks(char const* const data, unsigned const size) {
+	if (s_stdout) {
+		std::fwrite(data, 1, size, stdout);
+	}
+	for (unsigned i = 0; i < s_num_sinks; ++i) {
+		io::write(*s_sinks[i], data, size);
+	}
+}
+
+static void write_message(char const* const data, unsigned const size, f64 const time) {
+	if (s_timestamps) {
+		char prefix[32];
+		signed const prefix_size = std::snprintf(prefix, sizeof(prefix), "[%12.6lf] ", time);
+		write_sinks(prefix, static_cast<unsigned>(prefix_size));
+	}
+	write_sinks(data, size);
+}
+
+static LogRecord const* next_record(LogBuffer const& buffer, u32& tail, u32 const head) {
+	while (tail != head) {
+		u32 const offset = tail & (buffer.capacity - 1);
+		auto const* record = reinterpret_cast<LogRecord const*>(buffer.data + offset);
+		if (record->size != RECORD_WRAP) {
+			return record;
+		}
+		tail += buffer.capacity - offset;
+	}
+	return nullptr;
+}
+
+// Write all pending records to the sinks in timestamp order.
+// s_mutex must be held.
+static void drain() {
+	struct Cursor {
+		LogBuffer* buffer;
+		LogRecord const* record;
+		u32 tail;
+		u32 head;
+	};
+
+	Cursor cursors[log::ASYNC_MAX_THREADS];
+	unsigned num_cursors = 0;
+	unsigned const num_buffers = min(
+		s_num_buffers.load(std::memory_order_acquire),
+		unsigned{log::ASYNC_MAX_THREADS}
+	);
+	for (unsigned i = 0; i < num_buffers; ++i) {
+		Cursor c;
+		c.buffer = s_buffers[i].load(std::memory_order_acquire);
+		if (!c.buffer) {
+			continue;
+		}
+		c.tail = c.buffer->tail.load(std::memory_order_relaxed);
+		c.head = c.buffer->head.load(std::memory_order_acquire);
+		c.record = next_record(*c.buffer, c.tail, c.head);
+		if (c.record) {
+			cursors[num_cursors++] = c;
+		} else {
+			c.buffer->tail.store(c.tail, std::memory_order_release);
+		}
+	}
+
+	bool const written = num_cursors > 0;
+	while (num_cursors > 0) {
+		unsigned index = 0;
+		for (unsigned i = 1; i < num_cursors; ++i) {
+			if (cursors[i].record->time < cursors[index].record->time) {
+				index = i;
+			}
+		}
+		Cursor& c = cursors[index];
+		write_message(
+			reinterpret_cast<char const*>(c.record + 1),
+			c.record->size,
+			c.record->time
+		);
+		c.tail += record_span(c.record->size);
+		c.record = next_record(*c.buffer, c.tail, c.head);
+		if (!c.record) {
+			c.buffer->tail.store(c.tail, std::memory_order_release);
+			c = cursors[--num_cursors];
+		}
+	}
+	if (written && s_stdout) {
+		std::fflush(stdout);
+	}
+}
+
+// Returns false if the message is too large for the buffer.
+static bool buffer_push(
+	LogBuffer& buffer,
+	char const* const data,
+	unsigned const size,
+	f64 const time
+) {
+	// Limited to half the capacity so a wrapped record always fits
+	// into an empty buffer
+	u32 const span = record_span(size);
+	if (span > buffer.capacity / 2) {
+		return false;
+	}
+	while (true) {
+		u32 const head = buffer.head.load(std::memory_order_relaxed);
+		u32 const tail = buffer.tail.load(std::memory_order_acquire);
+		u32 const offset = head & (buffer.capacity - 1);
+		u32 const to_end = buffer.capacity - offset;
+		u32 const needed = span + (to_end < span ? to_end : 0);
+		if (needed <= buffer.capacity - (head - tail)) {
+			u32 position = head;
+			if (to_end < span) {
+				reinterpret_cast<LogRecord*>(buffer.data + offset)->size = RECORD_WRAP;
+				position += to_end;
+			}
+			auto* record = reinterpret_cast<LogRecord*>(
+				buffer.data + (position & (buffer.capacity - 1))
+			);
+			record->size = size;
+			record->time = time;
+			std::memcpy(record + 1, data, size);
+			buffer.head.store(position + span, std::memory_order_release);
+			return true;
+		}
+
+		// Full; drain it on this thread instead of waiting
+		LogLock lock{};
+		drain();
+	}
+}
+
+static LogBuffer* thread_buffer() {
+	u32 const generation = s_generation.load(std::memory_order_acquire);
+	if (t_generation != generation) {
+		t_generation = generation;
+		t_buffer = nullptr;
+		unsigned const index = s_num_buffers.fetch_add(1, std::memory_order_relaxed);
+		if (index < log::ASYNC_MAX_THREADS) {
+			void* const p = memory::default_allocator().allocate(
+				sizeof(LogBuffer) + s_buffer_capacity,
+				alignof(LogBuffer)
+			);
+			t_buffer = new(p) LogBuffer();
+			t_buffer->head.store(0, std::memory_order_relaxed);
+			t_buffer->tail.store(0, std::memory_order_relaxed);
+			t_buffer->capacity = s_buffer_capacity;
+			t_buffer->data = reinterpret_cast<u8*>(t_buffer + 1);
+			s_buffers[index].store(t_buffer, std::memory_order_release);
+		}
+	}
+	return t_buffer;
+}
+
+static void* flush_func(void* /*call_data*/) {
+	while (!s_shutdown.load(std::memory_order_acquire)) {
+		system::sleep_ms(s_flush_interval_ms);
+		LogLock lock{};
+		drain();
+	}
+	return nullptr;
+}
+
 } // anonymous namespace
 
 void log::printf(char const* const msg, ...) {
-	MutexLock l{_log_mutex};
+	char message[MESSAGE_SIZE];
 	va_list va;
 	va_start(va, msg);
-	std::vprintf(msg, va);
+	signed const result = std::vsnprintf(message, sizeof(message), msg, va);
+	va_end(va);
+	if (result < 0) {
+		return;
+	}
+
+	unsigned const size = static_cast<unsigned>(result);
+	if (t_locked) {
+		// Logged by a sink while this thread writes to the sinks;
+		// taking the lock again would deadlock
+		if (s_stdout) {
+			std::fwrite(message, 1, min(size, unsigned{sizeof(message) - 1}), stdout);
+		}
+		return;
+	}
+	f64 const time = system::time_monotonic();
+	if (size < sizeof(message)) {
+		if (s_async.load(std::memory_order_acquire)) {
+			LogBuffer* const buffer = thread_buffer();
+			if (buffer && buffer_push(*buffer, message, size, time)) {
+				return;
+			}
+		}
+		LogLock lock{};
+		if (s_async.load(std::memory_order_relaxed)) {
+			drain();
+		}
+		write_message(message, size, time);
+		return;
+	}
+
+	// Too large for the format buffer
+	char* const long_message = static_cast<char*>(std::malloc(size + 1));
+	va_start(va, msg);
+	std::vsnprintf(long_message, size + 1, msg, va);
 	va_end(va);
+	{
+		LogLock lock{};
+		if (s_async.load(std::memory_order_relaxed)) {
+			drain();
+		}
+		write_message(long_message, size, time);
+	}
+	std::free(long_message);
+}
+
+void log::set_stdout(bool const enable) {
+	LogLock lock{};
+	s_stdout = enable;
+}
+
+void log::set_timestamps(bool const enable) {
+	LogLock lock{};
+	s_timestamps = enable;
+}
+
+void log::add_sink(IWriter& stream) {
+	LogLock lock{};
+	TOGO_ASSERT(s_num_sinks < MAX_SINKS, "too many log sinks");
+	s_sinks[s_num_sinks++] = &stream;
+}
+
+void log::remove_sink(IWriter& stream) {
+	LogLock lock{};
+	if (s_async.load(std::memory_order_relaxed)) {
+		drain();
+	}
+	for (unsigned i = 0; i < s_num_sinks; ++i) {
+		if (s_sinks[i] == &stream) {
+			--s_num_sinks;
+			for (; i < s_num_sinks; ++i) {
+				s_sinks[i] = s_sinks[i + 1];
+			}
+			break;
+		}
+	}
+}
+
+void log::start_async(unsigned const buffer_size, unsigned const flush_interval_ms) {
+	TOGO_ASSERT(!log::is_async(), "asynchronous logging is already running");
+	unsigned capacity = BUFFER_SIZE_MIN;
+	while (capacity < buffer_size) {
+		capacity <<= 1;
+	}
+	s_buffer_capacity = capacity;
+	s_flush_interval_ms = max(flush_interval_ms, 1u);
+	s_num_buffers.store(0, std::memory_order_relaxed);
+	s_shutdown.store(false, std::memory_order_relaxed);
+	s_generation.fetch_add(1, std::memory_order_release);
+	s_async.store(true, std::memory_order_release);
+	s_flusher = thread::create("log", nullptr, flush_func);
+}
+
+void log::stop_async() {
+	TOGO_ASSERT(log::is_async(), "asynchronous logging is not running");
+	s_shutdown.store(true, std::memory_order_release);
+	thread::join(s_flusher);
+	s_flusher = nullptr;
+
+	LogLock lock{};
+	s_async.store(false, std::memory_order_release);
+	drain();
+	unsigned const num_buffers = min(
+		s_num_buffers.load(std::memory_order_relaxed),
+		unsigned{ASYNC_MAX_THREADS}
+	);
+	for (unsigned i = 0; i < num_buffers; ++i) {
+		LogBuffer* const buffer = s_buffers[i].exchange(nullptr, std::memory_order_relaxed);
+		if (buffer) {
+			buffer->~LogBuffer();
+			memory::default_allocator().deallocate(buffer);
+		}
+	}
+	s_num_buffers.store(0, std::memory_order_relaxed);
+}
+
+bool log::is_async() {
+	return s_async.load(std::memory_order_acquire);
+}
+
+void log::flush() {
+	// May be called from an assertion while logging on this thread
+	if (t_locked) {
+		return;
+	}
+	LogLock lock{};
+	if (s_async.load(std::memory_order_relaxed)) {
+		drain();
+	} else if (s_stdout) {
+		std::fflush(stdout);
+	}
 }
 
 } // namespace togo
@@ -13,6 +13,10 @@
 #include <togo/core/types.hpp>
 
 namespace togo {
+
+// Forward declarations
+class IWriter; // external
+
 namespace log {
 
 /**
@@ -20,9 +24,69 @@ namespace log {
 	@{
 */
 
+enum : unsigned {
+	/// Default size of per-thread buffers for asynchronous logging.
+	ASYNC_BUFFER_SIZE_DEFAULT = 64 * 1024,
+	/// Default interval between asynchronous flushes.
+	ASYNC_FLUSH_INTERVAL_DEFAULT = 10,
+	/// Maximum number of threads with asynchronous log buffers.
+	///
+	/// Any further threads log synchronously.
+	ASYNC_MAX_THREADS = 64,
+};
+
+/// Log formatted message.
+///
+/// If asynchronous logging is running, the message is written to
+/// the calling thread's buffer. Otherwise it is written to the sinks
+/// immediately.
 TOGO_VALIDATE_FORMAT_PARAM(1, 2)
 void printf(char const* const msg, ...);
 
+/// Enable or disable the stdout sink.
+///
+/// The stdout sink is enabled by default.
+void set_stdout(bool enable);
+
+/// Enable or disable message timestamps.
+///
+/// Timestamps are in seconds from system::time_monotonic().
+void set_timestamps(bool enable);
+
+/// Add a sink.
+///
+/// An assertion will fail if the sink limit has been reached.
+void add_sink(IWriter& stream);
+
+/// Remove a sink.
+///
+/// Pending messages are flushed before the sink is removed.
+void remove_sink(IWriter& stream);
+
+/// Start asynchronous logging.
+///
+/// Each thread gets a buffer of buffer_size bytes, which is drained
+/// to the sinks by a background thread every flush_interval_ms
+/// milliseconds. Messages from different threads are written in
+/// timestamp order within a flush.
+/// An assertion will fail if asynchronous logging is already running.
+void start_async(
+	unsigned buffer_size = ASYNC_BUFFER_SIZE_DEFAULT,
+	unsigned flush_interval_ms = ASYNC_FLUSH_INTERVAL_DEFAULT
+);
+
+/// Stop asynchronous logging.
+///
+/// Pending messages are flushed and thread buffers are freed. Other
+/// threads must not log while this is called.
+void stop_async();
+
+/// Whether asynchronous logging is running.
+bool is_async();
+
+/// Flush pending messages to the sinks.
+void flush();
+
 /// Log message.
 #define TOGO_LOG(msg) \
 	::togo::log::printf(msg)
@@ -14,6 +14,7 @@
 #include <togo/core/utility/utility.hpp>
 #include <togo/core/collection/fixed_array.hpp>
 #include <togo/core/collection/array.hpp>
+#include <togo/core/collection/hash_map.hpp>
 #include <togo/core/string/string.hpp>
 #include <togo/core/parser/types.hpp>
 #include <togo/core/parser/parse_state.hpp>
@@ -25,6 +26,20 @@
 namespace togo {
 namespace parse_state {
 
+inline ParseCache::ParseCache(
+	Allocator& allocator,
+	u32 memo_capacity,
+	u32 memo_results_capacity
+)
+	: lookahead_index(allocator)
+	, lookahead(allocator)
+	, memo_capacity(memo_capacity)
+	, memo_results_capacity(memo_results_capacity)
+	, memo_generation(0)
+	, memo(allocator)
+	, memo_results(allocator)
+{}
+
 /// Initialize parser state.
 inline void init(ParseState& s) {
 	s.result_code = ParseResultCode::ok;
@@ -34,6 +49,17 @@ inline void init(ParseState& s) {
 	parse_state::reset_position(s);
 }
 
+/// Reset parser state for another parse.
+///
+/// Results storage is kept and reserved up to the largest number of
+/// results the state has held, so a reused state (or one whose
+/// allocator was reset) does not grow during steady-state parsing.
+inline void reset(ParseState& s, void* userdata) {
+	s.userdata = userdata;
+	parse_state::init(s);
+	array::reserve(s.results, s.results_high_water);
+}
+
 /// Set parser state data from string.
 inline void set_data(ParseState& s, StringRef const data) {
 	parse_state::set_data(s, begin(data), end(data));
@@ -83,10 +109,19 @@ inline void set_num_results(ParseState& s, ParsePosition const& pos) {
 	parse_state::set_num_results(s, min(array::size(s.results), pos.i));
 }
 
+/** @cond INTERNAL */
+inline void update_high_water(ParseState& s) {
+	if (array::size(s.results) > s.results_high_water) {
+		s.results_high_water = array::size(s.results);
+	}
+}
+/** @endcond */ // INTERNAL
+
 /// Push a null result.
 inline void push(ParseState& s) {
 	if (!s.suppress_results) {
 		array::push_back(s.results, {null_tag{}});
+		parse_state::update_high_water(s);
 	}
 }
 
@@ -94,6 +129,7 @@ inline void push(ParseState& s) {
 inline void push(ParseState& s, ParseResult const& r) {
 	if (!s.suppress_results) {
 		array::push_back(s.results, r);
+		parse_state::update_high_water(s);
 	}
 }
 
@@ -101,6 +137,7 @@ inline void push(ParseState& s, ParseResult const& r) {
 inline void push(ParseState& s, ParseResult&& r) {
 	if (!s.suppress_results) {
 		array::push_back(s.results, rvalue_ref(r));
+		parse_state::update_high_water(s);
 	}
 }
 
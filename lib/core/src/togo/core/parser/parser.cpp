@@ -12,6 +12,8 @@
 #include <togo/core/memory/fixed_allocator.hpp>
 #include <togo/core/memory/temp_allocator.hpp>
 #include <togo/core/collection/fixed_array.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/collection/hash_map.hpp>
 #include <togo/core/string/string.hpp>
 #include <togo/core/parser/types.hpp>
 #include <togo/core/parser/parser.hpp>
@@ -34,15 +36,7 @@ thread_local bool s_debug_error_show = false;
 
 namespace {
 
-static FixedParserAllocator<18, 16, 10> pdef_storage;
-
-} // anonymous namespace
-
-#define TOGO_PDEF(name_, ...) \
-Parser const PDef :: name_{"PDef." #name_, __VA_ARGS__};
-
-TOGO_PDEF(whitespace, PMod::test, Func{
-[](Parser const*, ParseState& s, ParsePosition const& from) {
+inline ParseResultCode pf_whitespace(Parser const*, ParseState& s, ParsePosition const& from) {
 	while (s.p < s.e) {
 		signed c = *s.p;
 		if (!(false
@@ -60,12 +54,8 @@ TOGO_PDEF(whitespace, PMod::test, Func{
 	}
 	return fail(s);
 }
-})
-
-TOGO_PDEF(whitespace_maybe, PMod::maybe, Ref{PDef::whitespace})
 
-TOGO_PDEF(space, PMod::test, Func{
-[](Parser const*, ParseState& s, ParsePosition const& from) {
+inline ParseResultCode pf_space(Parser const*, ParseState& s, ParsePosition const& from) {
 	while (s.p < s.e) {
 		signed c = *s.p;
 		if (!(false
@@ -81,54 +71,20 @@ TOGO_PDEF(space, PMod::test, Func{
 	}
 	return fail(s);
 }
-})
-
-TOGO_PDEF(space_maybe, PMod::maybe, Ref{PDef::space})
 
-TOGO_PDEF(null, PMod::test, Close{pdef_storage,
-String{"null"},
-[](Parser const*, ParseState& s, ParsePosition const&) {
+inline ParseResultCode pf_null(Parser const*, ParseState& s, ParsePosition const&) {
 	return ok(s, {null_tag{}});
 }
-})
-
-TOGO_PDEF(boolean, Any{pdef_storage,
-Parser{PMod::test, Close{pdef_storage,
-	String{"true"},
-	[](Parser const*, ParseState& s, ParsePosition const&) {
-		return ok(s, {true});
-	}
-}},
-Parser{PMod::test, Close{pdef_storage,
-	String{"false"},
-	[](Parser const*, ParseState& s, ParsePosition const&) {
-		return ok(s, {false});
-	}
-}}
-})
-
-TOGO_PDEF(sign, Any{pdef_storage,
-	Char{'-'},
-	Char{'+'}
-})
-TOGO_PDEF(sign_maybe, PMod::maybe, Ref{PDef::sign})
-
-TOGO_PDEF(digit_dec, CharRange{'0', '9'})
-TOGO_PDEF(digits_dec, PMod::repeat, Ref{PDef::digit_dec})
 
-TOGO_PDEF(digit_hex, Any{pdef_storage,
-PDef::digit_dec,
-CharRange{'a', 'f'},
-CharRange{'A', 'F'}
-})
-TOGO_PDEF(digits_hex, PMod::repeat, Ref{PDef::digit_hex})
+inline ParseResultCode pf_true(Parser const*, ParseState& s, ParsePosition const&) {
+	return ok(s, {true});
+}
 
-TOGO_PDEF(digit_oct, CharRange{'0', '7'})
-TOGO_PDEF(digits_oct, PMod::repeat, Ref{PDef::digit_oct})
+inline ParseResultCode pf_false(Parser const*, ParseState& s, ParsePosition const&) {
+	return ok(s, {false});
+}
 
-TOGO_PDEF(u64_dec, PMod::flatten, Close{
-PDef::digits_dec,
-[](Parser const*, ParseState& s, ParsePosition const& from) {
+inline ParseResultCode pf_u64_dec(Parser const*, ParseState& s, ParsePosition const& from) {
 	auto& r = back(s.results);
 	auto e = r.s.e;
 	u64 value = 0;
@@ -137,14 +93,8 @@ PDef::digits_dec,
 	}
 	return ok_replace(s, from, {value});
 }
-})
-
-TOGO_PDEF(u64_hex, PMod::flatten, Close{pdef_storage,
-All{pdef_storage,
-	Any{pdef_storage, String{"0x"}, String{"0X"}},
-	PDef::digits_hex
-},
-[](Parser const*, ParseState& s, ParsePosition const& from) {
+
+inline ParseResultCode pf_u64_hex(Parser const*, ParseState& s, ParsePosition const& from) {
 	auto const& r = back(s.results);
 	u64 value = 0;
 	auto p = r.s.b + 2;
@@ -163,14 +113,8 @@ All{pdef_storage,
 	}
 	return ok_replace(s, from, {value});
 }
-})
-
-TOGO_PDEF(u64_oct, PMod::flatten, Close{pdef_storage,
-All{pdef_storage,
-	Char{'0'},
-	Parser{PMod::maybe, Ref{PDef::digits_oct}}
-},
-[](Parser const*, ParseState& s, ParsePosition const& from) {
+
+inline ParseResultCode pf_u64_oct(Parser const*, ParseState& s, ParsePosition const& from) {
 	auto const& r = back(s.results);
 	u64 value = 0;
 	auto p = r.s.b + 1;
@@ -181,39 +125,8 @@ All{pdef_storage,
 	}
 	return ok_replace(s, from, {value});
 }
-})
-
-TOGO_PDEF(u64_any, Any{pdef_storage,
-PDef::u64_hex,
-PDef::u64_oct,
-PDef::u64_dec
-})
-
-TOGO_PDEF(s64_dec, Close{pdef_storage,
-All{pdef_storage,
-	PDef::sign_maybe,
-	PDef::u64_dec
-},
-[](Parser const*, ParseState& s, ParsePosition const& from) {
-	bool sign = false;
-	if ((array::size(s.results) - from.i) == 2) {
-		sign = s.results[from.i].c == '-';
-	}
-	s64 value = static_cast<s64>(back(s.results).u);
-	return ok_replace(s, from, {sign ? -value : value});
-}
-})
-
-TOGO_PDEF(s64_any, Close{pdef_storage,
-All{pdef_storage,
-	PDef::sign_maybe,
-	Any{pdef_storage,
-		PDef::u64_hex,
-		PDef::u64_oct,
-		PDef::s64_dec
-	}
-},
-[](Parser const*, ParseState& s, ParsePosition const& from) {
+
+inline ParseResultCode pf_s64(Parser const*, ParseState& s, ParsePosition const& from) {
 	bool sign = false;
 	if ((array::size(s.results) - from.i) == 2) {
 		sign = s.results[from.i].c == '-';
@@ -221,36 +134,115 @@ All{pdef_storage,
 	s64 value = static_cast<s64>(back(s.results).u);
 	return ok_replace(s, from, {sign ? -value : value});
 }
-})
-
-TOGO_PDEF(f64_basic, PMod::flatten, Close{pdef_storage,
-All{pdef_storage,
-	PDef::sign_maybe,
-	PDef::digits_dec,
-	Char{'.'},
-	PDef::digits_dec
-},
-[](Parser const*, ParseState& s, ParsePosition const& from) {
-	auto& r = back(s.results);
-	return ok_replace(s, from, {parser::parse_f64({r.s.b, r.s.e})});
-}
-})
-
-TOGO_PDEF(f64_exp, PMod::flatten, Close{pdef_storage,
-All{pdef_storage,
-	PDef::f64_basic,
-	Parser{PMod::maybe, All{pdef_storage,
-		Any{pdef_storage, Char{'e'}, Char{'E'}},
-		PDef::sign_maybe,
-		PDef::digits_dec
-	}}
-},
-[](Parser const*, ParseState& s, ParsePosition const& from) {
+
+inline ParseResultCode pf_f64(Parser const*, ParseState& s, ParsePosition const& from) {
 	auto& r = back(s.results);
 	return ok_replace(s, from, {parser::parse_f64({r.s.b, r.s.e})});
 }
-})
 
+} // anonymous namespace
+
+// PDef parsers and the unnamed parsers they are composed of are
+// constant-initialized. Series are defined over static pointer arrays
+// instead of allocator storage.
+
+#define TOGO_PDEF(name_, ...) \
+Parser const PDef :: name_{"PDef." #name_, __VA_ARGS__};
+
+#define TOGO_PDEF_NODE(name_, ...) \
+static Parser const name_{__VA_ARGS__};
+
+#define TOGO_PDEF_SERIES(name_, ...) \
+static Parser const* name_[]{__VA_ARGS__};
+
+namespace {
+
+TOGO_PDEF_NODE(n_null_string, String{"null"})
+TOGO_PDEF_NODE(n_true_string, String{"true"})
+TOGO_PDEF_NODE(n_false_string, String{"false"})
+TOGO_PDEF_NODE(n_true, PMod::test, Close{pf_true, n_true_string})
+TOGO_PDEF_NODE(n_false, PMod::test, Close{pf_false, n_false_string})
+TOGO_PDEF_SERIES(s_boolean, &n_true, &n_false)
+
+TOGO_PDEF_NODE(n_sign_minus, Char{'-'})
+TOGO_PDEF_NODE(n_sign_plus, Char{'+'})
+TOGO_PDEF_SERIES(s_sign, &n_sign_minus, &n_sign_plus)
+
+TOGO_PDEF_NODE(n_hex_lower, CharRange{'a', 'f'})
+TOGO_PDEF_NODE(n_hex_upper, CharRange{'A', 'F'})
+TOGO_PDEF_SERIES(s_digit_hex, &PDef::digit_dec, &n_hex_lower, &n_hex_upper)
+
+TOGO_PDEF_NODE(n_hex_prefix_lower, String{"0x"})
+TOGO_PDEF_NODE(n_hex_prefix_upper, String{"0X"})
+TOGO_PDEF_SERIES(s_hex_prefix, &n_hex_prefix_lower, &n_hex_prefix_upper)
+TOGO_PDEF_NODE(n_hex_prefix, Any{s_hex_prefix})
+TOGO_PDEF_SERIES(s_u64_hex, &n_hex_prefix, &PDef::digits_hex)
+TOGO_PDEF_NODE(n_u64_hex, All{s_u64_hex})
+
+TOGO_PDEF_NODE(n_oct_prefix, Char{'0'})
+TOGO_PDEF_NODE(n_oct_digits_maybe, PMod::maybe, Ref{PDef::digits_oct})
+TOGO_PDEF_SERIES(s_u64_oct, &n_oct_prefix, &n_oct_digits_maybe)
+TOGO_PDEF_NODE(n_u64_oct, All{s_u64_oct})
+
+TOGO_PDEF_SERIES(s_u64_any, &PDef::u64_hex, &PDef::u64_oct, &PDef::u64_dec)
+
+TOGO_PDEF_SERIES(s_s64_dec, &PDef::sign_maybe, &PDef::u64_dec)
+TOGO_PDEF_NODE(n_s64_dec, All{s_s64_dec})
+
+TOGO_PDEF_SERIES(s_s64_any_number, &PDef::u64_hex, &PDef::u64_oct, &PDef::s64_dec)
+TOGO_PDEF_NODE(n_s64_any_number, Any{s_s64_any_number})
+TOGO_PDEF_SERIES(s_s64_any, &PDef::sign_maybe, &n_s64_any_number)
+TOGO_PDEF_NODE(n_s64_any, All{s_s64_any})
+
+TOGO_PDEF_NODE(n_decimal_point, Char{'.'})
+TOGO_PDEF_SERIES(s_f64_basic, &PDef::sign_maybe, &PDef::digits_dec, &n_decimal_point, &PDef::digits_dec)
+TOGO_PDEF_NODE(n_f64_basic, All{s_f64_basic})
+
+TOGO_PDEF_NODE(n_exp_lower, Char{'e'})
+TOGO_PDEF_NODE(n_exp_upper, Char{'E'})
+TOGO_PDEF_SERIES(s_exp_marker, &n_exp_lower, &n_exp_upper)
+TOGO_PDEF_NODE(n_exp_marker, Any{s_exp_marker})
+TOGO_PDEF_SERIES(s_exp, &n_exp_marker, &PDef::sign_maybe, &PDef::digits_dec)
+TOGO_PDEF_NODE(n_exp_maybe, PMod::maybe, All{s_exp})
+TOGO_PDEF_SERIES(s_f64_exp, &PDef::f64_basic, &n_exp_maybe)
+TOGO_PDEF_NODE(n_f64_exp, All{s_f64_exp})
+
+} // anonymous namespace
+
+TOGO_PDEF(whitespace, PMod::test, Func{pf_whitespace})
+TOGO_PDEF(whitespace_maybe, PMod::maybe, Ref{PDef::whitespace})
+
+TOGO_PDEF(space, PMod::test, Func{pf_space})
+TOGO_PDEF(space_maybe, PMod::maybe, Ref{PDef::space})
+
+TOGO_PDEF(null, PMod::test, Close{pf_null, n_null_string})
+TOGO_PDEF(boolean, Any{s_boolean})
+
+TOGO_PDEF(sign, Any{s_sign})
+TOGO_PDEF(sign_maybe, PMod::maybe, Ref{PDef::sign})
+
+TOGO_PDEF(digit_dec, CharRange{'0', '9'})
+TOGO_PDEF(digits_dec, PMod::repeat, Ref{PDef::digit_dec})
+
+TOGO_PDEF(digit_hex, Any{s_digit_hex})
+TOGO_PDEF(digits_hex, PMod::repeat, Ref{PDef::digit_hex})
+
+TOGO_PDEF(digit_oct, CharRange{'0', '7'})
+TOGO_PDEF(digits_oct, PMod::repeat, Ref{PDef::digit_oct})
+
+TOGO_PDEF(u64_dec, PMod::flatten, Close{pf_u64_dec, PDef::digits_dec})
+TOGO_PDEF(u64_hex, PMod::flatten, Close{pf_u64_hex, n_u64_hex})
+TOGO_PDEF(u64_oct, PMod::flatten, Close{pf_u64_oct, n_u64_oct})
+TOGO_PDEF(u64_any, Any{s_u64_any})
+
+TOGO_PDEF(s64_dec, Close{pf_s64, n_s64_dec})
+TOGO_PDEF(s64_any, Close{pf_s64, n_s64_any})
+
+TOGO_PDEF(f64_basic, PMod::flatten, Close{pf_f64, n_f64_basic})
+TOGO_PDEF(f64_exp, PMod::flatten, Close{pf_f64, n_f64_exp})
+
+#undef TOGO_PDEF_SERIES
+#undef TOGO_PDEF_NODE
 #undef TOGO_PDEF
 
 namespace {
@@ -402,6 +394,166 @@ static void debug_print_shallow(Parser const& p) {
 static Parser const s_parser_begin{Head{}};
 static Parser const s_parser_end{Tail{}};
 
+// Past this the first set is not worth chasing (or the grammar is left-recursive)
+static constexpr unsigned const c_first_set_max_depth = 32;
+
+inline void first_set_add(ParserFirstSet& set, signed c) {
+	unsigned const u = static_cast<u8>(c);
+	set.chars[u >> 6] |= u64{1} << (u & 63);
+}
+
+inline bool first_set_test(ParserFirstSet const& set, unsigned u) {
+	return set.always || (u < 256 && (set.chars[u >> 6] & (u64{1} << (u & 63))));
+}
+
+static void first_set_build(ParserFirstSet& set, Parser const& p, unsigned depth) {
+	if (
+		depth >= c_first_set_max_depth ||
+		enum_bool(parser::modifiers(p) & (PMod::maybe | PMod::repeat_or_none))
+	) {
+		set.always = true;
+		return;
+	}
+	switch (parser::type(p)) {
+	case ParserType::Char:
+		first_set_add(set, p.s.Char.c);
+		break;
+
+	case ParserType::CharRange:
+		for (signed c = p.s.CharRange.b; c <= p.s.CharRange.e; ++c) {
+			first_set_add(set, c);
+		}
+		break;
+
+	case ParserType::String:
+		if (p.s.String.s.any()) {
+			first_set_add(set, p.s.String.s.data[0]);
+		} else {
+			set.always = true;
+		}
+		break;
+
+	case ParserType::Bounded:
+		first_set_add(set, p.s.Bounded.opener);
+		break;
+
+	case ParserType::Any:
+		for (auto sub : array_cref(p.s.Any.p, p.s.Any.num)) {
+			first_set_build(set, *sub, depth + 1);
+		}
+		break;
+
+	case ParserType::All:
+		if (p.s.All.num > 0) {
+			first_set_build(set, *p.s.All.p[0], depth + 1);
+		} else {
+			set.always = true;
+		}
+		break;
+
+	case ParserType::Ref:
+		first_set_build(set, *p.s.Ref.p, depth + 1);
+		break;
+
+	case ParserType::Close:
+		if (p.s.Close.p) {
+			first_set_build(set, *p.s.Close.p, depth + 1);
+		} else {
+			set.always = true;
+		}
+		break;
+
+	// Intangibles can match without input, functions are opaque, and
+	// Open and CloseAndFlush call their function before or regardless
+	// of the match
+	default:
+		set.always = true;
+		break;
+	}
+}
+
+// Index of the first sets of an Any parser's branches
+static u32 lookahead_index(ParseCache& cache, Parser const& p) {
+	hash64 const key = reinterpret_cast<std::uintptr_t>(&p) >> 3;
+	if (u32 const* index = hash_map::find(cache.lookahead_index, key)) {
+		return *index;
+	}
+	auto const& d = p.s.Any;
+	u32 const index = array::size(cache.lookahead);
+	array::resize(cache.lookahead, index + d.num);
+	for (unsigned i = 0; i < d.num; ++i) {
+		auto& set = cache.lookahead[index + i];
+		set = {{0, 0, 0, 0}, false};
+		first_set_build(set, *d.p[i], 0);
+	}
+	hash_map::set(cache.lookahead_index, key, index);
+	return index;
+}
+
+inline bool memoizable(Parser const& p, ParserType const type) {
+	return type >= ParserType::Any && p.name.any();
+}
+
+static parse_state::ParseMemoEntry& memo_slot(ParseCache& cache, Parser const& p, u32 const pos) {
+	if (array::empty(cache.memo)) {
+		u32 capacity = 1;
+		while (capacity < cache.memo_capacity) {
+			capacity <<= 1;
+		}
+		array::resize(cache.memo, capacity);
+		for (auto& entry : cache.memo) {
+			entry.p = nullptr;
+		}
+	}
+	u64 h = (reinterpret_cast<std::uintptr_t>(&p) >> 3) ^ (u64{pos} * 0x9E3779B97F4A7C15);
+	h ^= h >> 29;
+	return cache.memo[static_cast<u32>(h) & (array::size(cache.memo) - 1)];
+}
+
+inline bool memo_hit(
+	parse_state::ParseMemoEntry const& entry,
+	ParseCache const& cache,
+	ParseState const& s,
+	Parser const& p,
+	u32 const pos
+) {
+	return
+		entry.p == &p &&
+		entry.pos == pos &&
+		entry.generation == cache.memo_generation &&
+		(entry.has_results || s.suppress_results)
+	;
+}
+
+static void memo_store(
+	parse_state::ParseMemoEntry& entry,
+	ParseCache& cache,
+	ParseState& s,
+	Parser const& p,
+	ParsePosition const& from,
+	ParseResultCode const rc
+) {
+	entry.p = &p;
+	entry.generation = cache.memo_generation;
+	entry.pos = static_cast<u32>(from.p - s.b);
+	entry.end = static_cast<u32>(s.p - s.b);
+	entry.result_code = rc;
+	entry.results_offset = array::size(cache.memo_results);
+	entry.num_results = 0;
+	entry.has_results = !s.suppress_results;
+	if (rc == ParseResultCode::ok && entry.has_results) {
+		u32 const num = parse_state::num_results(s, from);
+		if (entry.results_offset + num > cache.memo_results_capacity) {
+			entry.has_results = false;
+			return;
+		}
+		entry.num_results = num;
+		for (u32 i = 0; i < num; ++i) {
+			array::push_back(cache.memo_results, s.results[from.i + i]);
+		}
+	}
+}
+
 static ParseResultCode parse_impl(
 	Parser const& p,
 	ParseState& s,
@@ -537,7 +689,12 @@ static ParseResultCode parse_impl(
 
 	case ParserType::Any: {
 		auto const& d = p.s.Any;
+		u32 const lookahead = s.cache ? lookahead_index(*s.cache, p) : 0;
+		unsigned const c = s.p < s.e ? static_cast<u8>(*s.p) : 256;
 		for (unsigned i = 0; i < d.num; ++i) {
+			if (s.cache && !first_set_test(s.cache->lookahead[lookahead + i], c)) {
+				continue;
+			}
 			if (parser::parse_do(*d.p[i], s) == ParseResultCode::ok) {
 				PARSE_RESULT(ok(s));
 			}
@@ -716,6 +873,23 @@ ParseResultCode parser::parse_do(Parser const& p, ParseState& s) {
 	auto mods = parser::modifiers(p);
 	auto const from = position(s);
 
+	parse_state::ParseMemoEntry* memo = nullptr;
+	if (s.cache && s.cache->memo_capacity && memoizable(p, type)) {
+		u32 const pos = static_cast<u32>(s.p - s.b);
+		memo = &memo_slot(*s.cache, p, pos);
+		if (memo_hit(*memo, *s.cache, s, p, pos)) {
+			s.p = s.b + memo->end;
+			if (memo->result_code == ParseResultCode::ok && !s.suppress_results) {
+				for (u32 i = 0; i < memo->num_results; ++i) {
+					array::push_back(s.results, s.cache->memo_results[memo->results_offset + i]);
+				}
+				parse_state::update_high_water(s);
+			}
+			s.result_code = memo->result_code;
+			return memo->result_code;
+		}
+	}
+
 #if defined(TOGO_DEBUG)
 	if (s_debug_trace) {
 		PARSE_TRACE("+ ");
@@ -801,9 +975,25 @@ ParseResultCode parser::parse_do(Parser const& p, ParseState& s) {
 		set_position(s, from);
 		break;
 	}
+	if (memo) {
+		memo_store(*memo, *s.cache, s, p, from, rc);
+	}
 	return rc;
 }
 
+/// Clear memoized results.
+///
+/// This is called by parse() before parsing with a cache.
+void parser::clear_memo(ParseCache& cache) {
+	// Invalidate by generation instead of clearing the table
+	if (++cache.memo_generation == 0) {
+		for (auto& entry : cache.memo) {
+			entry.p = nullptr;
+		}
+	}
+	array::clear(cache.memo_results);
+}
+
 /// Run parser.
 bool parser::parse(
 	Parser const& p,
@@ -821,6 +1011,9 @@ bool parser::parse(
 #endif
 
 	parse_state::clear_error(s);
+	if (s.cache) {
+		parser::clear_memo(*s.cache);
+	}
 	auto const rc = parser::parse_do(p, s);
 	if (rc == ParseResultCode::ok) {
 		update_text_position(s);
@@ -48,7 +48,7 @@ inline void series_add_parser(ParserData<T>& d, Allocator& a, unsigned i, Parser
 
 } // anonymous namespace
 
-inline Bounded::ParserData(char opener, char closer, Parser const& p)
+inline constexpr Bounded::ParserData(char opener, char closer, Parser const& p)
 	: opener(opener)
 	, closer(closer)
 	, p(&p)
@@ -60,6 +60,14 @@ inline Bounded::ParserData(Allocator& a, char opener, char closer, Parser&& p)
 	, p(TOGO_CONSTRUCT(a, Parser, rvalue_ref(p)))
 {}
 
+template<ParserType T>
+template<unsigned N>
+inline constexpr ParserData<T, enable_if<is_series<T>::value>>
+::ParserData(Parser const* (&p)[N])
+	: num(N)
+	, p(p)
+{}
+
 template<ParserType T>
 template<class... P>
 inline ParserData<T, enable_if<is_series<T>::value>>
@@ -71,7 +79,7 @@ inline ParserData<T, enable_if<is_series<T>::value>>
 }
 
 template<ParserType T>
-inline ParserData<T, enable_if<is_branch<T>::value>>
+inline constexpr ParserData<T, enable_if<is_branch<T>::value>>
 ::ParserData(Parser const& p)
 	: p(&p)
 {}
@@ -82,37 +90,37 @@ inline ParserData<T, enable_if<is_branch<T>::value>>
 	: p(TOGO_CONSTRUCT(a, Parser, rvalue_ref(p)))
 {}
 
-inline Func::ParserData(parse_func_type* f)
+inline constexpr Func::ParserData(parse_func_type* f)
 	: f(f)
 	, userdata(nullptr)
 {}
 
-inline Func::ParserData(parse_func_type* f, void* userdata)
+inline constexpr Func::ParserData(parse_func_type* f, void* userdata)
 	: f(f)
 	, userdata(userdata)
 {}
 
-inline Func::ParserData(void* userdata, parse_func_type* f)
+inline constexpr Func::ParserData(void* userdata, parse_func_type* f)
 	: f(f)
 	, userdata(userdata)
 {}
 
 template<ParserType T>
-inline ParserData<T, enable_if<is_branch_call<T>::value>>
+inline constexpr ParserData<T, enable_if<is_branch_call<T>::value>>
 ::ParserData(parse_func_type* f)
 	: f(f)
 	, p(nullptr)
 {}
 
 template<ParserType T>
-inline ParserData<T, enable_if<is_branch_call<T>::value>>
+inline constexpr ParserData<T, enable_if<is_branch_call<T>::value>>
 ::ParserData(parse_func_type* f, Parser const& p)
 	: f(f)
 	, p(&p)
 {}
 
 template<ParserType T>
-inline ParserData<T, enable_if<is_branch_call<T>::value>>
+inline constexpr ParserData<T, enable_if<is_branch_call<T>::value>>
 ::ParserData(Parser const& p, parse_func_type* f)
 	: f(f)
 	, p(&p)
@@ -134,7 +142,7 @@ inline ParserData<T, enable_if<is_branch_call<T>::value>>
 
 inline Parser::Parser(StringRef name)
 	: properties(unsigned_cast(ParserType::Undefined))
-	, name_hash(hash::calc32(name))
+	, name_hash(hash::calc32_ce(name))
 	, name(name)
 	, s(no_init_tag{})
 {}
@@ -144,35 +152,35 @@ inline Parser::Parser()
 {}
 
 template<ParserType T>
-inline Parser::Parser(StringRef name, ParserModifier mods, ParserData<T>&& d)
+inline constexpr Parser::Parser(StringRef name, ParserModifier mods, ParserData<T>&& d)
 	: properties(unsigned_cast(T) | (unsigned_cast(mods) << 16))
-	, name_hash(hash::calc32(name))
+	, name_hash(hash::calc32_ce(name))
 	, name(name)
 	, s(forward<ParserData<T>&&>(d))
 {}
 
 template<ParserType T>
-inline Parser::Parser(StringRef name, ParserData<T>&& d)
+inline constexpr Parser::Parser(StringRef name, ParserData<T>&& d)
 	: Parser(name, PMod::none, forward<ParserData<T>&&>(d))
 {}
 
 template<ParserType T>
-inline Parser::Parser(ParserData<T>&& d)
+inline constexpr Parser::Parser(ParserData<T>&& d)
 	: Parser(StringRef{}, PMod::none, forward<ParserData<T>&&>(d))
 {}
 
 template<ParserType T>
-inline Parser::Parser(ParserModifier mods, ParserData<T>&& d)
+inline constexpr Parser::Parser(ParserModifier mods, ParserData<T>&& d)
 	: Parser(StringRef{}, mods, forward<ParserData<T>&&>(d))
 {}
 
 /// Type.
-inline ParserType type(Parser const& p) {
+inline constexpr ParserType type(Parser const& p) {
 	return static_cast<ParserType>(p.properties & ((1 << 16) - 1));
 }
 
 /// Modifiers.
-inline ParserModifier modifiers(Parser const& p) {
+inline constexpr ParserModifier modifiers(Parser const& p) {
 	return static_cast<ParserModifier>((p.properties >> 16));
 }
 
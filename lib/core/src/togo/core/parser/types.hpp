@@ -201,7 +201,7 @@ struct ParserData<ParserType::Bounded> {
 	signed closer;
 	Parser const* p;
 
-	ParserData(char opener, char closer, Parser const& p);
+	constexpr ParserData(char opener, char closer, Parser const& p);
 	ParserData(Allocator& a, char opener, char closer, Parser&& p);
 };
 
@@ -210,6 +210,9 @@ struct ParserData<T, enable_if<is_series<T>::value>> {
 	unsigned num;
 	Parser const** p;
 
+	template<unsigned N>
+	constexpr ParserData(Parser const* (&p)[N]);
+
 	template<class... P>
 	ParserData(Allocator& a, P&&... p);
 };
@@ -218,7 +221,7 @@ template<ParserType T>
 struct ParserData<T, enable_if<is_branch<T>::value>> {
 	Parser const* p;
 
-	ParserData(Parser const& p);
+	constexpr ParserData(Parser const& p);
 	ParserData(Allocator& a, Parser&& p);
 };
 
@@ -227,9 +230,9 @@ struct ParserData<ParserType::Func> {
 	parse_func_type* f;
 	void* userdata;
 
-	ParserData(parse_func_type* f);
-	ParserData(parse_func_type* f, void* userdata);
-	ParserData(void* userdata, parse_func_type* f);
+	constexpr ParserData(parse_func_type* f);
+	constexpr ParserData(parse_func_type* f, void* userdata);
+	constexpr ParserData(void* userdata, parse_func_type* f);
 };
 
 template<ParserType T>
@@ -237,14 +240,18 @@ struct ParserData<T, enable_if<is_branch_call<T>::value>> {
 	parse_func_type* f;
 	Parser const* p;
 
-	ParserData(parse_func_type* f);
-	ParserData(parse_func_type* f, Parser const& p);
-	ParserData(Parser const& p, parse_func_type* f);
+	constexpr ParserData(parse_func_type* f);
+	constexpr ParserData(parse_func_type* f, Parser const& p);
+	constexpr ParserData(Parser const& p, parse_func_type* f);
 	ParserData(Allocator& a, parse_func_type* f, Parser&& p);
 	ParserData(Allocator& a, Parser&& p, parse_func_type* f);
 };
 
 /// Parser.
+///
+/// A parser built from references to other parsers, series over static
+/// pointer arrays, and non-lambda functions is constant-initialized, so
+/// a static grammar has no construction cost at startup.
 struct Parser {
 	// {u16 type; u16 modifiers;}
 	u32 properties;
@@ -270,27 +277,28 @@ struct Parser {
 
 		Storage(no_init_tag) {}
 
-		Storage(parser::Undefined&&) {}
-		Storage(parser::Nothing&&) {}
-		Storage(parser::Empty&&) {}
-		Storage(parser::Head&&) {}
-		Storage(parser::Tail&&) {}
+		// A constexpr union constructor must initialize a member
+		constexpr Storage(parser::Undefined&&) : Char{0} {}
+		constexpr Storage(parser::Nothing&&) : Char{0} {}
+		constexpr Storage(parser::Empty&&) : Char{0} {}
+		constexpr Storage(parser::Head&&) : Char{0} {}
+		constexpr Storage(parser::Tail&&) : Char{0} {}
 
-		Storage(parser::Char&& d) : Char(rvalue_ref(d)) {}
-		Storage(parser::CharRange&& d) : CharRange(rvalue_ref(d)) {}
-		Storage(parser::String&& d) : String(rvalue_ref(d)) {}
-		Storage(parser::Bounded&& d) : Bounded(rvalue_ref(d)) {}
+		constexpr Storage(parser::Char&& d) : Char(rvalue_ref(d)) {}
+		constexpr Storage(parser::CharRange&& d) : CharRange(rvalue_ref(d)) {}
+		constexpr Storage(parser::String&& d) : String(rvalue_ref(d)) {}
+		constexpr Storage(parser::Bounded&& d) : Bounded(rvalue_ref(d)) {}
 
-		Storage(parser::Any&& d) : Any(rvalue_ref(d)) {}
-		Storage(parser::All&& d) : All(rvalue_ref(d)) {}
+		constexpr Storage(parser::Any&& d) : Any(rvalue_ref(d)) {}
+		constexpr Storage(parser::All&& d) : All(rvalue_ref(d)) {}
 
-		Storage(parser::Ref&& d) : Ref(rvalue_ref(d)) {}
+		constexpr Storage(parser::Ref&& d) : Ref(rvalue_ref(d)) {}
 
-		Storage(parser::Func&& d) : Func(rvalue_ref(d)) {}
+		constexpr Storage(parser::Func&& d) : Func(rvalue_ref(d)) {}
 
-		Storage(parser::Open&& d) : Open(rvalue_ref(d)) {}
-		Storage(parser::Close&& d) : Close(rvalue_ref(d)) {}
-		Storage(parser::CloseAndFlush&& d) : CloseAndFlush(rvalue_ref(d)) {}
+		constexpr Storage(parser::Open&& d) : Open(rvalue_ref(d)) {}
+		constexpr Storage(parser::Close&& d) : Close(rvalue_ref(d)) {}
+		constexpr Storage(parser::CloseAndFlush&& d) : CloseAndFlush(rvalue_ref(d)) {}
 	} s;
 
 	/// Construct named Undefined parser.
@@ -301,19 +309,28 @@ struct Parser {
 
 	/// Construct named parser with modifiers.
 	template<ParserType T>
-	Parser(StringRef name, ParserModifier mods, ParserData<T>&& d);
+	constexpr Parser(StringRef name, ParserModifier mods, ParserData<T>&& d);
 
 	/// Construct named parser.
 	template<ParserType T>
-	Parser(StringRef name, ParserData<T>&& d);
+	constexpr Parser(StringRef name, ParserData<T>&& d);
 
 	/// Construct unnamed parser with modifiers.
 	template<ParserType T>
-	Parser(ParserModifier mods, ParserData<T>&& d);
+	constexpr Parser(ParserModifier mods, ParserData<T>&& d);
 
 	/// Construct unnamed parser.
 	template<ParserType T>
-	Parser(ParserData<T>&& d);
+	constexpr Parser(ParserData<T>&& d);
+};
+
+/// First-character set of a parser.
+///
+/// If always is true, the parser must be tried regardless of the next
+/// character (e.g., it may match without consuming input).
+struct ParserFirstSet {
+	u64 chars[4];
+	bool always;
 };
 
 /// sizeof(Parser) * num.
@@ -494,6 +511,50 @@ struct ParseError {
 	{}
 };
 
+/** @cond INTERNAL */
+struct ParseMemoEntry {
+	parser::Parser const* p;
+	u32 generation;
+	u32 pos;
+	u32 end;
+	u32 results_offset;
+	u32 num_results;
+	bool has_results;
+	ParseResultCode result_code;
+};
+/** @endcond */ // INTERNAL
+
+/// Parse cache.
+///
+/// When attached to ParseState::cache, branches of Any parsers are
+/// skipped if the next character can't start them. If memo_capacity is
+/// non-zero, results of named series, branch, and call parsers are also
+/// memoized by input position (packrat parsing). The memo table and its
+/// results are bounded by memo_capacity and memo_results_capacity.
+///
+/// Memoization assumes parse functions depend only on the input and
+/// results; it must not be used with parsers that act on
+/// ParseState::userdata.
+struct ParseCache {
+	HashMap<hash64, u32> lookahead_index;
+	Array<parser::ParserFirstSet> lookahead;
+
+	u32 memo_capacity;
+	u32 memo_results_capacity;
+	u32 memo_generation;
+	Array<ParseMemoEntry> memo;
+	Array<ParseResult> memo_results;
+
+	ParseCache(ParseCache const&) = delete;
+	ParseCache& operator=(ParseCache const&) = delete;
+
+	ParseCache(
+		Allocator& allocator,
+		u32 memo_capacity = 0,
+		u32 memo_results_capacity = 0
+	);
+};
+
 /// Parse state.
 struct ParseState {
 	char const* p;
@@ -507,7 +568,9 @@ struct ParseState {
 	bool only_furthest_error;
 	unsigned line;
 	unsigned column;
+	unsigned results_high_water;
 	void* userdata;
+	ParseCache* cache;
 	Array<ParseResult> results;
 	ParseError error;
 
@@ -526,7 +589,9 @@ struct ParseState {
 		, only_furthest_error(false)
 		, line(1)
 		, column(1)
+		, results_high_water(0)
 		, userdata(userdata)
+		, cache(nullptr)
 		, results(allocator)
 		, error()
 	{}
@@ -567,11 +632,13 @@ using parser::ParserModifier;
 using parser::PMod;
 using parser::Parser;
 using parser::FixedParserAllocator;
+using parser::ParserFirstSet;
 
 using parse_state::ParseResultCode;
 using parse_state::ParseResult;
 using parse_state::ParsePosition;
 using parse_state::ParseError;
+using parse_state::ParseCache;
 using parse_state::ParseState;
 
 using parser::PDef;
@@ -18,10 +18,14 @@
 #include <togo/core/error/assert.hpp>
 #include <togo/core/utility/traits.hpp>
 #include <togo/core/utility/utility.hpp>
+#include <togo/core/utility/endian.hpp>
+#include <togo/core/collection/array.hpp>
 #include <togo/core/io/io.hpp>
 #include <togo/core/serialization/types.hpp>
 #include <togo/core/serialization/support.hpp>
 
+#include <cstring>
+
 namespace togo {
 
 /**
@@ -41,6 +45,25 @@ inline BinaryOutputSerializer::BinaryOutputSerializer(IWriter& stream, Endian en
 	, _endian(endian)
 {}
 
+/// Construct with data.
+inline BinaryMemoryInputSerializer::BinaryMemoryInputSerializer(
+	ArrayRef<u8 const> const& data,
+	Endian endian
+)
+	: _position(begin(data))
+	, _end(end(data))
+	, _endian(endian)
+{}
+
+/// Construct with buffer.
+inline BinaryMemoryOutputSerializer::BinaryMemoryOutputSerializer(
+	Array<u8>& buffer,
+	Endian endian
+)
+	: _buffer(buffer)
+	, _endian(endian)
+{}
+
 /** @cond INTERNAL */
 
 // arithmetic
@@ -98,6 +121,97 @@ write(serializer_tag, BinaryOutputSerializer& ser, SerBuffer<C> const& buffer) {
 	TOGO_ASSERTE(io::write(ser._stream, buffer.ptr, buffer.size));
 }
 
+// memory
+
+inline void binary_memory_read(BinaryMemoryInputSerializer& ser, void* data, unsigned size) {
+	TOGO_ASSERTE(static_cast<unsigned>(ser._end - ser._position) >= size);
+	if (size) {
+		std::memcpy(data, ser._position, size);
+		ser._position += size;
+	}
+}
+
+inline u8* binary_memory_extend(BinaryMemoryOutputSerializer& ser, unsigned size) {
+	unsigned const offset = array::size(ser._buffer);
+	array::increase_size(ser._buffer, size);
+	return array::begin(ser._buffer) + offset;
+}
+
+inline void binary_memory_write(BinaryMemoryOutputSerializer& ser, void const* data, unsigned size) {
+	if (size) {
+		std::memcpy(binary_memory_extend(ser, size), data, size);
+	}
+}
+
+// memory arithmetic
+
+template<class T>
+inline enable_if<is_arithmetic<T>::value>
+read(serializer_tag, BinaryMemoryInputSerializer& ser, T& value) {
+	binary_memory_read(ser, &value, sizeof(T));
+	reverse_bytes_if(value, ser._endian);
+}
+
+template<class T>
+inline enable_if<is_arithmetic<T>::value>
+write(serializer_tag, BinaryMemoryOutputSerializer& ser, T const& value) {
+	T const serial = reverse_bytes_copy_if(value, ser._endian);
+	binary_memory_write(ser, &serial, sizeof(T));
+}
+
+// memory arithmetic sequence
+
+template<class T>
+inline enable_if<is_arithmetic<T>::value>
+read(serializer_tag, BinaryMemoryInputSerializer& ser, SerSequence<T>&& seq) {
+	binary_memory_read(ser, seq.ptr, seq.size * sizeof(T));
+	reverse_bytes_if(array_ref(seq.ptr, seq.size), ser._endian);
+}
+
+template<class T>
+inline enable_if<is_arithmetic<T>::value>
+write(serializer_tag, BinaryMemoryOutputSerializer& ser, SerSequence<T> const& seq) {
+	if (ser._endian == Endian::system) {
+		binary_memory_write(ser, seq.ptr, seq.size * sizeof(T));
+		return;
+	} else if (seq.size == 0) {
+		return;
+	}
+	u8* out = binary_memory_extend(ser, seq.size * sizeof(T));
+	remove_cv<T> value;
+	for (auto it = seq.ptr; it != seq.ptr + seq.size; ++it, out += sizeof(T)) {
+		value = reverse_bytes_copy(*it);
+		std::memcpy(out, &value, sizeof(T));
+	}
+}
+
+// memory explicitly binary-serializable sequence
+
+template<class T>
+inline enable_if<is_binary_serializable_explicitly<T>::value>
+read(serializer_tag, BinaryMemoryInputSerializer& ser, SerSequence<T>&& seq) {
+	binary_memory_read(ser, seq.ptr, seq.size * sizeof(T));
+}
+
+template<class T>
+inline enable_if<is_binary_serializable_explicitly<T>::value>
+write(serializer_tag, BinaryMemoryOutputSerializer& ser, SerSequence<T> const& seq) {
+	binary_memory_write(ser, seq.ptr, seq.size * sizeof(T));
+}
+
+// memory SerBuffer
+
+inline void
+read(serializer_tag, BinaryMemoryInputSerializer& ser, SerBuffer<false>&& buffer) {
+	binary_memory_read(ser, buffer.ptr, buffer.size);
+}
+
+template<bool C>
+inline void
+write(serializer_tag, BinaryMemoryOutputSerializer& ser, SerBuffer<C> const& buffer) {
+	binary_memory_write(ser, buffer.ptr, buffer.size);
+}
+
 /** @endcond */ // INTERNAL
 
 /** @} */ // end of doc-group lib_core_binary_serializer
@@ -14,6 +14,7 @@
 #include <togo/core/types.hpp>
 #include <togo/core/utility/types.hpp>
 #include <togo/core/utility/traits.hpp>
+#include <togo/core/collection/types.hpp>
 
 #include <type_traits>
 
@@ -164,6 +165,48 @@ struct BinaryOutputSerializer
 	BinaryOutputSerializer(IWriter& stream, Endian endian = Endian::little);
 };
 
+/// Binary input serializer for memory.
+///
+/// This reads directly from data instead of through a stream.
+/// An assertion will fail if a read goes past the end of data.
+struct BinaryMemoryInputSerializer
+	: InputSerializer<BinaryMemoryInputSerializer>
+{
+	u8 const* _position;
+	u8 const* _end;
+	Endian _endian;
+
+	BinaryMemoryInputSerializer() = delete;
+	BinaryMemoryInputSerializer& operator=(BinaryMemoryInputSerializer const&) = delete;
+	BinaryMemoryInputSerializer& operator=(BinaryMemoryInputSerializer&&) = delete;
+
+	~BinaryMemoryInputSerializer() = default;
+	BinaryMemoryInputSerializer(BinaryMemoryInputSerializer const&) = default;
+	BinaryMemoryInputSerializer(BinaryMemoryInputSerializer&&) = default;
+
+	BinaryMemoryInputSerializer(ArrayRef<u8 const> const& data, Endian endian = Endian::little);
+};
+
+/// Binary output serializer for memory.
+///
+/// Serial data is appended to buffer.
+struct BinaryMemoryOutputSerializer
+	: OutputSerializer<BinaryMemoryOutputSerializer>
+{
+	Array<u8>& _buffer;
+	Endian _endian;
+
+	BinaryMemoryOutputSerializer() = delete;
+	BinaryMemoryOutputSerializer& operator=(BinaryMemoryOutputSerializer const&) = delete;
+	BinaryMemoryOutputSerializer& operator=(BinaryMemoryOutputSerializer&&) = delete;
+
+	~BinaryMemoryOutputSerializer() = default;
+	BinaryMemoryOutputSerializer(BinaryMemoryOutputSerializer const&) = default;
+	BinaryMemoryOutputSerializer(BinaryMemoryOutputSerializer&&) = default;
+
+	BinaryMemoryOutputSerializer(Array<u8>& buffer, Endian endian = Endian::little);
+};
+
 /** @} */ // end of doc-group lib_core_binary_serializer
 
 /** @} */ // end of doc-group lib_core_serialization
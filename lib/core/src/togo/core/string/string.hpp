@@ -189,7 +189,7 @@ inline unsigned ensure_trailing_slash(FixedArray<char, N>& string) {
 } // namespace string
 
 /// Construct to null/empty.
-inline StringRef::StringRef()
+inline constexpr StringRef::StringRef()
 	: data(nullptr)
 	, size(0)
 {}
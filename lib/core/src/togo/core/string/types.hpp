@@ -43,7 +43,7 @@ struct StringRef {
 	StringRef& operator=(StringRef const&) = default;
 	StringRef& operator=(StringRef&&) = default;
 
-	StringRef();
+	constexpr StringRef();
 	StringRef(char const* const cstr, cstr_tag);
 	StringRef(char const* const data, char const* const end);
 	constexpr StringRef(char const* const data, unsigned const size);
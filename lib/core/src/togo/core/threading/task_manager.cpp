@@ -13,6 +13,7 @@
 #include <togo/core/threading/mutex.hpp>
 #include <togo/core/threading/thread.hpp>
 #include <togo/core/threading/task_manager.hpp>
+#include <togo/core/trace/trace.hpp>
 
 #include <cstring>
 #include <cstdio>
@@ -68,6 +69,11 @@ inline bool is_ready(Task const& task) {
 	return task.num_incomplete <= 1;
 }
 
+// Unique among task managers
+inline u64 trace_flow_id(TaskManager const& tm, TaskID const id) {
+	return u64{reinterpret_cast<std::uintptr_t>(&tm)} << 16 ^ id._value;
+}
+
 inline void free_slot(TaskManager& tm, Task& task) {
 	TaskSlot& slot = *reinterpret_cast<TaskSlot*>(&task);
 	unsigned index = slot.id._value & INDEX_MASK;
@@ -115,6 +121,10 @@ inline void queue_task(TaskManager& tm, Task& task) {
 		task.priority
 	);*/
 	priority_queue::push(tm._queue, &task);
+	if (task.work.func) {
+		TOGO_TRACE_FLOW_BEGIN("task", trace_flow_id(tm, task.id));
+	}
+	TOGO_TRACE_COUNTER("tasks queued", priority_queue::size(tm._queue));
 	/*#if defined(TOGO_TEST_TASK_MANAGER)
 		Task* const front = priority_queue::front(tm._queue);
 		TOGO_TEST_LOG_DEBUGF(
@@ -186,7 +196,11 @@ void execute_pending(TaskManager& tm, TaskID const wait_id) {
 				// by any other function, so this is free of race
 				// conditions.
 				mutex::unlock(tm._mutex);
+				{
+				TOGO_TRACE_ZONE("task");
+				TOGO_TRACE_FLOW_END("task", trace_flow_id(tm, task->id));
 				task->work.func(task->id, task->work.data);
+				}
 				mutex::lock(tm._mutex);
 			}
 			continue;
@@ -317,6 +331,7 @@ void task_manager::end_hold(TaskManager& tm, TaskID const id) {
 /// This function will execute any available tasks while id is incomplete.
 void task_manager::wait(TaskManager& tm, TaskID const id) {
 	TOGO_DEBUG_ASSERT(id != ID_NULL, "attempted to wait on null ID");
+	TOGO_TRACE_ZONE("task wait");
 	execute_pending(tm, id);
 }
 
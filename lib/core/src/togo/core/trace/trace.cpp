@@ -0,0 +1,412 @@
+#line 2 "togo/core/trace/trace.cpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#include <togo/core/config.hpp>
+#include <togo/core/types.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/string/string.hpp>
+#include <togo/core/system/system.hpp>
+#include <togo/core/threading/thread.hpp>
+#include <togo/core/io/io.hpp>
+#include <togo/core/io/file_stream.hpp>
+#include <togo/core/trace/types.hpp>
+#include <togo/core/trace/trace.hpp>
+
+#include <atomic>
+#include <new>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+
+namespace togo {
+
+namespace {
+
+enum : unsigned {
+	MAX_THREADS = 128,
+	THREAD_NAME_SIZE = 32,
+	WRITE_BUFFER_SIZE = 8192,
+};
+
+// Events are only appended by the owning thread. num_events is
+// published after each event so chunks can be read while recording.
+struct TraceChunk {
+	std::atomic<TraceChunk*> next;
+	std::atomic<u32> num_events;
+	u32 capacity;
+	TraceEvent* events;
+};
+
+struct TraceThread {
+	TraceChunk* head;
+	TraceChunk* tail;
+	unsigned index;
+	char name[THREAD_NAME_SIZE];
+};
+
+static std::atomic<bool> s_recording{false};
+static std::atomic<u32> s_generation{0};
+static std::atomic<unsigned> s_num_threads{0};
+static std::atomic<TraceThread*> s_threads[MAX_THREADS]{};
+static unsigned s_chunk_size = TRACE_CHUNK_SIZE_DEFAULT;
+static f64 s_time_basis = 0.0;
+
+static thread_local TraceThread* t_thread = nullptr;
+static thread_local u32 t_generation = 0;
+
+static TraceChunk* create_chunk(u32 const capacity) {
+	void* const p = memory::default_allocator().allocate(
+		sizeof(TraceChunk) + capacity * sizeof(TraceEvent),
+		alignof(TraceChunk)
+	);
+	auto* const chunk = new(p) TraceChunk();
+	chunk->next.store(nullptr, std::memory_order_relaxed);
+	chunk->num_events.store(0, std::memory_order_relaxed);
+	chunk->capacity = capacity;
+	chunk->events = reinterpret_cast<TraceEvent*>(chunk + 1);
+	return chunk;
+}
+
+static TraceThread* thread_state() {
+	u32 const generation = s_generation.load(std::memory_order_acquire);
+	if (t_generation != generation) {
+		t_generation = generation;
+		t_thread = nullptr;
+		unsigned const index = s_num_threads.fetch_add(1, std::memory_order_relaxed);
+		if (index < MAX_THREADS) {
+			auto& allocator = memory::default_allocator();
+			t_thread = TOGO_CONSTRUCT_DEFAULT(allocator, TraceThread);
+			t_thread->head = create_chunk(s_chunk_size);
+			t_thread->tail = t_thread->head;
+			t_thread->index = index;
+			std::snprintf(t_thread->name, sizeof(t_thread->name), "%s", thread::name());
+			s_threads[index].store(t_thread, std::memory_order_release);
+		}
+	}
+	return t_thread;
+}
+
+static void push(TraceEvent const& event) {
+	TraceThread* const thread = thread_state();
+	if (!thread) {
+		return;
+	}
+	TraceChunk* chunk = thread->tail;
+	u32 const num_events = chunk->num_events.load(std::memory_order_relaxed);
+	if (num_events == chunk->capacity) {
+		TraceChunk* const next = create_chunk(chunk->capacity);
+		next->events[0] = event;
+		next->num_events.store(1, std::memory_order_relaxed);
+		chunk->next.store(next, std::memory_order_release);
+		thread->tail = next;
+		return;
+	}
+	chunk->events[num_events] = event;
+	chunk->num_events.store(num_events + 1, std::memory_order_release);
+}
+
+inline unsigned num_threads() {
+	return min(s_num_threads.load(std::memory_order_acquire), unsigned{MAX_THREADS});
+}
+
+// Buffered JSON output
+struct TraceWriter {
+	IWriter& stream;
+	IOStatus status;
+	unsigned size;
+	char buffer[WRITE_BUFFER_SIZE];
+
+	TraceWriter(IWriter& stream)
+		: stream(stream)
+		, status{IOStatus::flag_none}
+		, size(0)
+	{}
+};
+
+static void flush_writer(TraceWriter& w) {
+	if (w.size > 0 && w.status) {
+		w.status = io::write(w.stream, w.buffer, w.size);
+	}
+	w.size = 0;
+}
+
+TOGO_VALIDATE_FORMAT_PARAM(2, 3)
+static void write_format(TraceWriter& w, char const* const format, ...) {
+	va_list va;
+	for (unsigned attempt = 0; attempt < 2; ++attempt) {
+		unsigned const available = WRITE_BUFFER_SIZE - w.size;
+		va_start(va, format);
+		signed const result = std::vsnprintf(w.buffer + w.size, available, format, va);
+		va_end(va);
+		if (result >= 0 && static_cast<unsigned>(result) < available) {
+			w.size += static_cast<unsigned>(result);
+			return;
+		}
+		flush_writer(w);
+	}
+	TOGO_ASSERT(false, "trace event too large for write buffer");
+}
+
+// Names are written separately to escape them
+static void write_string(TraceWriter& w, char const* s) {
+	char escape[8];
+	for (; *s; ++s) {
+		if (WRITE_BUFFER_SIZE - w.size < sizeof(escape)) {
+			flush_writer(w);
+		}
+		auto const c = static_cast<unsigned char>(*s);
+		if (c == '"' || c == '\\') {
+			w.buffer[w.size++] = '\\';
+			w.buffer[w.size++] = *s;
+		} else if (c < 0x20) {
+			std::snprintf(escape, sizeof(escape), "\\u%04x", c);
+			std::memcpy(w.buffer + w.size, escape, 6);
+			w.size += 6;
+		} else {
+			w.buffer[w.size++] = *s;
+		}
+	}
+}
+
+static void write_event(
+	TraceWriter& w,
+	TraceThread const& thread,
+	TraceEvent const& event,
+	unsigned const pid
+) {
+	f64 const ts = (event.time - s_time_basis) * 1.0e6;
+	write_format(w, ",\n{\"name\":\"");
+	write_string(w, event.name);
+	switch (event.type) {
+	case TraceEventType::zone:
+		write_format(w,
+			"\",\"cat\":\"togo\",\"ph\":\"X\",\"pid\":%u,\"tid\":%u,\"ts\":%.3lf,\"dur\":%.3lf}",
+			pid, thread.index, ts, event.duration * 1.0e6
+		);
+		break;
+
+	case TraceEventType::counter:
+		write_format(w,
+			"\",\"ph\":\"C\",\"pid\":%u,\"tid\":%u,\"ts\":%.3lf,\"args\":{\"value\":%.17g}}",
+			pid, thread.index, ts, event.value
+		);
+		break;
+
+	case TraceEventType::flow_begin:
+		write_format(w,
+			"\",\"cat\":\"togo\",\"ph\":\"s\",\"id\":%llu,\"pid\":%u,\"tid\":%u,\"ts\":%.3lf}",
+			static_cast<unsigned long long>(event.id), pid, thread.index, ts
+		);
+		break;
+
+	case TraceEventType::flow_end:
+		write_format(w,
+			"\",\"cat\":\"togo\",\"ph\":\"f\",\"bp\":\"e\",\"id\":%llu,\"pid\":%u,\"tid\":%u,\"ts\":%.3lf}",
+			static_cast<unsigned long long>(event.id), pid, thread.index, ts
+		);
+		break;
+	}
+}
+
+} // anonymous namespace
+
+/// Start recording.
+///
+/// Each thread records into chunks of chunk_size events. Events that
+/// were already recorded are kept.
+void trace::start(unsigned const chunk_size IGEN_DEFAULT(TRACE_CHUNK_SIZE_DEFAULT)) {
+	TOGO_ASSERT(chunk_size > 0, "chunk_size must be non-zero");
+	if (num_threads() == 0) {
+		s_chunk_size = chunk_size;
+		s_time_basis = system::time_monotonic();
+		s_generation.fetch_add(1, std::memory_order_release);
+	}
+	s_recording.store(true, std::memory_order_release);
+}
+
+/// Stop recording.
+///
+/// Recorded events are kept until clear() is called.
+void trace::stop() {
+	s_recording.store(false, std::memory_order_release);
+}
+
+/// Whether events are being recorded.
+bool trace::is_recording() {
+	return s_recording.load(std::memory_order_relaxed);
+}
+
+/// Free recorded events.
+///
+/// No thread may be recording when this is called.
+void trace::clear() {
+	auto& allocator = memory::default_allocator();
+	unsigned const count = num_threads();
+	for (unsigned i = 0; i < count; ++i) {
+		TraceThread* const thread = s_threads[i].exchange(nullptr, std::memory_order_acquire);
+		if (!thread) {
+			continue;
+		}
+		TraceChunk* chunk = thread->head;
+		while (chunk) {
+			TraceChunk* const next = chunk->next.load(std::memory_order_relaxed);
+			chunk->~TraceChunk();
+			allocator.deallocate(chunk);
+			chunk = next;
+		}
+		TOGO_DESTROY(allocator, thread);
+	}
+	s_num_threads.store(0, std::memory_order_relaxed);
+	// Invalidate thread states
+	s_generation.fetch_add(1, std::memory_order_release);
+}
+
+/// Number of recorded events.
+unsigned trace::num_events() {
+	unsigned count = 0;
+	unsigned const n = num_threads();
+	for (unsigned i = 0; i < n; ++i) {
+		TraceThread const* const thread = s_threads[i].load(std::memory_order_acquire);
+		if (!thread) {
+			continue;
+		}
+		for (
+			TraceChunk const* chunk = thread->head; chunk;
+			chunk = chunk->next.load(std::memory_order_acquire)
+		) {
+			count += chunk->num_events.load(std::memory_order_acquire);
+		}
+	}
+	return count;
+}
+
+/// Begin a zone.
+///
+/// Returns the start time, or a negative value if not recording.
+/// This is used by TraceZone.
+f64 trace::zone_begin() {
+	return trace::is_recording() ? system::time_monotonic() : -1.0;
+}
+
+/// End a zone started by zone_begin().
+void trace::zone_end(char const* const name, f64 const start) {
+	if (!trace::is_recording()) {
+		return;
+	}
+	TraceEvent event;
+	event.name = name;
+	event.time = start;
+	event.duration = system::time_monotonic() - start;
+	event.type = TraceEventType::zone;
+	push(event);
+}
+
+/// Record counter value.
+void trace::counter(char const* const name, f64 const value) {
+	if (!trace::is_recording()) {
+		return;
+	}
+	TraceEvent event;
+	event.name = name;
+	event.time = system::time_monotonic();
+	event.value = value;
+	event.type = TraceEventType::counter;
+	push(event);
+}
+
+/// Record the start of a flow.
+///
+/// id must be unique among flows with the same name that are in
+/// progress.
+void trace::flow_begin(char const* const name, u64 const id) {
+	if (!trace::is_recording()) {
+		return;
+	}
+	TraceEvent event;
+	event.name = name;
+	event.time = system::time_monotonic();
+	event.id = id;
+	event.type = TraceEventType::flow_begin;
+	push(event);
+}
+
+/// Record the end of a flow.
+void trace::flow_end(char const* const name, u64 const id) {
+	if (!trace::is_recording()) {
+		return;
+	}
+	TraceEvent event;
+	event.name = name;
+	event.time = system::time_monotonic();
+	event.id = id;
+	event.type = TraceEventType::flow_end;
+	push(event);
+}
+
+/// Write recorded events in the Chrome trace event format.
+///
+/// This can be called while recording; events recorded during the
+/// call may be omitted.
+IOStatus trace::write_chrome(IWriter& stream) {
+	unsigned const pid = system::pid();
+	TraceWriter w{stream};
+	write_format(w, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	write_format(w,
+		"{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":%u,\"args\":{\"name\":\"togo\"}}",
+		pid
+	);
+
+	unsigned const n = num_threads();
+	for (unsigned i = 0; i < n; ++i) {
+		TraceThread const* const thread = s_threads[i].load(std::memory_order_acquire);
+		if (!thread) {
+			continue;
+		}
+		write_format(w,
+			",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%u,\"tid\":%u,\"args\":{\"name\":\"",
+			pid, thread->index
+		);
+		write_string(w, thread->name);
+		write_format(w, "\"}}");
+		for (
+			TraceChunk const* chunk = thread->head; chunk;
+			chunk = chunk->next.load(std::memory_order_acquire)
+		) {
+			u32 const num_events = chunk->num_events.load(std::memory_order_acquire);
+			for (u32 e = 0; e < num_events; ++e) {
+				write_event(w, *thread, chunk->events[e], pid);
+			}
+		}
+	}
+	write_format(w, "\n]}\n");
+	flush_writer(w);
+	return w.status;
+}
+
+/// Write recorded events to a file in the Chrome trace event format.
+bool trace::write_chrome_file(StringRef const& path) {
+	FileWriter stream{};
+	if (!stream.open(path, false)) {
+		TOGO_LOG_ERRORF(
+			"failed to write trace to '%.*s': failed to open file\n",
+			path.size, path.data
+		);
+		return false;
+	}
+	bool const success = trace::write_chrome(stream).ok();
+	stream.close();
+	if (!success) {
+		TOGO_LOG_ERRORF(
+			"failed to write trace to '%.*s'\n",
+			path.size, path.data
+		);
+	}
+	return success;
+}
+
+} // namespace togo
@@ -0,0 +1,74 @@
+#line 2 "togo/core/trace/trace.hpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+
+@file
+@brief Trace interface.
+@ingroup lib_core_trace
+*/
+
+#pragma once
+
+#include <togo/core/config.hpp>
+#include <togo/core/types.hpp>
+#include <togo/core/string/types.hpp>
+#include <togo/core/io/types.hpp>
+#include <togo/core/trace/types.hpp>
+
+#include <togo/core/trace/trace.gen_interface>
+
+namespace togo {
+
+/**
+	@addtogroup lib_core_trace
+	@{
+*/
+
+/** @cond INTERNAL */
+#define TOGO_TRACE_JOIN_IMPL_(x, y) x ## y
+#define TOGO_TRACE_JOIN_(x, y) TOGO_TRACE_JOIN_IMPL_(x, y)
+/** @endcond */ // INTERNAL
+
+#if defined(TOGO_DISABLE_TRACE)
+	#define TOGO_TRACE_ZONE(name) (void(0))
+	#define TOGO_TRACE_COUNTER(name, value) (void(0))
+	#define TOGO_TRACE_FLOW_BEGIN(name, id) (void(0))
+	#define TOGO_TRACE_FLOW_END(name, id) (void(0))
+#else
+	/// Trace the rest of the enclosing scope as a zone.
+	#define TOGO_TRACE_ZONE(name) \
+		::togo::TraceZone TOGO_TRACE_JOIN_(togo_trace_zone_, __LINE__){name}
+
+	/// Trace counter value.
+	#define TOGO_TRACE_COUNTER(name, value) \
+		::togo::trace::counter(name, static_cast<::togo::f64>(value))
+
+	/// Trace start of a flow.
+	#define TOGO_TRACE_FLOW_BEGIN(name, id) \
+		::togo::trace::flow_begin(name, static_cast<::togo::u64>(id))
+
+	/// Trace end of a flow.
+	///
+	/// The flow is bound to the enclosing zone.
+	#define TOGO_TRACE_FLOW_END(name, id) \
+		::togo::trace::flow_end(name, static_cast<::togo::u64>(id))
+#endif
+
+/// Records the zone if tracing was running when it was constructed.
+inline TraceZone::~TraceZone() {
+	if (_start >= 0.0) {
+		trace::zone_end(_name, _start);
+	}
+}
+
+/// Construct with name.
+///
+/// name must have static storage duration.
+inline TraceZone::TraceZone(char const* name)
+	: _name(name)
+	, _start(trace::zone_begin())
+{}
+
+/** @} */ // end of doc-group lib_core_trace
+
+} // namespace togo
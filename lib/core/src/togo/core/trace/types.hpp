@@ -0,0 +1,74 @@
+#line 2 "togo/core/trace/types.hpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+
+@file
+@brief Trace types.
+@ingroup lib_core_types
+@ingroup lib_core_trace
+*/
+
+#pragma once
+
+#include <togo/core/config.hpp>
+#include <togo/core/types.hpp>
+
+namespace togo {
+
+/**
+	@addtogroup lib_core_trace
+	@{
+*/
+
+enum : unsigned {
+	/// Default number of events in a thread's trace chunk.
+	TRACE_CHUNK_SIZE_DEFAULT = 4096,
+};
+
+/// Trace event type.
+enum class TraceEventType : u32 {
+	/// Timed zone.
+	zone,
+	/// Counter value.
+	counter,
+	/// Start of a flow between zones.
+	flow_begin,
+	/// End of a flow between zones.
+	flow_end,
+};
+
+/// Trace event.
+struct TraceEvent {
+	char const* name;
+	f64 time;
+	union {
+		/// Zone duration.
+		f64 duration;
+		/// Counter value.
+		f64 value;
+		/// Flow ID.
+		u64 id;
+	};
+	TraceEventType type;
+};
+
+/// Scoped trace zone.
+///
+/// The zone is recorded when the object dies.
+struct TraceZone {
+	char const* _name;
+	f64 _start;
+
+	TraceZone() = delete;
+	TraceZone(TraceZone const&) = delete;
+	TraceZone(TraceZone&&) = delete;
+	TraceZone& operator=(TraceZone const&) = delete;
+	TraceZone& operator=(TraceZone&&) = delete;
+
+	~TraceZone();
+	TraceZone(char const* name);
+};
+
+/** @} */ // end of doc-group lib_core_trace
+
+} // namespace togo
@@ -3,6 +3,7 @@
 #include <togo/core/memory/memory.hpp>
 #include <togo/core/collection/array.hpp>
 #include <togo/core/algorithm/sort.hpp>
+#include <togo/core/threading/task_manager.hpp>
 
 #include <togo/support/test.hpp>
 
@@ -198,6 +199,65 @@ void test_and_validate(
 	}
 }
 
+// Sorts keys with a constant prefix serially and in parallel
+template<class K, class B, class R>
+void test_parallel(
+	TaskManager& tm,
+	unsigned const num,
+	unsigned const seed,
+	K const prefix,
+	K const mask
+) {
+	Array<Item<K>> items{memory::default_allocator()};
+	Array<Item<K>> items_serial{memory::default_allocator()};
+	Array<Item<K>> items_swap{memory::default_allocator()};
+	Array<Item<K>> items_stdlib_stable{memory::default_allocator()};
+
+	array::resize(items, num);
+	array::resize(items_swap, num);
+	fill_items<K, R>(items, seed);
+	for (auto& item : items) {
+		item.key = prefix | (item.key & mask);
+	}
+	array::copy(items_serial, items);
+	array::copy(items_stdlib_stable, items);
+	std::stable_sort(
+		array::begin(items_stdlib_stable), array::end(items_stdlib_stable),
+		ItemKeyLess<K>{}
+	);
+
+	auto start = hrc::now();
+	auto ptr_items = array::begin(items_serial);
+	auto ptr_items_swap = array::begin(items_swap);
+	bool swapped = sort_radix_generic<Item<K>, K, B>(
+		ptr_items, ptr_items_swap, num, ItemKeyFunc<K>{}
+	);
+	time_type const time_serial = duration_cast<duration_type>(hrc::now() - start).count();
+	if (swapped) {
+		array::copy(items_serial, items_swap);
+	}
+
+	start = hrc::now();
+	ptr_items = array::begin(items);
+	ptr_items_swap = array::begin(items_swap);
+	swapped = sort_radix_parallel<Item<K>, K, B>(
+		tm, ptr_items, ptr_items_swap, num, ItemKeyFunc<K>{}, 4
+	);
+	time_type const time_parallel = duration_cast<duration_type>(hrc::now() - start).count();
+
+	TOGO_LOGF(
+		"times (R, P): %12.06lf / %12.06lf  "
+		"num = %-10u  seed = %-12u  key size = %zu  mask = %#llx\n",
+		time_serial, time_parallel,
+		num, seed, sizeof(K), static_cast<unsigned long long>(mask)
+	);
+
+	auto const& items_parallel = swapped ? items_swap : items;
+	validate(items_parallel);
+	check_equal(items_stdlib_stable, items_serial);
+	check_equal(items_stdlib_stable, items_parallel);
+}
+
 struct Run {
 	unsigned num;
 	unsigned seed;
@@ -344,6 +404,17 @@ signed main() {
 	test_and_validate<u32, u64, std::mt19937>(4e6, rdev());
 	test_and_validate<u64, u64, std::mt19937_64>(4e6, rdev());
 
+	TOGO_LOG("\nparallel:\n");
+	{
+	TaskManager tm{3, memory::default_allocator()};
+	test_parallel<u32, u32, std::mt19937>(tm, 1000, rdev(), 0, ~0u);
+	test_parallel<u32, u32, std::mt19937>(tm, 1e6, rdev(), 0, ~0u);
+	test_parallel<u32, u32, std::mt19937>(tm, 1e6, rdev(), 0xABC00000u, 0xFFFu);
+	test_parallel<u64, u32, std::mt19937_64>(tm, 1e6, rdev(), 0, ~0ull);
+	test_parallel<u64, u32, std::mt19937_64>(tm, 1e6, rdev(), 0x0120000000000000ull, 0x0000FFFF000000FFull);
+	test_parallel<u64, u32, std::mt19937_64>(tm, 1e5, rdev(), 7, 0);
+	}
+
 	TOGO_LOG("\noptimal (32-bit key):\n");
 	test_growth<u32, u32, std::mt19937, std::random_device>(10, 1e5, rdev);
 
@@ -21,6 +21,7 @@ togo.make_tests("collection", {
 togo.make_tests("filesystem", {
 	["general"] = {nil, configs},
 	["directory_reader"] = {nil, configs},
+	["file_watcher"] = {nil, configs},
 })
 
 togo.make_tests("general", {
@@ -29,9 +30,11 @@ togo.make_tests("general", {
 
 togo.make_tests("hash", {
 	["literal"] = {nil, configs},
+	["xxh64"] = {nil, configs},
 })
 
 togo.make_tests("io", {
+	["async_io"] = {nil, configs},
 	["file_stream"] = {nil, configs},
 	["memory_stream"] = {nil, configs},
 	["object_buffer"] = {nil, configs},
@@ -41,6 +44,12 @@ togo.make_tests("kvs", {
 	["general"] = {nil, configs},
 	["io"] = {nil, configs},
 	["echo"] = {nil, configs},
+	["view"] = {nil, configs},
+	["visit"] = {nil, configs},
+})
+
+togo.make_tests("log", {
+	["async"] = {nil, configs},
 })
 
 togo.make_tests("memory", {
@@ -59,6 +68,7 @@ togo.make_tests("random", {
 
 togo.make_tests("serialization", {
 	["general"] = {nil, configs},
+	["memory"] = {nil, configs},
 })
 
 togo.make_tests("string", {
@@ -76,6 +86,10 @@ togo.make_tests("threading", {
 	["task_manager"] = {nil, configs},
 })
 
+togo.make_tests("trace", {
+	["general"] = {nil, configs},
+})
+
 togo.make_tests("utility", {
 	["general"] = {nil, configs},
 	["endian"] = {nil, configs},
@@ -85,6 +99,8 @@ togo.make_tests("utility", {
 togo.make_tests("parser", {
 	["general"] = {nil, configs},
 	["pdef"] = {nil, configs},
+	["cache"] = {nil, configs},
+	["reuse"] = {nil, configs},
 })
 
 togo.make_tests("lua", {
@@ -1,12 +1,58 @@
 
 #include <togo/core/error/assert.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/collection/array.hpp>
 #include <togo/core/string/string.hpp>
+#include <togo/core/system/system.hpp>
+#include <togo/core/threading/task_manager.hpp>
 #include <togo/core/filesystem/filesystem.hpp>
 #include <togo/core/filesystem/directory_reader.hpp>
 
+#include <togo/support/test.hpp>
+
+#include <cstdio>
+
 using namespace togo;
 
-signed main() {
+// Scan matches read() exactly, with and without a task manager
+static void check_scan(
+	StringRef const& path,
+	bool const prepend_path,
+	DirectoryEntry::Type const type_mask,
+	TaskManager& task_manager
+) {
+	DirectoryListing listing{memory::default_allocator()};
+	DirectoryListing listing_parallel{memory::default_allocator()};
+	TOGO_ASSERTE(directory_reader::scan(listing, path, prepend_path, true, true, type_mask));
+	TOGO_ASSERTE(directory_reader::scan(
+		listing_parallel, path, prepend_path, true, true, type_mask, &task_manager
+	));
+	TOGO_ASSERTE(array::size(listing.entries) == array::size(listing_parallel.entries));
+
+	DirectoryReader reader{};
+	DirectoryEntry entry;
+	unsigned i = 0;
+	TOGO_ASSERTE(directory_reader::open(reader, path, prepend_path, true, true));
+	while (directory_reader::read(reader, entry, type_mask)) {
+		TOGO_ASSERTE(i < array::size(listing.entries));
+		auto const scanned = directory_reader::entry(listing, i);
+		auto const scanned_parallel = directory_reader::entry(listing_parallel, i);
+		TOGO_ASSERTE(scanned.type == entry.type && scanned_parallel.type == entry.type);
+		TOGO_ASSERTF(
+			string::compare_equal(scanned.path, entry.path) &&
+			string::compare_equal(scanned_parallel.path, entry.path),
+			"mismatched entry: %.*s", entry.path.size, entry.path.data
+		);
+		TOGO_ASSERTE(scanned.path.data[scanned.path.size] == '\0');
+		++i;
+	}
+	directory_reader::close(reader);
+	TOGO_ASSERTE(i == array::size(listing.entries));
+}
+
+signed main(signed argc, char* argv[]) {
+	memory_init();
+
 	#define ROOT "data/directory_reader"
 
 	#define CREATE_IF_NON_EXISTENT(kind_, path_)					\
@@ -62,11 +108,87 @@ signed main() {
 		TOGO_ASSERTF(x.found, "unmatched entry: %.*s", x.path.size, x.path.data);
 	}}
 
+	{// Scan
+	TaskManager task_manager{3, memory::default_allocator()};
+	char path[64];
+	for (unsigned i = 0; i < 8; ++i) {
+		std::snprintf(path, sizeof(path), ROOT "/inner_dir/d%u", i);
+		CREATE_IF_NON_EXISTENT(directory, path);
+		std::snprintf(path, sizeof(path), ROOT "/inner_dir/d%u/f", i);
+		CREATE_IF_NON_EXISTENT(file, path);
+	}
+	check_scan(ROOT, true, DirectoryEntry::Type::all, task_manager);
+	check_scan(ROOT "/", false, DirectoryEntry::Type::file, task_manager);
+	check_scan(ROOT, false, DirectoryEntry::Type::dir, task_manager);
+
+	DirectoryListing listing{memory::default_allocator()};
+	TOGO_ASSERTE(!directory_reader::scan(
+		listing, ROOT "/nonexistent", true, true, true, DirectoryEntry::Type::all
+	));
+	TOGO_ASSERTE(array::empty(listing.entries));
+
+	// Non-recursive and appending
+	TOGO_ASSERTE(directory_reader::scan(
+		listing, ROOT, true, false, false, DirectoryEntry::Type::all, &task_manager
+	));
+	TOGO_ASSERTE(array::size(listing.entries) == 3);
+	TOGO_ASSERTE(directory_reader::scan(
+		listing, ROOT, true, false, true, DirectoryEntry::Type::file
+	));
+	TOGO_ASSERTE(array::size(listing.entries) == 4);
+	TOGO_ASSERTE(string::compare_equal(directory_reader::entry(listing, 3).path, ROOT "/file"));
+
+	for (unsigned i = 0; i < 8; ++i) {
+		std::snprintf(path, sizeof(path), ROOT "/inner_dir/d%u/f", i);
+		TOGO_ASSERTE(filesystem::remove_file(path));
+		std::snprintf(path, sizeof(path), ROOT "/inner_dir/d%u", i);
+		TOGO_ASSERTE(filesystem::remove_directory(path));
+	}}
+
 	TOGO_ASSERTE(filesystem::remove_file(ROOT "/.dotdotdot"));
 	TOGO_ASSERTE(filesystem::remove_file(ROOT "/file"));
 	TOGO_ASSERTE(filesystem::remove_file(ROOT "/inner_dir/file"));
 	TOGO_ASSERTE(filesystem::remove_directory(ROOT "/inner_dir"));
 	TOGO_ASSERTE(filesystem::remove_directory(ROOT));
 
+	if (argc > 1) {
+		// Benchmark with an existing tree
+		StringRef const bench_path{argv[1], cstr_tag{}};
+		auto const type_mask = DirectoryEntry::Type::all;
+		unsigned num_read = 0;
+		f64 start = system::time_monotonic();
+		{
+		DirectoryReader reader{};
+		DirectoryEntry entry;
+		TOGO_ASSERTE(directory_reader::open(reader, bench_path, true, true, false));
+		while (directory_reader::read(reader, entry, type_mask)) {
+			++num_read;
+		}
+		}
+		f64 const duration_read = system::time_monotonic() - start;
+
+		DirectoryListing listing{memory::default_allocator()};
+		start = system::time_monotonic();
+		TOGO_ASSERTE(directory_reader::scan(listing, bench_path, true, true, false, type_mask));
+		f64 const duration_scan = system::time_monotonic() - start;
+		TOGO_ASSERTE(array::size(listing.entries) == num_read);
+
+		TaskManager task_manager{
+			max(system::num_cores(), 1u) - 1,
+			memory::default_allocator()
+		};
+		array::clear(listing.entries);
+		array::clear(listing.paths);
+		start = system::time_monotonic();
+		TOGO_ASSERTE(directory_reader::scan(
+			listing, bench_path, true, true, false, type_mask, &task_manager
+		));
+		f64 const duration_parallel = system::time_monotonic() - start;
+
+		TOGO_LOGF(
+			"entries = %u  read = %.06lf  scan = %.06lf  parallel = %.06lf\n",
+			num_read, duration_read, duration_scan, duration_parallel
+		);
+	}
 	return 0;
 }
@@ -0,0 +1,201 @@
+#include <togo/core/error/assert.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/string/string.hpp>
+#include <togo/core/io/io.hpp>
+#include <togo/core/io/file_stream.hpp>
+#include <togo/core/filesystem/filesystem.hpp>
+#include <togo/core/filesystem/file_watcher.hpp>
+
+#include <togo/support/test.hpp>
+
+#include <cstdio>
+
+using namespace togo;
+
+#define ROOT "data/file_watcher"
+
+using EventType = FileWatchEvent::Type;
+
+enum : unsigned {
+	TIMEOUT = 1000,
+	TIMEOUT_NONE_EXPECTED = 250,
+	// Two events per write, which is more than the default queue
+	// limit of 16384
+	NUM_FLOOD_WRITES = 10000,
+};
+
+static void write_file(StringRef const& path, StringRef const& data) {
+	FileWriter stream{};
+	TOGO_ASSERTE(stream.open(path, false));
+	TOGO_ASSERTE(io::write(stream, data.data, data.size));
+	stream.close();
+}
+
+static bool has_event(
+	ArrayRef<FileWatchEvent const> const& events,
+	EventType const type,
+	StringRef const& path,
+	StringRef const& from_path = {}
+) {
+	for (auto const& event : events) {
+		if (
+			event.type == type &&
+			event.root == 0 &&
+			string::compare_equal(event.path, path) &&
+			string::compare_equal(event.from_path, from_path)
+		) {
+			return true;
+		}
+	}
+	return false;
+}
+
+static void print_events(ArrayRef<FileWatchEvent const> const& events) {
+	for (auto const& event : events) {
+		TOGO_LOGF(
+			"  %u %.*s <- %.*s\n",
+			static_cast<unsigned>(event.type),
+			event.path.size, event.path.data,
+			event.from_path.size, event.from_path.data
+		);
+	}
+}
+
+static void test(bool const polling) {
+	TOGO_ASSERTE(filesystem::create_directory(ROOT));
+	write_file(ROOT "/a", "a");
+
+	FileWatcher watcher{memory::default_allocator(), polling};
+	TOGO_LOGF("polling: %s\n", file_watcher::is_polling(watcher) ? "yes" : "no");
+	TOGO_ASSERTE(file_watcher::add_root(watcher, ROOT "/", true));
+	TOGO_ASSERTE(!file_watcher::add_root(watcher, ROOT "/nonexistent", true));
+	TOGO_ASSERTE(file_watcher::num_roots(watcher) == 2);
+	TOGO_ASSERTE(file_watcher::poll(watcher, 0).size() == 0);
+
+	// Created and written: only a create
+	write_file(ROOT "/b", "b");
+	auto events = file_watcher::poll(watcher, TIMEOUT);
+	print_events(events);
+	TOGO_ASSERTE(events.size() == 1 && has_event(events, EventType::create, "b"));
+
+	write_file(ROOT "/a", "modified");
+	events = file_watcher::poll(watcher, TIMEOUT);
+	print_events(events);
+	TOGO_ASSERTE(events.size() == 1 && has_event(events, EventType::modify, "a"));
+
+	// New directories are watched
+	TOGO_ASSERTE(filesystem::create_directory(ROOT "/d"));
+	write_file(ROOT "/d/x", "x");
+	events = file_watcher::poll(watcher, TIMEOUT);
+	print_events(events);
+	TOGO_ASSERTE(events.size() == 2);
+	TOGO_ASSERTE(events[0].type == EventType::create && events[0].entry_type == DirectoryEntry::Type::dir);
+	TOGO_ASSERTE(has_event(events, EventType::create, "d/"));
+	TOGO_ASSERTE(has_event(events, EventType::create, "d/x"));
+
+	TOGO_ASSERTE(std::rename(ROOT "/b", ROOT "/c") == 0);
+	events = file_watcher::poll(watcher, TIMEOUT);
+	print_events(events);
+	if (polling) {
+		TOGO_ASSERTE(events.size() == 2);
+		TOGO_ASSERTE(has_event(events, EventType::remove, "b"));
+		TOGO_ASSERTE(has_event(events, EventType::create, "c"));
+	} else {
+		TOGO_ASSERTE(events.size() == 1 && has_event(events, EventType::move, "c", "b"));
+	}
+
+	// Moved directories keep reporting with their new path
+	TOGO_ASSERTE(std::rename(ROOT "/d", ROOT "/e") == 0);
+	events = file_watcher::poll(watcher, TIMEOUT);
+	print_events(events);
+	if (polling) {
+		TOGO_ASSERTE(events.size() == 4);
+		TOGO_ASSERTE(has_event(events, EventType::remove, "d/x"));
+		TOGO_ASSERTE(has_event(events, EventType::create, "e/x"));
+	} else {
+		TOGO_ASSERTE(events.size() == 1 && has_event(events, EventType::move, "e/", "d/"));
+	}
+	write_file(ROOT "/e/y", "y");
+	events = file_watcher::poll(watcher, TIMEOUT);
+	print_events(events);
+	TOGO_ASSERTE(events.size() == 1 && has_event(events, EventType::create, "e/y"));
+
+	TOGO_ASSERTE(filesystem::remove_file(ROOT "/c"));
+	events = file_watcher::poll(watcher, TIMEOUT);
+	print_events(events);
+	TOGO_ASSERTE(events.size() == 1 && has_event(events, EventType::remove, "c"));
+
+	// Ignored and transient files have no events
+	write_file(ROOT "/.hidden", "h");
+	write_file(ROOT "/transient", "t");
+	TOGO_ASSERTE(filesystem::remove_file(ROOT "/transient"));
+	events = file_watcher::poll(watcher, TIMEOUT_NONE_EXPECTED);
+	print_events(events);
+	TOGO_ASSERTE(events.size() == 0);
+
+	file_watcher::clear(watcher);
+	TOGO_ASSERTE(file_watcher::num_roots(watcher) == 0);
+	TOGO_ASSERTE(filesystem::remove_file(ROOT "/.hidden"));
+	TOGO_ASSERTE(filesystem::remove_file(ROOT "/e/x"));
+	TOGO_ASSERTE(filesystem::remove_file(ROOT "/e/y"));
+	TOGO_ASSERTE(filesystem::remove_directory(ROOT "/e"));
+	TOGO_ASSERTE(filesystem::remove_file(ROOT "/a"));
+	TOGO_ASSERTE(filesystem::remove_directory(ROOT));
+}
+
+// Directories created while events are lost are watched after the
+// overflow is reported
+static void test_overflow() {
+	TOGO_ASSERTE(filesystem::create_directory(ROOT));
+	FileWatcher watcher{memory::default_allocator(), false};
+	if (file_watcher::is_polling(watcher)) {
+		TOGO_ASSERTE(filesystem::remove_directory(ROOT));
+		return;
+	}
+	TOGO_ASSERTE(file_watcher::add_root(watcher, ROOT "/", true));
+	for (unsigned i = 0; i < NUM_FLOOD_WRITES; ++i) {
+		write_file((i & 1) ? ROOT "/a" : ROOT "/b", "x");
+	}
+	TOGO_ASSERTE(filesystem::create_directory(ROOT "/d"));
+	write_file(ROOT "/d/x", "x");
+
+	auto events = file_watcher::poll(watcher, TIMEOUT);
+	bool overflowed = false;
+	for (auto const& event : events) {
+		if (event.type == EventType::overflow) {
+			TOGO_ASSERTE(event.root == 0 && event.path.empty());
+			overflowed = true;
+		}
+	}
+	if (overflowed) {
+		write_file(ROOT "/d/y", "y");
+		events = file_watcher::poll(watcher, TIMEOUT);
+		print_events(events);
+		TOGO_ASSERTE(events.size() == 1 && has_event(events, EventType::create, "d/y"));
+	} else {
+		TOGO_LOG("overflow: queue limit not reached; skipped\n");
+	}
+
+	file_watcher::clear(watcher);
+	TOGO_ASSERTE(filesystem::remove_file(ROOT "/d/x"));
+	if (overflowed) {
+		TOGO_ASSERTE(filesystem::remove_file(ROOT "/d/y"));
+	}
+	TOGO_ASSERTE(filesystem::remove_directory(ROOT "/d"));
+	TOGO_ASSERTE(filesystem::remove_file(ROOT "/a"));
+	TOGO_ASSERTE(filesystem::remove_file(ROOT "/b"));
+	TOGO_ASSERTE(filesystem::remove_directory(ROOT));
+}
+
+signed main() {
+	memory_init();
+
+	if (filesystem::is_directory(ROOT)) {
+		TOGO_LOG("error: " ROOT " already exists\n");
+		return 1;
+	}
+	test(false);
+	test(true);
+	test_overflow();
+	return 0;
+}
@@ -6,6 +6,8 @@
 #include <togo/core/system/system.hpp>
 #include <togo/core/filesystem/filesystem.hpp>
 
+#include <cstring>
+
 using namespace togo;
 
 signed main() {
@@ -78,6 +80,14 @@ signed main() {
 	TOGO_ASSERTE(filesystem::copy_file(TEST_EXEC_FILE, TEST_FILE_COPIED));
 	TOGO_ASSERTE(filesystem::is_file(TEST_FILE_COPIED));
 	TOGO_ASSERTE(filesystem::file_size(TEST_EXEC_FILE) == filesystem::file_size(TEST_FILE_COPIED));
+	{
+		MappedFile file_src{};
+		MappedFile file_copied{};
+		TOGO_ASSERTE(filesystem::map_file(file_src, TEST_EXEC_FILE));
+		TOGO_ASSERTE(filesystem::map_file(file_copied, TEST_FILE_COPIED));
+		TOGO_ASSERTE(file_src.size == file_copied.size);
+		TOGO_ASSERTE(std::memcmp(file_src.data, file_copied.data, file_src.size) == 0);
+	}
 
 	TOGO_ASSERTE(!filesystem::copy_file(TEST_FILE, TEST_FILE_COPIED));
 	TOGO_ASSERTE(filesystem::copy_file(TEST_FILE, TEST_FILE_COPIED, true));
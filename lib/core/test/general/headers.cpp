@@ -61,6 +61,7 @@
 #include <togo/core/filesystem/types.hpp>
 #include <togo/core/filesystem/filesystem.hpp>
 #include <togo/core/filesystem/directory_reader.hpp>
+#include <togo/core/filesystem/file_watcher.hpp>
 #include <togo/core/random/types.hpp>
 #include <togo/core/random/random.hpp>
 #include <togo/core/threading/types.hpp>
@@ -75,6 +76,8 @@
 #include <togo/core/io/file_stream.hpp>
 #include <togo/core/io/object_buffer_type.hpp>
 #include <togo/core/io/object_buffer.hpp>
+#include <togo/core/trace/types.hpp>
+#include <togo/core/trace/trace.hpp>
 #include <togo/core/kvs/types.hpp>
 #include <togo/core/kvs/kvs.hpp>
 #include <togo/core/serialization/types.hpp>
@@ -0,0 +1,71 @@
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/system/system.hpp>
+#include <togo/core/hash/hash.hpp>
+
+#include <togo/support/test.hpp>
+
+#include <cstdlib>
+
+using namespace togo;
+
+static constexpr StringRef const s_path{"togo/core/hash/hash.hpp"};
+
+static_assert(hash::calc_ce<hash::XXH64>("", 0) == hash::XXH64::identity, "");
+static_assert(hash::calc_ce<hash::XXH64>("a", 1) == 0xd24ec4f1a98c6e5b, "");
+static_assert(hash::calc_ce<hash::XXH64>("abc", 3) == 0x44bc2cf5ad770999, "");
+static_assert(hash::calc_ce<hash::XXH64>("test", 4) == 0x4fdcca5ddb678139, "");
+static_assert(hash::calc_ce<hash::XXH64>(s_path) == 0x2d953a0ae349c8c6, "");
+
+static char s_data[256];
+
+signed main(signed argc, char* argv[]) {
+	for (unsigned i = 0; i < array_extent(s_data); ++i) {
+		s_data[i] = static_cast<char>(i);
+	}
+	TOGO_ASSERTE(hash::calc<hash::XXH64>(s_data, 100) == 0x6ac1e58032166597);
+	TOGO_ASSERTE(hash::calc_ce<hash::XXH64>(s_data, 100) == 0x6ac1e58032166597);
+
+	// Runtime and constexpr variants agree on stripe and tail boundaries
+	for (unsigned size = 0; size <= 200; ++size) {
+		hash64 const value = hash::calc<hash::XXH64>(s_data, size);
+		TOGO_ASSERTE(value == hash::calc_ce<hash::XXH64>(s_data, size));
+
+		// Chunked input gives the same value as a single add
+		for (unsigned chunk = 1; chunk <= 40; chunk += 3) {
+			hash::XXH64 s;
+			for (unsigned i = 0; i < size; i += chunk) {
+				hash::add(s, s_data + i, min(chunk, size - i));
+			}
+			TOGO_ASSERTE(hash::size(s) == size);
+			TOGO_ASSERTE(hash::value(s) == value);
+		}
+	}
+
+	if (argc > 1) {
+		unsigned num = static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10));
+		num = num ? num : 1000000;
+
+		hash64 sink = 0;
+		f64 start = system::time_monotonic();
+		for (unsigned i = 0; i < num; ++i) {
+			sink += hash::calc<hash::FNV1a<hash::HS64>>(s_data, array_extent(s_data));
+		}
+		f64 const duration_fnv = system::time_monotonic() - start;
+
+		start = system::time_monotonic();
+		for (unsigned i = 0; i < num; ++i) {
+			sink += hash::calc<hash::XXH64>(s_data, array_extent(s_data));
+		}
+		f64 const duration_xxh = system::time_monotonic() - start;
+
+		TOGO_LOGF(
+			"num = %u  size = %u  fnv1a = %.06lf  xxh64 = %.06lf  ratio = %.03lf  (0x%016lx)\n",
+			num, array_extent(s_data),
+			duration_fnv, duration_xxh, duration_xxh / duration_fnv,
+			sink
+		);
+	}
+	return 0;
+}
@@ -0,0 +1,126 @@
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/string/string.hpp>
+#include <togo/core/threading/task_manager.hpp>
+#include <togo/core/io/io.hpp>
+#include <togo/core/io/file_stream.hpp>
+#include <togo/core/io/async_io.hpp>
+
+#include <togo/support/test.hpp>
+
+#include <atomic>
+#include <cstring>
+
+using namespace togo;
+
+static constexpr StringRef const path{"data/async_io.bin"};
+
+enum : unsigned {
+	NUM_CHUNKS = 48,
+	CHUNK_SIZE = 5000,
+	FILE_SIZE = NUM_CHUNKS * CHUNK_SIZE,
+};
+
+static u8 s_data[FILE_SIZE];
+static u8 s_data_in[FILE_SIZE + CHUNK_SIZE];
+static std::atomic<unsigned> s_num_callbacks{0};
+static std::atomic<unsigned> s_num_tasks{0};
+
+static void callback(AsyncIORequest& request) {
+	TOGO_ASSERTE(request.userdata == &s_num_callbacks);
+	++s_num_callbacks;
+}
+
+static void task_func(TaskID, void* data) {
+	// The data is complete before the task runs
+	AsyncIORequest const& request = *static_cast<AsyncIORequest const*>(data);
+	TOGO_ASSERTE(request.transferred == request.size);
+	TOGO_ASSERTE(std::memcmp(request.data, s_data + request.offset, request.size) == 0);
+	++s_num_tasks;
+}
+
+static void test_backend(AsyncIOBackend const backend) {
+	AsyncIO io{16, 4, memory::default_allocator(), backend};
+	TOGO_LOGF(
+		"backend: requested %u, using %u\n",
+		unsigned_cast(backend), unsigned_cast(async_io::backend(io))
+	);
+	TOGO_ASSERTE(async_io::backend(io) != AsyncIOBackend::automatic);
+	if (backend == AsyncIOBackend::threads) {
+		TOGO_ASSERTE(async_io::backend(io) == AsyncIOBackend::threads);
+	}
+
+	AsyncIORequest requests[NUM_CHUNKS];
+	AsyncIORequest* request_ptrs[NUM_CHUNKS];
+	for (unsigned i = 0; i < NUM_CHUNKS; ++i) {
+		request_ptrs[i] = &requests[i];
+	}
+
+	{// Write chunks in reverse order
+	FileWriter writer;
+	TOGO_ASSERTE(writer.open(path, false));
+	for (unsigned i = 0; i < NUM_CHUNKS; ++i) {
+		unsigned const chunk = NUM_CHUNKS - 1 - i;
+		async_io::set_write(
+			requests[i], writer, chunk * CHUNK_SIZE, s_data + chunk * CHUNK_SIZE, CHUNK_SIZE
+		);
+		async_io::set_callback(requests[i], callback, &s_num_callbacks);
+	}
+	s_num_callbacks = 0;
+	async_io::submit(io, array_cref(request_ptrs));
+	async_io::wait(io);
+	TOGO_ASSERTE(s_num_callbacks == NUM_CHUNKS);
+	for (auto const& request : requests) {
+		TOGO_ASSERTE(request.status.ok() && request.transferred == CHUNK_SIZE);
+	}
+	writer.close();
+	}
+
+	FileReader reader;
+	TOGO_ASSERTE(reader.open(path));
+
+	{// Read chunks, releasing a task for each
+	TaskManager tm{2, memory::default_allocator()};
+	std::memset(s_data_in, 0, sizeof(s_data_in));
+	s_num_tasks = 0;
+	TaskID const root = task_manager::add_hold_empty(tm);
+	for (unsigned i = 0; i < NUM_CHUNKS; ++i) {
+		async_io::set_read(
+			requests[i], reader, i * CHUNK_SIZE, s_data_in + i * CHUNK_SIZE, CHUNK_SIZE
+		);
+		TaskID const task = task_manager::add_hold(tm, {&requests[i], task_func});
+		task_manager::set_parent(tm, task, root);
+		async_io::set_task(requests[i], tm, task);
+	}
+	task_manager::end_hold(tm, root);
+	async_io::submit(io, array_cref(request_ptrs));
+	task_manager::wait(tm, root);
+	TOGO_ASSERTE(s_num_tasks == NUM_CHUNKS);
+	TOGO_ASSERTE(std::memcmp(s_data, s_data_in, FILE_SIZE) == 0);
+	}
+
+	{// Read past the end
+	AsyncIORequest request;
+	async_io::set_read(request, reader, FILE_SIZE - 10, s_data_in, CHUNK_SIZE);
+	async_io::submit(io, request);
+	async_io::wait(io);
+	TOGO_ASSERTE(!request.status.fail() && request.status.eof());
+	TOGO_ASSERTE(request.transferred == 10);
+	TOGO_ASSERTE(std::memcmp(s_data + FILE_SIZE - 10, s_data_in, 10) == 0);
+	}
+	reader.close();
+}
+
+signed main() {
+	memory_init();
+
+	for (unsigned i = 0; i < FILE_SIZE; ++i) {
+		s_data[i] = static_cast<u8>(i * 13 + (i >> 9));
+	}
+	test_backend(AsyncIOBackend::automatic);
+	test_backend(AsyncIOBackend::kernel);
+	test_backend(AsyncIOBackend::threads);
+	return 0;
+}
@@ -1,28 +1,106 @@
-
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/memory/memory.hpp>
 #include <togo/core/string/string.hpp>
 #include <togo/core/io/file_stream.hpp>
 
+#include <togo/support/test.hpp>
+
 #include "./common.hpp"
 
 using namespace togo;
 
-signed main() {
-	static constexpr StringRef const path{"data/file_stream.bin"};
+static constexpr StringRef const path{"data/file_stream.bin"};
+
+static void test_stream(unsigned const buffer_size, FileStreamFlags const flags) {
 	{
 		FileWriter writer;
+		writer.set_buffer_size(buffer_size);
 		TOGO_ASSERTE(!writer.is_open());
-		TOGO_ASSERTE(writer.open(path, false));
+		TOGO_ASSERTE(writer.open(path, false, flags));
 		TOGO_ASSERTE(writer.is_open());
 		test_writer(writer, true);
 		writer.close();
 	}
 	{
 		FileReader reader;
+		reader.set_buffer_size(buffer_size);
 		TOGO_ASSERTE(!reader.is_open());
-		TOGO_ASSERTE(reader.open(path));
+		TOGO_ASSERTE(reader.open(path, flags));
 		TOGO_ASSERTE(reader.is_open());
 		test_reader(reader, true);
 		reader.close();
 	}
+}
+
+static u8 s_data[300 * 1024];
+static u8 s_data_in[array_extent(s_data)];
+
+static void test_bulk(unsigned const buffer_size, FileStreamFlags const flags) {
+	std::memset(s_data_in, 0, sizeof(s_data_in));
+	{
+		FileWriter writer;
+		writer.set_buffer_size(buffer_size);
+		TOGO_ASSERTE(writer.open(path, false, flags));
+		TOGO_ASSERTE(io::write(writer, s_data, 3));
+		TOGO_ASSERTE(io::write(writer, s_data + 3, 100 * 1024 - 3));
+		IOVecConst const out[]{
+			{s_data + 100 * 1024, 1},
+			{s_data + 100 * 1024 + 1, 0},
+			{s_data + 100 * 1024 + 1, 150 * 1024 - 1},
+			{s_data + 250 * 1024, 50 * 1024},
+		};
+		TOGO_ASSERTE(io::writev(writer, array_cref(out)));
+		TOGO_ASSERTE(io::position(writer) == sizeof(s_data));
+
+		// Overwrite in place
+		TOGO_ASSERTE(io::seek_to(writer, 10) == 10);
+		TOGO_ASSERTE(io::write(writer, s_data + 10, 20));
+		TOGO_ASSERTE(io::position(writer) == 30);
+		writer.close();
+	}
+	{
+		FileReader reader;
+		reader.set_buffer_size(buffer_size);
+		TOGO_ASSERTE(reader.open(path, flags));
+		unsigned read_size = 0;
+		TOGO_ASSERTE(io::read(reader, s_data_in, 5, &read_size) && read_size == 5);
+		IOVec const in[]{
+			{s_data_in + 5, 1},
+			{s_data_in + 6, 200 * 1024 - 6},
+			{s_data_in + 200 * 1024, 0},
+			{s_data_in + 200 * 1024, 100 * 1024 + 16},
+		};
+		io::readv(reader, array_cref(in), &read_size);
+		TOGO_ASSERTE(!io::status(reader).fail() && io::status(reader).eof());
+		TOGO_ASSERTE(read_size == sizeof(s_data) - 5);
+		TOGO_ASSERTE(io::position(reader) == sizeof(s_data));
+		TOGO_ASSERTE(std::memcmp(s_data, s_data_in, sizeof(s_data)) == 0);
+
+		// Seek backwards (inside and outside of the buffer)
+		u8 value = 0;
+		TOGO_ASSERTE(io::seek_relative(reader, -1) == sizeof(s_data) - 1);
+		TOGO_ASSERTE(io::read_value(reader, value) && value == s_data[sizeof(s_data) - 1]);
+		TOGO_ASSERTE(io::seek_to(reader, 4097) == 4097);
+		TOGO_ASSERTE(io::read_value(reader, value) && value == s_data[4097]);
+		io::seek_relative(reader, -4099);
+		TOGO_ASSERTE(io::status(reader).fail() && io::position(reader) == 4098);
+		reader.close();
+	}
+}
+
+signed main() {
+	memory_init();
+
+	for (unsigned i = 0; i < array_extent(s_data); ++i) {
+		s_data[i] = static_cast<u8>(i * 7 + (i >> 8));
+	}
+
+	unsigned const buffer_sizes[]{FILE_STREAM_BUFFER_SIZE_DEFAULT, 0, 1, 7, 4096};
+	for (unsigned const buffer_size : buffer_sizes) {
+		test_stream(buffer_size, FileStreamFlags::none);
+		test_stream(buffer_size, FileStreamFlags::direct);
+		test_bulk(buffer_size, FileStreamFlags::none);
+		test_bulk(buffer_size, FileStreamFlags::direct);
+	}
 	return 0;
 }
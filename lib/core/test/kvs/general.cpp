@@ -7,6 +7,7 @@
 
 #include <togo/support/test.hpp>
 
+#include <cstdio>
 #include <cstring>
 
 using namespace togo;
@@ -150,6 +151,105 @@ signed main() {
 		TOGO_ASSERTE(kvs::empty(c));
 	}
 
+	{
+		// Large nodes are looked up through a name hash index, which
+		// is built when they are read
+		enum : unsigned { NUM = 200 };
+		char name[16];
+		auto const name_of = [&name](unsigned const i) -> StringRef {
+			return {name, static_cast<unsigned>(std::snprintf(name, sizeof(name), "item%u", i))};
+		};
+		char text[NUM * 16 + 16];
+		unsigned text_size = 0;
+		for (unsigned i = 0; i < NUM; ++i) {
+			text_size += std::snprintf(text + text_size, sizeof(text) - text_size, "item%u = %u\n", i, i);
+		}
+		// Duplicate names keep the first match
+		text_size += std::snprintf(text + text_size, sizeof(text) - text_size, "item7 = -1\n");
+		KVS c;
+		KVSParserInfo pinfo{};
+		TOGO_ASSERTE(kvs::read_text(c, array_cref(StringRef{text, text_size}), pinfo));
+		TOGO_ASSERTE(kvs::size(c) == NUM + 1);
+		TOGO_ASSERTE(c._value.collection.index != nullptr);
+		KVS const& c_const = c;
+		for (unsigned i = 0; i < NUM; ++i) {
+			KVS const* const item = kvs::find(c, name_of(i));
+			TOGO_ASSERTE(item == &c[i]);
+			TOGO_ASSERTE(kvs::find(c, kvs::hash_name(name_of(i))) == item);
+			TOGO_ASSERTE(kvs::find(c_const, name_of(i)) == item);
+		}
+		TOGO_ASSERTE(kvs::find(c, "x") == nullptr);
+
+		// Items added after the index was built
+		for (unsigned i = NUM; i < NUM * 2; ++i) {
+			kvs::push_back(c, KVS{name_of(i), s64{i}});
+			TOGO_ASSERTE(kvs::find(c, name_of(i)) == &kvs::back(c));
+		}
+		kvs::push_back(c, KVS{});
+		kvs::set_name(kvs::back(c), "z");
+		TOGO_ASSERTE(kvs::find(c, "z") == &kvs::back(c));
+		kvs::pop_back(c);
+		TOGO_ASSERTE(kvs::find(c, "z") == nullptr);
+		TOGO_ASSERTE(kvs::integer(*kvs::find(c, name_of(NUM + 1))) == NUM + 1);
+		kvs::resize(c, NUM + 1);
+		TOGO_ASSERTE(kvs::find(c, name_of(NUM + 1)) == nullptr);
+		TOGO_ASSERTE(kvs::integer(*kvs::find(c, name_of(7))) == 7);
+
+		// Renaming an indexed child is seen by both const and
+		// non-const lookups
+		kvs::set_name(c[5], "renamed");
+		TOGO_ASSERTE(kvs::find(c_const, "renamed") == &c[5]);
+		TOGO_ASSERTE(kvs::find(c_const, name_of(5)) == nullptr);
+		TOGO_ASSERTE(kvs::find(c, "renamed") == &c[5]);
+		TOGO_ASSERTE(kvs::find(c, name_of(5)) == nullptr);
+		kvs::set_name(c[5], name_of(5));
+
+		kvs::set_name(c[3], "x");
+		TOGO_ASSERTE(kvs::find(c, "x") == &c[3]);
+		TOGO_ASSERTE(kvs::find(c, name_of(3)) == nullptr);
+		kvs::set_name(c[NUM - 1], "x");
+		TOGO_ASSERTE(kvs::find(c, "x") == &c[3]);
+		kvs::set_name(c[1], "x");
+		TOGO_ASSERTE(kvs::find(c_const, "x") == &c[1]);
+		TOGO_ASSERTE(kvs::find(c, "x") == &c[1]);
+		kvs::clear_name(c[1]);
+		TOGO_ASSERTE(kvs::find(c, "x") == &c[3]);
+		kvs::set_name(c[1], "x");
+
+		// Moving a named value into or out of an indexed child
+		{
+			KVS value{"moved", s64{-2}};
+			kvs::move(c[10], value);
+			TOGO_ASSERTE(kvs::find(c_const, "moved") == &c[10]);
+			TOGO_ASSERTE(kvs::find(c, "moved") == &c[10]);
+			TOGO_ASSERTE(kvs::find(c, name_of(10)) == nullptr);
+			KVS moved{rvalue_ref(c[10])};
+			TOGO_ASSERTE(kvs::find(c, "moved") == nullptr);
+			kvs::move(c[10], moved);
+			TOGO_ASSERTE(kvs::find(c, "moved") == &c[10]);
+			kvs::set_name(c[10], name_of(10));
+			kvs::integer(c[10], 10);
+		}
+
+		// Removing shifts the remaining children
+		kvs::remove(c, &c[0]);
+		TOGO_ASSERTE(kvs::find(c, name_of(0)) == nullptr);
+		TOGO_ASSERTE(kvs::find(c, "x") == &c[0]);
+		TOGO_ASSERTE(kvs::integer(*kvs::find(c, name_of(7))) == 7);
+		kvs::remove(c, 6);
+		TOGO_ASSERTE(kvs::integer(*kvs::find(c, name_of(7))) == -1);
+
+		// Copies get their own index
+		KVS d{c};
+		TOGO_ASSERTE(d._value.collection.index != nullptr);
+		TOGO_ASSERTE(d._value.collection.index != c._value.collection.index);
+		TOGO_ASSERTE(kvs::integer(*kvs::find(d, name_of(100))) == 100);
+		TOGO_ASSERTE(kvs::find(d, name_of(100)) != kvs::find(c, name_of(100)));
+		kvs::push_back(d, KVS{"y", null_tag{}});
+		TOGO_ASSERTE(kvs::find(d, "y") == &kvs::back(d));
+		TOGO_ASSERTE(kvs::find(c, "y") == nullptr);
+	}
+
 	{
 		KVS v{};
 		// kvs::find() short-circuits when KVS is non-collection
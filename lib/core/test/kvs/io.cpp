@@ -18,6 +18,7 @@
 
 #include <cmath>
 #include <cstdint>
+#include <cstring>
 
 using namespace togo;
 
@@ -511,6 +512,113 @@ void do_test_old(Test const& test) {
 	TOGO_LOG("\n");
 }
 
+// Reading from memory must match reading from a stream, including
+// error positions
+void check_read_memory(StringRef const& input) {
+	KVS root_stream;
+	KVSParserInfo pinfo_stream{};
+	MemoryReader in_stream{input};
+	bool const success = kvs::read_text(root_stream, in_stream, pinfo_stream);
+
+	KVS root_memory;
+	KVSParserInfo pinfo_memory{};
+	TOGO_ASSERTE(success == kvs::read_text(root_memory, array_cref(input), pinfo_memory));
+	if (success) {
+		MemoryStream out_stream{memory::default_allocator(), input.size + 1};
+		MemoryStream out_memory{memory::default_allocator(), input.size + 1};
+		TOGO_ASSERTE(kvs::write_text(root_stream, out_stream));
+		TOGO_ASSERTE(kvs::write_text(root_memory, out_memory));
+		TOGO_ASSERTE(out_stream.size() == out_memory.size());
+		TOGO_ASSERTE(std::memcmp(
+			array::begin(out_stream.data()),
+			array::begin(out_memory.data()),
+			out_stream.size()
+		) == 0);
+	} else {
+		TOGO_ASSERTE(pinfo_stream.line == pinfo_memory.line);
+		TOGO_ASSERTE(pinfo_stream.column == pinfo_memory.column);
+		TOGO_ASSERTE(std::strcmp(pinfo_stream.message, pinfo_memory.message) == 0);
+	}
+}
+
+// Runs that span stream chunks
+void do_test_large() {
+	Array<char> input{memory::default_allocator()};
+	auto const append = [&input](StringRef const& str) {
+		unsigned const size = array::size(input);
+		array::resize(input, size + str.size);
+		std::memcpy(array::begin(input) + size, str.data, str.size);
+	};
+	for (unsigned i = 0; i < 2000; ++i) {
+		append("a_fairly_long_name_for_a_value = \"a \\\"quoted\\\" string\"\r\n");
+		append("\t\t  // a line comment with some text in it\n");
+		append("b = [1, 2.5, (1 2 3), ```block\nstring```, {c = unquoted_string}]\n");
+		append("/* a block comment\n * over ** lines */ d = true\n");
+	}
+	StringRef const input_ref{array::begin(input), static_cast<unsigned>(array::size(input))};
+	check_read_memory(input_ref);
+
+	KVS root;
+	KVSParserInfo pinfo{};
+	TOGO_ASSERTE(kvs::read_text(root, array_cref(input_ref), pinfo));
+	TOGO_ASSERTE(kvs::size(root) == 2000 * 3);
+	// Large collections are indexed after they are read
+	TOGO_ASSERTE(root._value.collection.index != nullptr);
+	TOGO_ASSERTE(kvs::find(root, "d") == &root[2]);
+
+	append("x = \"unterminated\n");
+	check_read_memory(StringRef{array::begin(input), static_cast<unsigned>(array::size(input))});
+}
+
+// Reads into an arena, rewrites through the binary format and mutates
+void do_test_arena(Test const& test) {
+	if (!test.expected_success) {
+		return;
+	}
+	KVSArena arena{};
+	KVS root;
+	KVSParserInfo pinfo{};
+	MemoryReader in_stream{test.input};
+	TOGO_ASSERTE(kvs::read_text(root, in_stream, pinfo, &arena));
+	if (test.func) {
+		KVS& first = kvs::any(root) ? root[0] : root;
+		test.func(root, first);
+	}
+
+	MemoryStream binary_stream{memory::default_allocator(), 256};
+	TOGO_ASSERTE(kvs::write_binary(root, binary_stream).ok());
+	KVS root_binary;
+	MemoryReader binary_in_stream{array_cref(
+		array::begin(binary_stream.data()),
+		static_cast<unsigned>(binary_stream.size())
+	)};
+	TOGO_ASSERTE(kvs::read_binary(root_binary, binary_in_stream, Endian::little, &arena).ok());
+
+	MemoryStream out_stream{memory::default_allocator(), test.expected_output.size + 1};
+	TOGO_ASSERTE(kvs::write_text(root_binary, out_stream));
+	StringRef output{
+		reinterpret_cast<char*>(array::begin(out_stream.data())),
+		static_cast<unsigned>(out_stream.size())
+	};
+	if (output.size > 0) {
+		--output.size;
+	}
+	TOGO_ASSERT(
+		string::compare_equal(test.expected_output, output),
+		"output does not match"
+	);
+
+	// Mutation falls back to the heap
+	for (auto& k : root) {
+		kvs::set_name(k, "a much longer name than any of the test inputs use");
+		if (kvs::is_string(k)) {
+			kvs::string(k, "a much longer string than any of the test inputs use");
+		}
+	}
+	kvs::push_back(root, KVS{"y", s64{1}});
+	kvs::copy(root_binary, root);
+}
+
 void do_test_new(Test const& test) {
 	TOGO_LOGF(
 		"!! new  %-3u @ %3u\n",
@@ -597,6 +705,13 @@ signed main(signed argc, char* argv[]) {
 				kvs::read_text(root, in_stream, pinfo);
 			}
 		});
+		measure("old (memory)", num, [](){
+			KVS root;
+			KVSParserInfo pinfo;
+			for (auto& test : s_tests) {
+				kvs::read_text(root, array_cref(test.input), pinfo);
+			}
+		});
 		f64 duration_new = measure("new", num, [](){
 			KVS root;
 			ParseError error{};
@@ -605,6 +720,15 @@ signed main(signed argc, char* argv[]) {
 			}
 		});
 
+		measure("new (reused state)", num, [](){
+			KVS root;
+			ParseError error{};
+			ParseState state{memory::default_allocator()};
+			for (auto& test : s_tests) {
+				kvs::read_text_new(root, array_cref(test.input), state, &error);
+			}
+		});
+
 		f64 ratio = duration_new / duration_old;
 		f64 ratio_log2 = std::log2(ratio);
 		TOGO_LOGF(
@@ -614,8 +738,11 @@ signed main(signed argc, char* argv[]) {
 	} else {
 		for (auto& test : s_tests) {
 			do_test_old(test);
+			check_read_memory(test.input);
+			do_test_arena(test);
 			do_test_new(test);
 		}
+		do_test_large();
 	}
 
 	return 0;
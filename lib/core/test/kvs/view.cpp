@@ -0,0 +1,173 @@
+#include <togo/core/error/assert.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/string/string.hpp>
+#include <togo/core/io/io.hpp>
+#include <togo/core/io/memory_stream.hpp>
+#include <togo/core/filesystem/filesystem.hpp>
+#include <togo/core/kvs/kvs.hpp>
+#include <togo/core/kvs/view.hpp>
+
+#include <togo/support/test.hpp>
+
+#include <cstring>
+
+using namespace togo;
+
+static constexpr char const s_input[]{R"(
+	x = 42
+	y = -1.5
+	flag = true
+	name = "a string value"
+	empty = ""
+	n = null
+	v1 = (1)
+	v2 = (1 2)
+	v3 = (1 2 3)
+	v4 = (1 2 3 4)
+	dup = 1
+	dup = 2
+	list = [1, two, [3], {a = 4}]
+	node = {
+		a = {b = {c = deep}}
+		empty_node = {}
+		empty_list = []
+	}
+)"};
+
+void check_equal(KVS const& k, KVSView const& v) {
+	TOGO_ASSERTE(v);
+	TOGO_ASSERTE(kvs::type(k) == kvs::type(v));
+	TOGO_ASSERTE(kvs::name_hash(k) == kvs::name_hash(v));
+	TOGO_ASSERTE(string::compare_equal(kvs::name_ref(k), kvs::name_ref(v)));
+	TOGO_ASSERTE(kvs::name(v)[kvs::name_size(v)] == '\0');
+	switch (kvs::type(k)) {
+	case KVSType::null: break;
+	case KVSType::integer: TOGO_ASSERTE(kvs::integer(k) == kvs::integer(v)); break;
+	case KVSType::decimal: TOGO_ASSERTE(kvs::decimal(k) == kvs::decimal(v)); break;
+	case KVSType::boolean: TOGO_ASSERTE(kvs::boolean(k) == kvs::boolean(v)); break;
+	case KVSType::string:
+		TOGO_ASSERTE(string::compare_equal(kvs::string_ref(k), kvs::string_ref(v)));
+		TOGO_ASSERTE(kvs::string(v)[kvs::string_size(v)] == '\0');
+		break;
+	case KVSType::vec1: TOGO_ASSERTE(std::memcmp(&kvs::vec1(k), &kvs::vec1(v), sizeof(Vec1)) == 0); break;
+	case KVSType::vec2: TOGO_ASSERTE(std::memcmp(&kvs::vec2(k), &kvs::vec2(v), sizeof(Vec2)) == 0); break;
+	case KVSType::vec3: TOGO_ASSERTE(std::memcmp(&kvs::vec3(k), &kvs::vec3(v), sizeof(Vec3)) == 0); break;
+	case KVSType::vec4: TOGO_ASSERTE(std::memcmp(&kvs::vec4(k), &kvs::vec4(v), sizeof(Vec4)) == 0); break;
+
+	case KVSType::array: // fall-through
+	case KVSType::node: {
+		TOGO_ASSERTE(kvs::size(k) == kvs::size(v));
+		unsigned i = 0;
+		for (KVSView child : v) {
+			check_equal(k[i], child);
+			if (kvs::is_named(child)) {
+				// First match in both
+				TOGO_ASSERTE(
+					kvs::find(v, kvs::name_ref(child))._value - kvs::begin(v)._value ==
+					kvs::find(k, kvs::name_ref(child)) - kvs::begin(k)
+				);
+			}
+			++i;
+		}
+		TOGO_ASSERTE(i == kvs::size(v));
+	}	break;
+	}
+}
+
+signed main() {
+	memory_init();
+
+	KVS root;
+	{
+	MemoryReader in_stream{s_input};
+	TOGO_ASSERTE(kvs::read_text(root, in_stream));
+	}
+
+	MemoryStream packed_stream{memory::default_allocator(), 4096};
+	TOGO_ASSERTE(kvs::write_packed(root, packed_stream).ok());
+	unsigned const size = static_cast<unsigned>(packed_stream.size());
+	TOGO_LOGF("packed size: %u\n", size);
+
+	{// View in memory
+	Array<u64> data{memory::default_allocator()};
+	array::resize(data, (size + 7) / 8);
+	std::memcpy(array::begin(data), array::begin(packed_stream.data()), size);
+	KVSView const view = kvs::view_packed(array_cref(
+		reinterpret_cast<u8 const*>(array::begin(data)), size
+	));
+	check_equal(root, view);
+	TOGO_ASSERTE(kvs::integer(kvs::find(view, "dup")) == 1);
+	TOGO_ASSERTE(!kvs::find(view, "missing"));
+	TOGO_ASSERTE(!kvs::find(kvs::find(view, "x"), "x"));
+	TOGO_ASSERTE(string::compare_equal(
+		"deep",
+		kvs::string_ref(kvs::find(kvs::find(kvs::find(kvs::find(view, "node"), "a"), "b"), "c"))
+	));
+	TOGO_ASSERTE(kvs::integer(kvs::at(kvs::find(view, "list"), 0)) == 1);
+
+	// Null views are empty
+	KVSView const null_view = kvs::find(kvs::find(view, "missing"), "b");
+	TOGO_ASSERTE(!null_view);
+	TOGO_ASSERTE(kvs::size(null_view) == 0 && kvs::empty(null_view));
+	TOGO_ASSERTE(!(kvs::begin(null_view) != kvs::end(null_view)));
+	for (KVSView child : KVSView{nullptr, nullptr}) {
+		TOGO_ASSERTE(!child);
+	}
+	TOGO_ASSERTE(!kvs::find(KVSView{nullptr, nullptr}, "x"));
+
+	// Truncated or corrupt data
+	auto const data_ref = [&data, size]() {
+		return array_cref(reinterpret_cast<u8 const*>(array::begin(data)), size);
+	};
+	auto const corrupt = [&data_ref](u32& field, u32 const bad) {
+		u32 const good = field;
+		field = bad;
+		// Only the header and root are checked when viewing
+		TOGO_ASSERTE(kvs::view_packed(data_ref()));
+		TOGO_ASSERTE(!kvs::validate_packed(data_ref()));
+		field = good;
+		TOGO_ASSERTE(kvs::validate_packed(data_ref()));
+	};
+	TOGO_ASSERTE(kvs::validate_packed(data_ref()));
+	TOGO_ASSERTE(!kvs::view_packed(array_cref(
+		reinterpret_cast<u8 const*>(array::begin(data)), size - 1
+	)));
+	{
+	auto& node = const_cast<KVSPackedValue&>(*kvs::find(view, "node")._value);
+	corrupt(node.value.offset, size);
+	corrupt(node.value.offset, 0);
+	corrupt(node.size, 1000);
+	auto& name = const_cast<KVSPackedValue&>(*kvs::find(view, "name")._value);
+	corrupt(name.value.offset, size - 2);
+	corrupt(name.size, name.size + 1);
+	corrupt(name.name, ~u32{0} - 3);
+	auto& x = const_cast<KVSPackedValue&>(*kvs::find(view, "x")._value);
+	x.type = static_cast<KVSType>(3);
+	TOGO_ASSERTE(!kvs::validate_packed(data_ref()));
+	x.type = KVSType::integer;
+	TOGO_ASSERTE(kvs::validate_packed(data_ref()));
+	auto& header = *reinterpret_cast<KVSPackedHeader*>(array::begin(data));
+	u32 const num_values = header.num_values;
+	header.num_values = size;
+	TOGO_ASSERTE(!kvs::view_packed(data_ref()));
+	header.num_values = num_values;
+	}
+	array::front(data) = 0;
+	TOGO_ASSERTE(!kvs::view_packed(data_ref()));
+	TOGO_ASSERTE(!kvs::validate_packed(data_ref()));
+	}
+
+	{// View a mapped file
+	StringRef const path{"kvs_view_test.kvsp"};
+	TOGO_ASSERTE(kvs::write_packed_file(root, path));
+	MappedFile file;
+	TOGO_ASSERTE(filesystem::map_file(file, path));
+	TOGO_ASSERTE(file.size == size);
+	check_equal(root, kvs::view_packed(array_cref(file.data, static_cast<unsigned>(file.size))));
+	filesystem::unmap_file(file);
+	TOGO_ASSERTE(file.data == nullptr);
+	TOGO_ASSERTE(filesystem::remove_file(path));
+	}
+	return 0;
+}
@@ -0,0 +1,164 @@
+#include <togo/core/error/assert.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/string/string.hpp>
+#include <togo/core/io/io.hpp>
+#include <togo/core/io/memory_stream.hpp>
+#include <togo/core/kvs/kvs.hpp>
+
+#include <togo/support/test.hpp>
+
+#include <cstring>
+
+using namespace togo;
+
+static constexpr char const s_input[]{R"(
+	x = 42
+	y = -1.5
+	name = "a string value"
+	n = null
+	v3 = (1 2 3)
+	list = [1, two, [3], {a = 4}, (1 2)]
+	node = {
+		a = {b = {c = deep}}
+		empty_node = {}
+		empty_list = []
+	}
+	after = true
+)"};
+
+// Rebuilds the tree from events
+struct TreeVisitor : IKVSVisitor {
+	KVS root{KVSType::node};
+	Array<KVS*> stack{memory::default_allocator()};
+	StringRef skip_name{};
+	unsigned num_skipped{0};
+
+	TreeVisitor() {
+		array::push_back(stack, &root);
+	}
+
+	KVS& add(KVS const& kvs) {
+		KVS& top = *array::back(stack);
+		kvs::push_back(top, kvs);
+		return kvs::back(top);
+	}
+
+	bool begin_collection(KVS const& collection) override {
+		TOGO_ASSERTE(kvs::is_collection(collection) && kvs::empty(collection));
+		KVS& added = add(collection);
+		if (skip_name.any() && string::compare_equal(skip_name, kvs::name_ref(collection))) {
+			++num_skipped;
+			return false;
+		}
+		array::push_back(stack, &added);
+		return true;
+	}
+
+	void end_collection(KVS const& collection) override {
+		TOGO_ASSERTE(array::size(stack) > 1);
+		KVS& top = *array::back(stack);
+		TOGO_ASSERTE(kvs::type(top) == kvs::type(collection));
+		TOGO_ASSERTE(kvs::name_hash(top) == kvs::name_hash(collection));
+		array::pop_back(stack);
+	}
+
+	void value(KVS const& value) override {
+		TOGO_ASSERTE(!kvs::is_collection(value));
+		add(value);
+	}
+};
+
+static void check_equal_text(KVS const& a, KVS const& b) {
+	MemoryStream stream_a{memory::default_allocator(), 1024};
+	MemoryStream stream_b{memory::default_allocator(), 1024};
+	TOGO_ASSERTE(kvs::write_text(a, stream_a));
+	TOGO_ASSERTE(kvs::write_text(b, stream_b));
+	TOGO_ASSERTE(stream_a.size() == stream_b.size());
+	TOGO_ASSERTE(std::memcmp(
+		array::begin(stream_a.data()),
+		array::begin(stream_b.data()),
+		stream_a.size()
+	) == 0);
+}
+
+static void check_visitor(TreeVisitor const& visitor, KVS const& expected) {
+	TOGO_ASSERTE(array::size(visitor.stack) == 1);
+	check_equal_text(visitor.root, expected);
+}
+
+signed main() {
+	memory_init();
+
+	KVS root;
+	{
+	MemoryReader in_stream{s_input};
+	TOGO_ASSERTE(kvs::read_text(root, in_stream));
+	}
+
+	// Skipping a collection leaves it empty
+	KVS root_skipped;
+	kvs::copy(root_skipped, root);
+	kvs::clear(*kvs::find(root_skipped, "node"));
+
+	MemoryStream binary_stream{memory::default_allocator(), 1024};
+	TOGO_ASSERTE(kvs::write_binary(root, binary_stream).ok());
+	auto const binary_data = array_cref(
+		array::begin(binary_stream.data()),
+		static_cast<unsigned>(binary_stream.size())
+	);
+
+	{// Text
+	KVSParserInfo pinfo{};
+	TreeVisitor visitor{};
+	MemoryReader in_stream{s_input};
+	TOGO_ASSERTE(kvs::visit_text(visitor, in_stream, pinfo));
+	check_visitor(visitor, root);
+
+	TreeVisitor visitor_memory{};
+	TOGO_ASSERTE(kvs::visit_text(visitor_memory, array_cref(StringRef{s_input}), pinfo));
+	check_visitor(visitor_memory, root);
+
+	TreeVisitor visitor_skip{};
+	visitor_skip.skip_name = "node";
+	TOGO_ASSERTE(kvs::visit_text(visitor_skip, array_cref(StringRef{s_input}), pinfo));
+	TOGO_ASSERTE(visitor_skip.num_skipped == 1);
+	check_visitor(visitor_skip, root_skipped);
+
+	// Errors are reported the same as with read_text()
+	TreeVisitor visitor_error{};
+	MemoryReader error_stream{"x = {y = 1"};
+	TOGO_ASSERTE(!kvs::visit_text(visitor_error, error_stream, pinfo));
+	TOGO_LOGF("error: [%2u,%2u]: %s\n", pinfo.line, pinfo.column, pinfo.message);
+	}
+
+	{// Binary
+	TreeVisitor visitor{};
+	MemoryReader in_stream{binary_data};
+	TOGO_ASSERTE(kvs::visit_binary(visitor, in_stream).ok());
+	check_visitor(visitor, root);
+
+	TreeVisitor visitor_skip{};
+	visitor_skip.skip_name = "node";
+	MemoryReader in_stream_skip{binary_data};
+	TOGO_ASSERTE(kvs::visit_binary(visitor_skip, in_stream_skip).ok());
+	TOGO_ASSERTE(visitor_skip.num_skipped == 1);
+	check_visitor(visitor_skip, root_skipped);
+
+	TreeVisitor visitor_memory{};
+	kvs::visit_binary(visitor_memory, binary_data);
+	check_visitor(visitor_memory, root);
+
+	// Memory round-trip matches the stream form
+	KVS root_memory;
+	kvs::read_binary(root_memory, binary_data);
+	check_equal_text(root_memory, root);
+	Array<u8> buffer{memory::default_allocator()};
+	kvs::write_binary(root_memory, buffer);
+	TOGO_ASSERTE(array::size(buffer) == binary_data.size());
+	TOGO_ASSERTE(std::memcmp(
+		array::begin(buffer), begin(binary_data), array::size(buffer)
+	) == 0);
+	}
+	return 0;
+}
@@ -0,0 +1,176 @@
+#include <togo/core/error/assert.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/threading/thread.hpp>
+#include <togo/core/system/system.hpp>
+#include <togo/core/io/memory_stream.hpp>
+
+#include <togo/support/test.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace togo;
+
+enum : unsigned {
+	NUM_THREADS = 4,
+	NUM_MESSAGES = 2000,
+};
+
+static unsigned s_thread_indices[NUM_THREADS];
+
+// Logs from within the sink, like a file stream reporting an error
+class FailingWriter
+	: public IWriter
+{
+public:
+	unsigned num_writes = 0;
+
+	IOStatus status() const override {
+		return IOStatus{IOStatus::flag_fail};
+	}
+
+	IOStatus write(void const* /*data*/, unsigned /*size*/) override {
+		++num_writes;
+		TOGO_LOG("sink write failed\n");
+		return status();
+	}
+};
+
+static void* log_func(void* call_data) {
+	unsigned const index = *static_cast<unsigned*>(call_data);
+	for (unsigned i = 0; i < NUM_MESSAGES; ++i) {
+		TOGO_LOGF("t%u %u\n", index, i);
+	}
+	return nullptr;
+}
+
+static void log_threaded() {
+	Thread* threads[NUM_THREADS];
+	for (unsigned i = 0; i < NUM_THREADS; ++i) {
+		s_thread_indices[i] = i;
+		threads[i] = thread::create("log-test", &s_thread_indices[i], log_func);
+	}
+	for (auto t : threads) {
+		thread::join(t);
+	}
+}
+
+// Each thread's messages are complete and in order
+static void check_output(MemoryStream& stream, bool const timestamps) {
+	unsigned next[NUM_THREADS]{};
+	char const* p = reinterpret_cast<char const*>(array::begin(stream.data()));
+	char const* const e = p + stream.size();
+	while (p < e) {
+		char const* const line_end = static_cast<char const*>(std::memchr(p, '\n', e - p));
+		TOGO_ASSERTE(line_end);
+		if (timestamps) {
+			TOGO_ASSERTE(*p == '[');
+			p = static_cast<char const*>(std::memchr(p, ']', line_end - p));
+			TOGO_ASSERTE(p && p[1] == ' ');
+			p += 2;
+		}
+		TOGO_ASSERTE(*p == 't');
+		char* end = nullptr;
+		unsigned const index = static_cast<unsigned>(std::strtoul(p + 1, &end, 10));
+		unsigned const value = static_cast<unsigned>(std::strtoul(end + 1, nullptr, 10));
+		TOGO_ASSERTE(index < NUM_THREADS && value == next[index]);
+		++next[index];
+		p = line_end + 1;
+	}
+	for (unsigned const n : next) {
+		TOGO_ASSERTE(n == NUM_MESSAGES);
+	}
+	stream.clear();
+}
+
+signed main(signed argc, char* argv[]) {
+	memory_init();
+
+	MemoryStream stream{memory::default_allocator(), 64 * 1024};
+	log::set_stdout(false);
+	log::add_sink(stream);
+
+	// Synchronous
+	log_threaded();
+	check_output(stream, false);
+
+	// Asynchronous with small buffers, which fill up constantly
+	log::start_async(256, 1);
+	TOGO_ASSERTE(log::is_async());
+	log_threaded();
+	log::stop_async();
+	TOGO_ASSERTE(!log::is_async());
+	check_output(stream, false);
+
+	log::set_timestamps(true);
+	log::start_async();
+	log_threaded();
+	log::flush();
+	check_output(stream, true);
+	log::set_timestamps(false);
+
+	// Messages too large for the buffers keep their order
+	{
+	char long_message[3000];
+	std::memset(long_message, 'x', sizeof(long_message) - 1);
+	long_message[sizeof(long_message) - 1] = '\0';
+	TOGO_LOG("a\n");
+	TOGO_LOGF("%s\n", long_message);
+	TOGO_LOG("b\n");
+	log::flush();
+	auto const& data = stream.data();
+	TOGO_ASSERTE(stream.size() == 2 + sizeof(long_message) + 2);
+	TOGO_ASSERTE(data[0] == 'a' && data[2] == 'x' && data[stream.size() - 2] == 'b');
+	stream.clear();
+	}
+	log::stop_async();
+
+	// Sinks that log don't deadlock
+	{
+	FailingWriter failing{};
+	log::add_sink(failing);
+	TOGO_LOG("t0 0\n");
+	TOGO_ASSERTE(failing.num_writes == 1);
+	log::start_async(256, 1);
+	for (unsigned i = 0; i < 100; ++i) {
+		TOGO_LOGF("t0 %u\n", i + 1);
+	}
+	log::stop_async();
+	TOGO_ASSERTE(failing.num_writes == 101);
+	log::remove_sink(failing);
+	auto const& data = stream.data();
+	TOGO_ASSERTE(stream.size() > 5 && std::memcmp(array::begin(data), "t0 0\n", 5) == 0);
+	// Messages from the sink are not written to the sinks
+	TOGO_ASSERTE(!std::memchr(array::begin(data), 's', stream.size()));
+	stream.clear();
+	}
+
+	if (argc > 1) {
+		unsigned num = static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10));
+		num = num ? num : 100000;
+
+		f64 start = system::time_monotonic();
+		for (unsigned i = 0; i < num; ++i) {
+			TOGO_LOGF("message %u %s\n", i, "value");
+		}
+		f64 const duration_sync = system::time_monotonic() - start;
+		stream.clear();
+
+		log::start_async(1024 * 1024);
+		start = system::time_monotonic();
+		for (unsigned i = 0; i < num; ++i) {
+			TOGO_LOGF("message %u %s\n", i, "value");
+		}
+		f64 const duration_async = system::time_monotonic() - start;
+		log::stop_async();
+
+		log::set_stdout(true);
+		TOGO_LOGF(
+			"num = %u  sync = %.06lf  async = %.06lf  ratio = %.03lf\n",
+			num, duration_sync, duration_async, duration_async / duration_sync
+		);
+	}
+	log::remove_sink(stream);
+	return 0;
+}
@@ -0,0 +1,131 @@
+
+#include <togo/core/types.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/memory/fixed_allocator.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/string/string.hpp>
+#include <togo/core/parser/parser.hpp>
+#include <togo/core/parser/parse_state.hpp>
+
+#include <togo/support/test.hpp>
+
+#include "./common.hpp"
+
+#include <cstring>
+
+using namespace togo;
+
+static unsigned s_num_word_calls = 0;
+
+static Parser const s_word{"word", PMod::flatten, Func{
+[](Parser const*, ParseState& s, ParsePosition const& from) {
+	++s_num_word_calls;
+	while (s.p < s.e && 'a' <= *s.p && *s.p <= 'z') {
+		++s.p;
+	}
+	return from.p < s.p ? ok(s) : fail(s, "expected word");
+}
+}};
+
+static FixedParserAllocator<3, 4> s_statement_storage;
+static Parser const s_statement{"statement", Any{s_statement_storage,
+	Parser{All{s_statement_storage, s_word, Char{';'}}},
+	Parser{All{s_statement_storage, s_word, Char{','}}},
+	PDef::s64_any
+}};
+
+static void check_equal(ParseState& a, ParseState& b, bool success_a, bool success_b) {
+	TOGO_ASSERTE(success_a == success_b);
+	TOGO_ASSERTE(a.p - a.b == b.p - b.b);
+	TOGO_ASSERTE(array::size(a.results) == array::size(b.results));
+	for (unsigned i = 0; i < array::size(a.results); ++i) {
+		auto const& ra = a.results[i];
+		auto const& rb = b.results[i];
+		TOGO_ASSERTE(ra.type == rb.type);
+		switch (ra.type) {
+		case ParseResult::type_bool: TOGO_ASSERTE(ra.b == rb.b); break;
+		case ParseResult::type_char: TOGO_ASSERTE(ra.c == rb.c); break;
+		case ParseResult::type_s64: TOGO_ASSERTE(ra.i == rb.i); break;
+		case ParseResult::type_u64: TOGO_ASSERTE(ra.u == rb.u); break;
+		case ParseResult::type_f64: TOGO_ASSERTE(std::memcmp(&ra.f, &rb.f, sizeof(f64)) == 0); break;
+		case ParseResult::type_slice:
+			TOGO_ASSERTE(ra.s.b - a.b == rb.s.b - b.b && ra.s.e - a.b == rb.s.e - b.b);
+			break;
+		default:
+			break;
+		}
+	}
+}
+
+static void check_cache(Parser const& p, ParseCache& cache, StringRef input) {
+	FixedAllocator<1024> storage_a;
+	FixedAllocator<1024> storage_b;
+	ParseState a{storage_a};
+	ParseState b{storage_b};
+	b.cache = &cache;
+	parse_state::set_data(a, input);
+	parse_state::set_data(b, input);
+	bool const success_a = parser::parse(p, a, nullptr);
+	bool const success_b = parser::parse(p, b, nullptr);
+	check_equal(a, b, success_a, success_b);
+}
+
+signed main() {
+	memory_init();
+
+	ParseCache cache{memory::default_allocator(), 64, 64};
+	ParseCache cache_lookahead{memory::default_allocator()};
+	ParseCache cache_small{memory::default_allocator(), 1, 1};
+
+	static StringRef const s_inputs[]{
+		"", "x", "0", "1", "-1", "+1", "007", "0x1f", "0XfF", "-0x10", "08",
+		"1.0", "-1.5", "1.0e3", "1.0E-3", "1e3", "true", "false", "null",
+		"abc;", "abc,", "abc", "abc.", "42",
+	};
+	Parser const* const s_parsers[]{
+		&PDef::whitespace_maybe,
+		&PDef::null,
+		&PDef::boolean,
+		&PDef::digit_hex,
+		&PDef::u64_any,
+		&PDef::s64_dec,
+		&PDef::s64_any,
+		&PDef::f64_exp,
+		&s_statement,
+	};
+	for (auto p : s_parsers) {
+		for (auto input : s_inputs) {
+			check_cache(*p, cache, input);
+			check_cache(*p, cache_lookahead, input);
+			check_cache(*p, cache_small, input);
+		}
+	}
+	TOGO_ASSERTE(array::empty(cache_lookahead.memo));
+
+	{// Memoized rules are not reparsed when backtracking
+	FixedAllocator<1024> storage;
+	ParseState s{storage};
+	parse_state::set_data(s, "abc,");
+	s_num_word_calls = 0;
+	TOGO_ASSERTE(parser::parse(s_statement, s, nullptr));
+	TOGO_ASSERTE(s_num_word_calls == 2);
+
+	s.cache = &cache;
+	parse_state::init(s);
+	s_num_word_calls = 0;
+	TOGO_ASSERTE(parser::parse(s_statement, s, nullptr));
+	TOGO_ASSERTE(s_num_word_calls == 1);
+	TOGO_ASSERTE(array::size(s.results) == 2);
+	TOGO_ASSERTE(string::compare_equal({s.results[0].s.b, s.results[0].s.e}, "abc"));
+
+	// Reparsing (even the same data) starts from an empty memo
+	parse_state::init(s);
+	s_num_word_calls = 0;
+	TOGO_ASSERTE(parser::parse(s_statement, s, nullptr));
+	TOGO_ASSERTE(s_num_word_calls == 1);
+	}
+	return 0;
+}
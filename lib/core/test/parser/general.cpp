@@ -22,6 +22,18 @@ static_assert(parser::sizeof_series(1) == sizeof(Parser*), "");
 static_assert(parser::sizeof_series(2) == sizeof(Parser*) * 2, "");
 static_assert(parser::sizeof_series(2, 2) == sizeof(Parser*) * 4 + sizeof(Parser) * 2, "");
 
+// Grammars can be built at compile time
+static constexpr Parser const s_ce_x{Char{'x'}};
+static constexpr Parser const s_ce_y{PMod::test, CharRange{'y', 'z'}};
+static Parser const* s_ce_series[]{&s_ce_x, &s_ce_y};
+static constexpr Parser const s_ce_any{"ce_any", PMod::repeat, Any{s_ce_series}};
+static constexpr Parser const s_ce_ref{Ref{s_ce_any}};
+static_assert(parser::type(s_ce_any) == ParserType::Any, "");
+static_assert(parser::modifiers(s_ce_any) == PMod::repeat, "");
+static_assert(s_ce_any.name_hash == "ce_any"_hash32, "");
+static_assert(s_ce_any.s.Any.num == 2, "");
+static_assert(s_ce_ref.s.Ref.p == &s_ce_any, "");
+
 ParseResultCode f_func_nop(Parser const*, ParseState& s, ParsePosition const&) {
 	return parse_state::ok(s);
 }
@@ -70,6 +82,11 @@ signed main() {
 	}
 }
 
+{
+	TOGO_ASSERTE(TEST_WHOLE(s_ce_ref, "xyzx"));
+	TOGO_ASSERTE(!TEST_WHOLE(s_ce_ref, "xyzw"));
+}
+
 {
 	Parser const p{PMod::maybe, Nothing{}};
 	TOGO_ASSERTE(modifiers(p) == PMod::maybe);
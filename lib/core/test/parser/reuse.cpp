@@ -0,0 +1,139 @@
+
+#include <togo/core/types.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/memory/fixed_allocator.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/string/string.hpp>
+#include <togo/core/system/system.hpp>
+#include <togo/core/parser/parser.hpp>
+#include <togo/core/parser/parse_state.hpp>
+
+#include <togo/support/test.hpp>
+
+#include "./common.hpp"
+
+#include <cstdlib>
+
+using namespace togo;
+
+// Counts calls to allocate()
+class CountingAllocator
+	: public Allocator
+{
+public:
+	Allocator& _allocator;
+	unsigned _num_calls;
+
+	CountingAllocator(Allocator& allocator)
+		: _allocator(allocator)
+		, _num_calls(0)
+	{}
+
+	unsigned num_allocations() const override {
+		return _allocator.num_allocations();
+	}
+
+	unsigned total_size() const override {
+		return _allocator.total_size();
+	}
+
+	unsigned allocation_size(void const* p) const override {
+		return _allocator.allocation_size(p);
+	}
+
+	void* allocate(unsigned size, unsigned align = DEFAULT_ALIGNMENT) override {
+		++_num_calls;
+		return _allocator.allocate(size, align);
+	}
+
+	void deallocate(void const* p) override {
+		_allocator.deallocate(p);
+	}
+};
+
+static FixedParserAllocator<5, 1> s_list_storage;
+static Parser const s_number{"number", Any{s_list_storage,
+	PDef::f64_exp,
+	PDef::s64_any
+}};
+static Parser const s_list{"list", All{s_list_storage,
+	PDef::whitespace_maybe,
+	Parser{PMod::repeat, All{s_list_storage,
+		s_number,
+		PDef::whitespace_maybe
+	}}
+}};
+
+static StringRef const s_inputs[]{
+	"1",
+	"1 2 3",
+	"1 -2 3.5 0x10 010 -0.25e2",
+	"1 2 3 4 5 6 7 8 9 10 11 12 13 14 15 16 17 18 19 20 21 22 23 24 25 26 27 28 29 30 31 32",
+	"0x1 0x2 0x3 0x4 0x5 0x6 0x7 0x8",
+};
+
+static unsigned const s_num_results[]{1, 3, 6, 32, 8};
+
+static void parse_all(ParseState& s) {
+	for (unsigned i = 0; i < array_extent(s_inputs); ++i) {
+		parse_state::reset(s, nullptr);
+		parse_state::set_data(s, s_inputs[i]);
+		TOGO_ASSERTE(parser::parse(s_list, s, nullptr));
+		TOGO_ASSERTE(array::size(s.results) == s_num_results[i]);
+	}
+}
+
+signed main(signed argc, char* argv[]) {
+	memory_init();
+
+#if defined(TOGO_DEBUG)
+	parser::s_debug_trace = false;
+#endif
+
+	{// Reused state does not allocate in steady-state
+	CountingAllocator allocator{memory::default_allocator()};
+	ParseState state{allocator};
+	parse_all(state);
+	TOGO_ASSERTE(allocator._num_calls > 0);
+	TOGO_ASSERTE(state.results_high_water == 32);
+
+	allocator._num_calls = 0;
+	parse_all(state);
+	TOGO_ASSERTE(allocator._num_calls == 0);
+
+	// A new state with a known high-water mark allocates once
+	CountingAllocator allocator_fresh{memory::default_allocator()};
+	ParseState state_fresh{allocator_fresh};
+	state_fresh.results_high_water = state.results_high_water;
+	parse_all(state_fresh);
+	TOGO_ASSERTE(allocator_fresh._num_calls == 1);
+	}
+
+	if (argc > 1) {
+		unsigned num = static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10));
+		num = num ? num : 10000;
+
+		f64 start = system::time_monotonic();
+		for (unsigned i = 0; i < num; ++i) {
+			ParseState state{memory::default_allocator()};
+			parse_all(state);
+		}
+		f64 const duration_fresh = system::time_monotonic() - start;
+
+		start = system::time_monotonic();
+		ParseState state{memory::default_allocator()};
+		for (unsigned i = 0; i < num; ++i) {
+			parse_all(state);
+		}
+		f64 const duration_reused = system::time_monotonic() - start;
+
+		TOGO_LOGF(
+			"num = %u  fresh = %.06lf  reused = %.06lf  ratio = %.03lf\n",
+			num, duration_fresh, duration_reused, duration_reused / duration_fresh
+		);
+	}
+	return 0;
+}
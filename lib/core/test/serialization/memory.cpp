@@ -0,0 +1,157 @@
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/string/string.hpp>
+#include <togo/core/system/system.hpp>
+#include <togo/core/io/io.hpp>
+#include <togo/core/io/memory_stream.hpp>
+#include <togo/core/serialization/serializer.hpp>
+#include <togo/core/serialization/support.hpp>
+#include <togo/core/serialization/binary_serializer.hpp>
+#include <togo/core/serialization/array.hpp>
+#include <togo/core/serialization/string.hpp>
+
+#include <togo/support/test.hpp>
+
+#include <cstdlib>
+#include <cstring>
+
+using namespace togo;
+
+struct Record {
+	u64 a;
+	u32 b;
+	s16 c;
+	u8 d;
+	f32 e[3];
+	char name[16];
+};
+
+template<class Ser>
+inline void
+serialize(serializer_tag, Ser& ser, Record& value_unsafe) {
+	auto& value = serializer_cast_safe<Ser>(value_unsafe);
+	ser
+		% value.a
+		% value.b
+		% value.c
+		% value.d
+		% make_ser_sequence(value.e, 3)
+		% make_ser_string<u8>(value.name)
+	;
+}
+
+static bool operator==(Record const& x, Record const& y) {
+	return
+		x.a == y.a &&
+		x.b == y.b &&
+		x.c == y.c &&
+		x.d == y.d &&
+		std::memcmp(x.e, y.e, sizeof(x.e)) == 0 &&
+		std::strcmp(x.name, y.name) == 0
+	;
+}
+
+static void fill(Array<Record>& records, unsigned size) {
+	array::resize(records, size);
+	for (unsigned i = 0; i < size; ++i) {
+		auto& r = records[i];
+		r.a = 0x0102030405060708 * (i + 1);
+		r.b = 0xA0B0C0D0 ^ i;
+		r.c = static_cast<s16>(-1 - static_cast<signed>(i));
+		r.d = static_cast<u8>(i);
+		r.e[0] = static_cast<f32>(i) * 0.5f;
+		r.e[1] = -1.0f;
+		r.e[2] = 1.0e10f;
+		string::copy(r.name, i & 1 ? StringRef{"odd"} : StringRef{"even"});
+	}
+}
+
+static void test_endian(Array<Record> const& records, Endian const endian) {
+	// Output matches the stream serializer byte for byte
+	MemoryStream stream{memory::default_allocator(), 1024};
+	BinaryOutputSerializer oser_stream{stream, endian};
+	oser_stream % make_ser_collection<u32>(records);
+
+	Array<u8> buffer{memory::default_allocator()};
+	BinaryMemoryOutputSerializer oser{buffer, endian};
+	oser % make_ser_collection<u32>(records);
+	TOGO_ASSERTE(array::size(buffer) == stream.size());
+	TOGO_ASSERTE(std::memcmp(
+		array::begin(buffer), array::begin(stream.data()), array::size(buffer)
+	) == 0);
+
+	// Appends
+	oser % u16{0xBEEF};
+	TOGO_ASSERTE(array::size(buffer) == stream.size() + 2);
+
+	Array<Record> value{memory::default_allocator()};
+	BinaryMemoryInputSerializer iser{buffer, endian};
+	iser % make_ser_collection<u32>(value);
+	TOGO_ASSERTE(array::size(value) == array::size(records));
+	for (unsigned i = 0; i < array::size(records); ++i) {
+		TOGO_ASSERTE(value[i] == records[i]);
+	}
+	u16 tail = 0;
+	iser % tail;
+	TOGO_ASSERTE(tail == 0xBEEF);
+	TOGO_ASSERTE(iser._position == iser._end);
+
+	// Buffer and explicit sequence
+	u8 const bytes[]{1, 2, 3, 4, 5};
+	u8 bytes_in[array_extent(bytes)]{};
+	array::clear(buffer);
+	oser % make_ser_buffer(bytes, 2) % make_ser_sequence(bytes + 2, 3);
+	BinaryMemoryInputSerializer iser_bytes{buffer, endian};
+	iser_bytes % make_ser_buffer(bytes_in, 2) % make_ser_sequence(bytes_in + 2, 3);
+	TOGO_ASSERTE(std::memcmp(bytes, bytes_in, sizeof(bytes)) == 0);
+}
+
+signed main(signed argc, char* argv[]) {
+	memory_init();
+
+	auto const endian_foreign = Endian::system == Endian::little
+		? Endian::big
+		: Endian::little
+	;
+
+	Array<Record> records{memory::default_allocator()};
+	fill(records, 0);
+	test_endian(records, Endian::system);
+	fill(records, 100);
+	test_endian(records, Endian::system);
+	test_endian(records, endian_foreign);
+
+	if (argc > 1) {
+		unsigned num = static_cast<unsigned>(std::strtoul(argv[1], nullptr, 10));
+		num = num ? num : 100;
+		fill(records, 10000);
+
+		Array<u8> buffer{memory::default_allocator()};
+		BinaryMemoryOutputSerializer oser{buffer};
+		oser % make_ser_collection<u32>(records);
+		Array<Record> value{memory::default_allocator()};
+
+		f64 start = system::time_monotonic();
+		for (unsigned i = 0; i < num; ++i) {
+			MemoryReader stream{buffer};
+			BinaryInputSerializer iser{stream};
+			iser % make_ser_collection<u32>(value);
+		}
+		f64 const duration_stream = system::time_monotonic() - start;
+
+		start = system::time_monotonic();
+		for (unsigned i = 0; i < num; ++i) {
+			BinaryMemoryInputSerializer iser{buffer};
+			iser % make_ser_collection<u32>(value);
+		}
+		f64 const duration_memory = system::time_monotonic() - start;
+
+		TOGO_LOGF(
+			"num = %u  stream = %.06lf  memory = %.06lf  ratio = %.03lf\n",
+			num, duration_stream, duration_memory, duration_memory / duration_stream
+		);
+	}
+	return 0;
+}
@@ -0,0 +1,110 @@
+#include <togo/core/error/assert.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/string/string.hpp>
+#include <togo/core/threading/thread.hpp>
+#include <togo/core/io/memory_stream.hpp>
+#include <togo/core/trace/trace.hpp>
+
+#include <togo/support/test.hpp>
+
+#include <cstring>
+
+using namespace togo;
+
+enum : unsigned {
+	NUM_THREADS = 4,
+	NUM_ITERATIONS = 100,
+};
+
+static void* trace_func(void* call_data) {
+	unsigned const index = *static_cast<unsigned*>(call_data);
+	for (unsigned i = 0; i < NUM_ITERATIONS; ++i) {
+		TOGO_TRACE_ZONE("outer");
+		{
+			TOGO_TRACE_ZONE("inner \"quoted\"");
+			TOGO_TRACE_FLOW_END("flow", index * NUM_ITERATIONS + i);
+		}
+		TOGO_TRACE_COUNTER("counter", i);
+	}
+	return nullptr;
+}
+
+static unsigned count(StringRef const& data, StringRef const& what) {
+	unsigned n = 0;
+	for (unsigned i = 0; i + what.size <= data.size; ++i) {
+		if (std::memcmp(data.data + i, what.data, what.size) == 0) {
+			++n;
+		}
+	}
+	return n;
+}
+
+signed main() {
+	memory_init();
+
+	// Not recording
+	{
+		TOGO_TRACE_ZONE("ignored");
+		TOGO_TRACE_COUNTER("ignored", 1);
+	}
+	TOGO_ASSERTE(!trace::is_recording());
+	TOGO_ASSERTE(trace::num_events() == 0);
+
+	// Small chunks to exercise chunk growth
+	trace::start(4);
+	TOGO_ASSERTE(trace::is_recording());
+	unsigned indices[NUM_THREADS];
+	Thread* threads[NUM_THREADS];
+	for (unsigned i = 0; i < NUM_THREADS; ++i) {
+		indices[i] = i;
+		for (unsigned j = 0; j < NUM_ITERATIONS; ++j) {
+			TOGO_TRACE_FLOW_BEGIN("flow", i * NUM_ITERATIONS + j);
+		}
+		threads[i] = thread::create("trace-test", &indices[i], trace_func);
+	}
+	for (auto t : threads) {
+		thread::join(t);
+	}
+	trace::stop();
+
+	{// Stopped
+		TOGO_TRACE_ZONE("ignored");
+	}
+	unsigned const num_expected = NUM_THREADS * NUM_ITERATIONS * 5;
+	TOGO_ASSERTE(trace::num_events() == num_expected);
+
+	MemoryStream stream{memory::default_allocator(), 4096};
+	TOGO_ASSERTE(trace::write_chrome(stream));
+	StringRef const data{
+		reinterpret_cast<char const*>(array::begin(stream.data())),
+		static_cast<unsigned>(stream.size())
+	};
+	TOGO_ASSERTE(count(data, "\"ph\":\"X\"") == NUM_THREADS * NUM_ITERATIONS * 2);
+	TOGO_ASSERTE(count(data, "\"ph\":\"C\"") == NUM_THREADS * NUM_ITERATIONS);
+	TOGO_ASSERTE(count(data, "\"ph\":\"s\"") == NUM_THREADS * NUM_ITERATIONS);
+	TOGO_ASSERTE(count(data, "\"ph\":\"f\"") == NUM_THREADS * NUM_ITERATIONS);
+	TOGO_ASSERTE(count(data, "\"name\":\"thread_name\"") == 1 + NUM_THREADS);
+	TOGO_ASSERTE(count(data, "inner \\\"quoted\\\"") == NUM_THREADS * NUM_ITERATIONS);
+	TOGO_ASSERTE(count(data, "ignored") == 0);
+	TOGO_ASSERTE(count(data, "{") == count(data, "}"));
+	TOGO_ASSERTE(count(data, "[") == 1 && count(data, "]") == 1);
+
+	// Restarting keeps recorded events
+	trace::start();
+	TOGO_TRACE_COUNTER("counter", 1);
+	trace::stop();
+	TOGO_ASSERTE(trace::num_events() == num_expected + 1);
+
+	trace::clear();
+	TOGO_ASSERTE(trace::num_events() == 0);
+
+	trace::start();
+	{
+		TOGO_TRACE_ZONE("after clear");
+	}
+	trace::stop();
+	TOGO_ASSERTE(trace::num_events() == 1);
+	trace::clear();
+	return 0;
+}
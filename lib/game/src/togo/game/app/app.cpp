@@ -13,8 +13,10 @@
 #include <togo/window/input/input_buffer.hpp>
 #include <togo/game/entity/entity_manager.hpp>
 #include <togo/game/world/world_manager.hpp>
+#include <togo/game/world/system_scheduler.hpp>
 #include <togo/game/gfx/gfx.hpp>
 #include <togo/game/gfx/renderer.hpp>
+#include <togo/game/gfx/render_object_set.hpp>
 #include <togo/game/resource/resource_handler.hpp>
 #include <togo/game/resource/resource_manager.hpp>
 #include <togo/game/app/types.hpp>
@@ -60,6 +62,7 @@ AppBase::AppBase(
 	)
 	, entity_manager(memory::default_allocator())
 	, world_manager(memory::default_allocator())
+	, system_scheduler(memory::default_allocator())
 	, window(nullptr)
 	, input_buffer(memory::default_allocator())
 	, renderer(nullptr)
@@ -113,6 +116,7 @@ void app::actual_init(AppBase& app) {
 	resource_handler::register_render_config(app.resource_manager, app.renderer);
 
 	// Register components
+	gfx::render_object_set::register_component_manager(app.world_manager);
 	//components::register_transform3d(app.world_manager);
 	//components::register_mesh(app.world_manager);
 	//components::register_camera(app.world_manager);
@@ -129,6 +133,7 @@ void app::shutdown() {
 	TOGO_LOG("App: shutting down\n");
 	app._func_shutdown(app);
 
+	system_scheduler::clear(app.system_scheduler);
 	world_manager::shutdown(app.world_manager);
 	entity_manager::shutdown(app.entity_manager);
 
@@ -176,6 +181,7 @@ void app::update(AppBase& app, f32 dt) {
 		}
 	}
 	app._func_update(app, dt);
+	system_scheduler::update(app.system_scheduler, &app.task_manager, dt);
 }
 
 IGEN_PRIVATE
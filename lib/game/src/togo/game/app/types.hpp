@@ -62,6 +62,7 @@ struct AppBase {
 	ResourceManager resource_manager;
 	EntityManager entity_manager;
 	WorldManager world_manager;
+	SystemScheduler system_scheduler;
 
 	Window* window;
 	InputBuffer input_buffer;
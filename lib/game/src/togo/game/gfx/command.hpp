@@ -36,6 +36,8 @@ enum class CmdType : u8 {
 	RenderFullscreenPass,
 	RenderBuffers,
 	RenderWorld,
+	RenderBuffersInstanced,
+	RenderBuffersIndirect,
 };
 
 template<class T>
@@ -72,6 +74,26 @@ TOGO_GFX_CMD(RenderBuffers) {
 	gfx::BufferBindingID const* buffers;
 };
 
+/// renderer::render_buffers_instanced() command.
+TOGO_GFX_CMD(RenderBuffersInstanced) {
+	gfx::ShaderID shader_id;
+	u32 num_draw_param_blocks;
+	u32 num_instances;
+	gfx::ParamBlockBinding const* draw_param_blocks;
+	gfx::BufferBindingID buffer;
+};
+
+/// renderer::render_buffers_indirect() command.
+TOGO_GFX_CMD(RenderBuffersIndirect) {
+	gfx::ShaderID shader_id;
+	u32 num_draw_param_blocks;
+	u32 num_draws;
+	gfx::ParamBlockBinding const* draw_param_blocks;
+	gfx::BufferBindingID buffer;
+	gfx::BufferID indirect_buffer;
+	u32 indirect_offset;
+};
+
 /// renderer::render_world() command.
 TOGO_GFX_CMD(RenderWorld) {
 	WorldID world_id;
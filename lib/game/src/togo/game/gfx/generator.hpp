@@ -30,6 +30,7 @@ namespace generator {
 
 extern gfx::GeneratorDef const clear;
 extern gfx::GeneratorDef const fullscreen_pass;
+extern gfx::GeneratorDef const instanced_objects;
 
 /** @} */ // end of doc-group lib_game_gfx_generator
 
@@ -0,0 +1,219 @@
+#line 2 "togo/game/gfx/generator/gen_instanced_objects.cpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#include <togo/game/config.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/algorithm/sort.hpp>
+#include <togo/core/hash/hash.hpp>
+#include <togo/core/serialization/serializer.hpp>
+#include <togo/core/serialization/support.hpp>
+#include <togo/core/serialization/binary_serializer.hpp>
+#include <togo/game/gfx/generator.hpp>
+#include <togo/game/gfx/render_node.hpp>
+#include <togo/game/gfx/renderer.hpp>
+#include <togo/game/resource/resource_handler.hpp>
+#include <togo/game/app/app.hpp>
+
+namespace togo {
+namespace game {
+namespace gfx {
+
+namespace generator {
+namespace gen_instanced_objects {
+
+enum : unsigned {
+	BLOCK_SIZE = TOGO_GFX_INSTANCED_BATCH_SIZE * sizeof(Mat4x4),
+};
+
+struct UnitData {
+	ResourceNameHash shader_name_hash;
+	gfx::ShaderID shader_id;
+	gfx::BufferID buffer_id;
+	// Batches used in the current frame. A unit can run more than once
+	// per frame, and each run takes the next batches of the frame
+	// region.
+	u32 frame;
+	unsigned num_batches;
+	gfx::ParamBlockBinding batches[TOGO_GFX_INSTANCED_NUM_BATCHES];
+};
+
+struct DefData {
+	gfx::Renderer* renderer;
+	Array<UnitData> unit_storage;
+	Array<gfx::RenderObject const*> sorted;
+	Array<gfx::RenderObject const*> sorted_swap;
+};
+
+namespace {
+struct ObjectBindingKeyFunc {
+	inline u32 operator()(gfx::RenderObject const* const object) const noexcept {
+		return object->binding._value;
+	}
+};
+} // anonymous namespace
+
+static void destroy_units(
+	DefData* def_data,
+	gfx::Renderer* renderer
+) {
+	auto& app = app::instance();
+	for (auto& unit_data : def_data->unit_storage) {
+		resource::unref_shader(app.resource_manager, unit_data.shader_name_hash);
+		gfx::renderer::destroy_buffer(renderer, unit_data.buffer_id);
+	}
+}
+
+static void init(
+	gfx::GeneratorDef& def,
+	gfx::Renderer* renderer
+) {
+	if (!def.data) {
+		def.data = TOGO_CONSTRUCT(
+			memory::default_allocator(), DefData, {
+			renderer,
+			{memory::default_allocator()},
+			{memory::default_allocator()},
+			{memory::default_allocator()}
+		});
+	} else {
+		// Reinitialization
+		auto def_data = static_cast<DefData*>(def.data);
+		destroy_units(def_data, renderer);
+		array::clear(def_data->unit_storage);
+	}
+}
+
+static void destroy(
+	gfx::GeneratorDef const& def,
+	gfx::Renderer* renderer
+) {
+	auto def_data = static_cast<DefData*>(def.data);
+	destroy_units(def_data, renderer);
+	TOGO_DESTROY(memory::default_allocator(), def_data);
+}
+
+// Objects are grouped by buffer binding and their transforms are
+// written to the current frame region of the unit's buffer. Each
+// batch is a single instanced draw of up to
+// TOGO_GFX_INSTANCED_BATCH_SIZE objects; the shader indexes the
+// draw parameter block by gl_InstanceID. A frame has at most
+// TOGO_GFX_INSTANCED_NUM_BATCHES batches across all runs of the unit.
+static void exec(
+	gfx::GeneratorUnit const& unit,
+	gfx::RenderNode& node,
+	gfx::RenderObject const* const objects_begin,
+	gfx::RenderObject const* const objects_end
+) {
+	auto def_data = static_cast<DefData*>(unit.data);
+	auto& data = def_data->unit_storage[unit.data_index];
+	auto* const renderer = def_data->renderer;
+	unsigned const num_objects = objects_end - objects_begin;
+	if (num_objects == 0) {
+		return;
+	}
+
+	{// Sort by buffer binding
+	auto& sorted = def_data->sorted;
+	array::resize(sorted, num_objects);
+	array::resize(def_data->sorted_swap, num_objects);
+	for (unsigned i = 0; i < num_objects; ++i) {
+		sorted[i] = objects_begin + i;
+	}
+	sort_radix_k32(
+		array::begin(sorted), array::begin(def_data->sorted_swap),
+		num_objects,
+		ObjectBindingKeyFunc{}
+	);}
+
+	u32 const frame = gfx::renderer::num_frames(renderer);
+	if (data.frame != frame) {
+		data.frame = frame;
+		data.num_batches = 0;
+	}
+	auto* const region = gfx::renderer::buffer_region(renderer, data.buffer_id);
+	auto const* it = array::begin(def_data->sorted);
+	auto const* const end = array::end(def_data->sorted);
+	gfx::CmdRenderBuffersInstanced cmd;
+	cmd.shader_id = data.shader_id;
+	cmd.num_draw_param_blocks = 1;
+	for (; it != end; ++data.num_batches) {
+		unsigned const batch = data.num_batches;
+		if (batch == TOGO_GFX_INSTANCED_NUM_BATCHES) {
+			TOGO_LOG_ERRORF(
+				"instanced_objects: dropped %u objects; the frame's %u batches are used up\n",
+				static_cast<unsigned>(end - it),
+				unsigned{TOGO_GFX_INSTANCED_NUM_BATCHES}
+			);
+			break;
+		}
+		unsigned const offset = gfx::renderer::param_block_offset(renderer, batch, BLOCK_SIZE);
+		auto* const transforms = static_cast<Mat4x4*>(pointer_add(region, offset));
+		cmd.buffer = (*it)->binding;
+		cmd.num_instances = 0;
+		do {
+			transforms[cmd.num_instances++] = (*it)->transform;
+			++it;
+		} while (
+			it != end &&
+			(*it)->binding._value == cmd.buffer._value &&
+			cmd.num_instances < TOGO_GFX_INSTANCED_BATCH_SIZE
+		);
+		data.batches[batch] = gfx::renderer::make_param_block_binding(
+			renderer, data.buffer_id, offset, BLOCK_SIZE
+		);
+		cmd.draw_param_blocks = &data.batches[batch];
+		gfx::render_node::push(node, 0, cmd);
+	}
+}
+
+static void read(
+	gfx::GeneratorDef const& def,
+	gfx::Renderer* renderer,
+	BinaryInputSerializer& ser,
+	gfx::GeneratorUnit& unit
+) {
+	auto& app = app::instance();
+	auto def_data = static_cast<DefData*>(def.data);
+
+	UnitData unit_data;
+	unit_data.frame = ~u32{0};
+	unit_data.num_batches = 0;
+	ser % unit_data.shader_name_hash;
+	unit_data.shader_id = resource::ref_shader(
+		app.resource_manager, unit_data.shader_name_hash
+	);
+	unit_data.buffer_id = gfx::renderer::create_buffer(
+		renderer,
+		gfx::renderer::param_block_buffer_size(
+			renderer, TOGO_GFX_INSTANCED_NUM_BATCHES, BLOCK_SIZE
+		),
+		nullptr,
+		gfx::BufferDataBinding::persistent
+	);
+
+	unit.data = def_data;
+	unit.data_index = array::size(def_data->unit_storage);
+	array::push_back(def_data->unit_storage, unit_data);
+}
+
+} // namespace gen_instanced_objects
+} // namespace generator
+
+gfx::GeneratorDef const generator::instanced_objects{
+	"instanced_objects"_generator_name,
+	nullptr,
+	generator::gen_instanced_objects::init,
+	generator::gen_instanced_objects::destroy,
+	generator::gen_instanced_objects::read,
+	generator::gen_instanced_objects::exec
+};
+
+} // namespace gfx
+} // namespace game
+} // namespace togo
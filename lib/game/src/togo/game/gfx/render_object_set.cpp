@@ -0,0 +1,578 @@
+#line 2 "togo/game/gfx/render_object_set.cpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#include <togo/game/config.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/math/vector/4.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/collection/hash_map.hpp>
+#include <togo/core/algorithm/sort.hpp>
+#include <togo/core/threading/task_manager.hpp>
+#include <togo/game/world/types.hpp>
+#include <togo/game/world/world_manager.hpp>
+#include <togo/game/gfx/types.hpp>
+#include <togo/game/gfx/render_object_set.hpp>
+
+#include <cmath>
+#include <cstring>
+
+#if defined(TOGO_ARCH_X86_64)
+	#include <xmmintrin.h>
+#endif
+
+namespace togo {
+namespace game {
+namespace gfx {
+
+RenderObjectSet::RenderObjectSet(
+	Allocator& allocator
+)
+	: _dirty(false)
+	, _indices(allocator)
+	, _entities(allocator)
+	, _objects(allocator)
+	, _center_x(allocator)
+	, _center_y(allocator)
+	, _center_z(allocator)
+	, _radius(allocator)
+	, _cells(allocator)
+	, _cameras(allocator)
+	, visible(allocator)
+{}
+
+namespace {
+
+enum : s32 {
+	CELL_COORD_BITS = 10,
+	CELL_COORD_BIAS = 1 << (CELL_COORD_BITS - 1),
+	CELL_COORD_MAX = (1 << CELL_COORD_BITS) - 1,
+};
+
+enum : unsigned {
+	CELL_OUTSIDE,
+	CELL_INTERSECTS,
+	CELL_INSIDE,
+};
+
+struct KeyIndex {
+	u32 key;
+	u32 index;
+};
+
+struct KeyIndexKeyFunc {
+	inline u32 operator()(KeyIndex const& ki) const noexcept {
+		return ki.key;
+	}
+};
+
+struct CullTask {
+	gfx::RenderObjectSet* set;
+	gfx::Frustum const* frustum;
+	u32 cell_begin;
+	u32 cell_end;
+	u32 num_visible;
+};
+
+} // anonymous namespace
+
+inline static u32 cell_coord(f32 const v) {
+	s32 const c = static_cast<s32>(
+		std::floor(v * (1.0f / TOGO_GFX_CULL_CELL_SIZE))
+	) + CELL_COORD_BIAS;
+	return static_cast<u32>(clamp<s32>(c, 0, CELL_COORD_MAX));
+}
+
+inline static u32 cell_key(f32 const x, f32 const y, f32 const z) {
+	return
+		(cell_coord(x)) |
+		(cell_coord(y) << CELL_COORD_BITS) |
+		(cell_coord(z) << (CELL_COORD_BITS << 1))
+	;
+}
+
+inline static void cell_expand(
+	gfx::RenderObjectSet::Cell& cell,
+	f32 const x, f32 const y, f32 const z,
+	f32 const r
+) {
+	cell.min.x = std::fmin(cell.min.x, x - r);
+	cell.min.y = std::fmin(cell.min.y, y - r);
+	cell.min.z = std::fmin(cell.min.z, z - r);
+	cell.max.x = std::fmax(cell.max.x, x + r);
+	cell.max.y = std::fmax(cell.max.y, y + r);
+	cell.max.z = std::fmax(cell.max.z, z + r);
+}
+
+static gfx::RenderObjectSet::Cell& find_cell(
+	gfx::RenderObjectSet& set,
+	unsigned const index
+) {
+	unsigned low = 0;
+	unsigned high = array::size(set._cells);
+	while (low + 1 < high) {
+		unsigned const mid = (low + high) >> 1;
+		if (set._cells[mid].begin <= index) {
+			low = mid;
+		} else {
+			high = mid;
+		}
+	}
+	auto& cell = set._cells[low];
+	TOGO_DEBUG_ASSERTE(cell.begin <= index && index < cell.end);
+	return cell;
+}
+
+template<class T>
+static void permute(Array<T>& a, Array<KeyIndex> const& order) {
+	Array<T> source{memory::scratch_allocator()};
+	array::copy(source, a);
+	for (unsigned i = 0; i < array::size(a); ++i) {
+		a[i] = source[order[i].index];
+	}
+}
+
+static unsigned test_cell(
+	gfx::RenderObjectSet::Cell const& cell,
+	gfx::Frustum const& frustum
+) {
+	unsigned result = CELL_INSIDE;
+	for (auto const& p : frustum.planes) {
+		// Vertices of the box farthest along and against the plane normal
+		f32 const d_far
+			= p.x * (p.x >= 0.0f ? cell.max.x : cell.min.x)
+			+ p.y * (p.y >= 0.0f ? cell.max.y : cell.min.y)
+			+ p.z * (p.z >= 0.0f ? cell.max.z : cell.min.z)
+			+ p.w
+		;
+		if (d_far < 0.0f) {
+			return CELL_OUTSIDE;
+		}
+		f32 const d_near
+			= p.x * (p.x >= 0.0f ? cell.min.x : cell.max.x)
+			+ p.y * (p.y >= 0.0f ? cell.min.y : cell.max.y)
+			+ p.z * (p.z >= 0.0f ? cell.min.z : cell.max.z)
+			+ p.w
+		;
+		if (d_near < 0.0f) {
+			result = CELL_INTERSECTS;
+		}
+	}
+	return result;
+}
+
+static unsigned cull_spheres(
+	gfx::RenderObjectSet const& set,
+	gfx::Frustum const& frustum,
+	unsigned i,
+	unsigned const end,
+	gfx::RenderObject* const out
+) {
+	auto const* const objects = array::begin(set._objects);
+	auto const* const cx = array::begin(set._center_x);
+	auto const* const cy = array::begin(set._center_y);
+	auto const* const cz = array::begin(set._center_z);
+	auto const* const cr = array::begin(set._radius);
+	unsigned num_visible = 0;
+
+#if defined(TOGO_ARCH_X86_64)
+	__m128 px[gfx::Frustum::NUM_PLANES];
+	__m128 py[gfx::Frustum::NUM_PLANES];
+	__m128 pz[gfx::Frustum::NUM_PLANES];
+	__m128 pw[gfx::Frustum::NUM_PLANES];
+	for (unsigned p = 0; p < gfx::Frustum::NUM_PLANES; ++p) {
+		px[p] = _mm_set1_ps(frustum.planes[p].x);
+		py[p] = _mm_set1_ps(frustum.planes[p].y);
+		pz[p] = _mm_set1_ps(frustum.planes[p].z);
+		pw[p] = _mm_set1_ps(frustum.planes[p].w);
+	}
+	__m128 const zero = _mm_setzero_ps();
+	for (; i + 4 <= end; i += 4) {
+		__m128 const x = _mm_loadu_ps(cx + i);
+		__m128 const y = _mm_loadu_ps(cy + i);
+		__m128 const z = _mm_loadu_ps(cz + i);
+		__m128 const neg_r = _mm_sub_ps(zero, _mm_loadu_ps(cr + i));
+		__m128 inside = _mm_cmpeq_ps(zero, zero);
+		for (unsigned p = 0; p < gfx::Frustum::NUM_PLANES; ++p) {
+			__m128 const d = _mm_add_ps(
+				_mm_add_ps(_mm_mul_ps(px[p], x), _mm_mul_ps(py[p], y)),
+				_mm_add_ps(_mm_mul_ps(pz[p], z), pw[p])
+			);
+			inside = _mm_and_ps(inside, _mm_cmpge_ps(d, neg_r));
+		}
+		unsigned const mask = static_cast<unsigned>(_mm_movemask_ps(inside));
+		for (unsigned k = 0; k < 4; ++k) {
+			if (mask & (1 << k)) {
+				out[num_visible++] = objects[i + k];
+			}
+		}
+	}
+#endif
+
+	bool inside;
+	for (; i < end; ++i) {
+		inside = true;
+		for (auto const& p : frustum.planes) {
+			if (p.x * cx[i] + p.y * cy[i] + p.z * cz[i] + p.w < -cr[i]) {
+				inside = false;
+				break;
+			}
+		}
+		if (inside) {
+			out[num_visible++] = objects[i];
+		}
+	}
+	return num_visible;
+}
+
+// Writes visible objects from cells [cell_begin, cell_end) to the
+// visible array starting at the first object of cell_begin
+static unsigned cull_cells(
+	gfx::RenderObjectSet& set,
+	gfx::Frustum const& frustum,
+	unsigned const cell_begin,
+	unsigned const cell_end
+) {
+	auto* const out = array::begin(set.visible) + set._cells[cell_begin].begin;
+	unsigned num_visible = 0;
+	for (auto const& cell : array_ref(array::begin(set._cells) + cell_begin, cell_end - cell_begin)) {
+		switch (test_cell(cell, frustum)) {
+		case CELL_OUTSIDE:
+			break;
+
+		case CELL_INSIDE:
+			std::memcpy(
+				out + num_visible,
+				array::begin(set._objects) + cell.begin,
+				(cell.end - cell.begin) * sizeof(gfx::RenderObject)
+			);
+			num_visible += cell.end - cell.begin;
+			break;
+
+		case CELL_INTERSECTS:
+			num_visible += cull_spheres(
+				set, frustum, cell.begin, cell.end, out + num_visible
+			);
+			break;
+		}
+	}
+	return num_visible;
+}
+
+static void cull_task_func(TaskID /*task_id*/, void* task_data) {
+	auto& task = *static_cast<CullTask*>(task_data);
+	task.num_visible = cull_cells(*task.set, *task.frustum, task.cell_begin, task.cell_end);
+}
+
+static void* create_component_manager(WorldManager& /*world_manager*/) {
+	return TOGO_CONSTRUCT(
+		memory::default_allocator(), gfx::RenderObjectSet,
+		memory::default_allocator()
+	);
+}
+
+static void destroy_component_manager(WorldManager& /*world_manager*/, void* data) {
+	TOGO_DESTROY(memory::default_allocator(), static_cast<gfx::RenderObjectSet*>(data));
+}
+
+static void clear_component_manager(WorldManager& /*world_manager*/, void* data) {
+	render_object_set::clear(*static_cast<gfx::RenderObjectSet*>(data));
+}
+
+/// Register the render object set component manager.
+void render_object_set::register_component_manager(WorldManager& world_manager) {
+	world_manager::register_component_manager(world_manager, ComponentManagerDef{
+		render_object_set::COMPONENT_NAME,
+		create_component_manager,
+		destroy_component_manager,
+		clear_component_manager
+	});
+}
+
+/// Whether an entity has a render object.
+bool render_object_set::has(
+	gfx::RenderObjectSet const& set,
+	EntityID const entity_id
+) {
+	return hash_map::has(set._indices, entity_id.value);
+}
+
+/// Add a render object for an entity.
+///
+/// center and radius define the bounding sphere of the object in
+/// world space.
+/// An assertion will fail if the entity already has a render object.
+void render_object_set::add(
+	gfx::RenderObjectSet& set,
+	EntityID const entity_id,
+	gfx::RenderObject const& object,
+	Vec3 const& center,
+	f32 const radius
+) {
+	TOGO_ASSERT(
+		!hash_map::has(set._indices, entity_id.value),
+		"entity already has a render object"
+	);
+	hash_map::push(set._indices, entity_id.value, static_cast<u32>(array::size(set._objects)));
+	array::push_back(set._entities, entity_id);
+	array::push_back(set._objects, object);
+	array::push_back(set._center_x, center.x);
+	array::push_back(set._center_y, center.y);
+	array::push_back(set._center_z, center.z);
+	array::push_back(set._radius, radius);
+	set._dirty = true;
+}
+
+/// Update the transform and bounding sphere center of an entity's
+/// render object.
+///
+/// An assertion will fail if the entity does not have a render object.
+void render_object_set::update(
+	gfx::RenderObjectSet& set,
+	EntityID const entity_id,
+	Mat4x4 const& transform,
+	Vec3 const& center
+) {
+	u32 const* const index = hash_map::find(set._indices, entity_id.value);
+	TOGO_ASSERT(index, "entity does not have a render object");
+	unsigned const i = *index;
+	set._objects[i].transform = transform;
+	if (!set._dirty) {
+		if (
+			cell_key(set._center_x[i], set._center_y[i], set._center_z[i]) ==
+			cell_key(center.x, center.y, center.z)
+		) {
+			// Still in the same cell; only its bounds need to grow
+			cell_expand(find_cell(set, i), center.x, center.y, center.z, set._radius[i]);
+		} else {
+			set._dirty = true;
+		}
+	}
+	set._center_x[i] = center.x;
+	set._center_y[i] = center.y;
+	set._center_z[i] = center.z;
+}
+
+/// Remove an entity's render object.
+///
+/// An assertion will fail if the entity does not have a render object.
+void render_object_set::remove(
+	gfx::RenderObjectSet& set,
+	EntityID const entity_id
+) {
+	u32 const* const index = hash_map::find(set._indices, entity_id.value);
+	TOGO_ASSERT(index, "entity does not have a render object");
+	unsigned const i = *index;
+	hash_map::remove(set._indices, entity_id.value);
+	unsigned const last = array::size(set._objects) - 1;
+	if (i != last) {
+		set._entities[i] = set._entities[last];
+		set._objects[i] = set._objects[last];
+		set._center_x[i] = set._center_x[last];
+		set._center_y[i] = set._center_y[last];
+		set._center_z[i] = set._center_z[last];
+		set._radius[i] = set._radius[last];
+		hash_map::set(set._indices, set._entities[i].value, i);
+	}
+	array::pop_back(set._entities);
+	array::pop_back(set._objects);
+	array::pop_back(set._center_x);
+	array::pop_back(set._center_y);
+	array::pop_back(set._center_z);
+	array::pop_back(set._radius);
+	set._dirty = true;
+}
+
+/// Set an entity's camera.
+void render_object_set::set_camera(
+	gfx::RenderObjectSet& set,
+	EntityID const entity_id,
+	gfx::Camera const& camera
+) {
+	hash_map::set(set._cameras, entity_id.value, camera);
+}
+
+/// Remove an entity's camera.
+void render_object_set::remove_camera(
+	gfx::RenderObjectSet& set,
+	EntityID const entity_id
+) {
+	hash_map::remove(set._cameras, entity_id.value);
+}
+
+/// Camera for an entity.
+///
+/// Returns nullptr if the entity does not have a camera.
+gfx::Camera const* render_object_set::camera(
+	gfx::RenderObjectSet const& set,
+	EntityID const entity_id
+) {
+	return hash_map::find(set._cameras, entity_id.value);
+}
+
+/// Remove all render objects and cameras.
+void render_object_set::clear(gfx::RenderObjectSet& set) {
+	hash_map::clear(set._indices);
+	array::clear(set._entities);
+	array::clear(set._objects);
+	array::clear(set._center_x);
+	array::clear(set._center_y);
+	array::clear(set._center_z);
+	array::clear(set._radius);
+	array::clear(set._cells);
+	hash_map::clear(set._cameras);
+	array::clear(set.visible);
+	set._dirty = false;
+}
+
+/// Rebuild the grid if objects were added, removed, or moved across
+/// cells.
+///
+/// This is called by cull().
+void render_object_set::build(gfx::RenderObjectSet& set) {
+	if (!set._dirty) {
+		return;
+	}
+	unsigned const num_objects = array::size(set._objects);
+
+	{// Order objects by cell
+	Array<KeyIndex> order{memory::scratch_allocator()};
+	Array<KeyIndex> order_swap{memory::scratch_allocator()};
+	array::resize(order, num_objects);
+	array::resize(order_swap, num_objects);
+	for (unsigned i = 0; i < num_objects; ++i) {
+		order[i] = {
+			cell_key(set._center_x[i], set._center_y[i], set._center_z[i]),
+			i
+		};
+	}
+	sort_radix_k32(
+		array::begin(order), array::begin(order_swap),
+		num_objects,
+		KeyIndexKeyFunc{}
+	);
+	permute(set._entities, order);
+	permute(set._objects, order);
+	permute(set._center_x, order);
+	permute(set._center_y, order);
+	permute(set._center_z, order);
+	permute(set._radius, order);
+	}
+
+	{// Rebuild indices and cells
+	hash_map::clear(set._indices);
+	array::clear(set._cells);
+	u32 key;
+	u32 prev_key = 0;
+	for (unsigned i = 0; i < num_objects; ++i) {
+		hash_map::push(set._indices, set._entities[i].value, i);
+		key = cell_key(set._center_x[i], set._center_y[i], set._center_z[i]);
+		if (i == 0 || key != prev_key) {
+			array::push_back(set._cells, gfx::RenderObjectSet::Cell{
+				Vec3{set._center_x[i], set._center_y[i], set._center_z[i]}, i,
+				Vec3{set._center_x[i], set._center_y[i], set._center_z[i]}, i
+			});
+			prev_key = key;
+		}
+		auto& cell = array::back(set._cells);
+		cell_expand(cell, set._center_x[i], set._center_y[i], set._center_z[i], set._radius[i]);
+		cell.end = i + 1;
+	}}
+	set._dirty = false;
+}
+
+/// Cull objects against a frustum.
+///
+/// Visible objects are written to set.visible. Returns the number of
+/// visible objects.
+///
+/// If task_manager is non-null and the set is large enough, cells are
+/// split into ranges and culled in parallel.
+unsigned render_object_set::cull(
+	gfx::RenderObjectSet& set,
+	gfx::Frustum const& frustum,
+	TaskManager* const task_manager IGEN_DEFAULT(nullptr)
+) {
+	render_object_set::build(set);
+	unsigned const num_objects = array::size(set._objects);
+	unsigned const num_cells = array::size(set._cells);
+	array::resize(set.visible, num_objects);
+	unsigned num_visible = 0;
+	unsigned const num_tasks = min<unsigned>(
+		TOGO_GFX_CULL_NUM_TASKS, num_objects / TOGO_GFX_CULL_TASK_SIZE
+	);
+	if (num_cells == 0) {
+		// Nothing to do
+	} else if (!task_manager || num_tasks <= 1) {
+		num_visible = cull_cells(set, frustum, 0, num_cells);
+	} else {
+		CullTask tasks[TOGO_GFX_CULL_NUM_TASKS];
+		unsigned num_ranges = 0;
+
+		{// Split cells into ranges of roughly equal object count
+		unsigned const range_size = num_objects / num_tasks;
+		unsigned cell_begin = 0;
+		for (unsigned c = 0; c < num_cells; ++c) {
+			if (
+				c + 1 == num_cells || (
+					num_ranges + 1 < num_tasks &&
+					set._cells[c].end - set._cells[cell_begin].begin >= range_size
+				)
+			) {
+				tasks[num_ranges++] = {&set, &frustum, cell_begin, c + 1, 0};
+				cell_begin = c + 1;
+			}
+		}}
+
+		{// Cull the first range here and the rest on workers
+		TaskID const root_id = task_manager::add_hold_empty(*task_manager);
+		for (unsigned t = 1; t < num_ranges; ++t) {
+			TaskID const task_id = task_manager::add(
+				*task_manager, TaskWork{&tasks[t], cull_task_func}
+			);
+			task_manager::set_parent(*task_manager, task_id, root_id);
+		}
+		task_manager::end_hold(*task_manager, root_id);
+		cull_task_func(root_id, &tasks[0]);
+		task_manager::wait(*task_manager, root_id);
+		}
+
+		{// Compact range outputs
+		auto* const visible = array::begin(set.visible);
+		for (auto const& task : array_cref(tasks, num_ranges)) {
+			std::memmove(
+				visible + num_visible,
+				visible + set._cells[task.cell_begin].begin,
+				task.num_visible * sizeof(gfx::RenderObject)
+			);
+			num_visible += task.num_visible;
+		}}
+	}
+	array::resize(set.visible, num_visible);
+	return num_visible;
+}
+
+/// Calculate the view frustum of a camera.
+gfx::Frustum render_object_set::camera_frustum(gfx::Camera const& camera) {
+	auto const& m = camera.view_projection.data;
+	Vec4 const r0{m[0].x, m[1].x, m[2].x, m[3].x};
+	Vec4 const r1{m[0].y, m[1].y, m[2].y, m[3].y};
+	Vec4 const r2{m[0].z, m[1].z, m[2].z, m[3].z};
+	Vec4 const r3{m[0].w, m[1].w, m[2].w, m[3].w};
+	gfx::Frustum frustum{{
+		r3 + r0, r3 - r0,
+		r3 + r1, r3 - r1,
+		r3 + r2, r3 - r2
+	}};
+	for (auto& p : frustum.planes) {
+		p /= std::sqrt(p.x * p.x + p.y * p.y + p.z * p.z);
+	}
+	return frustum;
+}
+
+} // namespace gfx
+} // namespace game
+} // namespace togo
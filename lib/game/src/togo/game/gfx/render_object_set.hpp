@@ -0,0 +1,48 @@
+#line 2 "togo/game/gfx/render_object_set.hpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+
+@file
+@brief RenderObjectSet interface.
+@ingroup lib_game_gfx
+@ingroup lib_game_gfx_render_object_set
+
+@defgroup lib_game_gfx_render_object_set RenderObjectSet
+@ingroup lib_game_gfx
+@details
+*/
+
+#pragma once
+
+#include <togo/game/config.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/threading/types.hpp>
+#include <togo/game/entity/types.hpp>
+#include <togo/game/world/types.hpp>
+#include <togo/game/gfx/types.hpp>
+#include <togo/game/gfx/render_object_set.gen_interface>
+
+namespace togo {
+namespace game {
+namespace gfx {
+namespace render_object_set {
+
+/**
+	@addtogroup lib_game_gfx_render_object_set
+	@{
+*/
+
+/// Component name of the render object set.
+static constexpr ComponentNameHash const COMPONENT_NAME = "render_object_set"_component_name;
+
+/// Number of objects.
+inline unsigned size(gfx::RenderObjectSet const& set) {
+	return array::size(set._objects);
+}
+
+/** @} */ // end of doc-group lib_game_gfx_render_object_set
+
+} // namespace render_object_set
+} // namespace gfx
+} // namespace game
+} // namespace togo
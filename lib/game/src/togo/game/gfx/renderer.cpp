@@ -6,16 +6,22 @@
 #include <togo/game/config.hpp>
 #include <togo/core/error/assert.hpp>
 #include <togo/core/utility/utility.hpp>
+#include <togo/core/collection/fixed_array.hpp>
 #include <togo/core/collection/hash_map.hpp>
 #include <togo/core/algorithm/sort.hpp>
+#include <togo/core/system/system.hpp>
 #include <togo/core/threading/condvar.hpp>
 #include <togo/core/threading/mutex.hpp>
 #include <togo/core/threading/task_manager.hpp>
+#include <togo/core/trace/trace.hpp>
 #include <togo/window/window/window.hpp>
+#include <togo/game/world/world_manager.hpp>
 #include <togo/game/gfx/command.hpp>
 #include <togo/game/gfx/renderer.hpp>
 #include <togo/game/gfx/renderer/types.hpp>
 #include <togo/game/gfx/renderer/private.hpp>
+#include <togo/game/gfx/render_object_set.hpp>
+#include <togo/game/app/app.hpp>
 #include <togo/game/gfx/renderer/private.ipp>
 
 #if (TOGO_CONFIG_RENDERER == TOGO_RENDERER_OPENGL)
@@ -51,7 +57,14 @@ Renderer::Renderer(
 	, _render_targets()
 	, _uniforms()
 	, _shaders()
+	, _num_frames(0)
 	, _nodes()
+	, _profiling(false)
+	, _stats_slot(0)
+	, _stats_frame(0)
+	, _stats_frame_start(0.0)
+	, _stats()
+	, _stats_pending()
 {}
 
 /// Register generator definition.
@@ -111,6 +124,64 @@ gfx::RenderTargetID renderer::shared_render_target(
 	return renderer->_shared_rts[index];
 }
 
+/// Enable or disable profiling.
+///
+/// When enabled, CPU and GPU times are recorded for each frame and
+/// published to frame_stats() once GPU timings have been read back.
+/// This must not be called during a frame.
+void renderer::set_profiling(
+	gfx::Renderer* const renderer,
+	bool const enabled
+) {
+	if (enabled && !renderer->_profiling) {
+		renderer->_stats.frame = 0;
+		for (auto& stats : renderer->_stats_pending) {
+			stats.frame = 0;
+		}
+	}
+	renderer->_profiling = enabled;
+}
+
+/// Whether profiling is enabled.
+bool renderer::profiling(gfx::Renderer const* const renderer) {
+	return renderer->_profiling;
+}
+
+/// Statistics for the most recent frame with complete GPU timings.
+///
+/// frame is 0 if no frame has completed since profiling was enabled.
+/// This should only be read between frames.
+gfx::FrameStats const& renderer::frame_stats(gfx::Renderer const* const renderer) {
+	return renderer->_stats;
+}
+
+static void begin_stats_frame(gfx::Renderer* const renderer) {
+	auto& stats = renderer->_stats_pending[renderer->_stats_slot];
+	// Drop queries left from a frame that was never resolved
+	renderer::resolve_gpu_scopes(renderer, renderer->_stats_slot, stats);
+	std::memset(&stats, 0, sizeof(gfx::FrameStats));
+	stats.frame = ++renderer->_stats_frame;
+	renderer->_stats_frame_start = system::time_monotonic();
+}
+
+static void end_stats_frame(gfx::Renderer* const renderer) {
+	renderer::end_gpu_scope(renderer);
+	auto& stats = renderer->_stats_pending[renderer->_stats_slot];
+	stats.cpu_time = static_cast<f32>(
+		system::time_monotonic() - renderer->_stats_frame_start
+	);
+
+	// The next slot was recorded TOGO_GFX_NUM_STATS_FRAMES - 1 frames
+	// ago. finish_frame() has since waited on a later frame, so its
+	// queries are complete.
+	renderer->_stats_slot = (renderer->_stats_slot + 1) % TOGO_GFX_NUM_STATS_FRAMES;
+	auto& complete = renderer->_stats_pending[renderer->_stats_slot];
+	renderer::resolve_gpu_scopes(renderer, renderer->_stats_slot, complete);
+	if (complete.frame != 0) {
+		renderer->_stats = complete;
+	}
+}
+
 static void process_work(
 	gfx::Renderer* const renderer
 ) {
@@ -119,6 +190,8 @@ static void process_work(
 		return;
 	}
 
+	TOGO_TRACE_ZONE("gfx process work");
+	TOGO_TRACE_COUNTER("gfx commands", w.num_commands);
 	void const* data = w.buffer;
 	gfx::CmdType type;
 	for (; w.num_commands > 0; --w.num_commands) {
@@ -131,10 +204,14 @@ static void process_work(
 }
 
 static void worker_task_func(TaskID /*id*/, void* task_data) {
+	TOGO_TRACE_ZONE("gfx frame");
 	auto* renderer = static_cast<gfx::Renderer*>(task_data);
 	auto& w = renderer->_work_data;
 	MutexLock l{renderer->_frame_mutex};
 	window::bind_context(w.window);
+	if (renderer->_profiling) {
+		begin_stats_frame(renderer);
+	}
 	while (
 		w.active ||
 		w.num_commands > 0
@@ -145,11 +222,30 @@ static void worker_task_func(TaskID /*id*/, void* task_data) {
 		}
 		condvar::wait(renderer->_frame_condvar, l);
 	}
+	if (renderer->_profiling) {
+		end_stats_frame(renderer);
+	}
+	{
+	TOGO_TRACE_ZONE("gfx finish frame");
+	renderer::finish_frame(renderer);
+	++renderer->_num_frames;
+	}
+	{
+	TOGO_TRACE_ZONE("gfx swap buffers");
 	window::swap_buffers(w.window);
+	}
 	window::unbind_context();
 	w.window = nullptr;
 }
 
+/// Number of frames finished.
+///
+/// This is constant during a frame, so generators can use it to tell
+/// frames apart.
+u32 renderer::num_frames(gfx::Renderer const* const renderer) {
+	return renderer->_num_frames;
+}
+
 /// Begin frame.
 ///
 /// This binds the window context to the worker thread. It must be
@@ -222,6 +318,16 @@ unsigned renderer::execute_command(
 	gfx::CmdType const type,
 	void const* const data
 ) {
+	static_assert(
+		static_cast<unsigned>(gfx::CmdType::RenderBuffersIndirect) < TOGO_GFX_NUM_CMD_TYPES,
+		"TOGO_GFX_NUM_CMD_TYPES is too small"
+	);
+	if (renderer->_profiling) {
+		auto& stats = renderer->_stats_pending[renderer->_stats_slot];
+		++stats.num_commands;
+		++stats.num_commands_by_type[static_cast<unsigned>(type)];
+	}
+
 	#define DO_CMD(name) \
 		case gfx::CmdType:: name: { \
 			auto* d = static_cast<gfx::Cmd ## name const*>(data); \
@@ -262,6 +368,30 @@ unsigned renderer::execute_command(
 		);
 	END_CMD()
 
+	DO_CMD(RenderBuffersInstanced)
+		gfx::renderer::render_buffers_instanced(
+			renderer,
+			d->shader_id,
+			d->num_draw_param_blocks,
+			d->draw_param_blocks,
+			d->buffer,
+			d->num_instances
+		);
+	END_CMD()
+
+	DO_CMD(RenderBuffersIndirect)
+		gfx::renderer::render_buffers_indirect(
+			renderer,
+			d->shader_id,
+			d->num_draw_param_blocks,
+			d->draw_param_blocks,
+			d->buffer,
+			d->indirect_buffer,
+			d->indirect_offset,
+			d->num_draws
+		);
+	END_CMD()
+
 	DO_CMD(RenderWorld)
 		gfx::renderer::render_world(
 			renderer,
@@ -277,6 +407,21 @@ unsigned renderer::execute_command(
 	TOGO_ASSERTE(false);
 }
 
+// Layers are ordered by their base sequence
+static unsigned layer_for_sequence(
+	gfx::Pipe const& pipe,
+	u64 const sequence
+) {
+	unsigned index = 0;
+	for (unsigned i = 1; i < fixed_array::size(pipe.layers); ++i) {
+		if (pipe.layers[i].seq_base > sequence) {
+			break;
+		}
+		index = i;
+	}
+	return index;
+}
+
 namespace {
 struct CmdKeyKeyFunc {
 	inline u64 operator()(gfx::CmdKey const& key) const noexcept {
@@ -307,15 +452,33 @@ void renderer::render_objects(
 		node.buffer_size = 0;
 	}
 
+	bool const profiling = renderer->_profiling;
+	auto* const stats = &renderer->_stats_pending[renderer->_stats_slot];
+	auto* const layer_stats = stats->layers[viewport->pipe];
+	f64 time_start = 0.0;
+	f32 time_delta;
+
 	// TODO: Distribute across nodes
 	auto& pipe = rc.pipes[viewport->pipe];
 	for (auto& layer : pipe.layers) {
 		auto& node = renderer->_nodes[0];
+		unsigned const node_num_commands = node.num_commands;
+		if (profiling) {
+			time_start = system::time_monotonic();
+		}
 		node.sequence = layer.seq_base;
-	for (auto& gen_unit : layer.layout) {
-		gen_unit.func_exec(gen_unit, node, objects, objects + num_objects);
-		++node.sequence;
-	}}
+		for (auto& gen_unit : layer.layout) {
+			gen_unit.func_exec(gen_unit, node, objects, objects + num_objects);
+			++node.sequence;
+		}
+		if (profiling) {
+			auto& ls = layer_stats[&layer - fixed_array::begin(pipe.layers)];
+			time_delta = static_cast<f32>(system::time_monotonic() - time_start);
+			ls.num_commands += node.num_commands - node_num_commands;
+			ls.cpu_generate_time += time_delta;
+			stats->cpu_generate_time += time_delta;
+		}
+	}
 
 	unsigned num_commands = 0;
 
@@ -331,41 +494,92 @@ void renderer::render_objects(
 
 	auto* keys = renderer->_joined_keys_a;
 	{// Sort commands
+	if (profiling) {
+		time_start = system::time_monotonic();
+	}
 	auto* keys_swap = renderer->_joined_keys_b;
-	sort_radix_generic<gfx::CmdKey, u64, u32>(
-		keys, keys_swap,
-		num_commands,
-		CmdKeyKeyFunc{}
-	);
+	if (num_commands >= TOGO_GFX_SORT_PARALLEL_SIZE) {
+		sort_radix_parallel<gfx::CmdKey, u64, u32>(
+			app::instance().task_manager,
+			keys, keys_swap,
+			num_commands,
+			CmdKeyKeyFunc{},
+			TOGO_GFX_SORT_NUM_TASKS
+		);
+	} else {
+		sort_radix_generic<gfx::CmdKey, u64, u32>(
+			keys, keys_swap,
+			num_commands,
+			CmdKeyKeyFunc{}
+		);
 	}
+	if (profiling) {
+		stats->cpu_sort_time += static_cast<f32>(system::time_monotonic() - time_start);
+	}}
 
 	{// Execute commands
 	gfx::CmdType type;
 	void const* data_untyped;
+	unsigned layer_index;
+	unsigned scope_layer_index = TOGO_GFX_PIPE_NUM_LAYERS;
+	if (profiling) {
+		time_start = system::time_monotonic();
+	}
 	for (auto const& key : array_ref(keys, num_commands)) {
+		if (profiling) {
+			// Time each layer's commands on the GPU
+			layer_index = layer_for_sequence(pipe, key.key >> TOGO_GFX_KEY_USER_BITS);
+			if (layer_index != scope_layer_index) {
+				renderer::begin_gpu_scope(renderer, viewport->pipe, layer_index);
+				scope_layer_index = layer_index;
+			}
+		}
 		type = *static_cast<gfx::CmdType const*>(key.data);
 		data_untyped = pointer_add(key.data, sizeof(gfx::CmdType));
 		TOGO_ASSERTE(type != gfx::CmdType::RenderWorld);
 		renderer::execute_command(renderer, type, data_untyped);
+	}
+	if (profiling) {
+		renderer::end_gpu_scope(renderer);
+		stats->cpu_execute_time += static_cast<f32>(system::time_monotonic() - time_start);
 	}}
 }
 
 /// Render world through camera and viewport.
+///
+/// Objects from the world's render object set are culled against the
+/// camera's frustum and only the visible objects are passed to
+/// generators.
+///
+/// An assertion will fail if camera_id does not have a camera in the
+/// world's render object set.
 void renderer::render_world(
 	gfx::Renderer* const renderer,
-	WorldID const /*world_id*/,
-	EntityID const /*camera_id*/,
+	WorldID const world_id,
+	EntityID const camera_id,
 	gfx::ViewportNameHash const viewport_name_hash
 ) {
 	// TODO: Take mesh component manager and Camera object directly
 	// (lower-level than app::render_world()). Rename, too.
-	// TODO: Camera data from entity
-	// TODO: Cull objects from world
-	gfx::Camera const camera{};
+	auto& app = app::instance();
+	auto* const set = static_cast<gfx::RenderObjectSet*>(world_manager::component_manager(
+		app.world_manager, world_id, render_object_set::COMPONENT_NAME
+	));
+	TOGO_ASSERT(set, "render object set component manager is not registered");
+	auto const* const camera = render_object_set::camera(*set, camera_id);
+	TOGO_ASSERT(camera, "camera entity does not have a camera");
+	unsigned num_visible;
+	{
+	TOGO_TRACE_ZONE("gfx cull");
+	num_visible = render_object_set::cull(
+		*set, render_object_set::camera_frustum(*camera), &app.task_manager
+	);
+	}
+	TOGO_TRACE_ZONE("gfx render objects");
 	gfx::renderer::render_objects(
 		renderer,
-		0, nullptr,
-		camera, viewport_name_hash
+		num_visible, array::begin(set->visible),
+		*camera, viewport_name_hash
 	);
 }
 
@@ -53,6 +53,8 @@ gfx::RendererType type(gfx::Renderer const* renderer);
 /// Create buffer.
 ///
 /// If data is nullptr, map_buffer() must be used to fill the buffer.
+/// If data_binding is BufferDataBinding::persistent, data is copied to
+/// every frame region.
 /// An assertion will fail if the buffer could not be created.
 gfx::BufferID create_buffer(
 	gfx::Renderer* renderer,
@@ -68,6 +70,9 @@ void destroy_buffer(
 );
 
 /// Map data to buffer.
+///
+/// For persistent buffers, data is written directly to the current
+/// frame region.
 void map_buffer(
 	gfx::Renderer* renderer,
 	gfx::BufferID id,
@@ -87,6 +92,16 @@ inline void map_buffer(
 	);
 }
 
+/// Current frame region of a persistent buffer.
+///
+/// Writes to the region are visible to the GPU without a map_buffer()
+/// call. The pointer is only valid until the frame has been rendered.
+/// An assertion will fail if the buffer is not persistent.
+void* buffer_region(
+	gfx::Renderer* renderer,
+	gfx::BufferID id
+);
+
 /// Parameter block offset by index.
 ///
 /// block_size should be the size of the largest block in the buffer.
@@ -272,6 +287,35 @@ void render_buffers(
 	gfx::BufferBindingID const* buffers
 );
 
+/// Render buffer binding instanced.
+///
+/// Per-instance data is expected in draw parameter blocks, indexed by
+/// the instance ID in the shader.
+void render_buffers_instanced(
+	gfx::Renderer* renderer,
+	gfx::ShaderID shader_id,
+	unsigned num_draw_param_blocks,
+	gfx::ParamBlockBinding const* draw_param_blocks,
+	gfx::BufferBindingID buffer,
+	unsigned num_instances
+);
+
+/// Render buffer binding with draws from an indirect buffer.
+///
+/// indirect_buffer must contain num_draws IndirectDrawElements (if the
+/// buffer binding is indexed) or IndirectDrawArrays (otherwise) at
+/// indirect_offset. All draws are submitted in a single batch.
+void render_buffers_indirect(
+	gfx::Renderer* renderer,
+	gfx::ShaderID shader_id,
+	unsigned num_draw_param_blocks,
+	gfx::ParamBlockBinding const* draw_param_blocks,
+	gfx::BufferBindingID buffer,
+	gfx::BufferID indirect_buffer,
+	unsigned indirect_offset,
+	unsigned num_draws
+);
+
 /// Configure the renderer.
 ///
 /// Base effects:
@@ -46,6 +46,8 @@ static constexpr GLenum const g_gl_buffer_data_binding[]{
 	GL_STATIC_DRAW,
 	// dynamic
 	GL_DYNAMIC_DRAW,
+	// persistent (unused; storage is immutable)
+	GL_STREAM_DRAW,
 };
 static_assert(
 	array_extent(g_gl_buffer_data_binding)
@@ -108,11 +110,16 @@ struct Buffer {
 	enum : u32 {
 		F_NONE = 0,
 		F_DYNAMIC = 1 << 0,
+		F_PERSISTENT = 1 << 1,
 	};
 
 	gfx::BufferID id;
 	GLuint handle;
 	u32 flags;
+	// Size of a frame region (persistent only)
+	u32 region_size;
+	// Base of the persistent mapping (persistent only)
+	u8* mapped;
 };
 
 struct BufferBinding {
@@ -256,6 +263,16 @@ struct OpenGLRendererImpl {
 	unsigned p_uniform_buffer_offset_alignment;
 	unsigned p_max_uniform_block_size;
 	gfx::BufferBinding* empty_buffer_binding;
+	// Frame region currently written by the frame being built
+	unsigned frame_region;
+	// Fences for frame regions that may still be read by the GPU
+	GLsync frame_region_fences[TOGO_GFX_NUM_FRAME_REGIONS];
+	// GL_TIME_ELAPSED queries by stats slot and the pipe and layer
+	// (pipe << 8 | layer) each was recorded for
+	bool query_active;
+	unsigned num_queries[TOGO_GFX_NUM_STATS_FRAMES];
+	GLuint queries[TOGO_GFX_NUM_STATS_FRAMES][TOGO_GFX_NUM_FRAME_QUERIES];
+	u16 query_scopes[TOGO_GFX_NUM_STATS_FRAMES][TOGO_GFX_NUM_FRAME_QUERIES];
 };
 
 using RendererImpl = OpenGLRendererImpl;
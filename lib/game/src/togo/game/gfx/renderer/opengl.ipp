@@ -17,6 +17,8 @@
 #include <togo/game/gfx/renderer/private.hpp>
 #include <togo/game/gfx/renderer/opengl.hpp>
 
+#include <cstring>
+
 namespace togo {
 namespace game {
 namespace gfx {
@@ -83,6 +85,17 @@ inline static void bind_buffer(
 	}
 }
 
+inline static unsigned buffer_region_offset(
+	gfx::Renderer const* const renderer,
+	gfx::Buffer const& buffer
+) {
+	return
+		(buffer.flags & gfx::Buffer::F_PERSISTENT)
+		? renderer->_impl.frame_region * buffer.region_size
+		: 0
+	;
+}
+
 inline static void bind_param_block(
 	gfx::Renderer* const renderer,
 	gfx::BufferID const id,
@@ -93,7 +106,10 @@ inline static void bind_param_block(
 	TOGO_ASSERTE(id.valid());
 	auto const& buffer = resource_array::get(renderer->_buffers, id);
 	TOGO_ASSERT(buffer.id == id, "invalid buffer ID");
-	glBindBufferRange(GL_UNIFORM_BUFFER, index, buffer.handle, offset, size);
+	glBindBufferRange(
+		GL_UNIFORM_BUFFER, index, buffer.handle,
+		buffer_region_offset(renderer, buffer) + offset, size
+	);
 }
 
 inline static void unbind_param_block(
@@ -207,12 +223,26 @@ gfx::Renderer* renderer::create(
 	);
 	}
 
+	glGenQueries(
+		TOGO_GFX_NUM_STATS_FRAMES * TOGO_GFX_NUM_FRAME_QUERIES,
+		&renderer->_impl.queries[0][0]
+	);
 	return renderer;
 }
 
 void renderer::destroy(gfx::Renderer* const renderer) {
 	Allocator& allocator = *renderer->_allocator;
 	renderer::teardown_base(renderer);
+	for (auto& fence : renderer->_impl.frame_region_fences) {
+		if (fence) {
+			glDeleteSync(fence);
+			fence = nullptr;
+		}
+	}
+	glDeleteQueries(
+		TOGO_GFX_NUM_STATS_FRAMES * TOGO_GFX_NUM_FRAME_QUERIES,
+		&renderer->_impl.queries[0][0]
+	);
 	TOGO_DESTROY(allocator, renderer);
 }
 
@@ -223,10 +253,11 @@ gfx::RendererType renderer::type(gfx::Renderer const* /*renderer*/) {
 inline static u32 gl_buffer_flags(
 	gfx::BufferDataBinding const data_binding
 ) {
-	return (data_binding == gfx::BufferDataBinding::dynamic)
-		? gfx::Buffer::F_DYNAMIC
-		: gfx::Buffer::F_NONE
-	;
+	switch (data_binding) {
+	case gfx::BufferDataBinding::dynamic: return gfx::Buffer::F_DYNAMIC;
+	case gfx::BufferDataBinding::persistent: return gfx::Buffer::F_PERSISTENT;
+	default: return gfx::Buffer::F_NONE;
+	}
 }
 
 gfx::BufferID renderer::create_buffer(
@@ -238,15 +269,43 @@ gfx::BufferID renderer::create_buffer(
 	TOGO_ASSERTE(size > 0);
 	gfx::Buffer buffer{
 		{}, BUFFER_HANDLE_NULL,
-		gl_buffer_flags(data_binding)
+		gl_buffer_flags(data_binding),
+		0, nullptr
 	};
 	glGenBuffers(1, &buffer.handle);
 	TOGO_ASSERTE(buffer.handle != BUFFER_HANDLE_NULL);
 	glBindBuffer(GL_ARRAY_BUFFER, buffer.handle);
-	glBufferData(
-		GL_ARRAY_BUFFER,
-		size, data, gfx::g_gl_buffer_data_binding[unsigned_cast(data_binding)]
-	);
+	if (buffer.flags & gfx::Buffer::F_PERSISTENT) {
+		TOGO_ASSERT(
+			GLAD_GL_ARB_buffer_storage,
+			"persistent buffers require GL_ARB_buffer_storage"
+		);
+		// Regions must be bindable as parameter blocks
+		buffer.region_size = align_param_block_offset(
+			size, renderer->_impl.p_uniform_buffer_offset_alignment
+		);
+		GLbitfield const access
+			= GL_MAP_WRITE_BIT
+			| GL_MAP_PERSISTENT_BIT
+			| GL_MAP_COHERENT_BIT
+		;
+		unsigned const storage_size = buffer.region_size * TOGO_GFX_NUM_FRAME_REGIONS;
+		glBufferStorage(GL_ARRAY_BUFFER, storage_size, nullptr, access);
+		buffer.mapped = static_cast<u8*>(
+			glMapBufferRange(GL_ARRAY_BUFFER, 0, storage_size, access)
+		);
+		TOGO_ASSERTE(buffer.mapped);
+		if (data) {
+			for (unsigned region = 0; region < TOGO_GFX_NUM_FRAME_REGIONS; ++region) {
+				std::memcpy(buffer.mapped + region * buffer.region_size, data, size);
+			}
+		}
+	} else {
+		glBufferData(
+			GL_ARRAY_BUFFER,
+			size, data, gfx::g_gl_buffer_data_binding[unsigned_cast(data_binding)]
+		);
+	}
 	return resource_array::assign(renderer->_buffers, buffer).id;
 }
 
@@ -256,6 +315,11 @@ void renderer::destroy_buffer(
 ) {
 	auto& buffer = resource_array::get(renderer->_buffers, id);
 	TOGO_ASSERT(buffer.id == id, "invalid buffer ID");
+	if (buffer.mapped) {
+		glBindBuffer(GL_ARRAY_BUFFER, buffer.handle);
+		glUnmapBuffer(GL_ARRAY_BUFFER);
+		buffer.mapped = nullptr;
+	}
 	glDeleteBuffers(1, &buffer.handle);
 	resource_array::free(renderer->_buffers, buffer);
 }
@@ -273,8 +337,99 @@ void renderer::map_buffer(
 	);
 	auto const& buffer = resource_array::get(renderer->_buffers, id);
 	TOGO_ASSERT(buffer.id == id, "invalid buffer ID");
-	glBindBuffer(GL_ARRAY_BUFFER, buffer.handle);
-	glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+	if (buffer.flags & gfx::Buffer::F_PERSISTENT) {
+		TOGO_DEBUG_ASSERTE(offset + size <= buffer.region_size);
+		std::memcpy(
+			buffer.mapped + buffer_region_offset(renderer, buffer) + offset,
+			data, size
+		);
+	} else {
+		glBindBuffer(GL_ARRAY_BUFFER, buffer.handle);
+		glBufferSubData(GL_ARRAY_BUFFER, offset, size, data);
+	}
+}
+
+void* renderer::buffer_region(
+	gfx::Renderer* const renderer,
+	gfx::BufferID const id
+) {
+	auto const& buffer = resource_array::get(renderer->_buffers, id);
+	TOGO_ASSERT(buffer.id == id, "invalid buffer ID");
+	TOGO_ASSERT(
+		buffer.flags & gfx::Buffer::F_PERSISTENT,
+		"buffer is not persistent"
+	);
+	return buffer.mapped + buffer_region_offset(renderer, buffer);
+}
+
+void renderer::finish_frame(gfx::Renderer* const renderer) {
+	auto& impl = renderer->_impl;
+
+	// Fence the region the frame read from
+	auto& fence = impl.frame_region_fences[impl.frame_region];
+	TOGO_DEBUG_ASSERTE(!fence);
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+
+	// Wait for the GPU to release the next region before it is written
+	impl.frame_region = (impl.frame_region + 1) % TOGO_GFX_NUM_FRAME_REGIONS;
+	auto& next_fence = impl.frame_region_fences[impl.frame_region];
+	if (next_fence) {
+		GLenum status;
+		do {
+			status = glClientWaitSync(
+				next_fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000 // 1ms
+			);
+		} while (status == GL_TIMEOUT_EXPIRED);
+		TOGO_ASSERTE(status != GL_WAIT_FAILED);
+		glDeleteSync(next_fence);
+		next_fence = nullptr;
+	}
+}
+
+void renderer::begin_gpu_scope(
+	gfx::Renderer* const renderer,
+	unsigned const pipe,
+	unsigned const layer
+) {
+	auto& impl = renderer->_impl;
+	renderer::end_gpu_scope(renderer);
+	unsigned const slot = renderer->_stats_slot;
+	unsigned& num_queries = impl.num_queries[slot];
+	if (num_queries == TOGO_GFX_NUM_FRAME_QUERIES) {
+		// Out of queries; the rest of the frame is not timed
+		return;
+	}
+	impl.query_scopes[slot][num_queries] = static_cast<u16>((pipe << 8) | layer);
+	glBeginQuery(GL_TIME_ELAPSED, impl.queries[slot][num_queries]);
+	impl.query_active = true;
+	++num_queries;
+}
+
+void renderer::end_gpu_scope(gfx::Renderer* const renderer) {
+	auto& impl = renderer->_impl;
+	if (impl.query_active) {
+		glEndQuery(GL_TIME_ELAPSED);
+		impl.query_active = false;
+	}
+}
+
+void renderer::resolve_gpu_scopes(
+	gfx::Renderer* const renderer,
+	unsigned const slot,
+	gfx::FrameStats& stats
+) {
+	auto& impl = renderer->_impl;
+	GLuint64 elapsed;
+	f32 time;
+	unsigned scope;
+	for (unsigned i = 0; i < impl.num_queries[slot]; ++i) {
+		glGetQueryObjectui64v(impl.queries[slot][i], GL_QUERY_RESULT, &elapsed);
+		time = static_cast<f32>(static_cast<f64>(elapsed) * 1.0e-9);
+		scope = impl.query_scopes[slot][i];
+		stats.layers[scope >> 8][scope & 0xFF].gpu_time += time;
+		stats.gpu_time += time;
+	}
+	impl.num_queries[slot] = 0;
 }
 
 // NB: These two are equivalent!
@@ -342,6 +497,11 @@ gfx::BufferBindingID renderer::create_buffer_binding(
 	glBindVertexArray(bb.va_handle);
 	bind_buffer(renderer, index_binding.id, GL_ELEMENT_ARRAY_BUFFER);
 	if (index_binding.id.valid()) {
+		TOGO_ASSERT(
+			~resource_array::get(renderer->_buffers, index_binding.id).flags
+			& gfx::Buffer::F_PERSISTENT,
+			"persistent buffers cannot be used as index buffers"
+		);
 		bb.flags
 			|= gfx::BufferBinding::F_INDEXED
 			| (unsigned_cast(index_binding.type) << gfx::BufferBinding::F_SHIFT_INDEX_TYPE)
@@ -352,6 +512,11 @@ gfx::BufferBindingID renderer::create_buffer_binding(
 	unsigned attrib_index = 0;
 	for (auto const& vertex_binding : array_ref(bindings, num_bindings)) {
 		TOGO_ASSERTE(vertex_binding.id.valid());
+		TOGO_ASSERT(
+			~resource_array::get(renderer->_buffers, vertex_binding.id).flags
+			& gfx::Buffer::F_PERSISTENT,
+			"persistent buffers cannot be used as vertex buffers"
+		);
 		bind_buffer(renderer, vertex_binding.id, GL_ARRAY_BUFFER);
 		TOGO_DEBUG_ASSERTE(vertex_binding.format);
 		auto const& format = *vertex_binding.format;
@@ -828,18 +993,14 @@ void renderer::render_fullscreen_pass(
 	gfx::renderer::bind_framebuffer(renderer, prev_framebuffer_id);
 }
 
-void renderer::render_buffers(
+// Bind shader and draw parameter blocks
+static void use_shader(
 	gfx::Renderer* const renderer,
 	gfx::ShaderID const shader_id,
 	unsigned const num_draw_param_blocks,
-	gfx::ParamBlockBinding const* const draw_param_blocks,
-	unsigned const num_buffers,
-	gfx::BufferBindingID const* const buffers
+	gfx::ParamBlockBinding const* const draw_param_blocks
 ) {
-	TOGO_DEBUG_ASSERTE(
-		(num_draw_param_blocks == 0 || draw_param_blocks) &&
-		num_buffers > 0 && buffers
-	);
+	TOGO_DEBUG_ASSERTE(num_draw_param_blocks == 0 || draw_param_blocks);
 
 	{// Bind shader and validate supplied parameter blocks
 	auto& shader = gfx::resource_array::get(renderer->_shaders, shader_id);
@@ -865,17 +1026,37 @@ void renderer::render_buffers(
 	for (; num_unbind > index; ++index) {
 		unbind_param_block(renderer, index);
 	}}
+}
+
+inline static gfx::BufferBinding const& use_buffer_binding(
+	gfx::Renderer* const renderer,
+	gfx::BufferBindingID const id
+) {
+	auto const& bb = resource_array::get(renderer->_buffer_bindings, id);
+	TOGO_ASSERT(bb.id == id, "invalid buffer binding ID");
+	glBindVertexArray(bb.va_handle);
+	return bb;
+}
+
+void renderer::render_buffers(
+	gfx::Renderer* const renderer,
+	gfx::ShaderID const shader_id,
+	unsigned const num_draw_param_blocks,
+	gfx::ParamBlockBinding const* const draw_param_blocks,
+	unsigned const num_buffers,
+	gfx::BufferBindingID const* const buffers
+) {
+	TOGO_DEBUG_ASSERTE(num_buffers > 0 && buffers);
+	use_shader(renderer, shader_id, num_draw_param_blocks, draw_param_blocks);
 
 	{// Render!
 	GLenum polygonization_method;
 	unsigned index_data_type;
 	for (auto const id : array_ref(buffers, num_buffers)) {
-		auto const& bb = resource_array::get(renderer->_buffer_bindings, id);
-		TOGO_ASSERT(bb.id == id, "invalid buffer binding ID");
+		auto const& bb = use_buffer_binding(renderer, id);
 		polygonization_method = gfx::g_gl_polygonization_method[
 			unsigned_cast(bb.polygonization_method())
 		];
-		glBindVertexArray(bb.va_handle);
 		if (bb.flags & gfx::BufferBinding::F_INDEXED) {
 			index_data_type = bb.flags >> gfx::BufferBinding::F_SHIFT_INDEX_TYPE;
 			glDrawElements(
@@ -892,6 +1073,89 @@ void renderer::render_buffers(
 	}}
 }
 
+void renderer::render_buffers_instanced(
+	gfx::Renderer* const renderer,
+	gfx::ShaderID const shader_id,
+	unsigned const num_draw_param_blocks,
+	gfx::ParamBlockBinding const* const draw_param_blocks,
+	gfx::BufferBindingID const buffer,
+	unsigned const num_instances
+) {
+	if (num_instances == 0) {
+		return;
+	}
+	use_shader(renderer, shader_id, num_draw_param_blocks, draw_param_blocks);
+
+	auto const& bb = use_buffer_binding(renderer, buffer);
+	GLenum const polygonization_method = gfx::g_gl_polygonization_method[
+		unsigned_cast(bb.polygonization_method())
+	];
+	if (bb.flags & gfx::BufferBinding::F_INDEXED) {
+		unsigned const index_data_type = bb.flags >> gfx::BufferBinding::F_SHIFT_INDEX_TYPE;
+		glDrawElementsInstanced(
+			polygonization_method,
+			bb.num_vertices,
+			gfx::g_gl_primitive_type[index_data_type],
+			reinterpret_cast<void const*>(
+				bb.base_vertex * gfx::g_gl_primitive_size[index_data_type]
+			),
+			num_instances
+		);
+	} else {
+		glDrawArraysInstanced(
+			polygonization_method,
+			bb.base_vertex, bb.num_vertices,
+			num_instances
+		);
+	}
+}
+
+void renderer::render_buffers_indirect(
+	gfx::Renderer* const renderer,
+	gfx::ShaderID const shader_id,
+	unsigned const num_draw_param_blocks,
+	gfx::ParamBlockBinding const* const draw_param_blocks,
+	gfx::BufferBindingID const buffer,
+	gfx::BufferID const indirect_buffer_id,
+	unsigned const indirect_offset,
+	unsigned const num_draws
+) {
+	TOGO_ASSERT(
+		GLAD_GL_ARB_multi_draw_indirect,
+		"indirect rendering requires GL_ARB_multi_draw_indirect"
+	);
+	if (num_draws == 0) {
+		return;
+	}
+	use_shader(renderer, shader_id, num_draw_param_blocks, draw_param_blocks);
+
+	auto const& indirect_buffer = resource_array::get(renderer->_buffers, indirect_buffer_id);
+	TOGO_ASSERT(indirect_buffer.id == indirect_buffer_id, "invalid buffer ID");
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer.handle);
+	auto const* const offset = reinterpret_cast<void const*>(
+		buffer_region_offset(renderer, indirect_buffer) + indirect_offset
+	);
+
+	auto const& bb = use_buffer_binding(renderer, buffer);
+	GLenum const polygonization_method = gfx::g_gl_polygonization_method[
+		unsigned_cast(bb.polygonization_method())
+	];
+	if (bb.flags & gfx::BufferBinding::F_INDEXED) {
+		unsigned const index_data_type = bb.flags >> gfx::BufferBinding::F_SHIFT_INDEX_TYPE;
+		glMultiDrawElementsIndirect(
+			polygonization_method,
+			gfx::g_gl_primitive_type[index_data_type],
+			offset, num_draws, sizeof(gfx::IndirectDrawElements)
+		);
+	} else {
+		glMultiDrawArraysIndirect(
+			polygonization_method,
+			offset, num_draws, sizeof(gfx::IndirectDrawArrays)
+		);
+	}
+	glBindBuffer(GL_DRAW_INDIRECT_BUFFER, BUFFER_HANDLE_NULL);
+}
+
 void renderer::configure(
 	gfx::Renderer* const renderer,
 	gfx::PackedRenderConfig const& packed_config,
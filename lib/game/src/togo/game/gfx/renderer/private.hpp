@@ -35,6 +35,18 @@ void configure_base(
 	Endian endian
 );
 
+// Implemented by the backend; called by the worker after the last
+// command of a frame
+void finish_frame(gfx::Renderer* renderer);
+
+// Implemented by the backend. GPU scopes time the commands executed
+// between them; beginning a scope ends the active one. Scopes are
+// recorded to the current stats slot and read back into stats by
+// resolve_gpu_scopes() when the slot is reused.
+void begin_gpu_scope(gfx::Renderer* renderer, unsigned pipe, unsigned layer);
+void end_gpu_scope(gfx::Renderer* renderer);
+void resolve_gpu_scopes(gfx::Renderer* renderer, unsigned slot, gfx::FrameStats& stats);
+
 } // namespace renderer
 
 namespace resource_array {
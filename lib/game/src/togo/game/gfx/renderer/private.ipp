@@ -21,6 +21,7 @@ void renderer::init_base(gfx::Renderer* const renderer) {
 	// Register standard generators
 	gfx::renderer::register_generator_def(renderer, gfx::generator::clear);
 	gfx::renderer::register_generator_def(renderer, gfx::generator::fullscreen_pass);
+	gfx::renderer::register_generator_def(renderer, gfx::generator::instanced_objects);
 }
 
 #define TOGO_GFX_RENDERER_TEARDOWN_RA_(ra, func_destroy)		\
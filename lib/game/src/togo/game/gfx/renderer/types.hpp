@@ -125,10 +125,18 @@ struct Renderer {
 	gfx::ResourceArray<gfx::Uniform, TOGO_GFX_NUM_UNIFORMS> _uniforms;
 	gfx::ResourceArray<gfx::Shader, TOGO_GFX_NUM_SHADERS> _shaders;
 
+	u32 _num_frames;
 	gfx::RenderNode _nodes[TOGO_GFX_NUM_NODES];
 	gfx::CmdKey _joined_keys_a[TOGO_GFX_NUM_NODES * TOGO_GFX_NODE_NUM_COMMANDS];
 	gfx::CmdKey _joined_keys_b[TOGO_GFX_NUM_NODES * TOGO_GFX_NODE_NUM_COMMANDS];
 
+	bool _profiling;
+	unsigned _stats_slot;
+	u32 _stats_frame;
+	f64 _stats_frame_start;
+	gfx::FrameStats _stats;
+	gfx::FrameStats _stats_pending[TOGO_GFX_NUM_STATS_FRAMES];
+
 	Renderer() = delete;
 	Renderer(Renderer const&) = delete;
 	Renderer& operator=(Renderer const&) = delete;
@@ -15,11 +15,14 @@
 #include <togo/core/utility/traits.hpp>
 #include <togo/core/utility/utility.hpp>
 #include <togo/core/math/types.hpp>
+#include <togo/core/math/vector/3_type.hpp>
+#include <togo/core/math/vector/4_type.hpp>
 #include <togo/core/math/matrix/4x4_type.hpp>
 #include <togo/core/collection/types.hpp>
 #include <togo/core/hash/hash.hpp>
 #include <togo/core/serialization/types.hpp>
 #include <togo/game/resource/types.hpp>
+#include <togo/game/entity/types.hpp>
 
 #include <initializer_list>
 
@@ -61,6 +64,17 @@ namespace gfx {
 #define TOGO_GFX_NUM_UNIFORMS 64
 #define TOGO_GFX_NUM_SHADERS 128
 #define TOGO_GFX_NUM_NODES 4
+#define TOGO_GFX_NUM_FRAME_REGIONS 3
+#define TOGO_GFX_INSTANCED_BATCH_SIZE 256
+#define TOGO_GFX_INSTANCED_NUM_BATCHES 64
+#define TOGO_GFX_CULL_CELL_SIZE 32.0f
+#define TOGO_GFX_CULL_TASK_SIZE 4096
+#define TOGO_GFX_CULL_NUM_TASKS 16
+#define TOGO_GFX_SORT_PARALLEL_SIZE 2048
+#define TOGO_GFX_SORT_NUM_TASKS 4
+#define TOGO_GFX_NUM_CMD_TYPES 16
+#define TOGO_GFX_NUM_STATS_FRAMES (TOGO_GFX_NUM_FRAME_REGIONS + 1)
+#define TOGO_GFX_NUM_FRAME_QUERIES 128
 
 /// Buffer data binding mode.
 enum class BufferDataBinding : unsigned {
@@ -68,6 +82,12 @@ enum class BufferDataBinding : unsigned {
 	fixed,
 	/// Buffer data changes frequently.
 	dynamic,
+	/// Buffer data changes every frame.
+	///
+	/// The buffer is persistently mapped and split into
+	/// TOGO_GFX_NUM_FRAME_REGIONS regions, one for each frame in flight.
+	/// Writes go directly to the current frame's region.
+	persistent,
 
 	NUM
 };
@@ -170,6 +190,9 @@ struct RenderConfig;
 struct RenderObject;
 struct RenderNode;
 struct Camera;
+struct Frustum;
+struct RenderObjectSet;
+struct FrameStats;
 
 /// Renderer.
 struct Renderer;
@@ -383,6 +406,29 @@ struct ParamBlockBinding {
 	u32 size;
 };
 
+/// Indirect draw parameters for an indexed buffer binding.
+///
+/// The layout matches the backend's indirect command format.
+/// base_instance must be 0 unless the backend supports base instances.
+struct IndirectDrawElements {
+	u32 num_indices;
+	u32 num_instances;
+	u32 base_index;
+	s32 base_vertex;
+	u32 base_instance;
+};
+
+/// Indirect draw parameters for a non-indexed buffer binding.
+///
+/// The layout matches the backend's indirect command format.
+/// base_instance must be 0 unless the backend supports base instances.
+struct IndirectDrawArrays {
+	u32 num_vertices;
+	u32 num_instances;
+	u32 base_vertex;
+	u32 base_instance;
+};
+
 /// Parameter block definition.
 struct ParamBlockDef {
 	u32 index;
@@ -559,6 +605,42 @@ struct RenderObject {
 	gfx::BufferBindingID binding;
 };
 
+/// Renderer frame statistics.
+///
+/// Times are in seconds. GPU times are read back
+/// TOGO_GFX_NUM_STATS_FRAMES - 1 frames after the frame was rendered
+/// to avoid stalling on the GPU, so these lag behind the current frame.
+struct FrameStats {
+	/// Layer statistics.
+	struct Layer {
+		/// Number of commands generated.
+		u32 num_commands;
+		/// Time spent in generators.
+		f32 cpu_generate_time;
+		/// GPU time taken by the layer's commands.
+		f32 gpu_time;
+	};
+
+	/// Frame number (starts at 1).
+	u32 frame;
+	/// Number of commands executed.
+	u32 num_commands;
+	/// Worker time from the start of the frame to swapping buffers.
+	f32 cpu_time;
+	/// Time spent in generators.
+	f32 cpu_generate_time;
+	/// Time spent sorting commands.
+	f32 cpu_sort_time;
+	/// Time spent executing generated commands.
+	f32 cpu_execute_time;
+	/// GPU time taken by all layers.
+	f32 gpu_time;
+	/// Number of commands executed by type.
+	u32 num_commands_by_type[TOGO_GFX_NUM_CMD_TYPES];
+	/// Layer statistics by pipe and layer index.
+	Layer layers[TOGO_GFX_CONFIG_NUM_PIPES][TOGO_GFX_PIPE_NUM_LAYERS];
+};
+
 /// Render command key.
 struct CmdKey {
 	u64 key;
@@ -576,7 +658,68 @@ struct RenderNode {
 
 // TODO: Move to component
 /// Camera.
-struct Camera {};
+struct Camera {
+	/// Combined projection and view transform.
+	Mat4x4 view_projection;
+};
+
+/// View frustum.
+///
+/// Planes are normalized and face inward: a point p is on the inside
+/// of a plane if dot(plane.xyz, p) + plane.w >= 0.
+struct Frustum {
+	enum : unsigned {
+		NUM_PLANES = 6,
+	};
+
+	Vec4 planes[NUM_PLANES];
+};
+
+/// Render object set.
+///
+/// This is the render component manager for a world. Objects are
+/// keyed by entity and have a bounding sphere. Bounds are stored in
+/// SoA form and objects are ordered by the cell of a uniform grid
+/// their bounds center lies in so that culling can reject whole cells
+/// and test the objects within a cell in bulk.
+struct RenderObjectSet {
+	/// Grid cell.
+	///
+	/// Objects [begin, end) lie in the cell. min and max bound the
+	/// spheres of those objects.
+	struct Cell {
+		Vec3 min;
+		u32 begin;
+		Vec3 max;
+		u32 end;
+	};
+
+	bool _dirty;
+	HashMap<hash32, u32> _indices;
+	Array<EntityID> _entities;
+	Array<gfx::RenderObject> _objects;
+	Array<f32> _center_x;
+	Array<f32> _center_y;
+	Array<f32> _center_z;
+	Array<f32> _radius;
+	Array<gfx::RenderObjectSet::Cell> _cells;
+	HashMap<hash32, gfx::Camera> _cameras;
+
+	/// Visible objects from the last cull.
+	Array<gfx::RenderObject> visible;
+
+	RenderObjectSet() = delete;
+	RenderObjectSet(RenderObjectSet const&) = delete;
+	RenderObjectSet& operator=(RenderObjectSet const&) = delete;
+
+	~RenderObjectSet() = default;
+	RenderObjectSet(RenderObjectSet&&) = default;
+	RenderObjectSet& operator=(RenderObjectSet&&) = default;
+
+	RenderObjectSet(
+		Allocator& allocator
+	);
+};
 
 /** @} */ // end of doc-group lib_game_gfx_renderer
 
@@ -10,6 +10,8 @@
 #include <togo/core/string/string.hpp>
 #include <togo/game/resource/resource.hpp>
 
+#include <cstdio>
+
 namespace togo {
 namespace game {
 
@@ -9,6 +9,7 @@
 #include <togo/core/memory/memory.hpp>
 #include <togo/core/collection/array.hpp>
 #include <togo/core/collection/hash_map.hpp>
+#include <togo/core/trace/trace.hpp>
 #include <togo/game/resource/types.hpp>
 #include <togo/game/resource/resource.hpp>
 #include <togo/game/resource/resource_package.hpp>
@@ -268,6 +269,7 @@ Resource* resource_manager::load(
 		return active;
 	}}
 
+	TOGO_TRACE_ZONE("resource load");
 	auto const* const handler = hash_map::find(rm._handlers, type);
 	ResourcePackage* pkg = nullptr;
 	auto* resource = resource_manager::find_manifest(
@@ -7,6 +7,8 @@
 #include <togo/core/error/assert.hpp>
 #include <togo/core/utility/utility.hpp>
 #include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/collection/array.hpp>
 #include <togo/core/collection/hash_map.hpp>
 #include <togo/core/hash/hash.hpp>
 #include <togo/core/io/io.hpp>
@@ -68,7 +70,17 @@ void resource_package::open(
 		path.size, path.data
 	);
 
-	ser % make_ser_collection<u32>(pkg._manifest);
+	// Read the manifest in one go and deserialize it from memory
+	u32 num_resources = 0;
+	ser % num_resources;
+	array::resize(pkg._manifest, num_resources);
+	{
+	Array<u8> buffer{memory::scratch_allocator()};
+	array::resize(buffer, num_resources * SER_SIZE_RESOURCE_METADATA);
+	ser % make_ser_buffer(array::begin(buffer), array::size(buffer));
+	BinaryMemoryInputSerializer ser_manifest{buffer};
+	ser_manifest % make_ser_sequence(array::begin(pkg._manifest), num_resources);
+	}
 	for (u32 i = 0; i < array::size(pkg._manifest); ++i) {
 		auto& resource = pkg._manifest[i];
 		resource.properties = 0;
@@ -35,6 +35,12 @@ enum : u32 {
 	SER_FORMAT_VERSION_PKG_MANIFEST = 3,
 };
 
+/// Serial sizes.
+enum : u32 {
+	/// Size of a serialized ResourceMetadata.
+	SER_SIZE_RESOURCE_METADATA = 8 + 8 + 4 + 4 + 4 + 4,
+};
+
 /// Resource type hasher.
 using ResourceTypeHasher = hash::Default32;
 /// Resource type.
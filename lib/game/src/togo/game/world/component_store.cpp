@@ -0,0 +1,180 @@
+#line 2 "togo/game/world/component_store.cpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#include <togo/game/config.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/game/world/types.hpp>
+#include <togo/game/world/component_store.hpp>
+
+#include <cstring>
+
+namespace togo {
+namespace game {
+
+ComponentStore::~ComponentStore() {
+	_entities._allocator->deallocate(_block);
+}
+
+ComponentStore::ComponentStore(
+	Allocator& allocator,
+	ArrayRef<ComponentStore::ColumnDef const> const& columns
+)
+	: _num_columns(columns.size())
+	, _capacity(0)
+	, _columns()
+	, _block(nullptr)
+	, _entities(allocator)
+	, _sparse(allocator)
+{
+	TOGO_ASSERT(
+		_num_columns > 0 && _num_columns <= ComponentStore::MAX_COLUMNS,
+		"invalid number of columns"
+	);
+	for (unsigned i = 0; i < _num_columns; ++i) {
+		auto const& def = columns[i];
+		TOGO_ASSERTE(def.size > 0 && def.alignment > 0);
+		_columns[i].def = def;
+		_columns[i].data = nullptr;
+	}
+}
+
+// Reallocate all columns in a single block
+static void set_capacity(ComponentStore& store, unsigned const new_capacity) {
+	unsigned size = 0;
+	unsigned alignment = 1;
+	unsigned offsets[ComponentStore::MAX_COLUMNS];
+	for (unsigned i = 0; i < store._num_columns; ++i) {
+		auto const& def = store._columns[i].def;
+		size = (size + def.alignment - 1) & ~(def.alignment - 1);
+		offsets[i] = size;
+		size += new_capacity * def.size;
+		alignment = max(alignment, unsigned{def.alignment});
+	}
+
+	Allocator& allocator = *store._entities._allocator;
+	u8* const block = static_cast<u8*>(allocator.allocate(size, alignment));
+	unsigned const num_instances = array::size(store._entities);
+	for (unsigned i = 0; i < store._num_columns; ++i) {
+		auto& column = store._columns[i];
+		u8* const data = block + offsets[i];
+		if (num_instances > 0) {
+			std::memcpy(data, column.data, num_instances * column.def.size);
+		}
+		column.data = data;
+	}
+	allocator.deallocate(store._block);
+	store._block = block;
+	store._capacity = new_capacity;
+}
+
+/// Reserve space for at least capacity instances.
+void component_store::reserve(ComponentStore& store, unsigned const capacity) {
+	if (capacity > store._capacity) {
+		set_capacity(store, capacity);
+	}
+	array::reserve(store._entities, capacity);
+}
+
+/// Find the instance of an entity.
+///
+/// Returns INSTANCE_NULL if the entity has no instance.
+unsigned component_store::find(
+	ComponentStore const& store,
+	EntityID const entity_id
+) {
+	unsigned const index = entity_id.index();
+	if (index < array::size(store._sparse)) {
+		u32 const instance = store._sparse[index];
+		if (
+			instance != 0 &&
+			store._entities[instance - 1].value == entity_id.value
+		) {
+			return instance - 1;
+		}
+	}
+	return component_store::INSTANCE_NULL;
+}
+
+/// Add an instance for an entity.
+///
+/// Columns of the instance are zeroed. Returns the instance.
+/// If a destroyed entity with the same index still has an instance,
+/// that instance is removed first.
+/// An assertion will fail if the entity already has an instance.
+unsigned component_store::add(
+	ComponentStore& store,
+	EntityID const entity_id
+) {
+	TOGO_ASSERT(
+		!component_store::has(store, entity_id),
+		"entity already has an instance"
+	);
+	unsigned const index = entity_id.index();
+	if (index < array::size(store._sparse) && store._sparse[index] != 0) {
+		component_store::remove(store, store._entities[store._sparse[index] - 1]);
+	}
+	unsigned const instance = array::size(store._entities);
+	if (instance == store._capacity) {
+		set_capacity(store, store._capacity * 2 + 8);
+	}
+	array::push_back(store._entities, entity_id);
+	if (index >= array::size(store._sparse)) {
+		unsigned const prev_size = array::size(store._sparse);
+		array::resize(store._sparse, index + 1);
+		std::memset(
+			array::begin(store._sparse) + prev_size, 0,
+			(index + 1 - prev_size) * sizeof(u32)
+		);
+	}
+	store._sparse[index] = instance + 1;
+	for (unsigned i = 0; i < store._num_columns; ++i) {
+		auto const& column = store._columns[i];
+		std::memset(column.data + instance * column.def.size, 0, column.def.size);
+	}
+	return instance;
+}
+
+/// Remove the instance of an entity.
+///
+/// The last instance is moved into its place.
+/// Returns false if the entity has no instance.
+bool component_store::remove(
+	ComponentStore& store,
+	EntityID const entity_id
+) {
+	unsigned const instance = component_store::find(store, entity_id);
+	if (instance == component_store::INSTANCE_NULL) {
+		return false;
+	}
+	unsigned const last = array::size(store._entities) - 1;
+	if (instance != last) {
+		EntityID const last_id = store._entities[last];
+		store._entities[instance] = last_id;
+		store._sparse[last_id.index()] = instance + 1;
+		for (unsigned i = 0; i < store._num_columns; ++i) {
+			auto const& column = store._columns[i];
+			std::memcpy(
+				column.data + instance * column.def.size,
+				column.data + last * column.def.size,
+				column.def.size
+			);
+		}
+	}
+	store._sparse[entity_id.index()] = 0;
+	array::pop_back(store._entities);
+	return true;
+}
+
+/// Remove all instances.
+void component_store::clear(ComponentStore& store) {
+	array::clear(store._entities);
+	array::clear(store._sparse);
+}
+
+} // namespace game
+} // namespace togo
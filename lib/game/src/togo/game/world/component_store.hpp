@@ -0,0 +1,163 @@
+#line 2 "togo/game/world/component_store.hpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+
+@file
+@brief ComponentStore interface.
+@ingroup lib_game_world
+@ingroup lib_game_world_component_store
+
+@defgroup lib_game_world_component_store ComponentStore
+@ingroup lib_game_world
+@details
+
+A component store keeps the data of one component type for a world.
+Each column holds one field of every instance contiguously, so systems
+iterate over exactly the fields they use. Entities map to instances
+through a sparse array indexed by entity index.
+
+Column types must be trivially copyable; instances are moved with
+memcpy() and zeroed when added.
+*/
+
+#pragma once
+
+#include <togo/game/config.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/types.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/game/entity/types.hpp>
+#include <togo/game/world/types.hpp>
+#include <togo/game/world/world_manager.hpp>
+#include <togo/game/world/component_store.gen_interface>
+
+#include <type_traits>
+
+namespace togo {
+namespace game {
+namespace component_store {
+
+/**
+	@addtogroup lib_game_world_component_store
+	@{
+*/
+
+enum : unsigned {
+	/// Null instance.
+	INSTANCE_NULL = ~0u,
+};
+
+/// Column definition for type T.
+template<class T>
+inline constexpr ComponentStore::ColumnDef column_def() {
+	static_assert(
+		std::is_trivially_copyable<T>::value,
+		"column type must be trivially copyable"
+	);
+	return ComponentStore::ColumnDef{sizeof(T), alignof(T)};
+}
+
+/// Number of instances.
+inline unsigned size(ComponentStore const& store) {
+	return array::size(store._entities);
+}
+
+/// Whether there are any instances.
+inline bool any(ComponentStore const& store) {
+	return array::any(store._entities);
+}
+
+/// Entity of each instance.
+inline ArrayRef<EntityID const> entities(ComponentStore const& store) {
+	return array_ref(array::begin(store._entities), array::size(store._entities));
+}
+
+/// Whether an entity has an instance.
+inline bool has(ComponentStore const& store, EntityID const entity_id) {
+	return component_store::find(store, entity_id) != INSTANCE_NULL;
+}
+
+/// Column data.
+///
+/// The reference is invalidated when an instance is added.
+/// An assertion will fail if T does not match the size of the column.
+template<class T>
+inline ArrayRef<T> column(ComponentStore& store, unsigned const index) {
+	TOGO_DEBUG_ASSERTE(index < store._num_columns);
+	auto const& column = store._columns[index];
+	TOGO_DEBUG_ASSERTE(
+		column.def.size == sizeof(T) &&
+		column.def.alignment == alignof(T)
+	);
+	return array_ref(reinterpret_cast<T*>(column.data), array::size(store._entities));
+}
+
+/// Column data.
+template<class T>
+inline ArrayRef<T const> column(ComponentStore const& store, unsigned const index) {
+	return column<T>(const_cast<ComponentStore&>(store), index);
+}
+
+/// Register a component manager that keeps a component store for each
+/// world.
+///
+/// Stores have a column for each type in Columns.
+template<class... Columns>
+inline void register_component_manager(
+	WorldManager& world_manager,
+	ComponentNameHash const name_hash
+) {
+	static_assert(
+		sizeof...(Columns) > 0 && sizeof...(Columns) <= ComponentStore::MAX_COLUMNS,
+		"invalid number of columns"
+	);
+	struct Funcs {
+		static void* create(WorldManager& /*world_manager*/) {
+			ComponentStore::ColumnDef const columns[]{
+				component_store::column_def<Columns>()...
+			};
+			return TOGO_CONSTRUCT(
+				memory::default_allocator(), ComponentStore,
+				memory::default_allocator(), columns
+			);
+		}
+
+		static void destroy(WorldManager& /*world_manager*/, void* data) {
+			auto* const store = static_cast<ComponentStore*>(data);
+			TOGO_DESTROY(memory::default_allocator(), store);
+		}
+
+		static void clear(WorldManager& /*world_manager*/, void* data) {
+			component_store::clear(*static_cast<ComponentStore*>(data));
+		}
+	};
+	world_manager::register_component_manager(world_manager, ComponentManagerDef{
+		name_hash,
+		Funcs::create,
+		Funcs::destroy,
+		Funcs::clear
+	});
+}
+
+/// Component store of a world.
+///
+/// The component manager must have been registered with
+/// component_store::register_component_manager().
+/// Returns nullptr if no component manager is registered with name_hash.
+inline ComponentStore* get(
+	WorldManager& world_manager,
+	WorldID const& world_id,
+	ComponentNameHash const name_hash
+) {
+	return static_cast<ComponentStore*>(
+		world_manager::component_manager(world_manager, world_id, name_hash)
+	);
+}
+
+/** @} */ // end of doc-group lib_game_world_component_store
+
+} // namespace component_store
+} // namespace game
+} // namespace togo
@@ -0,0 +1,259 @@
+#line 2 "togo/game/world/system_scheduler.cpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#include <togo/game/config.hpp>
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/hash/hash.hpp>
+#include <togo/core/system/system.hpp>
+#include <togo/core/threading/mutex.hpp>
+#include <togo/core/threading/task_manager.hpp>
+#include <togo/core/trace/trace.hpp>
+#include <togo/game/world/types.hpp>
+#include <togo/game/world/system_scheduler.hpp>
+
+namespace togo {
+namespace game {
+
+SystemScheduler::SystemScheduler(
+	Allocator& allocator
+)
+	: _graph_dirty(false)
+	, _dt(0.0f)
+	, _task_manager(nullptr)
+	, _root()
+	, _mutex(MutexType::normal)
+	, _systems(allocator)
+	, _access(allocator)
+	, _dependents(allocator)
+{}
+
+inline static ArrayRef<ComponentNameHash const> reads(
+	SystemScheduler const& scheduler,
+	SystemScheduler::System const& sys
+) {
+	return array_ref(array::begin(scheduler._access) + sys.access_begin, sys.num_reads);
+}
+
+inline static ArrayRef<ComponentNameHash const> writes(
+	SystemScheduler const& scheduler,
+	SystemScheduler::System const& sys
+) {
+	return array_ref(
+		array::begin(scheduler._access) + sys.access_begin + sys.num_reads,
+		sys.num_writes
+	);
+}
+
+static bool intersects(
+	ArrayRef<ComponentNameHash const> const& x,
+	ArrayRef<ComponentNameHash const> const& y
+) {
+	for (auto const a : x) {
+		for (auto const b : y) {
+			if (a == b) {
+				return true;
+			}
+		}
+	}
+	return false;
+}
+
+// Whether b must wait for a
+static bool conflicts(
+	SystemScheduler const& scheduler,
+	SystemScheduler::System const& a,
+	SystemScheduler::System const& b
+) {
+	auto const a_writes = writes(scheduler, a);
+	return
+		intersects(a_writes, writes(scheduler, b)) ||
+		intersects(a_writes, reads(scheduler, b)) ||
+		intersects(reads(scheduler, a), writes(scheduler, b))
+	;
+}
+
+// Systems only depend on earlier systems, so the graph is acyclic and
+// the order systems were added in is a valid serial order
+static void build_graph(SystemScheduler& scheduler) {
+	array::clear(scheduler._dependents);
+	for (auto& sys : scheduler._systems) {
+		sys.num_dependencies = 0;
+	}
+	unsigned const num_systems = array::size(scheduler._systems);
+	for (unsigned i = 0; i < num_systems; ++i) {
+		auto& sys = scheduler._systems[i];
+		sys.dependents_begin = array::size(scheduler._dependents);
+		for (unsigned j = i + 1; j < num_systems; ++j) {
+			auto& dependent = scheduler._systems[j];
+			if (conflicts(scheduler, sys, dependent)) {
+				array::push_back(scheduler._dependents, u32{j});
+				++dependent.num_dependencies;
+			}
+		}
+		sys.num_dependents = array::size(scheduler._dependents) - sys.dependents_begin;
+	}
+	scheduler._graph_dirty = false;
+}
+
+static SystemScheduler::System const* find_system(
+	SystemScheduler const& scheduler,
+	SystemNameHash const name_hash
+) {
+	for (auto const& sys : scheduler._systems) {
+		if (sys.name_hash == name_hash) {
+			return &sys;
+		}
+	}
+	return nullptr;
+}
+
+static void run_system(SystemScheduler::System& sys, f32 const dt) {
+	TOGO_TRACE_ZONE(sys.name);
+	f64 const start = system::time_monotonic();
+	sys.func_update(sys.data, dt);
+	sys.duration = system::time_monotonic() - start;
+}
+
+static void spawn_system(SystemScheduler& scheduler, SystemScheduler::System& sys);
+
+static void system_task_func(TaskID /*task_id*/, void* task_data) {
+	auto& sys = *static_cast<SystemScheduler::System*>(task_data);
+	auto& scheduler = *sys.scheduler;
+	run_system(sys, scheduler._dt);
+
+	// This task still holds the root, so dependents can be parented
+	// to it safely
+	bool ready;
+	for (u32 const index : array_ref(
+		array::begin(scheduler._dependents) + sys.dependents_begin,
+		sys.num_dependents
+	)) {
+		auto& dependent = scheduler._systems[index];
+		{
+			MutexLock lock{scheduler._mutex};
+			ready = --dependent.num_pending == 0;
+		}
+		if (ready) {
+			spawn_system(scheduler, dependent);
+		}
+	}
+}
+
+static void spawn_system(SystemScheduler& scheduler, SystemScheduler::System& sys) {
+	TaskManager& tm = *scheduler._task_manager;
+	TaskID const id = task_manager::add_hold(tm, TaskWork{&sys, system_task_func});
+	task_manager::set_parent(tm, id, scheduler._root);
+	task_manager::end_hold(tm, id);
+}
+
+/// Add a system.
+///
+/// The system runs after every system added before it that it
+/// conflicts with.
+/// An assertion will fail if a system with the same name has already
+/// been added.
+void system_scheduler::add(
+	SystemScheduler& scheduler,
+	SystemDef const& def
+) {
+	TOGO_DEBUG_ASSERTE(def.name && def.func_update);
+	SystemNameHash const name_hash = hash::calc32(StringRef{def.name, cstr_tag{}});
+	TOGO_ASSERT(
+		!system_scheduler::has(scheduler, name_hash),
+		"a system has already been added with this name"
+	);
+	SystemScheduler::System sys{};
+	sys.scheduler = &scheduler;
+	sys.name = def.name;
+	sys.name_hash = name_hash;
+	sys.func_update = def.func_update;
+	sys.data = def.data;
+	sys.access_begin = array::size(scheduler._access);
+	sys.num_reads = def.reads.size();
+	sys.num_writes = def.writes.size();
+	for (auto const component : def.reads) {
+		array::push_back(scheduler._access, component);
+	}
+	for (auto const component : def.writes) {
+		array::push_back(scheduler._access, component);
+	}
+	sys.duration = 0.0;
+	array::push_back(scheduler._systems, sys);
+	scheduler._graph_dirty = true;
+}
+
+/// Whether a system has been added.
+bool system_scheduler::has(
+	SystemScheduler const& scheduler,
+	SystemNameHash const name_hash
+) {
+	return find_system(scheduler, name_hash);
+}
+
+/// Time taken by a system in the last update in seconds.
+///
+/// An assertion will fail if the system has not been added.
+f64 system_scheduler::duration(
+	SystemScheduler const& scheduler,
+	SystemNameHash const name_hash
+) {
+	auto const* const sys = find_system(scheduler, name_hash);
+	TOGO_ASSERT(sys, "system does not exist");
+	return sys->duration;
+}
+
+/// Remove all systems.
+void system_scheduler::clear(SystemScheduler& scheduler) {
+	array::clear(scheduler._systems);
+	array::clear(scheduler._access);
+	array::clear(scheduler._dependents);
+	scheduler._graph_dirty = false;
+}
+
+/// Update all systems.
+///
+/// If task_manager is non-null, systems that do not conflict are run
+/// concurrently as tasks. Otherwise, they are run serially in the
+/// order they were added.
+/// This returns when all systems have completed.
+void system_scheduler::update(
+	SystemScheduler& scheduler,
+	TaskManager* const task_manager,
+	f32 const dt
+) {
+	if (array::empty(scheduler._systems)) {
+		return;
+	}
+	TOGO_TRACE_ZONE("systems");
+	if (!task_manager) {
+		for (auto& sys : scheduler._systems) {
+			run_system(sys, dt);
+		}
+		return;
+	}
+
+	if (scheduler._graph_dirty) {
+		build_graph(scheduler);
+	}
+	for (auto& sys : scheduler._systems) {
+		sys.num_pending = sys.num_dependencies;
+	}
+	scheduler._dt = dt;
+	scheduler._task_manager = task_manager;
+	scheduler._root = task_manager::add_hold_empty(*task_manager);
+	for (auto& sys : scheduler._systems) {
+		if (sys.num_dependencies == 0) {
+			spawn_system(scheduler, sys);
+		}
+	}
+	task_manager::end_hold(*task_manager, scheduler._root);
+	task_manager::wait(*task_manager, scheduler._root);
+	scheduler._task_manager = nullptr;
+}
+
+} // namespace game
+} // namespace togo
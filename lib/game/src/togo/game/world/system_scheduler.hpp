@@ -0,0 +1,49 @@
+#line 2 "togo/game/world/system_scheduler.hpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+
+@file
+@brief SystemScheduler interface.
+@ingroup lib_game_world
+@ingroup lib_game_world_system_scheduler
+
+@defgroup lib_game_world_system_scheduler SystemScheduler
+@ingroup lib_game_world
+@details
+
+Systems declare the components they read and write. A system waits
+for each system added before it that writes a component it accesses or
+reads a component it writes. Systems are run as tasks as soon as the
+systems they wait for have completed.
+
+The task manager can only hold a limited number of tasks, so a
+scheduler should not have more than a few dozen systems.
+*/
+
+#pragma once
+
+#include <togo/game/config.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/threading/types.hpp>
+#include <togo/game/world/types.hpp>
+#include <togo/game/world/system_scheduler.gen_interface>
+
+namespace togo {
+namespace game {
+namespace system_scheduler {
+
+/**
+	@addtogroup lib_game_world_system_scheduler
+	@{
+*/
+
+/// Number of systems.
+inline unsigned size(SystemScheduler const& scheduler) {
+	return array::size(scheduler._systems);
+}
+
+/** @} */ // end of doc-group lib_game_world_system_scheduler
+
+} // namespace system_scheduler
+} // namespace game
+} // namespace togo
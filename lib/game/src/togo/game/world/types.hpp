@@ -13,8 +13,10 @@
 #include <togo/game/config.hpp>
 #include <togo/core/types.hpp>
 #include <togo/core/utility/traits.hpp>
+#include <togo/core/utility/types.hpp>
 #include <togo/core/memory/types.hpp>
 #include <togo/core/collection/types.hpp>
+#include <togo/core/threading/types.hpp>
 #include <togo/core/hash/types.hpp>
 #include <togo/core/hash/hash.hpp>
 #include <togo/game/entity/types.hpp>
@@ -52,6 +54,21 @@ operator"" _component_name(
 	return hash::calc_ce<ComponentNameHasher>(data, size);
 }
 
+/// System name hasher.
+using SystemNameHasher = hash::Default32;
+
+/// System name hash.
+using SystemNameHash = SystemNameHasher::Value;
+
+/// System name hash literal.
+inline constexpr SystemNameHash
+operator"" _system_name(
+	char const* const data,
+	std::size_t const size
+) {
+	return hash::calc_ce<SystemNameHasher>(data, size);
+}
+
 /// Component manager definition.
 struct ComponentManagerDef {
 	using create_func_type = void* (
@@ -76,6 +93,117 @@ struct ComponentManagerDef {
 	clear_func_type* func_clear;
 };
 
+/// Component store.
+///
+/// Components keyed by entity, stored as packed columns (structure of
+/// arrays). Instances are indexed [0, size) in every column, and
+/// removal moves the last instance into the hole.
+struct ComponentStore {
+	enum : unsigned {
+		MAX_COLUMNS = 8,
+	};
+
+	/// Column definition.
+	struct ColumnDef {
+		u32 size;
+		u32 alignment;
+	};
+
+	struct Column {
+		ColumnDef def;
+		u8* data;
+	};
+
+	unsigned _num_columns;
+	unsigned _capacity;
+	Column _columns[MAX_COLUMNS];
+	void* _block;
+	Array<EntityID> _entities;
+	// Entity index -> instance + 1
+	Array<u32> _sparse;
+
+	ComponentStore() = delete;
+	ComponentStore(ComponentStore const&) = delete;
+	ComponentStore(ComponentStore&&) = delete;
+	ComponentStore& operator=(ComponentStore const&) = delete;
+	ComponentStore& operator=(ComponentStore&&) = delete;
+
+	~ComponentStore();
+	ComponentStore(
+		Allocator& allocator,
+		ArrayRef<ColumnDef const> const& columns
+	);
+};
+
+/// System definition.
+///
+/// A system updates components. Systems that access the same component
+/// where either writes to it run in the order they were added, and
+/// others may run concurrently.
+struct SystemDef {
+	using update_func_type = void (
+		void* data,
+		f32 dt
+	);
+
+	/// Name.
+	///
+	/// This must have static storage duration.
+	char const* name;
+
+	/// Update the system.
+	update_func_type* func_update;
+	/// Data passed to func_update.
+	void* data;
+
+	/// Components read.
+	ArrayRef<ComponentNameHash const> reads;
+	/// Components written.
+	ArrayRef<ComponentNameHash const> writes;
+};
+
+/// System scheduler.
+struct SystemScheduler {
+	struct System {
+		SystemScheduler* scheduler;
+		char const* name;
+		SystemNameHash name_hash;
+		SystemDef::update_func_type* func_update;
+		void* data;
+		// Reads followed by writes in _access
+		u32 access_begin;
+		u32 num_reads;
+		u32 num_writes;
+		// Systems that must wait for this one in _dependents
+		u32 dependents_begin;
+		u32 num_dependents;
+		u32 num_dependencies;
+		// Dependencies yet to complete in the current update
+		u32 num_pending;
+		f64 duration;
+	};
+
+	bool _graph_dirty;
+	f32 _dt;
+	TaskManager* _task_manager;
+	TaskID _root;
+	Mutex _mutex;
+	Array<SystemScheduler::System> _systems;
+	Array<ComponentNameHash> _access;
+	Array<u32> _dependents;
+
+	SystemScheduler() = delete;
+	SystemScheduler(SystemScheduler const&) = delete;
+	SystemScheduler(SystemScheduler&&) = delete;
+	SystemScheduler& operator=(SystemScheduler const&) = delete;
+	SystemScheduler& operator=(SystemScheduler&&) = delete;
+
+	~SystemScheduler() = default;
+	SystemScheduler(
+		Allocator& allocator
+	);
+};
+
 /// World ID.
 struct WorldID {
 	using value_type = u32;
@@ -104,6 +104,20 @@ WorldID world_manager::create(WorldManager& wm) {
 	return WorldID{index | (wm._instances[index].generation << WorldID::INDEX_BITS)};
 }
 
+/// Component manager data for a world.
+///
+/// Returns nullptr if no component manager is registered with name_hash.
+/// An assertion will fail if the world is not alive.
+void* world_manager::component_manager(
+	WorldManager& wm,
+	WorldID const& id,
+	ComponentNameHash const name_hash
+) {
+	TOGO_ASSERTE(world_manager::alive(wm, id));
+	void** data = hash_map::find(wm._instances[id.index()].component_managers, name_hash);
+	return data ? *data : nullptr;
+}
+
 /// Destroy world.
 void world_manager::destroy(
 	WorldManager& wm,
@@ -16,6 +16,12 @@ togo.make_tests("general", {
 togo.make_tests("gfx", {
 	["renderer_triangle"] = {nil, configs},
 	["renderer_pipeline"] = {nil, configs},
+	["render_object_set"] = {nil, configs},
+})
+
+togo.make_tests("world", {
+	["component_store"] = {nil, configs},
+	["system_scheduler"] = {nil, configs},
 })
 
 togo.make_tests("resource", {
@@ -4,6 +4,8 @@
 #include <togo/game/entity/entity_manager.hpp>
 #include <togo/game/world/types.hpp>
 #include <togo/game/world/world_manager.hpp>
+#include <togo/game/world/component_store.hpp>
+#include <togo/game/world/system_scheduler.hpp>
 #include <togo/game/gfx/types.hpp>
 #include <togo/game/gfx/gfx.hpp>
 #include <togo/game/gfx/command.hpp>
@@ -0,0 +1,121 @@
+#include <togo/core/error/assert.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/math/types.hpp>
+#include <togo/core/math/vector/3_type.hpp>
+#include <togo/core/collection/array.hpp>
+#include <togo/core/threading/task_manager.hpp>
+#include <togo/game/gfx/types.hpp>
+#include <togo/game/gfx/render_object_set.hpp>
+
+#include <togo/support/test.hpp>
+
+#include <algorithm>
+#include <random>
+
+using namespace togo;
+using namespace togo::game;
+
+enum : unsigned {
+	NUM_OBJECTS = 50000,
+	EXTENT = 100,
+};
+
+static Vec3 s_centers[NUM_OBJECTS];
+static f32 s_radii[NUM_OBJECTS];
+
+// Objects inside the axis-aligned box [-EXTENT, EXTENT]
+static unsigned count_visible_brute(unsigned const num_objects) {
+	unsigned count = 0;
+	for (unsigned i = 0; i < num_objects; ++i) {
+		auto const& c = s_centers[i];
+		f32 const r = s_radii[i];
+		f32 const e = static_cast<f32>(EXTENT);
+		if (
+			c.x + r >= -e && c.x - r <= e &&
+			c.y + r >= -e && c.y - r <= e &&
+			c.z + r >= -e && c.z - r <= e
+		) {
+			++count;
+		}
+	}
+	return count;
+}
+
+static void check_visible(
+	gfx::RenderObjectSet& set,
+	gfx::Frustum const& frustum,
+	TaskManager* task_manager,
+	unsigned const num_objects
+) {
+	unsigned const expected = count_visible_brute(num_objects);
+	unsigned const num_visible = gfx::render_object_set::cull(set, frustum, task_manager);
+	TOGO_LOGF(
+		"visible: %u / %u (expected %u, %s)\n",
+		num_visible, num_objects, expected,
+		task_manager ? "parallel" : "serial"
+	);
+	TOGO_ASSERTE(num_visible == expected);
+	TOGO_ASSERTE(array::size(set.visible) == num_visible);
+
+	// Each visible object must be unique
+	Array<u32> ids{memory::default_allocator()};
+	for (auto const& object : set.visible) {
+		array::push_back(ids, object.binding._value);
+	}
+	std::sort(array::begin(ids), array::end(ids));
+	TOGO_ASSERTE(std::adjacent_find(array::begin(ids), array::end(ids)) == array::end(ids));
+}
+
+signed main() {
+	memory_init();
+
+	std::mt19937 rng{42};
+	std::uniform_real_distribution<f32> pos_dist{-3.0f * EXTENT, 3.0f * EXTENT};
+	std::uniform_real_distribution<f32> radius_dist{0.5f, 8.0f};
+
+	{
+	TaskManager tm{4, memory::default_allocator()};
+	gfx::RenderObjectSet set{memory::default_allocator()};
+
+	// Orthographic view of the box [-EXTENT, EXTENT]
+	gfx::Camera camera{};
+	camera.view_projection.data[0].x = 1.0f / EXTENT;
+	camera.view_projection.data[1].y = 1.0f / EXTENT;
+	camera.view_projection.data[2].z = 1.0f / EXTENT;
+	gfx::Frustum const frustum = gfx::render_object_set::camera_frustum(camera);
+
+	gfx::RenderObject object{};
+	for (unsigned i = 0; i < NUM_OBJECTS; ++i) {
+		s_centers[i] = Vec3{pos_dist(rng), pos_dist(rng), pos_dist(rng)};
+		s_radii[i] = radius_dist(rng);
+		object.binding._value = i;
+		gfx::render_object_set::add(set, EntityID{i}, object, s_centers[i], s_radii[i]);
+	}
+	TOGO_ASSERTE(gfx::render_object_set::size(set) == NUM_OBJECTS);
+	check_visible(set, frustum, nullptr, NUM_OBJECTS);
+	check_visible(set, frustum, &tm, NUM_OBJECTS);
+
+	// Small moves stay within cells; large moves rebuild the grid
+	for (unsigned i = 0; i < NUM_OBJECTS; i += 7) {
+		s_centers[i].x += (i & 1) ? 0.25f : 2.0f * EXTENT;
+		gfx::render_object_set::update(set, EntityID{i}, object.transform, s_centers[i]);
+	}
+	check_visible(set, frustum, nullptr, NUM_OBJECTS);
+	check_visible(set, frustum, &tm, NUM_OBJECTS);
+
+	// Remove the upper half
+	for (unsigned i = NUM_OBJECTS / 2; i < NUM_OBJECTS; ++i) {
+		gfx::render_object_set::remove(set, EntityID{i});
+	}
+	TOGO_ASSERTE(gfx::render_object_set::size(set) == NUM_OBJECTS / 2);
+	TOGO_ASSERTE(!gfx::render_object_set::has(set, EntityID{NUM_OBJECTS - 1}));
+	check_visible(set, frustum, nullptr, NUM_OBJECTS / 2);
+	check_visible(set, frustum, &tm, NUM_OBJECTS / 2);
+
+	gfx::render_object_set::clear(set);
+	TOGO_ASSERTE(gfx::render_object_set::cull(set, frustum, &tm) == 0);
+	}
+	return 0;
+}
@@ -13,6 +13,7 @@
 #include <togo/game/gfx/command.hpp>
 #include <togo/game/gfx/render_node.hpp>
 #include <togo/game/gfx/renderer.hpp>
+#include <togo/game/gfx/render_object_set.hpp>
 #include <togo/game/gfx/renderer/private.hpp>
 #include <togo/game/gfx/renderer/opengl.hpp>
 #include <togo/game/resource/resource_handler.hpp>
@@ -150,6 +151,12 @@ void TestAppModel::init(TestApp& app) {
 
 	app.data.world = world_manager::create(app.world_manager);
 	app.data.camera = entity_manager::create(app.entity_manager);
+	auto* const render_object_set = static_cast<gfx::RenderObjectSet*>(
+		world_manager::component_manager(
+			app.world_manager, app.data.world, gfx::render_object_set::COMPONENT_NAME
+		)
+	);
+	gfx::render_object_set::set_camera(*render_object_set, app.data.camera, gfx::Camera{});
 }
 
 template<>
@@ -0,0 +1,168 @@
+#include <togo/core/error/assert.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/system/system.hpp>
+#include <togo/game/entity/types.hpp>
+#include <togo/game/entity/entity_manager.hpp>
+#include <togo/game/world/types.hpp>
+#include <togo/game/world/world_manager.hpp>
+#include <togo/game/world/component_store.hpp>
+
+#include <togo/support/test.hpp>
+
+using namespace togo;
+using namespace togo::game;
+
+namespace {
+
+struct Position {
+	f32 x, y, z;
+};
+
+enum : unsigned {
+	COLUMN_POSITION = 0,
+	COLUMN_SPEED = 1,
+	COLUMN_ID = 2,
+
+	NUM_ENTITIES = 1000,
+	BENCH_NUM_ENTITIES = 500000,
+	BENCH_NUM_STEPS = 100,
+};
+
+static constexpr ComponentNameHash const COMPONENT_NAME = "motion"_component_name;
+
+} // anonymous namespace
+
+static void check_store(ComponentStore const& store, unsigned const size) {
+	TOGO_ASSERTE(component_store::size(store) == size);
+	auto const entities = component_store::entities(store);
+	auto const ids = component_store::column<u32>(store, COLUMN_ID);
+	auto const speeds = component_store::column<f32>(store, COLUMN_SPEED);
+	TOGO_ASSERTE(ids.size() == size && speeds.size() == size);
+	for (unsigned i = 0; i < size; ++i) {
+		TOGO_ASSERTE(component_store::find(store, entities[i]) == i);
+		TOGO_ASSERTE(ids[i] == entities[i].value);
+		TOGO_ASSERTE(speeds[i] == static_cast<f32>(entities[i].index()));
+	}
+}
+
+static void add_instance(ComponentStore& store, EntityID const id) {
+	unsigned const instance = component_store::add(store, id);
+	TOGO_ASSERTE(component_store::has(store, id));
+	TOGO_ASSERTE(component_store::column<Position>(store, COLUMN_POSITION)[instance].x == 0.0f);
+	component_store::column<f32>(store, COLUMN_SPEED)[instance] = static_cast<f32>(id.index());
+	component_store::column<u32>(store, COLUMN_ID)[instance] = id.value;
+}
+
+static void test_store() {
+	EntityManager em{memory::default_allocator()};
+	ComponentStore::ColumnDef const columns[]{
+		component_store::column_def<Position>(),
+		component_store::column_def<f32>(),
+		component_store::column_def<u32>(),
+	};
+	ComponentStore store{memory::default_allocator(), columns};
+	TOGO_ASSERTE(!component_store::any(store));
+
+	EntityID ids[NUM_ENTITIES];
+	for (auto& id : ids) {
+		id = entity_manager::create(em);
+		add_instance(store, id);
+	}
+	check_store(store, NUM_ENTITIES);
+
+	// Every other entity, from the front so that the last instance
+	// moves into each hole
+	for (unsigned i = 0; i < NUM_ENTITIES; i += 2) {
+		TOGO_ASSERTE(component_store::remove(store, ids[i]));
+		TOGO_ASSERTE(!component_store::has(store, ids[i]));
+		TOGO_ASSERTE(!component_store::remove(store, ids[i]));
+	}
+	check_store(store, NUM_ENTITIES / 2);
+
+	// Stale IDs don't match reused indices
+	entity_manager::destroy(em, ids[0]);
+	EntityID const reused{ids[0].index() | ((ids[0].generation() + 1) << EntityID::INDEX_BITS)};
+	TOGO_ASSERTE(!component_store::has(store, reused));
+	add_instance(store, reused);
+	TOGO_ASSERTE(!component_store::has(store, ids[0]));
+	check_store(store, NUM_ENTITIES / 2 + 1);
+
+	// Reusing the index of a destroyed entity that still has an
+	// instance replaces the stale instance
+	TOGO_ASSERTE(component_store::has(store, ids[1]));
+	entity_manager::destroy(em, ids[1]);
+	EntityID const reused_live{ids[1].index() | ((ids[1].generation() + 1) << EntityID::INDEX_BITS)};
+	add_instance(store, reused_live);
+	TOGO_ASSERTE(!component_store::has(store, ids[1]));
+	TOGO_ASSERTE(!component_store::remove(store, ids[1]));
+	check_store(store, NUM_ENTITIES / 2 + 1);
+	for (auto const entity : component_store::entities(store)) {
+		TOGO_ASSERTE(entity.value != ids[1].value);
+	}
+
+	component_store::clear(store);
+	TOGO_ASSERTE(component_store::size(store) == 0);
+	TOGO_ASSERTE(!component_store::has(store, ids[1]));
+}
+
+static void test_world() {
+	WorldManager wm{memory::default_allocator()};
+	component_store::register_component_manager<Position, f32, u32>(wm, COMPONENT_NAME);
+	WorldID const world_id = world_manager::create(wm);
+	ComponentStore* store = component_store::get(wm, world_id, COMPONENT_NAME);
+	TOGO_ASSERTE(store && store->_num_columns == 3);
+	TOGO_ASSERTE(!component_store::get(wm, world_id, "none"_component_name));
+
+	add_instance(*store, EntityID{1});
+	check_store(*store, 1);
+	world_manager::destroy(wm, world_id);
+	TOGO_ASSERTE(component_store::size(*store) == 0);
+}
+
+static void bench() {
+	EntityManager em{memory::default_allocator()};
+	ComponentStore::ColumnDef const columns[]{
+		component_store::column_def<Position>(),
+		component_store::column_def<f32>(),
+		component_store::column_def<u32>(),
+	};
+	ComponentStore store{memory::default_allocator(), columns};
+	component_store::reserve(store, BENCH_NUM_ENTITIES);
+	for (unsigned i = 0; i < BENCH_NUM_ENTITIES; ++i) {
+		EntityID const id = entity_manager::create(em);
+		unsigned const instance = component_store::add(store, id);
+		component_store::column<f32>(store, COLUMN_SPEED)[instance] = 1.0f;
+	}
+
+	f64 const start = system::time_monotonic();
+	for (unsigned step = 0; step < BENCH_NUM_STEPS; ++step) {
+		auto positions = component_store::column<Position>(store, COLUMN_POSITION);
+		auto const speeds = component_store::column<f32>(store, COLUMN_SPEED);
+		for (unsigned i = 0; i < positions.size(); ++i) {
+			positions[i].x += speeds[i];
+		}
+	}
+	f64 const duration = system::time_monotonic() - start;
+	TOGO_ASSERTE(
+		component_store::column<Position>(store, COLUMN_POSITION)[0].x ==
+		static_cast<f32>(BENCH_NUM_STEPS)
+	);
+	TOGO_LOGF(
+		"%u steps over %u instances: %.3fms (%.2fns per instance)\n",
+		unsigned{BENCH_NUM_STEPS}, unsigned{BENCH_NUM_ENTITIES},
+		duration * 1000.0,
+		duration * 1.0e9 / (f64{BENCH_NUM_STEPS} * BENCH_NUM_ENTITIES)
+	);
+}
+
+signed main(signed argc, char* /*argv*/[]) {
+	memory_init();
+
+	test_store();
+	test_world();
+	if (argc > 1) {
+		bench();
+	}
+	return 0;
+}
@@ -0,0 +1,146 @@
+#include <togo/core/error/assert.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
+#include <togo/core/system/system.hpp>
+#include <togo/core/threading/task_manager.hpp>
+#include <togo/game/world/types.hpp>
+#include <togo/game/world/system_scheduler.hpp>
+
+#include <togo/support/test.hpp>
+
+#include <atomic>
+
+using namespace togo;
+using namespace togo::game;
+
+namespace {
+
+enum : unsigned {
+	NUM_SYSTEMS = 6,
+	NUM_UPDATES = 100,
+	BENCH_NUM_SYSTEMS = 16,
+	BENCH_WORK_ITERATIONS = 200000,
+};
+
+struct TestSystem {
+	unsigned index;
+	unsigned start;
+	unsigned end;
+	unsigned num_updates;
+};
+
+static std::atomic<unsigned> s_clock{0};
+
+static void test_update(void* data, f32 /*dt*/) {
+	auto& sys = *static_cast<TestSystem*>(data);
+	sys.start = s_clock++;
+	system::sleep_ms(1);
+	sys.end = s_clock++;
+	++sys.num_updates;
+}
+
+static constexpr ComponentNameHash const C_POSITION = "position"_component_name;
+static constexpr ComponentNameHash const C_VELOCITY = "velocity"_component_name;
+static constexpr ComponentNameHash const C_HEALTH = "health"_component_name;
+
+} // anonymous namespace
+
+static void test(TaskManager* const task_manager) {
+	SystemScheduler scheduler{memory::default_allocator()};
+	TestSystem systems[NUM_SYSTEMS]{};
+	ComponentNameHash const r_vel[]{C_VELOCITY};
+	ComponentNameHash const w_pos[]{C_POSITION};
+	ComponentNameHash const r_pos[]{C_POSITION};
+	ComponentNameHash const w_vel[]{C_VELOCITY};
+	ComponentNameHash const w_health[]{C_HEALTH};
+
+	// 0: reads velocity, writes position
+	// 1: writes velocity -> after 0
+	// 2: writes health
+	// 3: reads position -> after 0
+	// 4: reads position -> after 0
+	// 5: writes position -> after 0, 3, 4
+	SystemDef const defs[NUM_SYSTEMS]{
+		{"integrate", test_update, &systems[0], r_vel, w_pos},
+		{"accelerate", test_update, &systems[1], null_ref_tag{}, w_vel},
+		{"regenerate", test_update, &systems[2], null_ref_tag{}, w_health},
+		{"observe_a", test_update, &systems[3], r_pos, null_ref_tag{}},
+		{"observe_b", test_update, &systems[4], r_pos, null_ref_tag{}},
+		{"constrain", test_update, &systems[5], null_ref_tag{}, w_pos},
+	};
+	for (unsigned i = 0; i < NUM_SYSTEMS; ++i) {
+		systems[i].index = i;
+		system_scheduler::add(scheduler, defs[i]);
+	}
+	TOGO_ASSERTE(system_scheduler::size(scheduler) == NUM_SYSTEMS);
+	TOGO_ASSERTE(system_scheduler::has(scheduler, "constrain"_system_name));
+	TOGO_ASSERTE(!system_scheduler::has(scheduler, "none"_system_name));
+
+	#define ORDERED(a, b) (systems[a].end < systems[b].start)
+	for (unsigned u = 0; u < NUM_UPDATES; ++u) {
+		system_scheduler::update(scheduler, task_manager, 1.0f);
+		TOGO_ASSERTE(ORDERED(0, 1));
+		TOGO_ASSERTE(ORDERED(0, 3));
+		TOGO_ASSERTE(ORDERED(0, 4));
+		TOGO_ASSERTE(ORDERED(0, 5));
+		TOGO_ASSERTE(ORDERED(3, 5));
+		TOGO_ASSERTE(ORDERED(4, 5));
+	}
+	#undef ORDERED
+	for (auto const& sys : systems) {
+		TOGO_ASSERTE(sys.num_updates == NUM_UPDATES);
+	}
+	TOGO_ASSERTE(system_scheduler::duration(scheduler, "integrate"_system_name) > 0.0);
+
+	system_scheduler::clear(scheduler);
+	TOGO_ASSERTE(system_scheduler::size(scheduler) == 0);
+}
+
+static void bench_update(void* data, f32 /*dt*/) {
+	auto& value = *static_cast<f32*>(data);
+	for (unsigned i = 0; i < BENCH_WORK_ITERATIONS; ++i) {
+		value = value * 0.999f + 1.0f;
+	}
+}
+
+static void bench() {
+	static char const* const names[BENCH_NUM_SYSTEMS]{
+		"s00", "s01", "s02", "s03", "s04", "s05", "s06", "s07",
+		"s08", "s09", "s10", "s11", "s12", "s13", "s14", "s15",
+	};
+	f32 values[BENCH_NUM_SYSTEMS]{};
+	SystemScheduler scheduler{memory::default_allocator()};
+	for (unsigned i = 0; i < BENCH_NUM_SYSTEMS; ++i) {
+		system_scheduler::add(scheduler, SystemDef{
+			names[i], bench_update, &values[i], null_ref_tag{}, null_ref_tag{}
+		});
+	}
+	TaskManager task_manager{system::num_cores() - 1, memory::default_allocator()};
+
+	f64 start = system::time_monotonic();
+	system_scheduler::update(scheduler, nullptr, 1.0f);
+	f64 const duration_serial = system::time_monotonic() - start;
+	start = system::time_monotonic();
+	system_scheduler::update(scheduler, &task_manager, 1.0f);
+	f64 const duration_parallel = system::time_monotonic() - start;
+	TOGO_LOGF(
+		"%u independent systems: serial %.3fms, parallel %.3fms (%u cores)\n",
+		unsigned{BENCH_NUM_SYSTEMS},
+		duration_serial * 1000.0, duration_parallel * 1000.0,
+		system::num_cores()
+	);
+}
+
+signed main(signed argc, char* /*argv*/[]) {
+	memory_init();
+
+	test(nullptr);
+	{
+		TaskManager task_manager{4, memory::default_allocator()};
+		test(&task_manager);
+	}
+	if (argc > 1) {
+		bench();
+	}
+	return 0;
+}
@@ -18,6 +18,7 @@ void generator_compiler::register_standard(
 	gfx_compiler::register_generator_compiler(gfx_compiler, generator_compiler::test_proxy);
 	gfx_compiler::register_generator_compiler(gfx_compiler, generator_compiler::clear);
 	gfx_compiler::register_generator_compiler(gfx_compiler, generator_compiler::fullscreen_pass);
+	gfx_compiler::register_generator_compiler(gfx_compiler, generator_compiler::instanced_objects);
 }
 
 } // namespace tool_res_build
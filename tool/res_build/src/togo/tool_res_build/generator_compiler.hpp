@@ -35,6 +35,9 @@ extern GeneratorCompiler const clear;
 /// fullscreen_pass generator compiler.
 extern GeneratorCompiler const fullscreen_pass;
 
+/// instanced_objects generator compiler.
+extern GeneratorCompiler const instanced_objects;
+
 /** @} */ // end of doc-group tool_res_build_generator_compiler
 
 } // namespace generator_compiler
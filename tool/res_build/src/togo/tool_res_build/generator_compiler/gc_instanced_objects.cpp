@@ -0,0 +1,58 @@
+#line 2 "togo/tool_res_build/generator_compiler/gc_instanced_objects.cpp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+#include <togo/tool_res_build/config.hpp>
+#include <togo/tool_res_build/types.hpp>
+#include <togo/core/utility/utility.hpp>
+#include <togo/core/log/log.hpp>
+#include <togo/core/hash/hash.hpp>
+#include <togo/core/kvs/kvs.hpp>
+#include <togo/core/serialization/serializer.hpp>
+#include <togo/core/serialization/support.hpp>
+#include <togo/core/serialization/binary_serializer.hpp>
+#include <togo/game/gfx/types.hpp>
+#include <togo/game/gfx/gfx.hpp>
+#include <togo/game/resource/resource.hpp>
+#include <togo/tool_res_build/generator_compiler.hpp>
+
+namespace togo {
+namespace tool_res_build {
+
+namespace generator_compiler {
+namespace gc_instanced_objects {
+
+static bool write(
+	GeneratorCompiler& /*gen_compiler*/,
+	BinaryOutputSerializer& ser,
+	gfx::RenderConfig const& /*render_config*/,
+	gfx::GeneratorUnit const& unit
+) {
+	auto* const k_root = static_cast<KVS const*>(unit.data);
+
+	// Fetch and validate structure
+	auto* const k_shader = kvs::find(*k_root, "shader");
+	if (!k_shader || !kvs::is_type(*k_shader, KVSType::string) || !kvs::string_size(*k_shader)) {
+		TOGO_LOG_ERROR(
+			"malformed generator: instanced_objects: "
+			"'shader' is either not a string or is empty\n"
+		);
+		return false;
+	}
+
+	ResourceNameHash const shader_name_hash = resource::hash_name(kvs::string_ref(*k_shader));
+	ser % shader_name_hash;
+	return true;
+}
+
+} // namespace gc_instanced_objects
+} // namespace generator_compiler
+
+GeneratorCompiler const generator_compiler::instanced_objects{
+	gfx::hash_generator_name("instanced_objects"),
+	generator_compiler::gc_instanced_objects::write
+};
+
+} // namespace tool_res_build
+} // namespace togo
@@ -13,10 +13,16 @@
 #include <togo/core/collection/array.hpp>
 #include <togo/core/collection/hash_map.hpp>
 #include <togo/core/string/string.hpp>
+#include <togo/core/io/memory_stream.hpp>
+#include <togo/core/io/file_stream.hpp>
 #include <togo/core/system/system.hpp>
+#include <togo/core/threading/types.hpp>
+#include <togo/core/threading/task_manager.hpp>
 #include <togo/core/filesystem/filesystem.hpp>
 #include <togo/core/filesystem/directory_reader.hpp>
+#include <togo/core/filesystem/file_watcher.hpp>
 #include <togo/core/kvs/kvs.hpp>
+#include <togo/core/trace/trace.hpp>
 #include <togo/game/resource/resource.hpp>
 #include <togo/tool_res_build/resource_compiler.hpp>
 #include <togo/tool_res_build/package_compiler.hpp>
@@ -24,6 +30,10 @@
 #include <togo/tool_res_build/generator_compiler.hpp>
 #include <togo/tool_res_build/interface.hpp>
 
+#include <atomic>
+#include <cstring>
+#include <cstdio>
+
 namespace togo {
 namespace tool_res_build {
 
@@ -35,6 +45,7 @@ Interface::Interface()
 	: _manager(memory::default_allocator())
 	, _gfx_compiler(memory::default_allocator())
 	, _project_path()
+	, _trace_path()
 {}
 
 namespace interface {
@@ -83,6 +94,14 @@ bool interface::read_options(
 			interface::set_project_path(interface, kvs::string_ref(k_opt));
 			break;
 
+		case "--trace"_kvs_name:
+			if (!kvs::is_string(k_opt) || kvs::string_size(k_opt) == 0) {
+				TOGO_LOG("error: --trace expected a non-empty string\n");
+				return false;
+			}
+			string::copy(interface._trace_path, kvs::string_ref(k_opt));
+			break;
+
 		default:
 			TOGO_LOGF(
 				"error: option '%.*s' not recognized\n",
@@ -192,6 +211,10 @@ bool interface::run(
 		kvs::is_node(k_command)
 	);
 	interface::check_project_path(interface);
+	bool const tracing = string::size(interface._trace_path) != 0;
+	if (tracing) {
+		trace::start();
+	}
 
 	#define CMD_CASE(cmd)										\
 		case #cmd ## _kvs_name:									\
@@ -209,6 +232,7 @@ bool interface::run(
 		CMD_CASE(compile);
 		CMD_CASE(pack);
 		CMD_CASE(compact);
+		CMD_CASE(watch);
 
 	default:
 		if (kvs::is_named(k_command)) {
@@ -229,10 +253,16 @@ bool interface::run(
 	#undef CMD_CASE
 
 	if (success) {
+		TOGO_TRACE_ZONE("write project");
 		interface::write_project(interface);
 		TOGO_ASSERTE(compiler_manager::write_packages(interface._manager));
 	}
 
+	if (tracing) {
+		trace::stop();
+		success = trace::write_chrome_file(interface._trace_path) && success;
+		trace::clear();
+	}
 	return success;
 }
 
@@ -246,3 +276,4 @@ bool interface::run(
 #include <togo/tool_res_build/interface/command_compile.ipp>
 #include <togo/tool_res_build/interface/command_pack.ipp>
 #include <togo/tool_res_build/interface/command_compact.ipp>
+#include <togo/tool_res_build/interface/command_watch.ipp>
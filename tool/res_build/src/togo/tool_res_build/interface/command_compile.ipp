@@ -6,46 +6,129 @@
 namespace togo {
 namespace tool_res_build {
 
+namespace {
+
+enum : unsigned {
+	// Number of sources to read in parallel before compiling them
+	COMPILE_BATCH_SIZE = 64,
+};
+
+struct CompileSource {
+	ResourceCompilerMetadata* metadata{nullptr};
+	ResourceCompiler const* compiler{nullptr};
+	bool opened{false};
+	bool read_success{false};
+	KVSParserInfo pinfo{};
+	KVSArena arena{};
+	KVS k_root{};
+};
+
+struct CompileBatch {
+	CompileSource* sources[COMPILE_BATCH_SIZE];
+	unsigned size;
+	std::atomic<unsigned> next;
+};
+
+} // anonymous namespace
+
+static void read_sources(CompileBatch& batch) {
+	unsigned i;
+	while ((i = batch.next.fetch_add(1)) < batch.size) {
+		auto& source = *batch.sources[i];
+		if (!source.compiler || !source.compiler->kvs_source) {
+			continue;
+		}
+		TOGO_TRACE_ZONE("read source");
+		FileReader stream{};
+		source.opened = stream.open(source.metadata->path);
+		if (source.opened) {
+			source.read_success = kvs::read_text(
+				source.k_root, stream, source.pinfo, &source.arena
+			);
+			stream.close();
+		}
+	}
+}
+
+static void read_sources_task(TaskID /*task_id*/, void* data) {
+	read_sources(*static_cast<CompileBatch*>(data));
+}
+
+// Sources are read relative to the working directory, which must not
+// change until this returns
+static void read_sources_parallel(
+	TaskManager& task_manager,
+	CompileBatch& batch,
+	unsigned const num_tasks
+) {
+	batch.next = 0;
+	TaskID const root_id = task_manager::add_hold_empty(task_manager);
+	for (unsigned i = 1; i < min(num_tasks, batch.size); ++i) {
+		TaskID const task_id = task_manager::add(
+			task_manager, TaskWork{&batch, read_sources_task}
+		);
+		task_manager::set_parent(task_manager, task_id, root_id);
+	}
+	task_manager::end_hold(task_manager, root_id);
+	read_sources(batch);
+	task_manager::wait(task_manager, root_id);
+}
+
 static bool compile_resource(
 	Interface& interface,
 	PackageCompiler& pkg,
-	ResourceCompilerMetadata& metadata
+	CompileSource const& source
 ) {
-	ResourceCompiledPath compiled_path{};
-	resource::set_compiled_path(compiled_path, metadata.id);
+	TOGO_TRACE_ZONE("compile resource");
+	auto& metadata = *source.metadata;
+	auto const* const compiler = source.compiler;
+	if (!compiler) {
+		TOGO_LOG_ERROR("no compiler for type\n");
+		return false;
+	}
 
 	// Open streams
-	FileReader in_stream{};
+	FileReader file_stream{};
+	MemoryReader empty_stream{""};
 	FileWriter out_stream{};
-	if (!in_stream.open(metadata.path)) {
+	if (compiler->kvs_source) {
+		if (!source.opened) {
+			TOGO_LOG_ERROR("failed to open source file\n");
+			return false;
+		} else if (!source.read_success) {
+			TOGO_LOG_ERRORF(
+				"failed to read source: [%2u,%2u]: %s\n",
+				source.pinfo.line, source.pinfo.column, source.pinfo.message
+			);
+			return false;
+		}
+	} else if (!file_stream.open(metadata.path)) {
 		TOGO_LOG_ERROR("failed to open source file\n");
 		return false;
 	}
+	ResourceCompiledPath compiled_path{};
+	resource::set_compiled_path(compiled_path, metadata.id);
 	if (!out_stream.open(compiled_path, false)) {
 		TOGO_LOG_ERRORF(
 			"failed to open output file: '%.*s'\n",
 			compiled_path.size(), compiled_path.data()
 		);
-		in_stream.close();
+		file_stream.close();
 		return false;
 	}
 
 	{// Compile
-	auto const* const compiler = compiler_manager::find_compiler(
-		interface._manager,
-		metadata.type
-	);
-	if (!compiler) {
-		TOGO_LOG_ERROR("no compiler for type\n");
-		return false;
-	}
 	bool const success = compiler->func_compile(
 		compiler->type_data,
 		interface._manager,
 		pkg, metadata,
-		in_stream, out_stream
+		compiler->kvs_source ? &source.k_root : nullptr,
+		compiler->kvs_source
+			? static_cast<IReader&>(empty_stream)
+			: static_cast<IReader&>(file_stream),
+		out_stream
 	);
-	in_stream.close();
+	file_stream.close();
 	out_stream.close();
 	if (success) {
 		metadata.data_format_version = compiler->format_version;
@@ -128,6 +211,67 @@ static void add_node(
 	}
 }
 
+// Compile resources grouped by package.
+//
+// Sources are read in parallel a batch at a time using up to num_tasks
+// tasks, then compiled serially in order.
+static bool compile_groups(
+	Interface& interface,
+	HashMap<ResourcePackageNameHash, Array<u32>*> const& groups,
+	TaskManager& task_manager,
+	unsigned const num_tasks
+) {
+	CompileBatch batch{};
+	PackageCompiler* pkg;
+	Array<u32> const* res_list;
+	StringRef pkg_name{};
+	StringRef path{};
+	for (auto const& node : groups) {
+		pkg = compiler_manager::find_package(interface._manager, node.key);
+		TOGO_ASSERTE(pkg);
+		res_list = node.value;
+		pkg_name = package_compiler::name(*pkg);
+		WorkingDirScope wd_scope{package_compiler::path(*pkg)};
+	unsigned const num_resources = static_cast<unsigned>(array::size(*res_list));
+	for (unsigned first = 0; first < num_resources; first += COMPILE_BATCH_SIZE) {
+		batch.size = min(num_resources - first, unsigned{COMPILE_BATCH_SIZE});
+		for (unsigned i = 0; i < batch.size; ++i) {
+			auto* const source = TOGO_CONSTRUCT_DEFAULT(
+				memory::default_allocator(), CompileSource
+			);
+			source->metadata = &pkg->_manifest[(*res_list)[first + i] - 1];
+			source->compiler = compiler_manager::find_compiler(
+				interface._manager, source->metadata->type
+			);
+			batch.sources[i] = source;
+		}
+		read_sources_parallel(task_manager, batch, num_tasks);
+
+		bool batch_success = true;
+		for (unsigned i = 0; i < batch.size; ++i) {
+			CompileSource* const source = batch.sources[i];
+			if (batch_success) {
+				path = StringRef{source->metadata->path};
+				TOGO_LOGF(
+					"  C %.*s / %.*s\n",
+					pkg_name.size, pkg_name.data,
+					path.size, path.data
+				);
+				batch_success = compile_resource(interface, *pkg, *source);
+			}
+			TOGO_DESTROY(memory::default_allocator(), source);
+		}
+		if (!batch_success) {
+			return false;
+		}
+	}
+		if (&node + 1 != hash_map::end(groups)) {
+			TOGO_LOG("\n");
+		}
+	}
+	return true;
+}
+
 // Status:
 //   N: no compile needed
 //   C: compiling
@@ -247,33 +391,10 @@ bool interface::command_compile(
 
 	// TODO: Write package data after compiling
 	{// Compile resources
-	PackageCompiler* pkg;
-	Array<u32> const* res_list;
-	StringRef pkg_name{};
-	StringRef path{};
-	for (auto const& node : groups) {
-		pkg = compiler_manager::find_package(interface._manager, node.key);
-		TOGO_ASSERTE(pkg);
-		res_list = node.value;
-		pkg_name = package_compiler::name(*pkg);
-		WorkingDirScope wd_scope{package_compiler::path(*pkg)};
-	for (u32 id : *res_list) {
-		auto& metadata = pkg->_manifest[id - 1];
-		path = StringRef{metadata.path};
-		TOGO_LOGF(
-			"  C %.*s / %.*s\n",
-			pkg_name.size, pkg_name.data,
-			path.size, path.data
-		);
-		if (!compile_resource(interface, *pkg, metadata)) {
-			success = false;
-			goto l_exit;
-		}
+	unsigned const num_tasks = max(system::num_cores(), 1u);
+	TaskManager task_manager{num_tasks - 1, memory::default_allocator()};
+	success = compile_groups(interface, groups, task_manager, num_tasks);
 	}
-		if (&node + 1 != hash_map::end(groups)) {
-			TOGO_LOG("\n");
-		}
-	}}
 
 l_exit:
 	for (auto& node : groups) {
@@ -32,6 +32,7 @@ bool interface::command_help(
 				TOGO_TOOL_RES_BUILD_USAGE_TEXT "\n"
 				"  --project-path=<path>: specify project path\n"
 				"  if this is not defined, the TOGO_PROJECT environment variable will be used\n"
+				"  --trace=<path>: write a Chrome trace of the command to path\n"
 				"\n"
 			);
 
@@ -75,6 +76,13 @@ bool interface::command_help(
 			"  remove empty metadata entries\n"
 			"  if no packages are specified, all are selected\n"
 		);
+		CASE_DESCRIBE_COMMAND(
+			"watch", "[--batches=<n>] [<package_name> ...]",
+			"  sync and compile packages, then recompile resources as they change\n"
+			"  if no packages are specified, all are watched\n"
+			"\n"
+			"  --batches=<n>: exit after n batches of changes (default: never)\n"
+		);
 
 	default:
 		if (!do_all) {
@@ -8,7 +8,8 @@ namespace tool_res_build {
 
 static bool sync_package(
 	Interface& interface,
-	PackageCompiler& pkg
+	PackageCompiler& pkg,
+	TaskManager& task_manager
 ) {
 	StringRef const pkg_name = package_compiler::name(pkg);
 	StringRef const pkg_path = package_compiler::path(pkg);
@@ -47,8 +48,10 @@ static bool sync_package(
 	}}
 
 	{// Read new files in the package tree
-	DirectoryReader dir_reader{};
-	if (!directory_reader::open(dir_reader, ".", false, true, true)) {
+	DirectoryListing listing{memory::default_allocator()};
+	if (!directory_reader::scan(
+		listing, ".", false, true, true, DirectoryEntry::Type::file, &task_manager
+	)) {
 		TOGO_LOG_ERRORF(
 			"failed to open directory for package '%.*s': '%.*s'\n",
 			pkg_name.size, pkg_name.data,
@@ -58,8 +61,8 @@ static bool sync_package(
 	}
 
 	ResourcePathParts pp;
-	DirectoryEntry entry;
-	while (directory_reader::read(dir_reader, entry, DirectoryEntry::Type::file)) {
+	for (unsigned i = 0; i < array::size(listing.entries); ++i) {
+		DirectoryEntry const entry = directory_reader::entry(listing, i);
 		if (!resource::parse_path(entry.path, pp)) {
 			TOGO_LOG_STATUS_(entry.path, 'I', "(path parse failed)");
 		} else if (!compiler_manager::has_compiler(interface._manager, pp.type_hash)) {
@@ -69,7 +72,6 @@ static bool sync_package(
 			package_compiler::add_resource(pkg, entry.path, pp);
 		}
 	}
-	directory_reader::close(dir_reader);
 	}
 	#undef TOGO_LOG_STATUS_
 
@@ -91,6 +93,8 @@ bool interface::command_sync(
 	ArrayRef<StringRef const> const package_names
 ) {
 	auto& packages = compiler_manager::packages(interface._manager);
+	unsigned const num_tasks = max(system::num_cores(), 1u);
+	TaskManager task_manager{num_tasks - 1, memory::default_allocator()};
 	if (package_names.size() > 0) {
 		PackageCompiler* pkg;
 		for (auto const& pkg_name : package_names) {
@@ -99,7 +103,7 @@ bool interface::command_sync(
 				resource::hash_package_name(pkg_name)
 			);
 			if (pkg) {
-				if (!sync_package(interface, *pkg)) {
+				if (!sync_package(interface, *pkg, task_manager)) {
 					return false;
 				}
 			} else {
@@ -112,7 +116,7 @@ bool interface::command_sync(
 		}
 	} else if (array::any(packages)) {
 		for (auto* pkg : packages) {
-			if (!sync_package(interface, *pkg)) {
+			if (!sync_package(interface, *pkg, task_manager)) {
 				return false;
 			}
 		}
@@ -0,0 +1,363 @@
+#line 2 "togo/tool_res_build/interface/command_watch.ipp"
+/**
+@copyright MIT license; see @ref index or the accompanying LICENSE file.
+*/
+
+namespace togo {
+namespace tool_res_build {
+
+namespace {
+
+struct WatchState {
+	Interface& interface;
+	TaskManager& task_manager;
+	HashMap<ResourcePackageNameHash, Array<u32>*> groups;
+	// Packages changed by a batch, kept until they are written
+	Array<PackageCompiler*> changed;
+};
+
+} // anonymous namespace
+
+// Status:
+//   A: resource added
+//   D: resource removed
+//   M: resource modified
+#define TOGO_LOG_STATUS_(pkg, path, status)						\
+	TOGO_LOGF(													\
+		" %c  %.*s / %.*s\n",									\
+		status,													\
+		string::size(package_compiler::name(pkg)),				\
+		begin(package_compiler::name(pkg)),						\
+		string::size(path), begin(path)							\
+	)
+
+static void watch_queue(
+	WatchState& state,
+	PackageCompiler& pkg,
+	u32 const id
+) {
+	auto** res_list = hash_map::find(state.groups, package_compiler::name_hash(pkg));
+	if (res_list) {
+		for (u32 const queued_id : **res_list) {
+			if (queued_id == id) {
+				return;
+			}
+		}
+	}
+	add_resource(state.groups, &pkg, id, true);
+}
+
+static void watch_mark_changed(
+	WatchState& state,
+	PackageCompiler& pkg
+) {
+	for (auto const* changed : state.changed) {
+		if (changed == &pkg) {
+			return;
+		}
+	}
+	array::push_back(state.changed, &pkg);
+}
+
+static void watch_file_changed(
+	WatchState& state,
+	PackageCompiler& pkg,
+	StringRef const& path
+) {
+	ResourcePathParts pp;
+	if (
+		!resource::parse_path(path, pp) ||
+		!compiler_manager::has_compiler(state.interface._manager, pp.type_hash)
+	) {
+		return;
+	}
+	u32 id = package_compiler::find_resource_id(pkg, pp, false);
+	if (id == 0) {
+		TOGO_LOG_STATUS_(pkg, path, 'A');
+		id = package_compiler::add_resource(pkg, path, pp);
+	} else {
+		TOGO_LOG_STATUS_(pkg, path, 'M');
+	}
+	watch_queue(state, pkg, id);
+}
+
+static void watch_file_removed(
+	WatchState& state,
+	PackageCompiler& pkg,
+	StringRef const& path
+) {
+	ResourcePathParts pp;
+	if (
+		!resource::parse_path(path, pp) ||
+		!compiler_manager::has_compiler(state.interface._manager, pp.type_hash)
+	) {
+		return;
+	}
+	u32 const id = package_compiler::find_resource_id(pkg, pp, false);
+	if (id != 0) {
+		TOGO_LOG_STATUS_(pkg, path, 'D');
+		package_compiler::remove_resource(pkg, id);
+		auto** res_list = hash_map::find(state.groups, package_compiler::name_hash(pkg));
+		if (res_list) {
+			for (unsigned i = 0; i < array::size(**res_list); ++i) {
+				if ((**res_list)[i] == id) {
+					array::remove(**res_list, i);
+					break;
+				}
+			}
+		}
+	}
+}
+
+static void watch_dir_removed(
+	WatchState& state,
+	PackageCompiler& pkg,
+	StringRef const& prefix
+) {
+	for (auto const& metadata : package_compiler::manifest(pkg)) {
+		StringRef const path{metadata.path};
+		if (
+			metadata.id != 0 &&
+			path.size > prefix.size &&
+			std::memcmp(path.data, prefix.data, prefix.size) == 0
+		) {
+			watch_file_removed(state, pkg, path);
+		}
+	}
+}
+
+static void watch_dir_added(
+	WatchState& state,
+	PackageCompiler& pkg,
+	StringRef const& path
+) {
+	DirectoryListing listing{memory::default_allocator()};
+	if (!directory_reader::scan(
+		listing, path, true, true, true, DirectoryEntry::Type::file, &state.task_manager
+	)) {
+		return;
+	}
+	for (unsigned i = 0; i < array::size(listing.entries); ++i) {
+		watch_file_changed(state, pkg, directory_reader::entry(listing, i).path);
+	}
+}
+
+static void watch_overflow(
+	WatchState& state,
+	PackageCompiler& pkg
+) {
+	if (!sync_package(state.interface, pkg, state.task_manager)) {
+		return;
+	}
+	for (auto const& metadata : package_compiler::manifest(pkg)) {
+		add_resource(state.groups, &pkg, metadata.id, false);
+	}
+}
+
+static void watch_handle_event(
+	WatchState& state,
+	PackageCompiler& pkg,
+	FileWatchEvent const& event
+) {
+	using EventType = FileWatchEvent::Type;
+	bool const is_dir = event.entry_type == DirectoryEntry::Type::dir;
+	switch (event.type) {
+	case EventType::create:
+	case EventType::modify:
+		// Contents of new directories have their own events
+		if (!is_dir) {
+			watch_file_changed(state, pkg, event.path);
+		}
+		break;
+
+	case EventType::remove:
+		if (is_dir) {
+			watch_dir_removed(state, pkg, event.path);
+		} else {
+			watch_file_removed(state, pkg, event.path);
+		}
+		break;
+
+	case EventType::move:
+		if (is_dir) {
+			watch_dir_removed(state, pkg, event.from_path);
+			watch_dir_added(state, pkg, event.path);
+		} else {
+			watch_file_removed(state, pkg, event.from_path);
+			watch_file_changed(state, pkg, event.path);
+		}
+		break;
+
+	case EventType::overflow:
+		watch_overflow(state, pkg);
+		break;
+	}
+}
+
+#undef TOGO_LOG_STATUS_
+
+/// Run watch command.
+///
+/// Syncs and compiles packages, then watches them for changes and
+/// recompiles changed resources until max_batches batches of changes
+/// have been handled. If max_batches is 0, this never returns.
+/// If no packages are specified, all packages are watched.
+bool interface::command_watch(
+	Interface& interface,
+	unsigned const max_batches,
+	ArrayRef<StringRef const> const package_names
+) {
+	Array<PackageCompiler*> packages{memory::default_allocator()};
+	if (package_names.size() > 0) {
+		PackageCompiler* pkg;
+		for (auto const& pkg_name : package_names) {
+			pkg = compiler_manager::find_package(
+				interface._manager,
+				resource::hash_package_name(pkg_name)
+			);
+			if (!pkg) {
+				TOGO_LOG_ERRORF(
+					"package not found: '%.*s'\n",
+					pkg_name.size, pkg_name.data
+				);
+				return false;
+			}
+			array::push_back(packages, pkg);
+		}
+	} else {
+		array::copy(packages, compiler_manager::packages(interface._manager));
+	}
+	if (array::empty(packages)) {
+		TOGO_LOG("no packages to watch\n");
+		return true;
+	}
+
+	// Initial build
+	if (!interface::command_sync(interface, package_names)) {
+		return false;
+	}
+	for (auto* pkg : packages) {
+		if (!interface::command_compile(
+			interface, false, package_compiler::name(*pkg), nullptr, 0
+		)) {
+			return false;
+		}
+	}
+	interface::write_project(interface);
+	if (!compiler_manager::write_packages(interface._manager)) {
+		return false;
+	}
+
+	// Root index is package index
+	FileWatcher watcher{memory::default_allocator()};
+	for (auto* pkg : packages) {
+		if (!file_watcher::add_root(watcher, package_compiler::path(*pkg), true)) {
+			StringRef const pkg_name = package_compiler::name(*pkg);
+			TOGO_LOG_ERRORF(
+				"failed to watch package '%.*s'\n",
+				pkg_name.size, pkg_name.data
+			);
+			return false;
+		}
+	}
+
+	unsigned const num_tasks = max(system::num_cores(), 1u);
+	TaskManager task_manager{num_tasks - 1, memory::default_allocator()};
+	WatchState state{
+		interface,
+		task_manager,
+		HashMap<ResourcePackageNameHash, Array<u32>*>{memory::default_allocator()},
+		Array<PackageCompiler*>{memory::default_allocator()}
+	};
+
+	TOGO_LOG("\nwatching for changes\n");
+	unsigned num_batches = 0;
+	while (max_batches == 0 || num_batches < max_batches) {
+		auto const events = file_watcher::poll(watcher, 1000);
+		if (events.size() == 0) {
+			continue;
+		}
+		++num_batches;
+		TOGO_TRACE_ZONE("watch batch");
+
+		TOGO_LOG("\n");
+		for (auto const& event : events) {
+			PackageCompiler& pkg = *packages[event.root];
+			WorkingDirScope wd_scope{package_compiler::path(pkg)};
+			watch_handle_event(state, pkg, event);
+			watch_mark_changed(state, pkg);
+		}
+
+		if (!hash_map::empty(state.groups)) {
+			TOGO_LOG("\n");
+			if (!compile_groups(interface, state.groups, task_manager, num_tasks)) {
+				TOGO_LOG_ERROR("compile failed; waiting for changes\n");
+			}
+		}
+		for (auto& node : state.groups) {
+			TOGO_DESTROY(memory::default_allocator(), node.value);
+		}
+		hash_map::clear(state.groups);
+
+		// The package list does not change while watching, so only
+		// the changed packages are written. Packages that fail to
+		// write are retried after the next batch.
+		for (unsigned i = 0; i < array::size(state.changed);) {
+			PackageCompiler& pkg = *state.changed[i];
+			if (package_compiler::write(pkg)) {
+				array::remove(state.changed, i);
+			} else {
+				StringRef const pkg_name = package_compiler::name(pkg);
+				TOGO_LOG_ERRORF(
+					"failed to write package '%.*s'; waiting for changes\n",
+					pkg_name.size, pkg_name.data
+				);
+				++i;
+			}
+		}
+	}
+	return true;
+}
+
+/// Run watch command with KVS.
+///
+/// Specification:
+/// @verbatim watch [--batches=<n>] [<package_name> ...] @endverbatim
+bool interface::command_watch(
+	Interface& interface,
+	KVS const& k_command_options,
+	KVS const& k_command
+) {
+	unsigned max_batches = 0;
+	for (KVS const& k_opt : k_command_options) {
+		switch (kvs::name_hash(k_opt)) {
+		case "--batches"_kvs_name:
+			if (!kvs::is_integer(k_opt) || kvs::integer(k_opt) < 0) {
+				TOGO_LOG("error: --batches: expected non-negative integer value\n");
+				return false;
+			}
+			max_batches = static_cast<unsigned>(kvs::integer(k_opt));
+			break;
+
+		default:
+			TOGO_LOGF(
+				"error: option '%.*s' not recognized\n",
+				kvs::name_size(k_opt), kvs::name(k_opt)
+			);
+			return false;
+		}
+	}
+
+	Array<StringRef> package_names{memory::scratch_allocator()};
+	for (KVS const& k_pkg_name : k_command) {
+		if (!kvs::is_string(k_pkg_name) || kvs::string_size(k_pkg_name) == 0) {
+			TOGO_LOG("error: expected non-empty string argument\n");
+			return false;
+		}
+		array::push_back(package_names, kvs::string_ref(k_pkg_name));
+	}
+	return interface::command_watch(interface, max_batches, package_names);
+}
+
+} // namespace tool_res_build
+} // namespace togo
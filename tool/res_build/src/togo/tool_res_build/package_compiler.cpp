@@ -8,6 +8,7 @@
 #include <togo/core/error/assert.hpp>
 #include <togo/core/utility/traits.hpp>
 #include <togo/core/log/log.hpp>
+#include <togo/core/memory/memory.hpp>
 #include <togo/core/collection/fixed_array.hpp>
 #include <togo/core/collection/array.hpp>
 #include <togo/core/collection/hash_map.hpp>
@@ -15,7 +16,9 @@
 #include <togo/core/filesystem/filesystem.hpp>
 #include <togo/core/io/io.hpp>
 #include <togo/core/io/file_stream.hpp>
+#include <togo/core/io/async_io.hpp>
 #include <togo/core/kvs/kvs.hpp>
+#include <togo/core/trace/trace.hpp>
 #include <togo/core/serialization/serializer.hpp>
 #include <togo/core/serialization/support.hpp>
 #include <togo/core/serialization/binary_serializer.hpp>
@@ -348,14 +351,16 @@ void package_compiler::read(PackageCompiler& pkg) {
 	}}
 
 	{// Read manifest
-	FileReader stream{};
+	MappedFile file{};
 	TOGO_ASSERTF(
-		stream.open(".package/manifest"),
+		filesystem::map_file(file, ".package/manifest"),
 		"'%.*s': failed to open manifest for reading",
 		path.size, path.data
 	);
 
-	BinaryInputSerializer ser{stream};
+	BinaryMemoryInputSerializer ser{array_cref(
+		file.data, static_cast<unsigned>(file.size)
+	)};
 	u32 format_version = 0;
 	ser % format_version;
 	TOGO_ASSERTF(
@@ -365,7 +370,6 @@ void package_compiler::read(PackageCompiler& pkg) {
 	);
 
 	ser % make_ser_collection<u32>(pkg._manifest);
-	stream.close();
 	}
 
 	{// Read compiler_metadata
@@ -466,12 +470,23 @@ bool package_compiler::write_manifest(PackageCompiler& pkg) {
 		return false;
 	}
 
-	BinaryOutputSerializer ser{stream};
+	Array<u8> buffer{memory::scratch_allocator()};
+	BinaryMemoryOutputSerializer ser{buffer};
 	ser
 		% u32{SER_FORMAT_VERSION_PKG_MANIFEST}
 		% make_ser_collection<u32>(pkg._manifest);
 	;
+	bool const success = io::write(
+		stream, array::begin(buffer), array::size(buffer)
+	).ok();
 	stream.close();
+	if (!success) {
+		TOGO_LOG_ERRORF(
+			"failed to write manifest for package at '%.*s'\n",
+			path.size, path.data
+		);
+		return false;
+	}
 	}
 
 	{// Write compiler_metadata
@@ -500,6 +515,7 @@ bool package_compiler::write_manifest(PackageCompiler& pkg) {
 
 /// Build package.
 bool package_compiler::build(PackageCompiler& pkg, StringRef const& output_path) {
+	TOGO_TRACE_ZONE("build package");
 	StringRef const path{pkg._path};
 	TOGO_ASSERTF(
 		filesystem::is_directory(path),
@@ -522,7 +538,7 @@ bool package_compiler::build(PackageCompiler& pkg, StringRef const& output_path)
 	u32 const offset_basis
 		= 4 + 4
 		// manifest
-		+ (32 * array::size(pkg._manifest))
+		+ (SER_SIZE_RESOURCE_METADATA * array::size(pkg._manifest))
 	;
 
 	{// Calculate data offsets and sizes
@@ -548,50 +564,102 @@ bool package_compiler::build(PackageCompiler& pkg, StringRef const& output_path)
 	//    FORMAT_VERSION
 	//    manifest
 	//    <resource data>
-	BinaryOutputSerializer ser{stream};
+	Array<u8> buffer{memory::scratch_allocator()};
+	array::reserve(buffer, offset_basis);
+	BinaryMemoryOutputSerializer ser{buffer};
 	ser
 		% u32{SER_FORMAT_VERSION_PKG_MANIFEST}
 		% make_ser_collection<u32>(pkg._manifest)
 	;
-	TOGO_ASSERTE(offset_basis == io::position(stream));
+	TOGO_ASSERTE(offset_basis == array::size(buffer));
+	TOGO_ASSERTE(io::write(stream, array::begin(buffer), array::size(buffer)));
+
+	TOGO_ASSERTE(stream.flush());
+	}
 
+	{// Copy resource data
+	TOGO_TRACE_ZONE("copy resource data");
+	// Chunks are read in batches and then written at their offsets in
+	// the package, keeping a batch of transfers in flight at once.
 	enum : u32 {
-		tmp_buffer_size = 1 * 1024 * 1024,
+		chunk_size = 64 * 1024,
+		num_chunks = 16,
 	};
+	AsyncIO aio{num_chunks, 4, memory::default_allocator()};
+	FileReader compiled_streams[num_chunks];
+	AsyncIORequest reads[num_chunks];
+	AsyncIORequest writes[num_chunks];
+	AsyncIORequest* read_ptrs[num_chunks];
+	AsyncIORequest* write_ptrs[num_chunks];
+	u8* const buffer = static_cast<u8*>(
+		memory::scratch_allocator().allocate(chunk_size * num_chunks)
+	);
+	bool success = true;
 	StringRef rpath{};
-	FileReader compiled_stream{};
-	unsigned read_size;
-	void* const tmp_buffer = memory::scratch_allocator().allocate(tmp_buffer_size);
-	for (auto const& metadata : pkg._manifest) {
-		if (metadata.id == 0) {
-			continue;
-		}
-
-		resource::set_compiled_path(compiled_path, metadata.id);
-		rpath = metadata.path;
-		if (!compiled_stream.open(compiled_path)) {
-			TOGO_LOG_ERRORF(
-				"failed to open compiled resource file for '%.*s': '%.*s'\n",
-				rpath.size, rpath.data,
-				compiled_path.size(), compiled_path.data()
+	auto it = array::begin(pkg._manifest);
+	auto const end = array::end(pkg._manifest);
+	u32 resource_offset = 0;
+	while (success && it != end) {
+		unsigned num = 0;
+		unsigned num_streams = 0;
+		while (num < num_chunks && it != end) {
+			if (it->id == 0 || it->data_size == 0) {
+				++it;
+				continue;
+			}
+			if (resource_offset == 0 || num == 0) {
+				resource::set_compiled_path(compiled_path, it->id);
+				if (!compiled_streams[num_streams].open(compiled_path)) {
+					rpath = it->path;
+					TOGO_LOG_ERRORF(
+						"failed to open compiled resource file for '%.*s': '%.*s'\n",
+						rpath.size, rpath.data,
+						compiled_path.size(), compiled_path.data()
+					);
+					success = false;
+					break;
+				}
+				++num_streams;
+			}
+			u32 const size = min(u32{chunk_size}, it->data_size - resource_offset);
+			u8* const chunk = buffer + num * chunk_size;
+			async_io::set_read(
+				reads[num], compiled_streams[num_streams - 1],
+				resource_offset, chunk, size
+			);
+			async_io::set_write(
+				writes[num], stream,
+				it->data_offset + resource_offset, chunk, size
 			);
-			memory::scratch_allocator().deallocate(tmp_buffer);
-			return false;
+			read_ptrs[num] = &reads[num];
+			write_ptrs[num] = &writes[num];
+			resource_offset += size;
+			if (resource_offset == it->data_size) {
+				resource_offset = 0;
+				++it;
+			}
+			++num;
 		}
-
-		TOGO_ASSERTE(metadata.data_offset == io::position(stream));
-		do {
-			TOGO_ASSERTE(!io::read(
-				compiled_stream,
-				tmp_buffer, tmp_buffer_size,
-				&read_size
-			).fail());
-			TOGO_ASSERTE(io::write(stream, tmp_buffer, read_size));
-		} while (io::status(compiled_stream));
-		TOGO_ASSERTE(metadata.data_size == io::position(compiled_stream));
-		compiled_stream.close();
-	}
-	memory::scratch_allocator().deallocate(tmp_buffer);
+		if (success && num > 0) {
+			async_io::submit(aio, array_cref(read_ptrs, num));
+			async_io::wait(aio);
+			for (unsigned i = 0; i < num; ++i) {
+				TOGO_ASSERTE(reads[i].status.ok() && reads[i].transferred == reads[i].size);
+			}
+			async_io::submit(aio, array_cref(write_ptrs, num));
+			async_io::wait(aio);
+			for (unsigned i = 0; i < num; ++i) {
+				TOGO_ASSERTE(writes[i].status.ok());
+			}
+		}
+		while (num_streams--) {
+			compiled_streams[num_streams].close();
+		}
+	}
+	memory::scratch_allocator().deallocate(buffer);
+	if (!success) {
+		return false;
+	}
 	}
 	stream.close();
 
@@ -656,13 +656,14 @@ static bool compile(
 	CompilerManager& /*manager*/,
 	PackageCompiler& /*package*/,
 	ResourceCompilerMetadata const& /*metadata*/,
-	IReader& in_stream,
+	KVS const* const k_source,
+	IReader& /*in_stream*/,
 	IWriter& out_stream
 ) {
 	bool success = false;
 	auto& gfx_compiler = *static_cast<GfxCompiler*>(type_data);
 	gfx::PackedRenderConfig* packed = nullptr;
-	KVS k_root{};
+	KVS const& k_root = *k_source;
 
 	TempAllocator<512> temp_allocator;
 	HashMap<KVSNameHash, KVS const*> used{temp_allocator};
@@ -672,17 +673,6 @@ static bool compile(
 	KVS const* k_pipes;
 	KVS const* k_viewports;
 
-	{// Read source
-	KVSParserInfo pinfo;
-	bool const read_success = kvs::read_text(k_root, in_stream, pinfo);
-	if (!read_success) {
-		TOGO_LOG_ERRORF(
-			"failed to read render_config: [%2u,%2u]: %s\n",
-			pinfo.line, pinfo.column, pinfo.message
-		);
-		goto l_failed;
-	}}
-
 	// Fetch and validate structure
 	k_shared_resources = kvs::find(k_root, "shared_resources");
 	if (k_shared_resources && !kvs::is_type(*k_shared_resources, KVSType::node)) {
@@ -840,7 +830,8 @@ void resource_compiler::register_render_config(
 		RES_TYPE_RENDER_CONFIG,
 		SER_FORMAT_VERSION_RENDER_CONFIG,
 		&gfx_compiler,
-		resource_compiler::render_config::compile
+		resource_compiler::render_config::compile,
+		true
 	};
 	compiler_manager::register_compiler(cm, compiler);
 }
@@ -325,25 +325,13 @@ static bool compile(
 	CompilerManager& manager,
 	PackageCompiler& /*package*/,
 	ResourceCompilerMetadata const& metadata,
-	IReader& in_stream,
+	KVS const& k_root,
 	IWriter& out_stream,
 	gfx::ShaderDef& def,
 	complete_func_type& func_complete
 ) {
-	KVS k_root{};
 	KVS const* k_type;
 
-	{// Read source
-	KVSParserInfo pinfo;
-	bool const read_success = kvs::read_text(k_root, in_stream, pinfo);
-	if (!read_success) {
-		TOGO_LOG_ERRORF(
-			"failed to read shader_def: [%2u,%2u]: %s\n",
-			pinfo.line, pinfo.column, pinfo.message
-		);
-		return false;
-	}}
-
 	// Fetch and validate structure
 	k_type = kvs::find(k_root, "type");
 	if (!k_type || !kvs::is_string(*k_type)) {
@@ -393,13 +381,14 @@ static bool compile(
 	CompilerManager& manager,
 	PackageCompiler& package,
 	ResourceCompilerMetadata const& metadata,
-	IReader& in_stream,
+	KVS const* const k_source,
+	IReader& /*in_stream*/,
 	IWriter& out_stream
 ) {
 	gfx::ShaderDef def{memory::scratch_allocator()};
 	def.properties |= gfx::ShaderDef::TYPE_UNIT;
 	return resource_compiler::shader_def::compile(
-		type_data, manager, package, metadata, in_stream, out_stream,
+		type_data, manager, package, metadata, *k_source, out_stream,
 		def,
 		shader::complete
 	);
@@ -420,13 +409,14 @@ static bool compile(
 	CompilerManager& manager,
 	PackageCompiler& package,
 	ResourceCompilerMetadata const& metadata,
-	IReader& in_stream,
+	KVS const* const k_source,
+	IReader& /*in_stream*/,
 	IWriter& out_stream
 ) {
 	gfx::ShaderDef def{memory::scratch_allocator()};
 	def.properties |= gfx::ShaderDef::TYPE_PRELUDE;
 	return resource_compiler::shader_def::compile(
-		type_data, manager, package, metadata, in_stream, out_stream,
+		type_data, manager, package, metadata, *k_source, out_stream,
 		def,
 		shader_prelude::complete
 	);
@@ -444,7 +434,8 @@ void resource_compiler::register_shader_prelude(
 		RES_TYPE_SHADER_PRELUDE,
 		SER_FORMAT_VERSION_SHADER_DEF,
 		nullptr,
-		resource_compiler::shader_prelude::compile
+		resource_compiler::shader_prelude::compile,
+		true
 	};
 	compiler_manager::register_compiler(cm, compiler);
 }
@@ -457,7 +448,8 @@ void resource_compiler::register_shader(
 		RES_TYPE_SHADER,
 		SER_FORMAT_VERSION_SHADER_DEF,
 		nullptr,
-		resource_compiler::shader::compile
+		resource_compiler::shader::compile,
+		true
 	};
 	compiler_manager::register_compiler(cm, compiler);
 }
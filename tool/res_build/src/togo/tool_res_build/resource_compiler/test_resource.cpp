@@ -30,21 +30,11 @@ static bool compile(
 	CompilerManager& /*manager*/,
 	PackageCompiler& /*package*/,
 	ResourceCompilerMetadata const& /*metadata*/,
-	IReader& in_stream,
+	KVS const* const k_source,
+	IReader& /*in_stream*/,
 	IWriter& out_stream
 ) {
-	KVS k_root{};
-
-	{// Read source
-	KVSParserInfo pinfo;
-	bool const read_success = kvs::read_text(k_root, in_stream, pinfo);
-	if (!read_success) {
-		TOGO_LOG_ERRORF(
-			"failed to read test_resource: [%2u,%2u]: %s\n",
-			pinfo.line, pinfo.column, pinfo.message
-		);
-		return false;
-	}}
+	KVS const& k_root = *k_source;
 
 	// Fetch and validate structure
 	KVS const* const k_x = kvs::find(k_root, "x");
@@ -75,7 +65,8 @@ void resource_compiler::register_test(
 		RES_TYPE_TEST,
 		SER_FORMAT_VERSION_TEST_RESOURCE,
 		nullptr,
-		resource_compiler::test_resource::compile
+		resource_compiler::test_resource::compile,
+		true
 	};
 	compiler_manager::register_compiler(cm, compiler);
 }
@@ -20,6 +20,7 @@
 #include <togo/core/string/types.hpp>
 #include <togo/core/hash/hash.hpp>
 #include <togo/core/io/types.hpp>
+#include <togo/core/kvs/types.hpp>
 #include <togo/core/serialization/types.hpp>
 #include <togo/game/gfx/types.hpp>
 #include <togo/game/resource/types.hpp>
@@ -60,11 +61,16 @@ struct ResourceCompilerMetadata
 /// Resource compiler.
 struct ResourceCompiler {
 	/// Compile a resource.
+	///
+	/// If kvs_source is true, k_source is the source read as
+	/// text-format KVS and in_stream is empty. Otherwise, k_source
+	/// is nullptr.
 	using compile_func_type = bool (
 		void* type_data,
 		CompilerManager& manager,
 		PackageCompiler& package,
 		ResourceCompilerMetadata const& metadata,
+		KVS const* k_source,
 		IReader& in_stream,
 		IWriter& out_stream
 	);
@@ -73,6 +79,12 @@ struct ResourceCompiler {
 	u32 format_version;
 	void* type_data;
 	compile_func_type* func_compile;
+
+	/// Whether the source is text-format KVS.
+	///
+	/// Sources for these compilers are read in parallel before
+	/// compiling.
+	bool kvs_source;
 };
 
 /** @} */ // end of doc-group tool_res_build_resource_compiler
@@ -182,6 +194,7 @@ struct Interface {
 	CompilerManager _manager;
 	GfxCompiler _gfx_compiler;
 	FixedArray<char, 256> _project_path;
+	FixedArray<char, 256> _trace_path;
 
 	Interface(Interface const&) = delete;
 	Interface(Interface&&) = delete;